@@ -0,0 +1,269 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                          Implementation of class 'amg'
+
+  ==============================================================================*/
+
+#include <math.h>
+#include <algorithm>
+#include "amg.h"
+
+using std::endl;
+
+namespace RITA {
+
+template<class T_>
+amg<T_>::amg()
+        : _theta(0.08), _coarse_size(200), _max_levels(20), _nu(1)
+{
+}
+
+
+template<class T_>
+int amg<T_>::setup(const spmat<T_>& A)
+{
+   _level.clear();
+   _level.push_back(Level());
+   _level[0].A = A;
+   while (int(_level.size())<_max_levels) {
+      Level &L = _level.back();
+      size_t n = L.A.size();
+      if (n<=_coarse_size)
+         break;
+      vector<long> agg;
+      size_t nc = aggregate(L.A,agg);
+      if (nc==0 || nc>=n*9/10)
+         break;
+      prolongation(L.A,agg,nc,L.P);
+      Transpose(L.P,L.R);
+      spmat<T_> AP;
+      Multiply(L.A,L.P,AP);
+      Level C;
+      Multiply(L.R,AP,C.A);
+      _level.push_back(std::move(C));
+   }
+   for (auto &L: _level) {
+      L.x.resize(L.A.size());
+      L.b.resize(L.A.size());
+      L.r.resize(L.A.size());
+   }
+   _lu.factor(_level.back().A);
+   return 0;
+}
+
+
+/*
+ * Aggregation of strongly connected unknowns (Vanek, Mandel, Brezina).
+ * Unknowns without off-diagonal coupling (e.g. prescribed boundary values)
+ * are left out of the aggregates and handled by the smoother only.
+ */
+template<class T_>
+size_t amg<T_>::aggregate(const spmat<T_>& A,
+                          vector<long>&    agg) const
+{
+   size_t n = A.size();
+   vector<T_> d(n);
+   for (size_t i=0; i<n; ++i)
+      d[i] = fabs(A.diag(i));
+
+// Strong connections
+   vector<size_t> sp(n+1,0), sc;
+   sc.reserve(A.nnz());
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j!=i && fabs(A.a[k])>_theta*sqrt(d[i]*d[j]))
+            sc.push_back(j);
+      }
+      sp[i+1] = sc.size();
+   }
+
+   agg.assign(n,-1);
+   for (size_t i=0; i<n; ++i)
+      if (sp[i]==sp[i+1])
+         agg[i] = -2;
+
+// Phase 1: Unknowns whose neighbourhood is free form a new aggregate
+   long nc = 0;
+   for (size_t i=0; i<n; ++i) {
+      if (agg[i]!=-1)
+         continue;
+      bool free_nb = true;
+      for (size_t k=sp[i]; k<sp[i+1] && free_nb; ++k)
+         if (agg[sc[k]]>=0)
+            free_nb = false;
+      if (!free_nb)
+         continue;
+      agg[i] = nc;
+      for (size_t k=sp[i]; k<sp[i+1]; ++k)
+         agg[sc[k]] = nc;
+      nc++;
+   }
+
+// Phase 2: Remaining unknowns join a neighbouring aggregate
+   vector<long> agg1(agg);
+   for (size_t i=0; i<n; ++i) {
+      if (agg[i]!=-1)
+         continue;
+      for (size_t k=sp[i]; k<sp[i+1]; ++k) {
+         if (agg[sc[k]]>=0) {
+            agg1[i] = agg[sc[k]];
+            break;
+         }
+      }
+   }
+   agg = agg1;
+
+// Phase 3: Unknowns still left form aggregates with their free neighbours
+   for (size_t i=0; i<n; ++i) {
+      if (agg[i]!=-1)
+         continue;
+      agg[i] = nc;
+      for (size_t k=sp[i]; k<sp[i+1]; ++k)
+         if (agg[sc[k]]==-1)
+            agg[sc[k]] = nc;
+      nc++;
+   }
+   return size_t(nc);
+}
+
+
+/*
+ * Smoothed prolongation P = (I - omega D^{-1} A) T, where T is the tentative
+ * piecewise constant prolongation normalized on each aggregate and
+ * omega = 4/(3 rho(D^{-1}A))
+ */
+template<class T_>
+void amg<T_>::prolongation(const spmat<T_>&    A,
+                           const vector<long>& agg,
+                           size_t              nc,
+                           spmat<T_>&          P) const
+{
+   size_t n = A.size();
+   vector<size_t> count(nc,0);
+   for (size_t i=0; i<n; ++i)
+      if (agg[i]>=0)
+         count[agg[i]]++;
+   spmat<T_> T;
+   T.nb_rows = n, T.nb_cols = nc;
+   T.row_ptr.assign(n+1,0);
+   for (size_t i=0; i<n; ++i) {
+      if (agg[i]>=0) {
+         T.col_ind.push_back(agg[i]);
+         T.a.push_back(T_(1./sqrt(double(count[agg[i]]))));
+      }
+      T.row_ptr[i+1] = T.col_ind.size();
+   }
+
+   double omega = 4./(3.*SpectralRadius(A));
+   spmat<T_> S(A);
+   for (size_t i=0; i<n; ++i) {
+      T_ d = A.diag(i);
+      for (size_t k=S.row_ptr[i]; k<S.row_ptr[i+1]; ++k) {
+         S.a[k] = -omega*S.a[k]/d;
+         if (S.col_ind[k]==i)
+            S.a[k] += 1;
+      }
+   }
+   Multiply(S,T,P);
+}
+
+
+template<class T_>
+void amg<T_>::smooth(const spmat<T_>&  A,
+                     vector<T_>&       x,
+                     const vector<T_>& b,
+                     bool              forward) const
+{
+   size_t n = A.size();
+   for (size_t ii=0; ii<n; ++ii) {
+      size_t i = forward ? ii : n-1-ii;
+      T_ s = b[i], d = 0;
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j==i)
+            d = A.a[k];
+         else
+            s -= A.a[k]*x[j];
+      }
+      x[i] = s/d;
+   }
+}
+
+
+template<class T_>
+void amg<T_>::cycle(size_t l) const
+{
+   const Level &L = _level[l];
+   if (l==_level.size()-1) {
+      _lu.solve(L.x,L.b);
+      return;
+   }
+   std::fill(L.x.begin(),L.x.end(),T_(0));
+   for (int i=0; i<_nu; ++i)
+      smooth(L.A,L.x,L.b,true);
+   L.A.mult(L.x.data(),L.r.data());
+   for (size_t i=0; i<L.r.size(); ++i)
+      L.r[i] = L.b[i] - L.r[i];
+   const Level &C = _level[l+1];
+   L.R.mult(L.r.data(),C.b.data());
+   cycle(l+1);
+   L.P.mult(C.x.data(),L.r.data());
+   for (size_t i=0; i<L.x.size(); ++i)
+      L.x[i] += L.r[i];
+   for (int i=0; i<_nu; ++i)
+      smooth(L.A,L.x,L.b,false);
+}
+
+
+template<class T_>
+void amg<T_>::solve(const vector<T_>& r,
+                    vector<T_>&       z) const
+{
+   _level[0].b = r;
+   cycle(0);
+   z = _level[0].x;
+}
+
+
+template<class T_>
+void amg<T_>::print(std::ostream& s) const
+{
+   size_t nnz = 0, n = 0;
+   s << "AMG hierarchy: " << _level.size() << " levels" << endl;
+   for (size_t l=0; l<_level.size(); ++l) {
+      s << "   Level " << l << ": " << _level[l].A.size() << " unknowns, "
+        << _level[l].A.nnz() << " nonzeros" << endl;
+      nnz += _level[l].A.nnz();
+      n += _level[l].A.size();
+   }
+   s << "   Grid complexity: " << double(n)/_level[0].A.size()
+     << ", Operator complexity: " << double(nnz)/_level[0].A.nnz() << endl;
+}
+
+template class amg<double>;
+template class amg<float>;
+
+} /* namespace RITA */
@@ -0,0 +1,77 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                            Definition of class 'amg'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include "linearSolver.h"
+
+namespace RITA {
+
+/*
+ * Smoothed aggregation algebraic multigrid preconditioner.
+ * setup() builds the hierarchy of Galerkin operators A_{l+1} = P_l^T A_l P_l,
+ * solve() applies one V-cycle with symmetric Gauss-Seidel smoothing, which
+ * keeps the preconditioner symmetric and usable with CG.
+ */
+template<class T_>
+class amg : public precond<T_>
+{
+
+ public:
+
+    amg();
+    ~amg() { }
+    void setThreshold(double theta) { _theta = theta; }
+    void setCoarseSize(size_t n) { _coarse_size = n; }
+    void setMaxLevels(int n) { _max_levels = n; }
+    void setSweeps(int nu) { _nu = nu; }
+    int setup(const spmat<T_>& A);
+    void solve(const vector<T_>& r, vector<T_>& z) const;
+    void print(std::ostream& s) const;
+    int getNbLevels() const { return int(_level.size()); }
+
+ private:
+
+    struct Level {
+       spmat<T_> A, P, R;
+       mutable vector<T_> x, b, r;
+    };
+
+    double _theta;
+    size_t _coarse_size;
+    int _max_levels, _nu;
+    vector<Level> _level;
+    denseLU<T_> _lu;
+
+    size_t aggregate(const spmat<T_>& A, vector<long>& agg) const;
+    void prolongation(const spmat<T_>& A, const vector<long>& agg, size_t nc, spmat<T_>& P) const;
+    void smooth(const spmat<T_>& A, vector<T_>& x, const vector<T_>& b, bool forward) const;
+    void cycle(size_t l) const;
+};
+
+} /* namespace RITA */
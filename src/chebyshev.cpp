@@ -0,0 +1,124 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Implementation of class 'chebyshev'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include <algorithm>
+#include "chebyshev.h"
+#include "parallel.h"
+
+using std::endl;
+
+namespace RITA {
+
+template<class T_>
+chebyshev<T_>::chebyshev(int    degree,
+                         double ratio)
+              : _degree(degree), _ratio(ratio), _lmax(1.)
+{
+}
+
+
+template<class T_>
+int chebyshev<T_>::setup(const spmat<T_>& A)
+{
+   size_t n = A.size();
+   vector<T_> d(n);
+   double lmax = 0.;
+   for (size_t i=0; i<n; ++i) {
+      double s = 0.;
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k)
+         s += fabs(A.a[k]);
+      d[i] = A.diag(i);
+      if (d[i]!=T_(0))
+         lmax = std::max(lmax,s/fabs(d[i]));
+   }
+   set([&A](const T_* x, T_* y) { A.mult(x,y); },d,lmax);
+   return 0;
+}
+
+
+template<class T_>
+void chebyshev<T_>::set(Operator          A,
+                        const vector<T_>& d,
+                        double            lmax)
+{
+   _A = A;
+   _lmax = lmax;
+   size_t n = d.size();
+   _dinv.resize(n);
+   for (size_t i=0; i<n; ++i)
+      _dinv[i] = (d[i]!=T_(0)) ? T_(1)/d[i] : T_(1);
+   _d.resize(n);
+   _q.resize(n);
+}
+
+
+template<class T_>
+void chebyshev<T_>::solve(const vector<T_>& r,
+                          vector<T_>&       z) const
+{
+   size_t n = r.size();
+   double lmin = _lmax/_ratio, theta = 0.5*(_lmax+lmin), delta = 0.5*(_lmax-lmin);
+   double sigma = theta/delta, rho = 1./sigma;
+   z.assign(n,T_(0));
+   T_ c = T_(1./theta);
+   parallelFor(n,[&](size_t b, size_t e) {
+      for (size_t i=b; i<e; ++i)
+         _d[i] = c*_dinv[i]*r[i];
+   });
+   for (int k=1; k<=_degree; ++k) {
+      parallelFor(n,[&](size_t b, size_t e) {
+         for (size_t i=b; i<e; ++i)
+            z[i] += _d[i];
+      });
+      if (k==_degree)
+         break;
+      _A(z.data(),_q.data());
+      double rho1 = 1./(2.*sigma-rho);
+      T_ c1 = T_(rho1*rho), c2 = T_(2.*rho1/delta);
+      parallelFor(n,[&](size_t b, size_t e) {
+         for (size_t i=b; i<e; ++i)
+            _d[i] = c1*_d[i] + c2*_dinv[i]*(r[i]-_q[i]);
+      });
+      rho = rho1;
+   }
+}
+
+
+template<class T_>
+void chebyshev<T_>::print(std::ostream& s) const
+{
+   s << "Chebyshev preconditioner of degree " << _degree << ", spectrum bound of D^{-1}A: "
+     << _lmax << endl;
+}
+
+template class chebyshev<double>;
+template class chebyshev<float>;
+
+} /* namespace RITA */
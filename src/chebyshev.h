@@ -0,0 +1,69 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                         Definition of class 'chebyshev'
+
+  ==============================================================================*/
+
+
+#pragma once
+
+#include <functional>
+#include "linearSolver.h"
+
+namespace RITA {
+
+/*
+ * Chebyshev polynomial preconditioner: z = p(D^{-1}A) D^{-1} r, where p of
+ * degree k-1 is the Chebyshev approximation of 1/x on [lmax/ratio,lmax].
+ * lmax is a Gershgorin bound, which keeps the preconditioner symmetric
+ * positive definite. Only matrix-vector products and vector operations are
+ * used, so that it applies to matrix-free operators as well (see set()).
+ * Degree 1 gives the Jacobi (diag) preconditioner.
+ */
+template<class T_>
+class chebyshev : public precond<T_>
+{
+
+ public:
+
+    typedef std::function<void(const T_*,T_*)> Operator;
+
+    chebyshev(int degree=4, double ratio=30.);
+    ~chebyshev() { }
+    int setup(const spmat<T_>& A);
+    void set(Operator A, const vector<T_>& d, double lmax);
+    void solve(const vector<T_>& r, vector<T_>& z) const;
+    void print(std::ostream& s) const;
+
+ private:
+
+    int _degree;
+    double _ratio, _lmax;
+    Operator _A;
+    vector<T_> _dinv;
+    mutable vector<T_> _d, _q;
+};
+
+} /* namespace RITA */
@@ -0,0 +1,661 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Implementation of class 'cholesky'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "cholesky.h"
+
+using std::cout;
+using std::endl;
+
+namespace RITA {
+
+static const size_t none = size_t(-1);
+
+template<class T_>
+static inline T_ Dot(const T_* x,
+                     const T_* y,
+                     size_t    n)
+{
+   T_ s0=0, s1=0, s2=0, s3=0;
+   size_t k = 0;
+   for (; k+4<=n; k+=4) {
+      s0 += x[k  ]*y[k  ];
+      s1 += x[k+1]*y[k+1];
+      s2 += x[k+2]*y[k+2];
+      s3 += x[k+3]*y[k+3];
+   }
+   for (; k<n; ++k)
+      s0 += x[k]*y[k];
+   return (s0+s1) + (s2+s3);
+}
+
+
+/*
+ * Nested dissection ordering of the graph (xadj,adj): a connected set of
+ * vertices is split by one level of the breadth-first level structure rooted
+ * at a pseudo-peripheral vertex, chosen to balance the two parts; vertices of
+ * the separator that are not adjacent to the second part are moved to the
+ * first one. Both parts are numbered first, the separator last. Sets of less
+ * than 64 vertices are numbered in reverse breadth-first order.
+ * perm[i] is the vertex numbered i.
+ */
+static void Dissection(const vector<size_t>& xadj,
+                       const vector<size_t>& adj,
+                       vector<size_t>&       perm)
+{
+   const size_t leaf = 64;
+   size_t n = xadj.size() - 1, tag = 0, stamp = 0;
+   vector<size_t> set(n), owner(n,none), seen(n,none), level(n), q, comp;
+   perm.resize(n);
+   for (size_t i=0; i<n; ++i)
+      set[i] = i;
+
+// Breadth-first search from r in the current set, appends the vertices to q
+   auto bfs = [&](size_t r, vector<size_t>& q) {
+      size_t h = q.size();
+      q.push_back(r);
+      seen[r] = ++stamp;
+      level[r] = 0;
+      for (; h<q.size(); ++h) {
+         size_t v = q[h];
+         for (size_t k=xadj[v]; k<xadj[v+1]; ++k) {
+            size_t w = adj[k];
+            if (owner[w]==tag && seen[w]!=stamp) {
+               seen[w] = stamp;
+               level[w] = level[v] + 1;
+               q.push_back(w);
+            }
+         }
+      }
+   };
+
+   vector<std::pair<size_t,size_t> > stack {{0,n}};
+   while (stack.size()) {
+      size_t b = stack.back().first, e = stack.back().second, m = e - b;
+      stack.pop_back();
+      tag++;
+      for (size_t k=b; k<e; ++k)
+         owner[set[k]] = tag;
+
+//    Small sets
+      if (m<=leaf) {
+         q.clear();
+         for (size_t k=b; k<e; ++k) {
+            size_t v = set[k];
+            if (owner[v]==tag) {
+               size_t h = q.size();
+               bfs(v,q);
+               for (size_t i=h; i<q.size(); ++i)
+                  owner[q[i]] = none;
+            }
+         }
+         for (size_t k=0; k<m; ++k)
+            perm[e-1-k] = q[k];
+         continue;
+      }
+
+//    Connected components are numbered separately
+      q.clear();
+      bfs(set[b],q);
+      if (q.size()<m) {
+         comp.clear();
+         vector<size_t> cb;
+         for (size_t k=b; k<e; ++k) {
+            size_t v = set[k];
+            if (owner[v]==tag) {
+               cb.push_back(comp.size());
+               q.clear();
+               bfs(v,q);
+               for (auto const& w: q)
+                  owner[w] = none, comp.push_back(w);
+            }
+         }
+         cb.push_back(m);
+         std::copy(comp.begin(),comp.end(),set.begin()+b);
+         for (size_t c=0; c+1<cb.size(); ++c)
+            stack.push_back(std::make_pair(b+cb[c],b+cb[c+1]));
+         continue;
+      }
+
+//    Pseudo-peripheral vertex
+      size_t nlev = level[q.back()] + 1;
+      for (int it=0; it<5; ++it) {
+         size_t r = q.back();
+         q.clear();
+         bfs(r,q);
+         size_t nl = level[q.back()] + 1;
+         if (nl<=nlev)
+            break;
+         nlev = nl;
+      }
+      nlev = level[q.back()] + 1;
+      if (nlev<3) {
+         for (size_t k=0; k<m; ++k)
+            perm[e-1-k] = q[k];
+         continue;
+      }
+
+//    Separator level
+      size_t sep = std::min(std::max(level[q[m/2]],size_t(1)),nlev-2);
+      for (auto const& v: q) {
+         if (level[v]!=sep)
+            continue;
+         bool adj2 = false;
+         for (size_t k=xadj[v]; k<xadj[v+1] && !adj2; ++k)
+            adj2 = (owner[adj[k]]==tag && level[adj[k]]==sep+1);
+         if (!adj2)
+            level[v] = sep - 1;
+      }
+      size_t k1=b, k2=b, ns=0;
+      for (auto const& v: q)
+         k2 += (level[v]<sep);
+      size_t m1 = k2 - b;
+      for (auto const& v: q) {
+         if (level[v]<sep)
+            set[k1++] = v;
+         else if (level[v]>sep)
+            set[k2++] = v;
+         else
+            perm[e-1-ns++] = v;
+      }
+      stack.push_back(std::make_pair(b,b+m1));
+      stack.push_back(std::make_pair(b+m1,e-ns));
+   }
+}
+
+
+template<class T_>
+cholesky<T_>::cholesky(bool ldlt)
+             : _ldlt(ldlt), _reused(false), _n(0), _nb_tiny(0), _max_sn(0), _flops(0.), _anorm(0.)
+{
+}
+
+
+/*
+ * The symbolic analysis is kept if the pattern of A has not changed
+ */
+template<class T_>
+int cholesky<T_>::setup(const spmat<T_>& A)
+{
+   _reused = (_n==A.size() && _pat_ptr==A.row_ptr && _pat_ind==A.col_ind);
+   if (!_reused)
+      analyze(A);
+   return factor(A);
+}
+
+
+/*
+ * Symbolic phase: ordering, elimination tree (in postorder), column counts,
+ * relaxed supernodes, row structure of the supernodes and positions of the
+ * entries of A in the factor
+ */
+template<class T_>
+void cholesky<T_>::analyze(const spmat<T_>& A)
+{
+   size_t n = _n = A.size();
+   _pat_ptr = A.row_ptr;
+   _pat_ind = A.col_ind;
+
+// Graph of A + A^T
+   vector<size_t> xadj(n+1,0), adj, pos;
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j!=i)
+            xadj[i+1]++, xadj[j+1]++;
+      }
+   }
+   for (size_t i=0; i<n; ++i)
+      xadj[i+1] += xadj[i];
+   adj.resize(xadj[n]);
+   pos.assign(xadj.begin(),xadj.end()-1);
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j!=i)
+            adj[pos[i]++] = j, adj[pos[j]++] = i;
+      }
+   }
+   size_t l = 0;
+   for (size_t i=0; i<n; ++i) {
+      size_t b = xadj[i], e = xadj[i+1];
+      std::sort(adj.begin()+b,adj.begin()+e);
+      xadj[i] = l;
+      for (size_t k=b; k<e; ++k)
+         if (k==b || adj[k]!=adj[k-1])
+            adj[l++] = adj[k];
+   }
+   xadj[n] = l;
+   adj.resize(l);
+
+// Nested dissection ordering and elimination tree
+   vector<size_t> perm, ip(n), parent(n,none), anc(n,none);
+   Dissection(xadj,adj,perm);
+   for (size_t i=0; i<n; ++i)
+      ip[perm[i]] = i;
+   for (size_t k=0; k<n; ++k) {
+      size_t v = perm[k];
+      for (size_t m=xadj[v]; m<xadj[v+1]; ++m) {
+         for (size_t i=ip[adj[m]]; i!=none && i<k;) {
+            size_t t = anc[i];
+            anc[i] = k;
+            if (t==none)
+               parent[i] = k;
+            i = t;
+         }
+      }
+   }
+
+// Postorder of the tree, the factor has the same fill
+   vector<size_t> head(n,none), next(n,none), post, stack;
+   for (size_t k=n; k-->0;) {
+      if (parent[k]!=none) {
+         next[k] = head[parent[k]];
+         head[parent[k]] = k;
+      }
+   }
+   post.reserve(n);
+   for (size_t r=0; r<n; ++r) {
+      if (parent[r]!=none)
+         continue;
+      stack.push_back(r);
+      while (stack.size()) {
+         size_t v = stack.back();
+         if (head[v]!=none) {
+            size_t c = head[v];
+            head[v] = next[c];
+            stack.push_back(c);
+         }
+         else {
+            post.push_back(v);
+            stack.pop_back();
+         }
+      }
+   }
+   _perm.resize(n);
+   for (size_t k=0; k<n; ++k)
+      _perm[k] = perm[post[k]], pos[post[k]] = k;
+   vector<size_t> par(n,none), nchild(n,0);
+   for (size_t k=0; k<n; ++k) {
+      if (parent[post[k]]!=none) {
+         par[k] = pos[parent[post[k]]];
+         nchild[par[k]]++;
+      }
+   }
+   for (size_t k=0; k<n; ++k)
+      ip[_perm[k]] = k;
+
+// Column counts of L (diagonal included) by row subtrees
+   vector<size_t> cc(n,1), mark(n,none);
+   for (size_t i=0; i<n; ++i) {
+      mark[i] = i;
+      size_t v = _perm[i];
+      for (size_t m=xadj[v]; m<xadj[v+1]; ++m) {
+         for (size_t j=ip[adj[m]]; j<i && mark[j]!=i; j=par[j]) {
+            cc[j]++;
+            mark[j] = i;
+         }
+      }
+   }
+   _flops = 0.;
+   for (size_t j=0; j<n; ++j)
+      _flops += double(cc[j])*double(cc[j]);
+
+// Relaxed supernodes: a column is merged with the previous ones if it is
+// their parent and the number of zeros stored is small
+   _sn_ptr.assign(1,0);
+   double sum = double(cc[0]);
+   for (size_t j=1; j<n; ++j) {
+      bool merge = false;
+      if (par[j-1]==j) {
+         double w = double(j-_sn_ptr.back()+1);
+         double total = 0.5*w*(w-1.) + w*cc[j];
+         double zeros = total - sum - cc[j];
+         merge = (zeros==0. || w<=4. || (w<=16. && zeros<0.8*total) ||
+                  (w<=48. && zeros<0.1*total) || zeros<0.05*total);
+      }
+      if (merge)
+         sum += cc[j];
+      else
+         _sn_ptr.push_back(j), sum = double(cc[j]);
+   }
+   _sn_ptr.push_back(n);
+   size_t nsn = _sn_ptr.size() - 1;
+   _sn_of.resize(n);
+   _max_sn = 0;
+   for (size_t s=0; s<nsn; ++s) {
+      _max_sn = std::max(_max_sn,_sn_ptr[s+1]-_sn_ptr[s]);
+      for (size_t j=_sn_ptr[s]; j<_sn_ptr[s+1]; ++j)
+         _sn_of[j] = s;
+   }
+
+// Row structure of supernodes: columns of the supernode, then the rows of
+// A and of its children below them
+   vector<size_t> shead(nsn,none), snext(nsn,none);
+   for (size_t s=nsn; s-->0;) {
+      size_t p = par[_sn_ptr[s+1]-1];
+      if (p!=none) {
+         snext[s] = shead[_sn_of[p]];
+         shead[_sn_of[p]] = s;
+      }
+   }
+   _rptr.assign(1,0);
+   _lptr.assign(1,0);
+   _rind.clear();
+   std::fill(mark.begin(),mark.end(),none);
+   vector<size_t> rows;
+   for (size_t s=0; s<nsn; ++s) {
+      size_t f = _sn_ptr[s], l = _sn_ptr[s+1] - 1;
+      rows.clear();
+      for (size_t j=f; j<=l; ++j) {
+         size_t v = _perm[j];
+         for (size_t m=xadj[v]; m<xadj[v+1]; ++m) {
+            size_t i = ip[adj[m]];
+            if (i>l && mark[i]!=s)
+               mark[i] = s, rows.push_back(i);
+         }
+      }
+      for (size_t c=shead[s]; c!=none; c=snext[c]) {
+         for (size_t k=_rptr[c]; k<_rptr[c+1]; ++k) {
+            size_t i = _rind[k];
+            if (i>l && mark[i]!=s)
+               mark[i] = s, rows.push_back(i);
+         }
+      }
+      std::sort(rows.begin(),rows.end());
+      for (size_t j=f; j<=l; ++j)
+         _rind.push_back(unsigned(j));
+      for (auto const& i: rows)
+         _rind.push_back(unsigned(i));
+      _rptr.push_back(_rind.size());
+      _lptr.push_back(_lptr.back()+(l-f+1)*(_rptr[s+1]-_rptr[s]));
+   }
+
+// Position in L of each entry of A (lower triangle, or its transpose)
+   _amap.resize(A.nnz());
+   _lower.resize(A.nnz());
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t r=ip[i], c=ip[A.col_ind[k]];
+         _lower[k] = (r>=c);
+         if (r<c)
+            std::swap(r,c);
+         size_t s = _sn_of[c];
+         const unsigned *b=&_rind[_rptr[s]], *e=&_rind[0]+_rptr[s+1];
+         size_t lr = std::lower_bound(b,e,unsigned(r)) - b;
+         _amap[k] = _lptr[s] + lr*(_sn_ptr[s+1]-_sn_ptr[s]) + c - _sn_ptr[s];
+      }
+   }
+}
+
+
+/*
+ * Numeric phase (left-looking): supernode s receives the updates of the
+ * supernodes d having rows in its columns. Each d is kept in the list of the
+ * next supernode it updates.
+ */
+template<class T_>
+int cholesky<T_>::factor(const spmat<T_>& A)
+{
+   size_t n=_n, nsn=_sn_ptr.size()-1;
+   _L.assign(_lptr[nsn],T_(0));
+   _d.assign(n,T_(0));
+   _anorm = 0.;
+   _nb_tiny = 0;
+   for (size_t k=0; k<A.nnz(); ++k) {
+      if (_lower[k]) {
+         _L[_amap[k]] = A.a[k];
+         _anorm = std::max(_anorm,double(std::abs(A.a[k])));
+      }
+   }
+   double eps = sqrt(double(std::numeric_limits<T_>::epsilon()));
+   for (size_t k=0; k<A.nnz(); ++k) {
+      if (!_lower[k] && std::abs(double(_L[_amap[k]])-double(A.a[k]))>eps*_anorm) {
+         cout << "Error: Matrix is not symmetric, it cannot be factored as L D L^T." << endl;
+         return 1;
+      }
+   }
+
+   vector<size_t> map(n), head(nsn,none), next(nsn,none), pos(nsn);
+   for (size_t s=0; s<nsn; ++s) {
+      size_t nc=_sn_ptr[s+1]-_sn_ptr[s], nr=_rptr[s+1]-_rptr[s], l=_sn_ptr[s+1]-1;
+      const unsigned *R = &_rind[_rptr[s]];
+      for (size_t r=0; r<nr; ++r)
+         map[R[r]] = r;
+      for (size_t d=head[s]; d!=none;) {
+         size_t dn=next[d], nrd=_rptr[d+1]-_rptr[d], p1=pos[d], p2=p1;
+         const unsigned *Rd = &_rind[_rptr[d]];
+         while (p2<nrd && Rd[p2]<=l)
+            p2++;
+         update(s,d,p1,p2,map);
+         pos[d] = p2;
+         if (p2<nrd) {
+            size_t t = _sn_of[Rd[p2]];
+            next[d] = head[t];
+            head[t] = d;
+         }
+         d = dn;
+      }
+      if (factorPanel(s))
+         return 1;
+      if (nr>nc) {
+         size_t t = _sn_of[R[nc]];
+         pos[s] = nc;
+         next[s] = head[t];
+         head[t] = s;
+      }
+   }
+   return 0;
+}
+
+
+/*
+ * Update of supernode s by the rows p1:p2-1 (columns of s) and below of
+ * supernode d: L_s -= L_d(p1:,:) D_d L_d(p1:p2-1,:)^T. The product is computed
+ * by blocks of columns that fit in cache, rows being split among threads.
+ */
+template<class T_>
+void cholesky<T_>::update(size_t                s,
+                          size_t                d,
+                          size_t                p1,
+                          size_t                p2,
+                          const vector<size_t>& map)
+{
+   size_t ncd=_sn_ptr[d+1]-_sn_ptr[d], nrd=_rptr[d+1]-_rptr[d], fs=_sn_ptr[s];
+   size_t ncs=_sn_ptr[s+1]-fs, q=p2-p1;
+   const unsigned *Rd = &_rind[_rptr[d]];
+   const T_ *Ld=&_L[_lptr[d]], *Dd=&_d[_sn_ptr[d]];
+   T_ *Ls = &_L[_lptr[s]];
+   vector<T_> w(q*ncd);
+   for (size_t j=0; j<q; ++j)
+      for (size_t k=0; k<ncd; ++k)
+         w[j*ncd+k] = Ld[(p1+j)*ncd+k]*Dd[k];
+   size_t bs = std::max(size_t(8),size_t(16384)/ncd);
+   size_t min_rows = std::max(size_t(16),size_t(1<<16)/(q*ncd+1));
+   parallelFor(nrd-p1,[&](size_t b, size_t e) {
+      for (size_t j0=0; j0<q; j0+=bs) {
+         size_t j1 = std::min(q,j0+bs);
+         for (size_t i=p1+std::max(b,j0); i<p1+e; ++i) {
+            const T_ *li = Ld + i*ncd;
+            T_ *ti = Ls + map[Rd[i]]*ncs;
+            size_t je = std::min(j1,i-p1+1);
+            for (size_t j=j0; j<je; ++j)
+               ti[Rd[p1+j]-fs] -= Dot(li,&w[j*ncd],ncd);
+         }
+      }
+   },min_rows);
+}
+
+
+/*
+ * Dense L D L^T factorization of supernode s, by blocks of bs columns J:
+ * rows below the first column of J are first updated by the previous columns
+ * (dense product, rows split among threads), then the diagonal block of J is
+ * factored (row oriented Crout variant) and the rows below it are solved.
+ */
+template<class T_>
+int cholesky<T_>::factorPanel(size_t s)
+{
+   const size_t bs = 64;
+   size_t f=_sn_ptr[s], nc=_sn_ptr[s+1]-f, nr=_rptr[s+1]-_rptr[s];
+   T_ *P=&_L[_lptr[s]], *D=&_d[f];
+   T_ tiny = T_(sqrt(double(std::numeric_limits<T_>::epsilon()))*_anorm);
+   if (tiny==T_(0))
+      tiny = std::numeric_limits<T_>::min();
+   vector<T_> w;
+   for (size_t c0=0; c0<nc; c0+=bs) {
+      size_t c1 = std::min(nc,c0+bs), nb = c1 - c0;
+
+//    Update by the columns 0:c0-1
+      if (c0>0) {
+         w.resize(nb*c0);
+         for (size_t j=0; j<nb; ++j)
+            for (size_t k=0; k<c0; ++k)
+               w[j*c0+k] = P[(c0+j)*nc+k]*D[k];
+         parallelFor(nr-c0,[&](size_t b, size_t e) {
+            for (size_t i=c0+b; i<c0+e; ++i) {
+               T_ *li = P + i*nc;
+               size_t je = std::min(nb,i-c0+1);
+               for (size_t j=0; j<je; ++j)
+                  li[c0+j] -= Dot(li,&w[j*c0],c0);
+            }
+         },std::max(size_t(16),size_t(1<<16)/(nb*c0+1)));
+      }
+
+//    Diagonal block
+      for (size_t i=c0; i<c1; ++i) {
+         T_ *li = P + i*nc;
+         for (size_t j=c0; j<i; ++j)
+            li[j] -= Dot(li+c0,P+j*nc+c0,j-c0);
+         T_ di = li[i];
+         for (size_t k=c0; k<i; ++k) {
+            T_ lik = li[k]/D[k];
+            di -= lik*li[k];
+            li[k] = lik;
+         }
+         if (!_ldlt && !(di>T_(0))) {
+            cout << "Error: Matrix is not positive definite (pivot " << di << " at row " << f+i
+                 << "), use the ldlt factorization." << endl;
+            return 1;
+         }
+         if (std::abs(di)<tiny) {
+            di = (di<T_(0)) ? -tiny : tiny;
+            _nb_tiny++;
+         }
+         D[i] = di;
+      }
+
+//    Rows below the diagonal block
+      parallelFor(nr-c1,[&](size_t b, size_t e) {
+         for (size_t i=c1+b; i<c1+e; ++i) {
+            T_ *li = P + i*nc;
+            for (size_t j=c0; j<c1; ++j)
+               li[j] -= Dot(li+c0,P+j*nc+c0,j-c0);
+            for (size_t k=c0; k<c1; ++k)
+               li[k] /= D[k];
+         }
+      },std::max(size_t(16),size_t(1<<16)/(nb*nb+1)));
+   }
+   return 0;
+}
+
+
+/*
+ * z = P^T L^{-T} D^{-1} L^{-1} P r
+ */
+template<class T_>
+void cholesky<T_>::solve(const vector<T_>& r,
+                         vector<T_>&       z) const
+{
+   size_t n=_n, nsn=_sn_ptr.size()-1;
+   _y.resize(n);
+   z.resize(n);
+   for (size_t k=0; k<n; ++k)
+      _y[k] = r[_perm[k]];
+   T_ *y = _y.data();
+   for (size_t s=0; s<nsn; ++s) {
+      size_t f=_sn_ptr[s], nc=_sn_ptr[s+1]-f, nr=_rptr[s+1]-_rptr[s];
+      const T_ *P = &_L[_lptr[s]];
+      const unsigned *R = &_rind[_rptr[s]];
+      for (size_t i=0; i<nc; ++i)
+         y[f+i] -= Dot(P+i*nc,y+f,i);
+      parallelFor(nr-nc,[&](size_t b, size_t e) {
+         for (size_t i=nc+b; i<nc+e; ++i)
+            y[R[i]] -= Dot(P+i*nc,y+f,nc);
+      },std::max(size_t(64),size_t(1<<16)/(nc+1)));
+   }
+   for (size_t i=0; i<n; ++i)
+      y[i] /= _d[i];
+   for (size_t s=nsn; s-->0;) {
+      size_t f=_sn_ptr[s], nc=_sn_ptr[s+1]-f, nr=_rptr[s+1]-_rptr[s];
+      const T_ *P = &_L[_lptr[s]];
+      const unsigned *R = &_rind[_rptr[s]];
+      parallelFor(nc,[&](size_t b, size_t e) {
+         for (size_t i=nc; i<nr; ++i) {
+            T_ yi = y[R[i]];
+            for (size_t k=b; k<e; ++k)
+               y[f+k] -= P[i*nc+k]*yi;
+         }
+      },std::max(size_t(64),size_t(1<<16)/(nr-nc+1)));
+      for (size_t i=nc; i-->0;) {
+         T_ yi = y[f+i];
+         for (size_t k=0; k<i; ++k)
+            y[f+k] -= P[i*nc+k]*yi;
+      }
+   }
+   for (size_t k=0; k<n; ++k)
+      z[_perm[k]] = y[k];
+}
+
+
+template<class T_>
+void cholesky<T_>::print(std::ostream& s) const
+{
+   size_t nsn=_sn_ptr.size()-1, nnz=0;
+   for (size_t k=0; k<nsn; ++k) {
+      size_t nc = _sn_ptr[k+1] - _sn_ptr[k];
+      nnz += nc*(_rptr[k+1]-_rptr[k]) - nc*(nc-1)/2;
+   }
+   s << "Supernodal " << (_ldlt ? "LDLT" : "Cholesky") << " factorization: " << _n << " unknowns, "
+     << nsn << " supernodes (largest: " << _max_sn << " columns), " << nnz << " nonzeros in L, "
+     << _flops*1.e-6 << " Mflop";
+   if (_reused)
+      s << " (symbolic analysis reused)";
+   s << endl;
+   if (_nb_tiny)
+      s << "Warning: " << _nb_tiny << " tiny pivots were perturbed." << endl;
+}
+
+template class cholesky<double>;
+template class cholesky<float>;
+
+} /* namespace RITA */
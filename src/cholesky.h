@@ -0,0 +1,80 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                         Definition of class 'cholesky'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include "linearSolver.h"
+
+namespace RITA {
+
+/*
+ * Supernodal sparse factorization P A P^T = L D L^T of a symmetric matrix
+ * (L unit lower triangular), used as direct solver (ls direct cholesky|ldlt)
+ * or as exact preconditioner.
+ * The symbolic phase computes a nested dissection ordering of the graph of A,
+ * the elimination tree, and groups columns of L with the same structure
+ * (relaxed supernodes); it is done once and kept as long as the sparsity
+ * pattern of A does not change, so that repeated factorizations (e.g. time
+ * steps) only run the numeric phase. The numeric phase is left-looking: each
+ * supernode is stored as a dense block of rows, updated by dense blocked
+ * products with the supernodes of its subtree, then factored.
+ * With cholesky, A must be positive definite. With ldlt, pivots may be
+ * negative; tiny pivots are replaced by +/-sqrt(eps)|A| (static pivoting),
+ * the solution is then improved by iterative refinement.
+ */
+template<class T_>
+class cholesky : public precond<T_>
+{
+
+ public:
+
+    cholesky(bool ldlt=false);
+    ~cholesky() { }
+    int setup(const spmat<T_>& A);
+    void solve(const vector<T_>& r, vector<T_>& z) const;
+    void print(std::ostream& s) const;
+    size_t getNbPerturbedPivots() const { return _nb_tiny; }
+
+ private:
+
+    bool _ldlt, _reused;
+    size_t _n, _nb_tiny, _max_sn;
+    double _flops, _anorm;
+    vector<size_t> _pat_ptr, _perm, _sn_ptr, _sn_of, _rptr, _lptr, _amap;
+    vector<unsigned> _pat_ind, _rind;
+    vector<char> _lower;
+    vector<T_> _L, _d;
+    mutable vector<T_> _y;
+
+    void analyze(const spmat<T_>& A);
+    int factor(const spmat<T_>& A);
+    void update(size_t s, size_t d, size_t p1, size_t p2, const vector<size_t>& map);
+    int factorPanel(size_t s);
+};
+
+} /* namespace RITA */
@@ -27,11 +27,12 @@
   ==============================================================================*/
 
 #include "configure.h"
+#include "parallel.h"
 
 namespace RITA {
 
 configure::configure(rita *r, cmd *command)
-          : _rita(r), _verb(1), _save_results(1), _his_file(".rita.his"), _log_file(".rita.log"),
+          : _rita(r), _verb(1), _save_results(1), _threads(0), _mesh_cache(1), _his_file(".rita.his"), _log_file(".rita.log"),
             _cmd(command)
 {
    init();
@@ -53,6 +54,8 @@ void configure::save()
    _ocf << "save-results " << _save_results << endl;
    _ocf << "history-file " << _his_file << endl;
    _ocf << "log-file " << _log_file << endl;
+   _ocf << "threads " << _threads << endl;
+   _ocf << "mesh-cache " << _mesh_cache << endl;
    _ocf << "end" << endl;
    _ocf.close();
 }
@@ -106,12 +109,21 @@ int configure::read()
             break;
 
          case 4:
+            com.get(_threads);
+            setNbThreads(_threads);
+            break;
+
+         case 5:
+            com.get(_mesh_cache);
+            break;
+
+         case 6:
             _icf.close();
             return 0;
 
          default:
             _rita->msg("set>:","Unknown setting: "+com.token(),
-                       "Available settings: verbosity, save-results, history, log, end");
+                       "Available settings: verbosity, save-results, history, log, threads, mesh-cache, end");
             return 1;
       }
    }
@@ -121,7 +133,7 @@ int configure::read()
 
 int configure::run()
 {
-   bool verb_ok=false, hist_ok=false, log_ok=false, save_ok=false;
+   bool verb_ok=false, hist_ok=false, log_ok=false, save_ok=false, threads_ok=false, cache_ok=false;
    string hfile, lfile, buffer;
    ifstream is;
    _cmd->set(_kw);
@@ -153,9 +165,19 @@ int configure::run()
             _log_file = _cmd->string_token();
             break;
 
+         case 4:
+            _threads = _cmd->int_token();
+            threads_ok = true;
+            break;
+
+         case 5:
+            _mesh_cache = _cmd->int_token();
+            cache_ok = true;
+            break;
+
          default:
             _rita->msg("set>","Unknown setting: "+_cmd->token(),
-                       "Available settings: verbosity, save-results, history, log");
+                       "Available settings: verbosity, save-results, history, log, threads, mesh-cache");
             return 1;
        }
    }
@@ -175,6 +197,16 @@ int configure::run()
          }
          _ofh << " save-results=" << _save_results;
       }
+      if (threads_ok) {
+         if (_threads<0) {
+            _rita->msg("set>","Illegal number of threads: "+to_string(_threads));
+            return 1;
+         }
+         setNbThreads(_threads);
+         _ofh << " threads=" << _threads;
+      }
+      if (cache_ok)
+         _ofh << " mesh-cache=" << _mesh_cache;
       if (hist_ok) {
          _ofh.close();
          is.open(hfile);
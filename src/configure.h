@@ -56,6 +56,7 @@ class configure
     std::ofstream* getOStreamLog() { return &_ofl; }
     std::ofstream* getOStreamHistory() { return &_ofh; }
     int getSaveResults() const { return _save_results; }
+    int getMeshCache() const { return _mesh_cache; }
     void set(cmd* command) { _cmd = command; }
     void set(string cf);
     int read();
@@ -75,11 +76,11 @@ class configure
     }
 
     rita *_rita;
-    int _verb, _ret, _key, _save_results;
+    int _verb, _ret, _key, _save_results, _threads, _mesh_cache;
     string _HOME, _his_file, _log_file;
     ofstream _ofh, _ofl, _ocf;
     ifstream _icf;
-    const vector<string> _kw {"verb$osity","save$-results","history$-file","log$-file","end"};
+    const vector<string> _kw {"verb$osity","save$-results","history$-file","log$-file","threads","mesh-cache","end"};
     cmd *_cmd;
 };
 
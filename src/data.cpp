@@ -30,7 +30,12 @@
 #include "configure.h"
 #include "rita.h"
 #include "linear_algebra/Matrix.h"
+#include "linear_algebra/DMatrix.h"
 #include "io/IOField.h"
+#include "denseEigen.h"
+#include "meshTransfer.h"
+#include <iomanip>
+#include <chrono>
 
 using std::cout;
 using std::endl;
@@ -67,10 +72,10 @@ data::~data()
       delete _theFct;
    if (_theTab_alloc)
       delete _theTab;
-   if (_theVector_alloc)
-      delete _theVector;
-   if (_theMatrix_alloc)
-      delete _theMatrix;
+   for (auto& v: theVector)
+      delete v;
+   for (auto& M: theMatrix)
+      delete M;
    if (_u_alloc)
       delete _u;
 }
@@ -152,10 +157,66 @@ int data::addMesh(OFELI::Mesh* ms,
 }
 
 
-int data::addField(string   name,
-                   dataSize s,
-                   int      n,
-                   int      nb_dof)
+/*
+ * Spatial index of the mesh ms for point location, built at the first
+ * request and kept until the mesh is deleted (see clearIndex) or changes
+ * (numbers of nodes and elements, coordinates of its first and last nodes)
+ */
+const spatialIndex& data::getIndex(OFELI::Mesh& ms)
+{
+   size_t nn=ms.getNbNodes(), ne=ms.getNbElements();
+   int dim = ms.getDim();
+   double sig = 0.;
+   if (nn>0) {
+      OFELI::Point<double> a=ms[1]->getCoord(), b=ms[nn]->getCoord();
+      sig = a.x + 2.*a.y + 3.*a.z + 5.*b.x + 7.*b.y + 11.*b.z;
+   }
+   auto it = _index.find(&ms);
+   if (it!=_index.end() && it->second.nb_nodes==nn && it->second.nb_elements==ne &&
+       it->second.signature==sig)
+      return it->second.index;
+
+   vector<double> coord(dim*nn);
+   vector<size_t> el_ptr(1,0), el_node;
+   for (size_t n=1; n<=nn; ++n) {
+      OFELI::Point<double> x = ms[n]->getCoord();
+      for (int a=0; a<dim; ++a)
+         coord[dim*(n-1)+a] = (a==0) ? x.x : ((a==1) ? x.y : x.z);
+   }
+   for (size_t e=1; e<=ne; ++e) {
+      OFELI::Element *el = ms.getPtrElement(e);
+      for (size_t i=1; i<=el->getNbNodes(); ++i)
+         el_node.push_back(el->getPtrNode(i)->n()-1);
+      el_ptr.push_back(el_node.size());
+   }
+   meshIndex &mi = _index[&ms];
+   mi.nb_nodes = nn;
+   mi.nb_elements = ne;
+   mi.signature = sig;
+   if (mi.index.set(dim,coord,el_ptr,el_node))
+      mi.index = spatialIndex();
+   else if (_verb>1)
+      cout << "Spatial index of mesh: " << mi.index.getNbCells() << " cells, "
+           << mi.index.getMemory()/1048576. << " MB" << endl;
+   return mi.index;
+}
+
+
+/*
+ * Removes the spatial index of the mesh ms, to be called before the mesh is
+ * deleted or changed: a new mesh may be allocated at the same address
+ */
+void data::clearIndex(const OFELI::Mesh* ms)
+{
+   _index.erase(ms);
+}
+
+
+int data::addField(string       name,
+                   dataSize     s,
+                   int          n,
+                   int          nb_dof,
+                   OFELI::Mesh* ms)
 {
    bool new_field = true;
    _ifield = _nb_fields;
@@ -196,14 +257,14 @@ int data::addField(string   name,
       return _ifield;
    }
    else if (wm) {
-      if (_rita->_theMesh==nullptr) {
+      if (ms==nullptr && _rita->_theMesh==nullptr) {
          _rita->msg("data>","No mesh data available.");
          _ret = -1;
          return _ret;
       }
    }
    if (s==NODES) {
-      _theMesh = _rita->_theMesh;
+      _theMesh = (ms!=nullptr) ? ms : _rita->_theMesh;
       if (_theMesh->getNbNodes()==0) {
          _rita->msg("data>","Mesh has no nodes");
          _ret = 1;
@@ -212,7 +273,7 @@ int data::addField(string   name,
       _nb_dof = nb_dof;
    }
    else if (s==ELEMENTS) {
-      _theMesh = _rita->_theMesh;
+      _theMesh = (ms!=nullptr) ? ms : _rita->_theMesh;
       if (_theMesh->getNbElements()==0) {
          _rita->msg("data>","Mesh has no elements.");
          _ret = 1;
@@ -221,7 +282,7 @@ int data::addField(string   name,
       _nb_dof = nb_dof;
    }
    else if (s==SIDES) {
-      _theMesh = _rita->_theMesh;
+      _theMesh = (ms!=nullptr) ? ms : _rita->_theMesh;
       if (_theMesh->getNbSides()==0) {
          _rita->msg("data>","Mesh has no sides");
          _ret = 1;
@@ -230,7 +291,7 @@ int data::addField(string   name,
       _nb_dof = nb_dof;
    }
    else if (s==EDGES) {
-      _theMesh = _rita->_theMesh;
+      _theMesh = (ms!=nullptr) ? ms : _rita->_theMesh;
       if (_theMesh->getNbEdges()==0) {
          _rita->msg("data>","Mesh has no edges");
          _ret = 1;
@@ -260,7 +321,8 @@ int data::run()
 {
    int key = 0;
    static const vector<string> kw {"help","?","set","grid","mesh","field","tab$ulation","func$tion",
-                                   "vect$or","matr$ix","clear","summary","end","<","quit","exit","EXIT"};
+                                   "vect$or","matr$ix","clear","summary","end","<","quit","exit","EXIT",
+                                   "eigen","svd","interp$olate"};
    *_rita->ofh << "data" << endl;
    while (1) {
       _cmd->readline("rita>data> ");
@@ -279,6 +341,9 @@ int data::run()
             cout << "function:   Define a function\n";
             cout << "vector:     Define a vector\n";
             cout << "matrix:     Define a matrix\n";
+            cout << "eigen:      Compute eigenvalues of a symmetric matrix\n";
+            cout << "svd:        Compute singular values of a matrix\n";
+            cout << "interpolate: Transfer a field from a mesh to another one\n";
             cout << "summary:    Summary of prescribed data\n";
             cout << "end or <:   go back to higher level" << endl;
             break;
@@ -339,12 +404,25 @@ int data::run()
             _ret = 200;
             return _ret;
 
+         case 17:
+            _ret = setDenseEigen(false);
+            break;
+
+         case 18:
+            _ret = setDenseEigen(true);
+            break;
+
+         case 19:
+            _ret = setInterpolation();
+            break;
+
          case -4:
             return 1;
 
          default:
             _rita->msg("data>","Unknown Command "+_cmd->token(),
-                       "Available commands: grid, mesh, field, tabulation, function, vector, matrix, summary\n"
+                       "Available commands: grid, mesh, field, tabulation, function, vector, matrix, eigen, svd,\n"
+                       "                    interpolate, summary\n"
                        "Global commands:    help, ?, set, <, end, quit, exit");
             break;
        }
@@ -523,8 +601,68 @@ int data::setVector()
 
 int data::setMatrix()
 {
-   string name="mat-"+to_string(_nb_matrices+1);
-   static const vector<string> kw {"name","storage","size","def$ine","set"};
+   int nb=0, nr=0, nc=0;
+   string name="mat-"+to_string(_nb_matrices+1), def="";
+   static const vector<string> kw {"name","size","def$ine"};
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   if (nb_args<=0) {
+      _rita->msg("data>matrix>","Error in command.","Available arguments: name, size, define.");
+      return 1;
+   }
+   for (int i=0; i<nb_args; ++i) {
+      int n = _cmd->getArgs(nb);
+      switch (n) {
+
+         case 0:
+            name = _cmd->string_token(0);
+            break;
+
+         case 1:
+            if (nb==0 || nb>2) {
+               _rita->msg("data>matrix>","Illegal number of arguments");
+               return 1;
+            }
+            nr = nc = _cmd->int_token(0);
+            if (nb>1)
+               nc = _cmd->int_token(1);
+            break;
+
+         case 2:
+            def = _cmd->string_token(0);
+            break;
+
+         default:
+            _rita->msg("data>matrix>","Unknown argument: "+kw[n]);
+            return 1;
+      }
+   }
+   if (nr<1 || nc<1) {
+      _rita->msg("data>matrix>","Matrix size must be positive.");
+      return 1;
+   }
+   if (find(matrix_name.begin(),matrix_name.end(),name)!=matrix_name.end()) {
+      _rita->msg("data>matrix>","Matrix "+name+" exists already.");
+      return 1;
+   }
+
+// Entries are given by an expression of the (1-based) indices i and j
+   _theMatrix = new OFELI::DMatrix<double>(nr,nc);
+   if (def!="") {
+      OFELI::Fct f(name,def,{"i","j"});
+      if (f.check()) {
+         _rita->msg("data>matrix>",f.getErrorMessage());
+         delete _theMatrix;
+         return 1;
+      }
+      for (int i=1; i<=nr; ++i)
+         for (int j=1; j<=nc; ++j)
+            _theMatrix->set(i,j,f(vector<double> {double(i),double(j)}));
+   }
+   *_rita->ofh << "  matrix  name=" << name << "  size=" << nr << "," << nc;
+   if (def!="")
+      *_rita->ofh << "  define=" << def;
+   *_rita->ofh << endl;
    theMatrix.push_back(_theMatrix);
    matrix_name.push_back(name);
    _nb_matrices++;
@@ -532,6 +670,284 @@ int data::setMatrix()
 }
 
 
+int data::setDenseEigen(bool svd)
+{
+   string name="", mod=svd ? "data>svd>" : "data>eigen>";
+   bool vectors = false;
+   static const vector<string> kw {"matrix","vec$tors"};
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   for (int i=0; i<nb_args; ++i) {
+      switch (_cmd->getArg()) {
+
+         case 0:
+            name = _cmd->string_token();
+            break;
+
+         case 1:
+            vectors = true;
+            break;
+
+         default:
+            _rita->msg(mod,"Unknown argument: "+_cmd->Arg(),"Available arguments: matrix, vectors.");
+            return 1;
+      }
+   }
+   *_rita->ofh << "  " << (svd ? "svd" : "eigen") << "  matrix=" << name;
+   if (vectors)
+      *_rita->ofh << "  vectors";
+   *_rita->ofh << endl;
+   return runDenseEigen(name,svd,vectors);
+}
+
+
+int data::runDenseEigen(const string& name,
+                        bool          svd,
+                        bool          vectors)
+{
+   string mod = svd ? "data>svd>" : "data>eigen>";
+   auto it = find(matrix_name.begin(),matrix_name.end(),name);
+   if (it==matrix_name.end()) {
+      _rita->msg(mod,"Unknown matrix: "+name);
+      return 1;
+   }
+   OFELI::Matrix<double> &M = *theMatrix[distance(matrix_name.begin(),it)];
+   size_t nr=M.getNbRows(), nc=M.getNbColumns();
+   if (!svd && nr!=nc) {
+      _rita->msg(mod,"Matrix "+name+" is not square.");
+      return 1;
+   }
+
+// Copy in column major order
+   vector<double> a(nr*nc);
+   for (size_t j=0; j<nc; ++j)
+      for (size_t i=0; i<nr; ++i)
+         a[j*nr+i] = M(i+1,j+1);
+   denseEigen es;
+   es.setVerbose(_verb);
+   int ret = svd ? es.svd(nr,nc,a.data(),vectors) : es.symmetric(nr,a.data(),vectors);
+   if (ret) {
+      _rita->msg(mod,"Failure of the dense "+string(svd ? "singular value" : "eigenvalue")+" solver.");
+      return 1;
+   }
+   const vector<double> &v = es.getValues();
+   size_t n = v.size();
+   cout << (svd ? "Singular values" : "Eigenvalues") << " of matrix " << name << ":" << endl;
+   for (size_t i=0; i<n; ++i) {
+      if (n>20 && i==10) {
+         cout << "   ..." << endl;
+         i = n - 10;
+      }
+      cout << std::setw(8) << i+1 << "  " << std::setprecision(10) << v[i] << endl;
+   }
+
+// Values are stored as vectors and eigenvectors as matrices of the data module
+   addVector(name+(svd ? "-sv" : "-ev"),v);
+   if (vectors) {
+      if (svd) {
+         addMatrix(name+"-U",nr,n,es.getLeftVectors());
+         addMatrix(name+"-V",nc,n,es.getVectors());
+      }
+      else
+         addMatrix(name+"-evec",nr,n,es.getVectors());
+   }
+   return 0;
+}
+
+
+/*
+ * Transfer of a field defined on the nodes or the elements of a mesh to
+ * another mesh: interpolation at the target nodes (nodal fields) or element
+ * centroids (element fields), or conservative L2 projection of an element
+ * field. Points are located with the spatial index of the source mesh.
+ */
+int data::setInterpolation()
+{
+   string fd="", from="", to="", name="", method="interpolation";
+   static const vector<string> kw {"field","from","to","name","method"};
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   for (int i=0; i<nb_args; ++i) {
+      switch (_cmd->getArg()) {
+
+         case 0:
+            fd = _cmd->string_token();
+            break;
+
+         case 1:
+            from = _cmd->string_token();
+            break;
+
+         case 2:
+            to = _cmd->string_token();
+            break;
+
+         case 3:
+            name = _cmd->string_token();
+            break;
+
+         case 4:
+            method = _cmd->string_token();
+            if (method!="interpolation" && method!="conservative") {
+               _rita->msg("data>interpolate>","Unknown method: "+method,
+                          "Available methods: interpolation, conservative.");
+               return 1;
+            }
+            break;
+
+         default:
+            _rita->msg("data>interpolate>","Unknown argument: "+_cmd->Arg(),
+                       "Available arguments: field, from, to, name, method.");
+            return 1;
+      }
+   }
+   if (fd=="" && _nb_fields==1)
+      fd = Field[0];
+   int k = checkField(fd);
+   if (k<0) {
+      _rita->msg("data>interpolate>",fd=="" ? string("No field given.") : "Unknown field: "+fd);
+      return 1;
+   }
+   dataSize st = FieldSizeType[k];
+   if (!u[k]->WithMesh() || (st!=NODES && st!=ELEMENTS)) {
+      _rita->msg("data>interpolate>","Field "+fd+" is not defined on the nodes or elements of a mesh.");
+      return 1;
+   }
+   if (st==NODES && method=="conservative") {
+      _rita->msg("data>interpolate>","Conservative transfer is only available for element fields.");
+      return 1;
+   }
+   OFELI::Mesh *src = &u[k]->getMesh();
+   int i1 = (from=="") ? int(std::find(theMesh.begin(),theMesh.end(),src)-theMesh.begin()) : checkMesh(from);
+   if (i1<0 || i1>=int(theMesh.size()) || theMesh[i1]!=src) {
+      _rita->msg("data>interpolate>",from=="" ? "Mesh of field "+fd+" is unknown." :
+                                                "Field "+fd+" is not defined on mesh "+from);
+      return 1;
+   }
+   int i2 = checkMesh(to);
+   if (i2<0) {
+      _rita->msg("data>interpolate>",to=="" ? string("No target mesh given.") : "Unknown mesh: "+to);
+      return 1;
+   }
+   OFELI::Mesh *dst = theMesh[i2];
+   if (dst->getDim()!=src->getDim()) {
+      _rita->msg("data>interpolate>","Meshes "+mesh_name[i1]+" and "+to+" have different dimensions.");
+      return 1;
+   }
+
+// Result in field name (default: fd_M2), never the field fd nor an unknown of a pde
+   if (name=="")
+      name = fd + "_" + mesh_name[i2];
+   if (name==fd) {
+      _rita->msg("data>interpolate>","Field "+fd+" cannot receive its own transfer.",
+                 "Give another name with name=.");
+      return 1;
+   }
+   int j = checkField(name);
+   if (j>=0 && FieldType[j]==PDE_EQ) {
+      _rita->msg("data>interpolate>","Field "+name+" is an unknown of a pde and cannot be overwritten.");
+      return 1;
+   }
+
+   auto t0 = std::chrono::steady_clock::now();
+   const spatialIndex &si=getIndex(*src), &ti=getIndex(*dst);
+   if (si.empty() || ti.empty()) {
+      _rita->msg("data>interpolate>","Point location is not available for the elements of these meshes.");
+      return 1;
+   }
+   size_t ns = (st==NODES) ? si.getNbNodes() : si.getNbElements();
+   size_t nt = (st==NODES) ? ti.getNbNodes() : ti.getNbElements();
+   int nd = int(u[k]->size()/ns);
+   vector<double> v(nd*nt);
+   meshTransfer mt(si,ti);
+   size_t nout = 0;
+   if (st==NODES)
+      nout = mt.interpolate(&(*u[k])[0],nd,&v[0]);
+   else if (method=="interpolation")
+      nout = mt.sample(&(*u[k])[0],nd,&v[0]);
+   else
+      mt.project(&(*u[k])[0],nd,&v[0]);
+   double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+
+// Integrals of the first component of an element field on both meshes
+   if (_verb>1 && st==ELEMENTS) {
+      double s1=0., s2=0.;
+      for (size_t e=0; e<ns; ++e)
+         s1 += meshTransfer::measure(si,e)*(*u[k])[nd*e];
+      for (size_t e=0; e<nt; ++e)
+         s2 += meshTransfer::measure(ti,e)*v[nd*e];
+      cout << "Integral of field " << fd << " on mesh " << mesh_name[i1] << ": " << s1
+           << ", on mesh " << to << ": " << s2 << endl;
+   }
+
+// Result in field name
+   if (j<0) {
+      addField(name,st,0,nd,dst);
+      j = checkField(name);
+   }
+   else {
+      u[j]->setMesh(*dst,(st==NODES) ? NODE_DOF : ELEMENT_DOF,nd);
+      FieldSizeType[j] = st;
+   }
+   for (size_t i=0; i<v.size(); ++i)
+      (*u[j])[i] = v[i];
+   if (_verb) {
+      cout << "Field " << fd << " transferred from mesh " << mesh_name[i1] << " to mesh " << to
+           << " in field " << name << " in " << t << " s" << endl;
+      if (nout)
+         cout << nout << (st==NODES ? " nodes" : " elements") << " outside mesh " << mesh_name[i1]
+              << " get the values of its nearest points" << endl;
+   }
+   *_rita->ofh << "  interpolate  field=" << fd << " from=" << mesh_name[i1] << " to=" << to
+               << " name=" << name;
+   if (method!="interpolation")
+      *_rita->ofh << " method=" << method;
+   *_rita->ofh << endl;
+   return 0;
+}
+
+
+void data::addVector(const string&         name,
+                     const vector<double>& v)
+{
+   auto it = find(vector_name.begin(),vector_name.end(),name);
+   OFELI::Vect<double> *u = new OFELI::Vect<double>(v.size());
+   for (size_t i=0; i<v.size(); ++i)
+      (*u)[i] = v[i];
+   if (it!=vector_name.end()) {
+      size_t k = distance(vector_name.begin(),it);
+      delete theVector[k];
+      theVector[k] = u;
+      return;
+   }
+   theVector.push_back(u);
+   vector_name.push_back(name);
+   _nb_vectors++;
+}
+
+
+void data::addMatrix(const string&         name,
+                     size_t                nr,
+                     size_t                nc,
+                     const vector<double>& a)
+{
+   auto it = find(matrix_name.begin(),matrix_name.end(),name);
+   OFELI::DMatrix<double> *M = new OFELI::DMatrix<double>(nr,nc);
+   for (size_t j=0; j<nc; ++j)
+      for (size_t i=0; i<nr; ++i)
+         M->set(i+1,j+1,a[j*nr+i]);
+   if (it!=matrix_name.end()) {
+      size_t k = distance(matrix_name.begin(),it);
+      delete theMatrix[k];
+      theMatrix[k] = M;
+      return;
+   }
+   theMatrix.push_back(M);
+   matrix_name.push_back(name);
+   _nb_matrices++;
+}
+
+
 int data::setField()
 {
    int nb=0;
@@ -37,6 +37,7 @@ using std::string;
 #include "linear_algebra/Matrix.h"
 #include "io/Fct.h"
 #include "io/Tabulation.h"
+#include "spatialIndex.h"
 
 namespace RITA {
 
@@ -67,7 +68,7 @@ class data
 
     data(rita *r, cmd *command, configure *config);
     ~data();
-    int addField(string name, dataSize s, int n=0, int nb_dof=1);
+    int addField(string name, dataSize s, int n=0, int nb_dof=1, OFELI::Mesh* ms=nullptr);
     int checkField(string name);
     int checkFct(string name);
     int checkMesh(string name);
@@ -80,6 +81,11 @@ class data
     int ret() const { return _ret; }
     int addFunction(const string &name, const string &def, const vector<string> &var);
     int addMesh(OFELI::Mesh* ms, string name);
+    const spatialIndex& getIndex(OFELI::Mesh& ms);
+    void clearIndex(const OFELI::Mesh* ms);
+    void addVector(const string& name, const vector<double>& v);
+    void addMatrix(const string& name, size_t nr, size_t nc, const vector<double>& a);
+    int runDenseEigen(const string& name, bool svd, bool vectors);
 
     int getNbFields() const { return _nb_fields; }
     int getNbFcts() const { return _nb_fcts; }
@@ -128,6 +134,8 @@ class data
     int setConfigure();
     int setVector();
     int setMatrix();
+    int setDenseEigen(bool svd);
+    int setInterpolation();
     int setGrid();
     int setField();
     int setTab();
@@ -136,6 +144,12 @@ class data
     //    void Clear();
     void Summary();
     vector<double> _xv;
+    struct meshIndex {
+       size_t nb_nodes, nb_elements;
+       double signature;
+       spatialIndex index;
+    };
+    std::map<const OFELI::Mesh*,meshIndex> _index;
 };
 
 } /* namespace RITA */
@@ -0,0 +1,1156 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                     Implementation of class 'denseEigen'
+
+  ==============================================================================*/
+
+
+
+#include <math.h>
+#include <float.h>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <complex>
+#include "denseEigen.h"
+#include "parallel.h"
+
+using std::cout;
+using std::endl;
+
+namespace RITA {
+
+// Panel width of the reductions and block size of the reflectors
+static const size_t NB = 32;
+
+// Tile sizes of the blocked products
+static const size_t TR = 128, TC = 32;
+
+// Size of tridiagonal matrices solved directly in divide-and-conquer
+static const size_t LEAF = 32;
+
+
+/*
+ * Householder reflector H = I - tau v v^T such that H x = (beta,0,...,0)^T.
+ * On return, x holds v (with v[0]=1).
+ */
+static double Householder(size_t  n,
+                          double* x,
+                          double& beta)
+{
+   double alpha=x[0], s=0.;
+   for (size_t i=1; i<n; ++i)
+      s += x[i]*x[i];
+   x[0] = 1.;
+   if (s==0.) {
+      beta = alpha;
+      return 0.;
+   }
+   beta = -copysign(sqrt(alpha*alpha+s),alpha);
+   double f = 1./(alpha-beta);
+   for (size_t i=1; i<n; ++i)
+      x[i] *= f;
+   return (beta-alpha)/beta;
+}
+
+
+/*
+ * C = A B (m x n), A being m x k. Tiles of A are reused for several columns
+ * of C, updated four at a time; tiles of C are computed concurrently.
+ */
+static void Gemm(size_t        m,
+                 size_t        n,
+                 size_t        k,
+                 const double* A,
+                 size_t        lda,
+                 const double* B,
+                 size_t        ldb,
+                 double*       C,
+                 size_t        ldc)
+{
+   size_t nr=(m+TR-1)/TR, nc=(n+TC-1)/TC;
+   parallelFor(nr*nc,[&](size_t b, size_t e) {
+      for (size_t t=b; t<e; ++t) {
+         size_t i0=(t%nr)*TR, i1=std::min(m,i0+TR), j0=(t/nr)*TC, j1=std::min(n,j0+TC);
+         for (size_t j=j0; j<j1; ++j)
+            std::fill(C+j*ldc+i0,C+j*ldc+i1,0.);
+         for (size_t p0=0; p0<k; p0+=TR) {
+            size_t p1=std::min(k,p0+TR), j=j0;
+            for (; j+4<=j1; j+=4) {
+               double *c0=C+j*ldc, *c1=c0+ldc, *c2=c1+ldc, *c3=c2+ldc;
+               const double *b0=B+j*ldb, *b1=b0+ldb, *b2=b1+ldb, *b3=b2+ldb;
+               for (size_t p=p0; p<p1; ++p) {
+                  const double *a = A + p*lda;
+                  double x0=b0[p], x1=b1[p], x2=b2[p], x3=b3[p];
+                  for (size_t i=i0; i<i1; ++i) {
+                     double ai = a[i];
+                     c0[i] += ai*x0, c1[i] += ai*x1, c2[i] += ai*x2, c3[i] += ai*x3;
+                  }
+               }
+            }
+            for (; j<j1; ++j) {
+               double *c = C + j*ldc;
+               for (size_t p=p0; p<p1; ++p) {
+                  const double *a = A + p*lda;
+                  double x = B[j*ldb+p];
+                  for (size_t i=i0; i<i1; ++i)
+                     c[i] += a[i]*x;
+               }
+            }
+         }
+      }
+   },2);
+}
+
+
+/*
+ * y = A x for the symmetric matrix A of size n whose lower triangle is
+ * stored. Columns are shared among threads with equal amounts of work, each
+ * thread accumulating the contributions of the strict lower triangle in its
+ * own vector.
+ */
+static void SymMatVec(size_t        n,
+                      const double* A,
+                      size_t        lda,
+                      const double* x,
+                      double*       y)
+{
+   size_t nt = std::max(size_t(1),std::min(size_t(getNbThreads()),n/256));
+   vector<double> yt(nt*n,0.);
+   parallelRun(nt,[&](size_t t) {
+      size_t b=size_t(n*(1.-sqrt(1.-double(t)/nt))), e=size_t(n*(1.-sqrt(1.-double(t+1)/nt)));
+      if (t==nt-1)
+         e = n;
+      double *z = &yt[t*n];
+      for (size_t c=b; c<e; ++c) {
+         const double *a = A + c*lda;
+         double s=a[c]*x[c], xc=x[c];
+         for (size_t r=c+1; r<n; ++r) {
+            s += a[r]*x[r];
+            z[r] += a[r]*xc;
+         }
+         z[c] += s;
+      }
+   });
+   for (size_t i=0; i<n; ++i) {
+      double s = 0.;
+      for (size_t t=0; t<nt; ++t)
+         s += yt[t*n+i];
+      y[i] = s;
+   }
+}
+
+
+/*
+ * Z = (H_0 H_1 ... H_{k-1}) Z for the reflectors H_j = I - tau_j v_j v_j^T,
+ * v_j being column j of V with v_j[j+off]=1 and zeros above. Reflectors are
+ * applied by blocks of NB, from the last one, as I - V T V^T with T upper
+ * triangular. Columns of Z are processed concurrently.
+ */
+static void ApplyReflectors(size_t        nr,
+                            size_t        k,
+                            size_t        off,
+                            const double* V,
+                            size_t        ldv,
+                            const double* tau,
+                            double*       Z,
+                            size_t        ldz,
+                            size_t        nc)
+{
+   for (size_t b0=((k-1)/NB)*NB; b0<k; b0-=NB) {
+      size_t nb=std::min(NB,k-b0), r0=b0+off, len=nr-r0;
+      vector<double> Vb(len*nb,0.), T(nb*nb,0.), t(nb);
+      for (size_t j=0; j<nb; ++j)
+         for (size_t r=j; r<len; ++r)
+            Vb[j*len+r] = V[(b0+j)*ldv+r0+r];
+      for (size_t j=0; j<nb; ++j) {
+         double tj = tau[b0+j];
+         for (size_t i=0; i<j; ++i) {
+            double s = 0.;
+            for (size_t r=j; r<len; ++r)
+               s += Vb[i*len+r]*Vb[j*len+r];
+            t[i] = -tj*s;
+         }
+         for (size_t i=0; i<j; ++i) {
+            double s = 0.;
+            for (size_t l=i; l<j; ++l)
+               s += T[l*nb+i]*t[l];
+            T[j*nb+i] = s;
+         }
+         T[j*nb+j] = tj;
+      }
+
+//    Y = V^T Z, Y := T Y, Z := Z - V Y, columns of Z being handled four at a time
+      parallelFor((nc+3)/4,[&](size_t b, size_t e) {
+         double y[4*NB], w[4*NB];
+         for (size_t g=b; g<e; ++g) {
+            size_t c0=4*g, cn=std::min(nc-c0,size_t(4));
+            double *z[4];
+            for (size_t c=0; c<4; ++c)
+               z[c] = Z + (c0+std::min(c,cn-1))*ldz + r0;
+            for (size_t j=0; j<nb; ++j) {
+               const double *v = &Vb[j*len];
+               double s0=0., s1=0., s2=0., s3=0.;
+               for (size_t r=j; r<len; ++r) {
+                  double vr = v[r];
+                  s0 += vr*z[0][r], s1 += vr*z[1][r], s2 += vr*z[2][r], s3 += vr*z[3][r];
+               }
+               y[j] = s0, y[NB+j] = s1, y[2*NB+j] = s2, y[3*NB+j] = s3;
+            }
+            for (size_t c=0; c<4; ++c)
+               for (size_t i=0; i<nb; ++i) {
+                  double s = 0.;
+                  for (size_t j=i; j<nb; ++j)
+                     s += T[j*nb+i]*y[c*NB+j];
+                  w[c*NB+i] = (c<cn) ? s : 0.;
+               }
+            for (size_t j=0; j<nb; ++j) {
+               const double *v = &Vb[j*len];
+               double x0=w[j], x1=w[NB+j], x2=w[2*NB+j], x3=w[3*NB+j];
+               for (size_t r=j; r<len; ++r) {
+                  double vr = v[r];
+                  z[0][r] -= vr*x0, z[1][r] -= vr*x1, z[2][r] -= vr*x2, z[3][r] -= vr*x3;
+               }
+            }
+         }
+      },2);
+      if (b0==0)
+         break;
+   }
+}
+
+
+/*
+ * Reduction of the symmetric matrix A (lower triangle, n x n) to tridiagonal
+ * form T = Q^T A Q (diagonal d, subdiagonal e). Reflector j is stored in
+ * column j of A below the diagonal. For each panel of NB columns, the
+ * reflectors are generated with the matrix W such that the update of the
+ * rest of the matrix is A := A - V W^T - W V^T.
+ */
+static void Tridiagonalize(size_t          n,
+                           double*         A,
+                           vector<double>& d,
+                           vector<double>& e,
+                           vector<double>& tau)
+{
+   d.resize(n), e.assign(n,0.), tau.assign(n,0.);
+   vector<double> W(n*NB), t1(NB), t2(NB);
+   for (size_t k=0; k+1<n; k+=NB) {
+      size_t nb = std::min(NB,n-1-k);
+      for (size_t i=0; i<nb; ++i) {
+         size_t j=k+i, len=n-j-1;
+         double *aj=A+j*n, *w=&W[i*n];
+         for (size_t p=0; p<i; ++p) {
+            const double *vp=A+(k+p)*n, *wp=&W[p*n];
+            double wj=wp[j], vj=vp[j];
+            for (size_t r=j; r<n; ++r)
+               aj[r] -= vp[r]*wj + wp[r]*vj;
+         }
+         d[j] = aj[j];
+         double *v = aj + j + 1;
+         tau[j] = Householder(len,v,e[j]);
+         SymMatVec(len,A+(j+1)*n+j+1,n,v,w+j+1);
+         for (size_t p=0; p<i; ++p) {
+            const double *vp=A+(k+p)*n+j+1, *wp=&W[p*n+j+1];
+            double s1=0., s2=0.;
+            for (size_t r=0; r<len; ++r)
+               s1 += wp[r]*v[r], s2 += vp[r]*v[r];
+            t1[p] = s1, t2[p] = s2;
+         }
+         for (size_t p=0; p<i; ++p) {
+            const double *vp=A+(k+p)*n+j+1, *wp=&W[p*n+j+1];
+            for (size_t r=0; r<len; ++r)
+               w[j+1+r] -= vp[r]*t1[p] + wp[r]*t2[p];
+         }
+         double s = 0.;
+         for (size_t r=0; r<len; ++r)
+            w[j+1+r] *= tau[j], s += w[j+1+r]*v[r];
+         s *= -0.5*tau[j];
+         for (size_t r=0; r<len; ++r)
+            w[j+1+r] += s*v[r];
+      }
+
+//    Rank-2k update of the lower triangle of the trailing matrix by tiles
+      size_t c0=k+nb, m=n-c0, nt=(m+TR-1)/TR;
+      if (m==0)
+         continue;
+      vector<std::pair<size_t,size_t> > tiles;
+      for (size_t jt=0; jt<nt; ++jt)
+         for (size_t it=jt; it<nt; ++it)
+            tiles.push_back(std::make_pair(it,jt));
+      parallelFor(tiles.size(),[&](size_t b, size_t e) {
+         for (size_t t=b; t<e; ++t) {
+            size_t r0=c0+tiles[t].first*TR, r1=std::min(n,r0+TR);
+            size_t j0=c0+tiles[t].second*TR, j1=std::min(n,j0+TR);
+            for (size_t c=j0; c<j1; ++c) {
+               double *a = A + c*n;
+               for (size_t p=0; p<nb; ++p) {
+                  const double *vp=A+(k+p)*n, *wp=&W[p*n];
+                  double wc=wp[c], vc=vp[c];
+                  for (size_t r=std::max(r0,c); r<r1; ++r)
+                     a[r] -= vp[r]*wc + wp[r]*vc;
+               }
+            }
+         }
+      },2);
+   }
+   d[n-1] = A[(n-1)*n+n-1];
+}
+
+
+/*
+ * Reduction of A (m x n, m >= n) to upper bidiagonal form B = Q^T A P
+ * (diagonal d, superdiagonal e). Left reflector j is stored in column j of A
+ * from the diagonal, right reflector j in row j of A from the superdiagonal.
+ * For each panel of NB columns, the reflectors are generated with the
+ * matrices X and Y such that the update of the rest of the matrix is
+ * A := A - U Y^T - X V^T.
+ */
+static void Bidiagonalize(size_t          m,
+                          size_t          n,
+                          double*         A,
+                          vector<double>& d,
+                          vector<double>& e,
+                          vector<double>& tauq,
+                          vector<double>& taup)
+{
+   d.resize(n), e.assign(n,0.), tauq.assign(n,0.), taup.assign(n,0.);
+   vector<double> X(m*NB,0.), Y(n*NB,0.), s1(NB), s2(NB), v(n);
+   for (size_t k=0; k<n; k+=NB) {
+      size_t nb = std::min(NB,n-k);
+      for (size_t i=0; i<nb; ++i) {
+         size_t j = k + i;
+         double *aj = A + j*m;
+
+//       Column j and left reflector
+         for (size_t p=0; p<i; ++p) {
+            const double *up=A+(k+p)*m, *xp=&X[p*m];
+            double yj=Y[p*n+j], vj=aj[k+p];
+            for (size_t r=j; r<m; ++r)
+               aj[r] -= up[r]*yj + xp[r]*vj;
+         }
+         tauq[j] = Householder(m-j,aj+j,d[j]);
+         if (j+1==n)
+            break;
+
+//       Y(j+1:n,i) = tauq (A^T u - Y (U^T u) - V^T (X^T u))
+         const double *u = aj + j;
+         double *y = &Y[i*n];
+         parallelFor(n-j-1,[&](size_t b, size_t e) {
+            for (size_t c=j+1+b; c<j+1+e; ++c) {
+               const double *a = A + c*m + j;
+               double s = 0.;
+               for (size_t r=0; r<m-j; ++r)
+                  s += a[r]*u[r];
+               y[c] = s;
+            }
+         },64);
+         for (size_t p=0; p<i; ++p) {
+            const double *up=A+(k+p)*m+j, *xp=&X[p*m+j];
+            double a=0., b=0.;
+            for (size_t r=0; r<m-j; ++r)
+               a += up[r]*u[r], b += xp[r]*u[r];
+            s1[p] = a, s2[p] = b;
+         }
+         for (size_t c=j+1; c<n; ++c) {
+            double s = y[c];
+            for (size_t p=0; p<i; ++p)
+               s -= Y[p*n+c]*s1[p] + A[c*m+k+p]*s2[p];
+            y[c] = tauq[j]*s;
+         }
+
+//       Row j and right reflector
+         for (size_t c=j+1; c<n; ++c) {
+            double s = A[c*m+j];
+            for (size_t p=0; p<=i; ++p)
+               s -= Y[p*n+c]*A[(k+p)*m+j];
+            for (size_t p=0; p<i; ++p)
+               s -= A[c*m+k+p]*X[p*m+j];
+            v[c] = s;
+         }
+         taup[j] = Householder(n-j-1,&v[j+1],e[j]);
+         for (size_t c=j+1; c<n; ++c)
+            A[c*m+j] = v[c];
+
+//       X(j+1:m,i) = taup (A v - U (Y^T v) - X (V^T v))
+         for (size_t p=0; p<=i; ++p) {
+            double a=0., b=0.;
+            for (size_t c=j+1; c<n; ++c) {
+               a += Y[p*n+c]*v[c];
+               if (p<i)
+                  b += A[c*m+k+p]*v[c];
+            }
+            s1[p] = a, s2[p] = b;
+         }
+         double *x = &X[i*m];
+         parallelFor(m-j-1,[&](size_t b, size_t e) {
+            for (size_t r=j+1+b; r<j+1+e; ++r)
+               x[r] = 0.;
+            for (size_t c=j+1; c<n; ++c) {
+               const double *a = A + c*m;
+               for (size_t r=j+1+b; r<j+1+e; ++r)
+                  x[r] += a[r]*v[c];
+            }
+            for (size_t p=0; p<=i; ++p) {
+               const double *up=A+(k+p)*m, *xp=&X[p*m];
+               for (size_t r=j+1+b; r<j+1+e; ++r)
+                  x[r] -= up[r]*s1[p] + ((p<i) ? xp[r]*s2[p] : 0.);
+            }
+            for (size_t r=j+1+b; r<j+1+e; ++r)
+               x[r] *= taup[j];
+         },256);
+      }
+
+//    Update of the trailing matrix by tiles
+      size_t r0=k+nb, c0=k+nb;
+      if (c0>=n)
+         break;
+      size_t nr=(m-r0+TR-1)/TR, nc=(n-c0+TC-1)/TC;
+      parallelFor(nr*nc,[&](size_t b, size_t e) {
+         vector<double> yc(nb), vc(nb);
+         for (size_t t=b; t<e; ++t) {
+            size_t i0=r0+(t%nr)*TR, i1=std::min(m,i0+TR), j0=c0+(t/nr)*TC, j1=std::min(n,j0+TC);
+            for (size_t c=j0; c<j1; ++c) {
+               double *a = A + c*m;
+               for (size_t p=0; p<nb; ++p) {
+                  const double *up=A+(k+p)*m, *xp=&X[p*m];
+                  double yp=Y[p*n+c], vp=a[k+p];
+                  for (size_t r=i0; r<i1; ++r)
+                     a[r] -= up[r]*yp + xp[r]*vp;
+               }
+            }
+         }
+      },2);
+   }
+}
+
+
+/*
+ * Implicit QL method for the symmetric tridiagonal matrix (d, e), e[i] being
+ * the entry (i+1,i) and e[n-1] = 0. Off-diagonal entries are neglected when
+ * small relative to their diagonal neighbours or to the norm of the matrix.
+ * If Z is given, the rotations are applied to its columns. Returns 1 if an
+ * eigenvalue did not converge.
+ */
+static int QL(size_t  n,
+              double* d,
+              double* e,
+              double* Z,
+              size_t  ldz)
+{
+   double tiny = 0.;
+   for (size_t i=0; i<n; ++i)
+      tiny = std::max(tiny,fabs(d[i])+fabs(e[i]));
+   tiny *= DBL_EPSILON;
+   for (size_t l=0; l<n; ++l) {
+      for (int it=0; ; ++it) {
+         size_t m = l;
+         for (; m+1<n; ++m) {
+            double dd = fabs(d[m]) + fabs(d[m+1]);
+            if (fabs(e[m])<=DBL_EPSILON*dd+tiny)
+               break;
+         }
+         if (m==l)
+            break;
+         if (it==60)
+            return 1;
+         double g=(d[l+1]-d[l])/(2.*e[l]), r=hypot(g,1.);
+         g = d[m] - d[l] + e[l]/(g+copysign(r,g));
+         double s=1., c=1., p=0.;
+         bool underflow = false;
+         for (size_t i=m; i-->l;) {
+            double f=s*e[i], b=c*e[i];
+            e[i+1] = r = hypot(f,g);
+            if (r==0.) {
+               d[i+1] -= p;
+               e[m] = 0.;
+               underflow = true;
+               break;
+            }
+            s = f/r, c = g/r;
+            g = d[i+1] - p;
+            r = (d[i]-g)*s + 2.*c*b;
+            d[i+1] = g + (p=s*r);
+            g = c*r - b;
+            if (Z) {
+               double *z0=Z+i*ldz, *z1=Z+(i+1)*ldz;
+               for (size_t k=0; k<n; ++k) {
+                  f = z1[k];
+                  z1[k] = s*z0[k] + c*f;
+                  z0[k] = c*z0[k] - s*f;
+               }
+            }
+         }
+         if (underflow)
+            continue;
+         d[l] -= p;
+         e[l] = g;
+         e[m] = 0.;
+      }
+   }
+   return 0;
+}
+
+
+/*
+ * Root lambda of the secular equation 1 + rho sum_j z_j^2/(d_j - lambda) = 0
+ * lying in (d_i,d_{i+1}) (in (d_i,d_i+rho |z|^2) for the last one). The
+ * origin is moved to the closest pole so that the differences
+ * delta_j = d_j - lambda are accurate. Each iteration uses a rational model
+ * of both poles around the root (fixed weight method) safeguarded by
+ * bisection.
+ */
+static double Secular(size_t        k,
+                      const double* d,
+                      const double* z,
+                      double        rho,
+                      size_t        i,
+                      double*       delta)
+{
+   bool last = (i+1==k);
+   double org=d[i], lo=0., hi=0.;
+   if (last) {
+      double zz = 0.;
+      for (size_t j=0; j<k; ++j)
+         zz += z[j]*z[j];
+      hi = rho*zz;
+   }
+   else {
+      double mid=0.5*(d[i]+d[i+1]), f=1.;
+      for (size_t j=0; j<k; ++j)
+         f += rho*z[j]*z[j]/(d[j]-mid);
+      if (f>=0.)
+         hi = mid - d[i];
+      else
+         org = d[i+1], lo = mid - d[i+1];
+   }
+   for (size_t j=0; j<k; ++j)
+      delta[j] = d[j] - org;
+   double tau = 0.5*(lo+hi);
+   for (int it=0; it<200; ++it) {
+      double psi=0., dpsi=0., phi=0., dphi=0.;
+      for (size_t j=0; j<=i; ++j) {
+         double t = z[j]/(delta[j]-tau);
+         psi += z[j]*t, dpsi += t*t;
+      }
+      for (size_t j=i+1; j<k; ++j) {
+         double t = z[j]/(delta[j]-tau);
+         phi += z[j]*t, dphi += t*t;
+      }
+      psi *= rho, dpsi *= rho, phi *= rho, dphi *= rho;
+      double f = 1. + psi + phi;
+      if (fabs(f)<=8.*k*DBL_EPSILON*(1.+fabs(psi)+fabs(phi)))
+         break;
+      if (f<0.)
+         lo = tau;
+      else
+         hi = tau;
+      if (hi-lo<=2.*DBL_EPSILON*std::max(fabs(lo),fabs(hi)))
+         break;
+      double a=delta[i]-tau, y=-f/(dpsi+dphi), s=a*a*dpsi;
+      if (last) {
+         double c = f - s/a;
+         if (c!=0.)
+            y = a + s/c;
+      }
+      else {
+         double b=delta[i+1]-tau, S=b*b*dphi, c=f-s/a-S/b;
+         double qa=c, qb=-(c*(a+b)+s+S), qc=c*a*b+s*b+S*a;
+         double disc = std::max(qb*qb-4.*qa*qc,0.);
+         if (qa!=0.) {
+            double q = -0.5*(qb+copysign(sqrt(disc),qb));
+            double y1=q/qa, y2=(q!=0.) ? qc/q : y1;
+            bool in1=(tau+y1>lo && tau+y1<hi), in2=(tau+y2>lo && tau+y2<hi);
+            if (in1 && (!in2 || fabs(y1)<fabs(y2)))
+               y = y1;
+            else if (in2)
+               y = y2;
+         }
+         else if (qb!=0.)
+            y = -qc/qb;
+      }
+      double t = tau + y;
+      tau = (t>lo && t<hi) ? t : 0.5*(lo+hi);
+   }
+   for (size_t j=0; j<k; ++j)
+      delta[j] -= tau;
+   return org + tau;
+}
+
+
+/*
+ * Eigenvalues (increasing) and eigenvectors (columns of Q, n x n) of the
+ * symmetric tridiagonal matrix (d, e) by divide-and-conquer. The matrix is
+ * split by a rank-one tearing, both halves are solved recursively and the
+ * eigensystem of the rank-one modified diagonal matrix D + rho z z^T gives
+ * the result. Eigenvalues of D with small components of z or close to each
+ * other are deflated. Remaining eigenvectors are recombined by a matrix
+ * product with the eigenvectors of the halves.
+ */
+static int DivideConquer(size_t  n,
+                         double* d,
+                         double* e,
+                         double* Q,
+                         size_t  ldq)
+{
+   if (n<=LEAF) {
+      vector<double> f(e,e+n);
+      f[n-1] = 0.;
+      for (size_t j=0; j<n; ++j) {
+         std::fill(Q+j*ldq,Q+j*ldq+n,0.);
+         Q[j*ldq+j] = 1.;
+      }
+      if (QL(n,d,f.data(),Q,ldq))
+         return 1;
+      vector<size_t> id(n);
+      for (size_t i=0; i<n; ++i)
+         id[i] = i;
+      std::sort(id.begin(),id.end(),[d](size_t i, size_t j) { return d[i]<d[j]; });
+      vector<double> dd(d,d+n), QQ(n*n);
+      for (size_t j=0; j<n; ++j) {
+         d[j] = dd[id[j]];
+         std::copy(Q+id[j]*ldq,Q+id[j]*ldq+n,&QQ[j*n]);
+      }
+      for (size_t j=0; j<n; ++j)
+         std::copy(&QQ[j*n],&QQ[j*n]+n,Q+j*ldq);
+      return 0;
+   }
+   size_t m = n/2;
+   double rho = e[m-1];
+   d[m-1] -= fabs(rho);
+   d[m] -= fabs(rho);
+   if (DivideConquer(m,d,e,Q,ldq) || DivideConquer(n-m,d+m,e+m,Q+m*ldq+m,ldq))
+      return 1;
+   for (size_t j=0; j<m; ++j)
+      std::fill(Q+j*ldq+m,Q+j*ldq+n,0.);
+   for (size_t j=m; j<n; ++j)
+      std::fill(Q+j*ldq,Q+j*ldq+m,0.);
+
+// Rank-one modification: z is made of the last row of Q1 and the first row of Q2
+   vector<double> z(n);
+   for (size_t j=0; j<n; ++j)
+      z[j] = (j<m) ? Q[j*ldq+m-1] : copysign(1.,rho)*Q[j*ldq+m];
+   double r = 2.*fabs(rho);
+   for (size_t j=0; j<n; ++j)
+      z[j] /= sqrt(2.);
+
+// Sort and deflation
+   vector<size_t> id(n);
+   for (size_t i=0; i<n; ++i)
+      id[i] = i;
+   std::sort(id.begin(),id.end(),[d](size_t i, size_t j) { return d[i]<d[j]; });
+   vector<double> dl(n), zl(n), dmax(1,0.);
+   for (size_t i=0; i<n; ++i) {
+      dl[i] = d[id[i]], zl[i] = z[id[i]];
+      dmax[0] = std::max(dmax[0],fabs(dl[i]));
+   }
+   double tol = 8.*DBL_EPSILON*std::max(dmax[0],r);
+   vector<size_t> kept, defl;
+   vector<int> part(n);
+   for (size_t j=0; j<n; ++j)
+      part[j] = (j<m) ? 1 : 2;
+   for (size_t i=0; i<n; ++i) {
+      if (r*fabs(zl[i])<=tol) {
+         defl.push_back(i);
+         continue;
+      }
+      if (kept.size()) {
+         size_t p = kept.back();
+         double t=hypot(zl[p],zl[i]), c=zl[i]/t, s=-zl[p]/t;
+         if (fabs((dl[i]-dl[p])*c*s)<=tol) {
+            double *qp=Q+id[p]*ldq, *qi=Q+id[i]*ldq;
+            for (size_t k=0; k<n; ++k) {
+               double a=qp[k], b=qi[k];
+               qp[k] = c*a + s*b;
+               qi[k] = -s*a + c*b;
+            }
+            double dp=dl[p], di=dl[i];
+            dl[p] = c*c*dp + s*s*di;
+            dl[i] = s*s*dp + c*c*di;
+            zl[p] = 0., zl[i] = t;
+            part[id[p]] = part[id[i]] = part[id[p]] | part[id[i]];
+            kept.pop_back();
+            defl.push_back(p);
+         }
+      }
+      kept.push_back(i);
+   }
+
+// Secular equation, Gu-Eisenstat vector and eigenvectors of D + rho z z^T
+   size_t k = kept.size();
+   vector<double> dk(k), zk(k), lambda(k), D(k*k), U(k*k), W(n*k), Qk(n*k);
+   for (size_t i=0; i<k; ++i)
+      dk[i] = dl[kept[i]], zk[i] = zl[kept[i]];
+   parallelFor(k,[&](size_t b, size_t e) {
+      for (size_t i=b; i<e; ++i)
+         lambda[i] = Secular(k,dk.data(),zk.data(),r,i,&D[i*k]);
+   },16);
+   parallelFor(k,[&](size_t b, size_t e) {
+      for (size_t j=b; j<e; ++j) {
+         double w = -D[j*k+j]/r;
+         for (size_t i=0; i<k; ++i)
+            if (i!=j)
+               w *= -D[i*k+j]/(dk[i]-dk[j]);
+         zk[j] = copysign(sqrt(std::max(w,0.)),zk[j]);
+      }
+   },16);
+   parallelFor(k,[&](size_t b, size_t e) {
+      for (size_t i=b; i<e; ++i) {
+         double s = 0.;
+         for (size_t j=0; j<k; ++j) {
+            U[i*k+j] = zk[j]/D[i*k+j];
+            s += U[i*k+j]*U[i*k+j];
+         }
+         s = 1./sqrt(s);
+         for (size_t j=0; j<k; ++j)
+            U[i*k+j] *= s;
+      }
+   },16);
+
+// Vectors of the upper half only involve columns of Q1 and mixed ones,
+// those of the lower half columns of Q2 and mixed ones
+   for (int h=1; h<=2; ++h) {
+      size_t r0=(h==1) ? 0 : m, nr=(h==1) ? m : n-m;
+      vector<size_t> sel;
+      for (size_t i=0; i<k; ++i)
+         if (part[id[kept[i]]]&h)
+            sel.push_back(i);
+      size_t ks = sel.size();
+      if (ks==0) {
+         for (size_t j=0; j<k; ++j)
+            std::fill(&Qk[j*n+r0],&Qk[j*n+r0]+nr,0.);
+         continue;
+      }
+      vector<double> Us(ks*k);
+      for (size_t i=0; i<ks; ++i)
+         std::copy(Q+id[kept[sel[i]]]*ldq+r0,Q+id[kept[sel[i]]]*ldq+r0+nr,&W[i*nr]);
+      for (size_t j=0; j<k; ++j)
+         for (size_t i=0; i<ks; ++i)
+            Us[j*ks+i] = U[j*k+sel[i]];
+      Gemm(nr,k,ks,W.data(),nr,Us.data(),ks,&Qk[r0],n);
+   }
+
+// Merge of deflated and computed eigenpairs by increasing eigenvalues
+   vector<std::pair<double,const double*> > ev;
+   for (size_t i=0; i<k; ++i)
+      ev.push_back(std::make_pair(lambda[i],&Qk[i*n]));
+   vector<double> Wd(n*defl.size());
+   for (size_t i=0; i<defl.size(); ++i) {
+      std::copy(Q+id[defl[i]]*ldq,Q+id[defl[i]]*ldq+n,&Wd[i*n]);
+      ev.push_back(std::make_pair(dl[defl[i]],&Wd[i*n]));
+   }
+   std::sort(ev.begin(),ev.end(),[](const std::pair<double,const double*>& a,
+                                    const std::pair<double,const double*>& b) { return a.first<b.first; });
+   for (size_t j=0; j<n; ++j) {
+      d[j] = ev[j].first;
+      std::copy(ev[j].second,ev[j].second+n,Q+j*ldq);
+   }
+   return 0;
+}
+
+
+/*
+ * Eigenvalues of the tridiagonal matrix (d, e) and, if Z is given, its
+ * eigenvectors (n x n)
+ */
+int denseEigen::tridiagonal(size_t          n,
+                            vector<double>& d,
+                            vector<double>& e,
+                            vector<double>* Z)
+{
+   e.resize(n);
+   if (Z==nullptr) {
+      e[n-1] = 0.;
+      if (QL(n,d.data(),e.data(),nullptr,0))
+         return 1;
+      std::sort(d.begin(),d.end());
+      return 0;
+   }
+   Z->assign(n*n,0.);
+   return DivideConquer(n,d.data(),e.data(),Z->data(),n);
+}
+
+
+int denseEigen::symmetric(size_t        n,
+                          const double* a,
+                          bool          vectors)
+{
+   if (n==0) {
+      cout << "Error: Empty matrix." << endl;
+      return 1;
+   }
+   auto t0 = std::chrono::steady_clock::now();
+   vector<double> A(a,a+n*n), e, tau, Z;
+   _u.clear(), _v.clear();
+   Tridiagonalize(n,A.data(),_values,e,tau);
+   auto t1 = std::chrono::steady_clock::now();
+   if (tridiagonal(n,_values,e,vectors ? &Z : nullptr)) {
+      cout << "Error: Eigenvalues of tridiagonal matrix did not converge." << endl;
+      return 1;
+   }
+   auto t2 = std::chrono::steady_clock::now();
+   if (vectors) {
+      if (n>1)
+         ApplyReflectors(n,n-1,1,A.data(),n,tau.data(),Z.data(),n,n);
+      _v = std::move(Z);
+   }
+   if (_verb>1)
+      cout << "Dense symmetric eigenproblem of size " << n << ": tridiagonalization "
+           << std::chrono::duration<double>(t1-t0).count() << " s, tridiagonal eigenproblem "
+           << std::chrono::duration<double>(t2-t1).count() << " s, back transformation "
+           << std::chrono::duration<double>(std::chrono::steady_clock::now()-t2).count() << " s" << endl;
+   return 0;
+}
+
+
+/*
+ * If m < n, the decomposition of the transposed matrix is computed
+ */
+int denseEigen::svd(size_t        m,
+                    size_t        n,
+                    const double* a,
+                    bool          vectors)
+{
+   if (m==0 || n==0) {
+      cout << "Error: Empty matrix." << endl;
+      return 1;
+   }
+   auto t0 = std::chrono::steady_clock::now();
+   bool trans = (m<n);
+   size_t mm=std::max(m,n), nn=std::min(m,n);
+   vector<double> A(mm*nn), d, e, tauq, taup, Z;
+   for (size_t j=0; j<n; ++j)
+      for (size_t i=0; i<m; ++i)
+         A[trans ? i*mm+j : j*mm+i] = a[j*m+i];
+   _u.clear(), _v.clear();
+   Bidiagonalize(mm,nn,A.data(),d,e,tauq,taup);
+   auto t1 = std::chrono::steady_clock::now();
+
+// Golub-Kahan tridiagonal matrix: zero diagonal, subdiagonal (d0,e0,d1,e1,...)
+   vector<double> g(2*nn,0.), f(2*nn,0.);
+   for (size_t i=0; i<nn; ++i) {
+      f[2*i] = d[i];
+      if (i+1<nn)
+         f[2*i+1] = e[i];
+   }
+   if (tridiagonal(2*nn,g,f,vectors ? &Z : nullptr)) {
+      cout << "Error: Singular values of bidiagonal matrix did not converge." << endl;
+      return 1;
+   }
+   _values.resize(nn);
+   for (size_t i=0; i<nn; ++i)
+      _values[i] = fabs(g[2*nn-1-i]);
+   auto t2 = std::chrono::steady_clock::now();
+
+// Singular vectors of B, then of A by applying the reflectors
+   if (vectors) {
+      vector<double> U(mm*nn,0.), V(nn*nn,0.), P(nn*nn,0.);
+      for (size_t i=0; i<nn; ++i) {
+         const double *x = &Z[(2*nn-1-i)*2*nn];
+         double su=0., sv=0.;
+         for (size_t j=0; j<nn; ++j)
+            sv += x[2*j]*x[2*j], su += x[2*j+1]*x[2*j+1];
+         su = (su>0.) ? 1./sqrt(su) : 0., sv = (sv>0.) ? 1./sqrt(sv) : 0.;
+         for (size_t j=0; j<nn; ++j)
+            V[i*nn+j] = sv*x[2*j], U[i*mm+j] = su*x[2*j+1];
+      }
+      ApplyReflectors(mm,nn,0,A.data(),mm,tauq.data(),U.data(),mm,nn);
+      for (size_t j=0; j+1<nn; ++j)
+         for (size_t c=j+1; c<nn; ++c)
+            P[j*nn+c] = A[c*mm+j];
+      if (nn>2)
+         ApplyReflectors(nn,nn-2,1,P.data(),nn,taup.data(),V.data(),nn,nn);
+      _u = std::move(trans ? V : U);
+      _v = std::move(trans ? U : V);
+   }
+   if (_verb>1)
+      cout << "Singular value decomposition of a " << m << "x" << n << " matrix: bidiagonalization "
+           << std::chrono::duration<double>(t1-t0).count() << " s, bidiagonal problem "
+           << std::chrono::duration<double>(t2-t1).count() << " s, back transformation "
+           << std::chrono::duration<double>(std::chrono::steady_clock::now()-t2).count() << " s" << endl;
+   return 0;
+}
+
+
+/*
+ * Eigenvalues (wr, wi) of the upper Hessenberg matrix H (column major) by the
+ * Francis double shift QR algorithm. H is overwritten.
+ */
+static int HessenbergQR(size_t  n,
+                        double* H,
+                        double* wr,
+                        double* wi)
+{
+   auto a = [H,n](int i, int j) -> double& { return H[j*n+i]; };
+   double anorm=0., p=0., q=0., r=0., t=0., w, x, y, z;
+   for (int i=0; i<int(n); ++i)
+      for (int j=std::max(i-1,0); j<int(n); ++j)
+         anorm += fabs(a(i,j));
+   int nn=int(n)-1, l, m;
+   while (nn>=0) {
+      int its = 0;
+      do {
+         for (l=nn; l>=1; --l) {
+            double s = fabs(a(l-1,l-1)) + fabs(a(l,l));
+            if (s==0.)
+               s = anorm;
+            if (fabs(a(l,l-1))+s==s) {
+               a(l,l-1) = 0.;
+               break;
+            }
+         }
+         x = a(nn,nn);
+         if (l==nn) {
+            wr[nn] = x + t, wi[nn--] = 0.;
+            continue;
+         }
+         y = a(nn-1,nn-1), w = a(nn,nn-1)*a(nn-1,nn);
+         if (l==nn-1) {
+            p = 0.5*(y-x), q = p*p + w, z = sqrt(fabs(q)), x += t;
+            if (q>=0.) {
+               z = p + (p>=0. ? z : -z);
+               wr[nn-1] = wr[nn] = x + z;
+               if (z!=0.)
+                  wr[nn] = x - w/z;
+               wi[nn-1] = wi[nn] = 0.;
+            }
+            else {
+               wr[nn-1] = wr[nn] = x + p;
+               wi[nn-1] = z, wi[nn] = -z;
+            }
+            nn -= 2;
+            continue;
+         }
+         if (its==60)
+            return 1;
+
+//       Exceptional shifts
+         if (its==10 || its==20 || its==40) {
+            t += x;
+            for (int i=0; i<=nn; ++i)
+               a(i,i) -= x;
+            double s = fabs(a(nn,nn-1)) + fabs(a(nn-1,nn-2));
+            y = x = 0.75*s, w = -0.4375*s*s;
+         }
+         ++its;
+         for (m=nn-2; m>=l; --m) {
+            z = a(m,m), r = x - z;
+            double s = y - z;
+            p = (r*s-w)/a(m+1,m) + a(m,m+1), q = a(m+1,m+1) - z - r - s, r = a(m+2,m+1);
+            s = fabs(p) + fabs(q) + fabs(r);
+            p /= s, q /= s, r /= s;
+            if (m==l)
+               break;
+            double u = fabs(a(m,m-1))*(fabs(q)+fabs(r)),
+                   v = fabs(p)*(fabs(a(m-1,m-1))+fabs(z)+fabs(a(m+1,m+1)));
+            if (u+v==v)
+               break;
+         }
+         for (int i=m+2; i<=nn; ++i) {
+            a(i,i-2) = 0.;
+            if (i!=m+2)
+               a(i,i-3) = 0.;
+         }
+
+//       Double shift QR step on rows and columns l to nn
+         for (int k=m; k<=nn-1; ++k) {
+            if (k!=m) {
+               p = a(k,k-1), q = a(k+1,k-1), r = (k!=nn-1) ? a(k+2,k-1) : 0.;
+               if ((x=fabs(p)+fabs(q)+fabs(r))!=0.)
+                  p /= x, q /= x, r /= x;
+            }
+            double s = sqrt(p*p+q*q+r*r);
+            if (p<0.)
+               s = -s;
+            if (s==0.)
+               continue;
+            if (k==m) {
+               if (l!=m)
+                  a(k,k-1) = -a(k,k-1);
+            }
+            else
+               a(k,k-1) = -s*x;
+            p += s, x = p/s, y = q/s, z = r/s, q /= p, r /= p;
+            for (int j=k; j<=nn; ++j) {
+               p = a(k,j) + q*a(k+1,j);
+               if (k!=nn-1) {
+                  p += r*a(k+2,j);
+                  a(k+2,j) -= p*z;
+               }
+               a(k+1,j) -= p*y;
+               a(k,j) -= p*x;
+            }
+            for (int i=l; i<=std::min(nn,k+3); ++i) {
+               p = x*a(i,k) + y*a(i,k+1);
+               if (k!=nn-1) {
+                  p += z*a(i,k+2);
+                  a(i,k+2) -= p*r;
+               }
+               a(i,k+1) -= p*q;
+               a(i,k) -= p;
+            }
+         }
+      } while (l<nn-1);
+   }
+   return 0;
+}
+
+
+/*
+ * Eigenvector of A (n x n, column major) for the eigenvalue lambda by two
+ * steps of inverse iteration with the LU factorization of A - lambda I
+ */
+static void InverseIteration(size_t                 n,
+                             const double*          A,
+                             std::complex<double>   lambda,
+                             std::complex<double>*  v)
+{
+   typedef std::complex<double> cplx;
+   double an = 0.;
+   for (size_t i=0; i<n*n; ++i)
+      an = std::max(an,fabs(A[i]));
+   double eps = std::max(an,1.)*DBL_EPSILON*n;
+   lambda += eps*std::max(1.,std::abs(lambda));
+   vector<cplx> LU(n*n);
+   vector<size_t> piv(n);
+   for (size_t j=0; j<n; ++j)
+      for (size_t i=0; i<n; ++i)
+         LU[j*n+i] = A[j*n+i] - ((i==j) ? lambda : 0.);
+   for (size_t k=0; k<n; ++k) {
+      size_t pk = k;
+      for (size_t i=k+1; i<n; ++i)
+         if (std::abs(LU[k*n+i])>std::abs(LU[k*n+pk]))
+            pk = i;
+      piv[k] = pk;
+      if (pk!=k)
+         for (size_t j=0; j<n; ++j)
+            std::swap(LU[j*n+k],LU[j*n+pk]);
+      if (std::abs(LU[k*n+k])<eps)
+         LU[k*n+k] = eps;
+      for (size_t i=k+1; i<n; ++i)
+         LU[k*n+i] /= LU[k*n+k];
+      for (size_t j=k+1; j<n; ++j)
+         for (size_t i=k+1; i<n; ++i)
+            LU[j*n+i] -= LU[k*n+i]*LU[j*n+k];
+   }
+   for (size_t i=0; i<n; ++i)
+      v[i] = 1./sqrt(double(n)) + 0.1*double(i%7)/n;
+   for (int it=0; it<2; ++it) {
+      for (size_t k=0; k<n; ++k) {
+         std::swap(v[k],v[piv[k]]);
+         for (size_t i=k+1; i<n; ++i)
+            v[i] -= LU[k*n+i]*v[k];
+      }
+      for (size_t k=n; k-->0;) {
+         v[k] /= LU[k*n+k];
+         for (size_t i=0; i<k; ++i)
+            v[i] -= LU[k*n+i]*v[k];
+      }
+      double s = 0.;
+      for (size_t i=0; i<n; ++i)
+         s += std::norm(v[i]);
+      s = 1./sqrt(s);
+      for (size_t i=0; i<n; ++i)
+         v[i] *= s;
+   }
+}
+
+
+/*
+ * Eigenvalues are sorted by increasing modulus, the eigenvalue of positive
+ * imaginary part of a complex pair first. The basis of the eigenvectors of
+ * the nv first eigenvalues holds one vector for a real eigenvalue and the real
+ * and imaginary parts of the eigenvector of a complex pair; a pair is not
+ * split, so that the basis may have nv+1 vectors.
+ */
+int denseEigen::general(size_t        n,
+                        const double* a,
+                        size_t        nv)
+{
+   if (n==0) {
+      cout << "Error: Empty matrix." << endl;
+      return 1;
+   }
+   _u.clear(), _v.clear();
+
+// Hessenberg form by Householder reflectors
+   vector<double> H(a,a+n*n), wr(n), wi(n);
+   for (size_t k=0; k+2<n; ++k) {
+      vector<double> x(&H[k*n+k+1],&H[k*n+n]);
+      double beta, tau = Householder(n-k-1,x.data(),beta);
+      if (tau==0.)
+         continue;
+      for (size_t j=k; j<n; ++j) {
+         double s = 0.;
+         for (size_t i=k+1; i<n; ++i)
+            s += x[i-k-1]*H[j*n+i];
+         s *= tau;
+         for (size_t i=k+1; i<n; ++i)
+            H[j*n+i] -= s*x[i-k-1];
+      }
+      for (size_t i=0; i<n; ++i) {
+         double s = 0.;
+         for (size_t j=k+1; j<n; ++j)
+            s += H[j*n+i]*x[j-k-1];
+         s *= tau;
+         for (size_t j=k+1; j<n; ++j)
+            H[j*n+i] -= s*x[j-k-1];
+      }
+      for (size_t i=k+2; i<n; ++i)
+         H[k*n+i] = 0.;
+   }
+   if (HessenbergQR(n,H.data(),wr.data(),wi.data())) {
+      cout << "Error: Eigenvalues of Hessenberg matrix did not converge." << endl;
+      return 1;
+   }
+   vector<size_t> id(n);
+   for (size_t i=0; i<n; ++i)
+      id[i] = i;
+   std::sort(id.begin(),id.end(),[&wr,&wi](size_t i, size_t j) {
+      double mi=std::hypot(wr[i],wi[i]), mj=std::hypot(wr[j],wi[j]);
+      if (mi!=mj)
+         return mi<mj;
+      return wi[i]>wi[j];
+   });
+   _values.resize(n), _imag.resize(n);
+   for (size_t i=0; i<n; ++i)
+      _values[i] = wr[id[i]], _imag[i] = wi[id[i]];
+
+// Eigenvectors of the nv first eigenvalues
+   vector<std::complex<double> > v(n);
+   for (size_t i=0; i<std::min(nv,n); ++i) {
+      InverseIteration(n,a,std::complex<double>(_values[i],_imag[i]),v.data());
+      for (size_t j=0; j<n; ++j)
+         _v.push_back(v[j].real());
+      if (_imag[i]!=0. && i+1<n) {
+         for (size_t j=0; j<n; ++j)
+            _v.push_back(v[j].imag());
+         i++;
+      }
+   }
+   return 0;
+}
+
+} /* namespace RITA */
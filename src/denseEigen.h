@@ -0,0 +1,84 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                      Definition of class 'denseEigen'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+using std::vector;
+
+namespace RITA {
+
+/*
+ * Spectra of dense matrices (see the commands eigen and svd of data).
+ * symmetric(): eigenvalues (increasing) and optionally eigenvectors of a
+ * symmetric matrix. The matrix is reduced to tridiagonal form by blocked
+ * Householder transformations: reflectors are generated by panels of columns
+ * and the rest of the matrix is updated once per panel by a rank-2k product.
+ * Eigenvectors of the tridiagonal matrix are computed by divide-and-conquer
+ * (Cuppen's method with deflation and Gu-Eisenstat's recomputation of the
+ * rank-one vector), eigenvalues alone by the implicit QL method. The
+ * eigenvectors of the matrix are obtained by applying the reflectors by
+ * blocks (compact WY representation).
+ * svd(): singular values (decreasing) and optionally singular vectors of a
+ * general matrix, reduced in the same way to bidiagonal form B. The singular
+ * values and vectors of B are those of the tridiagonal Golub-Kahan matrix
+ * [0 B; B^T 0] with permuted rows and columns, computed by the same
+ * tridiagonal solvers.
+ * general(): eigenvalues of a general matrix (Hessenberg reduction and
+ * Francis double shift QR algorithm) and a real basis of the eigenvectors of
+ * those of smallest modulus (inverse iteration), for small matrices.
+ * Matrices are stored by columns. Blocked kernels are tiled for the cache and
+ * run on the threads of rita (see parallel.h).
+ */
+class denseEigen
+{
+
+ public:
+
+    denseEigen() : _verb(1) { }
+    ~denseEigen() { }
+    void setVerbose(int verb) { _verb = verb; }
+    int symmetric(size_t n, const double* a, bool vectors);
+    int svd(size_t m, size_t n, const double* a, bool vectors);
+    int general(size_t n, const double* a, size_t nv);
+    const vector<double>& getValues() const { return _values; }
+    const vector<double>& getImagValues() const { return _imag; }
+    const vector<double>& getVectors() const { return _v; }
+    const vector<double>& getLeftVectors() const { return _u; }
+
+ private:
+
+    int _verb;
+    vector<double> _values, _imag, _u, _v;
+
+    int tridiagonal(size_t n, vector<double>& d, vector<double>& e, vector<double>* Z);
+};
+
+} /* namespace RITA */
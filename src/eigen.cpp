@@ -27,7 +27,70 @@
   ==============================================================================*/
 
 
+#include "eigen.h"
+#include "equa.h"
+#include "io/IOField.h"
+#include <iostream>
+#include <iomanip>
+
+using std::cout;
+using std::endl;
+
 namespace RITA {
 
+eigen::eigen(rita *r)
+      : _rita(r)
+{
+   _data = _rita->_data;
+}
+
+
+eigen::~eigen()
+{
+}
+
+
+/*
+ * Eigenvectors are saved in the files rita-<e><f>-<i>.sol, e being the
+ * equation, f the field and i the eigenvalue index
+ */
+int eigen::run()
+{
+   int ret = 0;
+   EigenMethod method = (_rita->_eigen_method=="lobpcg") ? LOBPCG_EIGEN : LANCZOS_EIGEN;
+   try {
+      for (int e=0; e<_rita->_nb_eq; ++e) {
+         if (_rita->_eq_type[e]!=PDE_EQ) {
+            _rita->msg("solve>run>","Eigenvalue analysis is available for PDEs only.");
+            continue;
+         }
+         equa *pde = _rita->PDE[e];
+         if ((ret=pde->runEigen(_rita->_nb_eigv,_rita->_eigen_shift,method))) {
+            _rita->msg("solve>run>","Failure of eigenvalue solver for equation "+to_string(e+1)+".");
+            return ret;
+         }
+         const eigenSolver &es = pde->getEigenSolver();
+         int f = pde->field[0];
+         if (_rita->_verb) {
+            cout << "Eigenvalues of equation " << e+1 << ":" << endl;
+            for (int i=0; i<es.getNbEigen(); ++i)
+               cout << std::setw(6) << i+1 << "  " << std::setprecision(10) << std::setw(18)
+                    << es.getEigenValue(i) << "  residual: " << std::setprecision(3) << es.getResidual(i) << endl;
+            cout << std::setprecision(6);
+         }
+         for (int i=es.getNbEigen()-1; i>=0; --i) {
+            pde->getEigenVector(i,*_data->u[f]);
+            if (_rita->_eigen_vectors) {
+               string fn = "rita-" + to_string(10*(e+1)+f+1) + "-" + to_string(i+1) + ".sol";
+               OFELI::IOField ff(fn,OFELI::IOField::OUT);
+               ff.put(*_data->u[f]);
+               if (_rita->_verb>1)
+                  cout << "Eigenvector " << i+1 << " saved in file " << fn << endl;
+            }
+         }
+      }
+   } CATCH
+   return ret;
+}
 
 } /* namespace RITA */
@@ -28,8 +28,16 @@
 
 #pragma once
 
+#include "rita.h"
+
 namespace RITA {
- 
+
+/*
+ * Eigenvalue analysis: the lowest eigenvalues of each PDE (or the closest ones
+ * to the shift given by the command eigen) are computed by eigenSolver and
+ * printed. The field of the equation receives the first eigenvector and, if
+ * required, all eigenvectors are saved in files.
+ */
 class eigen
 {
 
@@ -41,8 +49,8 @@ class eigen
 
  private:
 
+    rita *_rita;
+    data *_data;
 };
 
 } /* namespace RITA */
-
-#endif
@@ -0,0 +1,628 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                     Implementation of class 'eigenSolver'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+#include "eigenSolver.h"
+#include "cholesky.h"
+#include "amg.h"
+
+using std::cout;
+using std::endl;
+
+namespace RITA {
+
+// Rows of vector blocks processed together in Combine and Gram, for cache reuse
+static const size_t TILE = 256;
+
+/*
+ * Eigenvalues w (increasing) and eigenvectors (columns of Z) of the symmetric
+ * matrix H of size m (row major), by cyclic Jacobi rotations
+ */
+static void SymEigen(int             m,
+                     vector<double>  H,
+                     vector<double>& w,
+                     vector<double>& Z)
+{
+   Z.assign(m*m,0.);
+   for (int i=0; i<m; ++i)
+      Z[i*m+i] = 1.;
+   for (int sweep=0; sweep<100; ++sweep) {
+      double off=0., diag=0.;
+      for (int p=0; p<m; ++p) {
+         diag += H[p*m+p]*H[p*m+p];
+         for (int q=p+1; q<m; ++q)
+            off += H[p*m+q]*H[p*m+q];
+      }
+      if (off<=1.e-30*diag || off==0.)
+         break;
+      for (int p=0; p<m; ++p) {
+         for (int q=p+1; q<m; ++q) {
+            double apq = H[p*m+q];
+            if (apq==0.)
+               continue;
+            double theta = 0.5*(H[q*m+q]-H[p*m+p])/apq;
+            double t = 1./(fabs(theta)+sqrt(theta*theta+1.));
+            if (theta<0.)
+               t = -t;
+            double c=1./sqrt(t*t+1.), s=t*c;
+            for (int k=0; k<m; ++k) {
+               double akp=H[k*m+p], akq=H[k*m+q];
+               H[k*m+p] = c*akp - s*akq;
+               H[k*m+q] = s*akp + c*akq;
+            }
+            for (int k=0; k<m; ++k) {
+               double apk=H[p*m+k], aqk=H[q*m+k];
+               H[p*m+k] = c*apk - s*aqk;
+               H[q*m+k] = s*apk + c*aqk;
+            }
+            for (int k=0; k<m; ++k) {
+               double zkp=Z[k*m+p], zkq=Z[k*m+q];
+               Z[k*m+p] = c*zkp - s*zkq;
+               Z[k*m+q] = s*zkp + c*zkq;
+            }
+         }
+      }
+   }
+   vector<int> id(m);
+   for (int i=0; i<m; ++i)
+      id[i] = i;
+   std::sort(id.begin(),id.end(),[&H,m](int i, int j) { return H[i*m+i]<H[j*m+j]; });
+   vector<double> Y(Z);
+   w.resize(m);
+   for (int j=0; j<m; ++j) {
+      w[j] = H[id[j]*m+id[j]];
+      for (int i=0; i<m; ++i)
+         Z[i*m+j] = Y[i*m+id[j]];
+   }
+}
+
+
+static double Dot(const vector<double>& x,
+                  const vector<double>& y)
+{
+   return parallelSum(x.size(),[&](size_t b, size_t e) {
+      double s = 0.;
+      for (size_t i=b; i<e; ++i)
+         s += x[i]*y[i];
+      return s;
+   });
+}
+
+
+/*
+ * h[j] = (V_j,w) for the k vectors V_j = V[j*n:(j+1)*n]
+ */
+static void Project(const double* V,
+                    size_t        n,
+                    int           k,
+                    const double* w,
+                    double*       h)
+{
+   parallelSum(n,[&](size_t b, size_t e, double* s) {
+      for (int j=0; j<k; ++j) {
+         const double *v = V + j*n;
+         double t = 0.;
+         for (size_t i=b; i<e; ++i)
+            t += v[i]*w[i];
+         s[j] += t;
+      }
+   },h,k);
+}
+
+
+/*
+ * y[c*n:(c+1)*n] = a y + sum_j V_j Z(j,c) for c < nc, Z being row major with ld columns
+ */
+static void Combine(const double* V,
+                    size_t        n,
+                    int           k,
+                    const double* Z,
+                    int           ld,
+                    int           nc,
+                    double        a,
+                    double*       y)
+{
+   parallelFor(n,[&](size_t b0, size_t e0) {
+      for (size_t b=b0; b<e0; b+=TILE) {
+         size_t e = std::min(e0,b+TILE);
+         for (int c=0; c<nc; ++c) {
+            double *yc = y + c*n;
+            if (a!=1.)
+               for (size_t i=b; i<e; ++i)
+                  yc[i] *= a;
+            for (int j=0; j<k; ++j) {
+               double z = Z[j*ld+c];
+               if (z==0.)
+                  continue;
+               const double *v = V + j*n;
+               for (size_t i=b; i<e; ++i)
+                  yc[i] += z*v[i];
+            }
+         }
+      }
+   },1024);
+}
+
+
+/*
+ * G(i,j) = (A_i,B_j) for the na vectors A_i and the nb vectors B_j, computed
+ * in a single sweep
+ */
+static void Gram(const double* A,
+                 int           na,
+                 const double* B,
+                 int           nb,
+                 size_t        n,
+                 double*       G)
+{
+   parallelSum(n,[&](size_t b0, size_t e0, double* s) {
+      for (size_t b=b0; b<e0; b+=TILE) {
+         size_t e = std::min(e0,b+TILE);
+         for (int i=0; i<na; ++i) {
+            const double *x = A + i*n;
+            int j = 0;
+            for (; j+4<=nb; j+=4) {
+               const double *y0=B+j*n, *y1=y0+n, *y2=y1+n, *y3=y2+n;
+               double t0=0., t1=0., t2=0., t3=0.;
+               for (size_t l=b; l<e; ++l) {
+                  t0 += x[l]*y0[l], t1 += x[l]*y1[l];
+                  t2 += x[l]*y2[l], t3 += x[l]*y3[l];
+               }
+               s[i*nb+j] += t0, s[i*nb+j+1] += t1, s[i*nb+j+2] += t2, s[i*nb+j+3] += t3;
+            }
+            for (; j<nb; ++j) {
+               const double *y = B + j*n;
+               double t = 0.;
+               for (size_t l=b; l<e; ++l)
+                  t += x[l]*y[l];
+               s[i*nb+j] += t;
+            }
+         }
+      }
+   },G,na*nb);
+}
+
+
+/*
+ * Columns j0:q-1 of S are made M-orthonormal to the previous ones and to each
+ * other by blocks: block classical Gram-Schmidt followed by the orthonormalization
+ * of the block from the eigenvectors of its Gram matrix, both applied twice.
+ * Numerically dependent columns are removed. MS holds M S on return. Returns
+ * the new number of columns.
+ */
+static int Orthonormalize(const spmat<double>& M,
+                          vector<double>&      S,
+                          vector<double>&      MS,
+                          size_t               n,
+                          int                  j0,
+                          int                  q)
+{
+   int nc = q - j0;
+   double *B=&S[j0*n], *MB=&MS[j0*n];
+   vector<double> C, G, w, U, T(size_t(nc)*n);
+   for (int pass=0; pass<2 && nc>0; ++pass) {
+      if (j0>0) {
+         for (int c=0; c<nc; ++c)
+            M.mult(B+c*n,MB+c*n);
+         C.resize(j0*nc);
+         Gram(S.data(),j0,MB,nc,n,C.data());
+         for (auto &c: C)
+            c = -c;
+         Combine(S.data(),n,j0,C.data(),nc,nc,1.,B);
+      }
+      for (int c=0; c<nc; ++c)
+         M.mult(B+c*n,MB+c*n);
+      G.resize(nc*nc);
+      Gram(B,nc,MB,nc,n,G.data());
+      for (int i=0; i<nc; ++i)
+         for (int j=0; j<i; ++j)
+            G[i*nc+j] = G[j*nc+i] = 0.5*(G[i*nc+j]+G[j*nc+i]);
+      SymEigen(nc,G,w,U);
+      int k = 0;
+      for (int c=nc-1; c>=0 && w[c]>1.e-20*w[nc-1]; --c)
+         k++;
+      C.assign(nc*k,0.);
+      for (int i=0; i<nc; ++i)
+         for (int c=0; c<k; ++c)
+            C[i*k+c] = U[i*nc+nc-1-c]/sqrt(w[nc-1-c]);
+      Combine(B,n,nc,C.data(),k,k,0.,T.data());
+      std::copy(T.begin(),T.begin()+k*n,B);
+      Combine(MB,n,nc,C.data(),k,k,0.,T.data());
+      std::copy(T.begin(),T.begin()+k*n,MB);
+      nc = k;
+   }
+   return j0 + nc;
+}
+
+
+eigenSolver::eigenSolver()
+            : _method(LANCZOS_EIGEN), _verb(1), _max_it(1000), _nb_it(0), _shift(0.), _toler(1.e-8),
+              _fact_shift(0.), _fact(nullptr), _amg(nullptr), _fact_ok(false), _amg_ok(false)
+{
+}
+
+
+eigenSolver::~eigenSolver()
+{
+   if (_fact!=nullptr)
+      delete _fact;
+   if (_amg!=nullptr)
+      delete _amg;
+}
+
+
+/*
+ * The factorization and the preconditioner are kept if the matrices have not
+ * changed since last call
+ */
+int eigenSolver::setMatrices(spmat<double>&& K,
+                             spmat<double>&& M)
+{
+   if (K.size()!=M.size()) {
+      cout << "Error: Stiffness and mass matrices have different sizes." << endl;
+      return -1;
+   }
+   if (K.samePattern(_K) && K.a==_K.a && M.samePattern(_M) && M.a==_M.a)
+      return 0;
+   _K = std::move(K);
+   _M = std::move(M);
+   _fact_ok = _amg_ok = false;
+   return 1;
+}
+
+
+/*
+ * L D L^T factorization of K - shift*M, kept as long as the matrices and the
+ * shift do not change
+ */
+int eigenSolver::factor()
+{
+   if (_fact_ok && _fact_shift==_shift)
+      return 0;
+   size_t n = _K.size();
+   spmat<double> &A = _A;
+   A.clear();
+   A.nb_rows = A.nb_cols = n;
+   A.row_ptr.assign(n+1,0);
+   vector<size_t> pos(n,0);
+   for (size_t i=0; i<n; ++i) {
+      size_t b = A.a.size();
+      for (size_t k=_K.row_ptr[i]; k<_K.row_ptr[i+1]; ++k) {
+         pos[_K.col_ind[k]] = A.a.size();
+         A.col_ind.push_back(_K.col_ind[k]);
+         A.a.push_back(_K.a[k]);
+      }
+      for (size_t k=_M.row_ptr[i]; k<_M.row_ptr[i+1]; ++k) {
+         unsigned j = _M.col_ind[k];
+         if (pos[j]>=b && pos[j]<A.a.size() && A.col_ind[pos[j]]==j)
+            A.a[pos[j]] -= _shift*_M.a[k];
+         else {
+            pos[j] = A.a.size();
+            A.col_ind.push_back(j);
+            A.a.push_back(-_shift*_M.a[k]);
+         }
+      }
+      A.row_ptr[i+1] = A.a.size();
+   }
+   if (_fact==nullptr)
+      _fact = new cholesky<double>(true);
+   auto t0 = std::chrono::steady_clock::now();
+   int ret = _fact->setup(A);
+   if (_verb>1) {
+      _fact->print(cout);
+      cout << "Factorization time: " << std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count()
+           << " s" << endl;
+   }
+   _fact_ok = (ret==0);
+   _fact_shift = _shift;
+   return ret;
+}
+
+
+/*
+ * w = (K - sigma M)^{-1} M v, refined if the factorization is not exact
+ */
+void eigenSolver::shiftInvert(const double*    v,
+                              vector<double>&  mv,
+                              vector<double>&  w)
+{
+   size_t n = _K.size();
+   _M.mult(v,mv.data());
+   _fact->solve(mv,w);
+   if (_fact->getNbPerturbedPivots()==0)
+      return;
+   vector<double> r(n), z(n);
+   double nb = sqrt(Dot(mv,mv));
+   for (int it=0; it<5; ++it) {
+      _A.mult(w.data(),r.data());
+      for (size_t i=0; i<n; ++i)
+         r[i] = mv[i] - r[i];
+      if (sqrt(Dot(r,r))<=1.e-14*nb)
+         break;
+      _fact->solve(r,z);
+      for (size_t i=0; i<n; ++i)
+         w[i] += z[i];
+   }
+}
+
+
+int eigenSolver::run(int nb)
+{
+   size_t n = _K.size();
+   if (n==0 || nb<1) {
+      cout << "Error: Empty eigenvalue problem." << endl;
+      return 1;
+   }
+   nb = int(std::min(size_t(nb),n));
+   auto t0 = std::chrono::steady_clock::now();
+   int ret = (_method==LOBPCG_EIGEN) ? LOBPCG(nb) : Lanczos(nb);
+   if (ret)
+      return ret;
+   residuals(nb);
+   if (_verb>1)
+      cout << "Eigenvalue solver: " << ((_method==LOBPCG_EIGEN) ? "LOBPCG, " : "Lanczos, ") << _nb_it
+           << ((_method==LOBPCG_EIGEN) ? " iterations" : " restarts") << ", time: "
+           << std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count() << " s" << endl;
+   return 0;
+}
+
+
+/*
+ * Relative residuals |K x - lambda M x|/(|lambda| |M x|)
+ */
+void eigenSolver::residuals(int nb)
+{
+   size_t n = _K.size();
+   vector<double> kx(n), mx(n);
+   _res.resize(nb);
+   for (int c=0; c<nb; ++c) {
+      const double *x = &_x[c*n];
+      _K.mult(x,kx.data());
+      _M.mult(x,mx.data());
+      double nm = sqrt(Dot(mx,mx));
+      for (size_t i=0; i<n; ++i)
+         kx[i] -= _lambda[c]*mx[i];
+      _res[c] = sqrt(Dot(kx,kx))/(std::max(fabs(_lambda[c]),1.e-30)*std::max(nm,1.e-300));
+   }
+}
+
+
+/*
+ * Thick restart Lanczos method for OP = (K - sigma M)^{-1} M, self-adjoint in
+ * the M inner product. The basis V of m vectors satisfies
+ *   OP V = V H + beta v_m e_m^T
+ * with H symmetric (tridiagonal, apart from the row and column of the first
+ * vector added after a restart). At each restart, the Ritz vectors of the
+ * eigenvalues theta of H of largest modulus are kept with v_m. Eigenvalues of
+ * the problem are lambda = sigma + 1/theta.
+ */
+int eigenSolver::Lanczos(int nb)
+{
+   if (factor())
+      return 1;
+   size_t n = _K.size();
+   int m = int(std::min(n,size_t(std::max(2*nb+1,nb+20))));
+   vector<double> V((m+1)*n), w(n), mw(n), H(m*m,0.), h(m+1), h2(m+1), theta, Z;
+   vector<int> id(m);
+   for (size_t i=0; i<n; ++i)
+      w[i] = 1. + 0.1*((i*7919)%13);
+   _M.mult(w.data(),mw.data());
+   double beta = sqrt(Dot(mw,w));
+   for (size_t i=0; i<n; ++i)
+      V[i] = w[i]/beta;
+
+   int k=0, nconv=0;
+   for (_nb_it=1; _nb_it<=_max_it; ++_nb_it) {
+      for (int j=k; j<m; ++j) {
+         shiftInvert(&V[j*n],mw,w);
+
+//       Full reorthogonalization, twice
+         _M.mult(w.data(),mw.data());
+         Project(V.data(),n,j+1,mw.data(),h.data());
+         for (int i=0; i<=j; ++i)
+            h2[i] = -h[i];
+         Combine(V.data(),n,j+1,h2.data(),1,1,1.,w.data());
+         _M.mult(w.data(),mw.data());
+         Project(V.data(),n,j+1,mw.data(),h2.data());
+         for (int i=0; i<=j; ++i)
+            h[i] += h2[i], h2[i] = -h2[i];
+         Combine(V.data(),n,j+1,h2.data(),1,1,1.,w.data());
+         for (int i=0; i<=j; ++i)
+            H[i*m+j] = H[j*m+i] = h[i];
+         _M.mult(w.data(),mw.data());
+         beta = sqrt(std::max(Dot(mw,w),0.));
+
+//       Invariant subspace: continue with a new vector orthogonal to V
+         if (beta<=1.e-12*fabs(h[j])) {
+            for (size_t i=0; i<n; ++i)
+               w[i] = 1. + 0.1*(((i+j+1)*104729)%17);
+            for (int pass=0; pass<2; ++pass) {
+               _M.mult(w.data(),mw.data());
+               Project(V.data(),n,j+1,mw.data(),h2.data());
+               for (int i=0; i<=j; ++i)
+                  h2[i] = -h2[i];
+               Combine(V.data(),n,j+1,h2.data(),1,1,1.,w.data());
+            }
+            _M.mult(w.data(),mw.data());
+            double nw = sqrt(Dot(mw,w));
+            for (size_t i=0; i<n; ++i)
+               V[(j+1)*n+i] = w[i]/nw;
+            beta = 0.;
+         }
+         else {
+            for (size_t i=0; i<n; ++i)
+               V[(j+1)*n+i] = w[i]/beta;
+         }
+         if (j+1<m)
+            H[(j+1)*m+j] = H[j*m+j+1] = beta;
+      }
+
+//    Ritz values of largest modulus and their residuals
+      SymEigen(m,H,theta,Z);
+      for (int i=0; i<m; ++i)
+         id[i] = i;
+      std::stable_sort(id.begin(),id.end(),[&theta](int i, int j) { return fabs(theta[i])>fabs(theta[j]); });
+      nconv = 0;
+      for (int c=0; c<nb; ++c)
+         if (fabs(beta*Z[(m-1)*m+id[c]])<=0.01*_toler*fabs(theta[id[c]]))
+            nconv++;
+      if (_verb>2)
+         cout << "Lanczos restart " << _nb_it << ": " << nconv << " converged eigenvalues" << endl;
+      if (nconv==nb || _nb_it==_max_it || m==int(n))
+         break;
+
+//    Thick restart with k Ritz vectors
+      k = std::min(m-1,nb+(m-nb)/2);
+      vector<double> Zk(m*k), Y(k*n,0.);
+      for (int i=0; i<m; ++i)
+         for (int c=0; c<k; ++c)
+            Zk[i*k+c] = Z[i*m+id[c]];
+      Combine(V.data(),n,m,Zk.data(),k,k,0.,Y.data());
+      std::copy(Y.begin(),Y.end(),V.begin());
+      std::copy(V.begin()+m*n,V.begin()+(m+1)*n,V.begin()+k*n);
+      std::fill(H.begin(),H.end(),0.);
+      for (int c=0; c<k; ++c)
+         H[c*m+c] = theta[id[c]];
+   }
+   if (nconv<nb)
+      cout << "Warning: " << nconv << " eigenvalues out of " << nb << " converged within " << _max_it
+           << " restarts." << endl;
+
+// Eigenvectors, by increasing eigenvalues
+   std::sort(id.begin(),id.begin()+nb,[&theta,this](int i, int j) {
+      return _shift+1./theta[i] < _shift+1./theta[j]; });
+   vector<double> Zk(m*nb);
+   for (int i=0; i<m; ++i)
+      for (int c=0; c<nb; ++c)
+         Zk[i*nb+c] = Z[i*m+id[c]];
+   _x.assign(nb*n,0.);
+   Combine(V.data(),n,m,Zk.data(),nb,nb,0.,_x.data());
+   _lambda.resize(nb);
+   for (int c=0; c<nb; ++c)
+      _lambda[c] = _shift + 1./theta[id[c]];
+   return 0;
+}
+
+
+/*
+ * LOBPCG method with a block of bs >= nb vectors. The Rayleigh-Ritz
+ * projection is done on the M-orthonormalized basis S = [X W P], X being the
+ * current eigenvector approximations, W the preconditioned residuals and P
+ * the previous search directions. Converged vectors have no W and P.
+ */
+int eigenSolver::LOBPCG(int nb)
+{
+   size_t n = _K.size();
+   if (!_amg_ok) {
+      if (_amg==nullptr)
+         _amg = new amg<double>;
+      if (_amg->setup(_K))
+         return 1;
+      if (_verb>1)
+         _amg->print(cout);
+      _amg_ok = true;
+   }
+   int bs = int(std::min(n,size_t(nb+std::max(2,std::min(nb,8)))));
+   vector<double> S(3*bs*n), KS(3*bs*n), MS(3*bs*n), T(2*bs*n), r(n), z(n), H, theta, Z;
+   vector<double> lambda(bs,0.);
+   unsigned long seed = 12345;
+   for (size_t i=0; i<bs*n; ++i) {
+      seed = (seed*1103515245 + 12345)%2147483648UL;
+      S[i] = double(seed)/2147483648. - 0.5;
+   }
+   int nx=Orthonormalize(_M,S,MS,n,0,bs), q=nx, q0=0, nconv=0;
+   for (_nb_it=0; _nb_it<=_max_it; ++_nb_it) {
+
+//    Rayleigh-Ritz projection, K S being only computed for new columns
+      for (int j=q0; j<q; ++j)
+         _K.mult(&S[j*n],&KS[j*n]);
+      H.resize(q*q);
+      Gram(S.data(),q,KS.data(),q,n,H.data());
+      for (int i=0; i<q; ++i)
+         for (int j=0; j<i; ++j)
+            H[i*q+j] = H[j*q+i] = 0.5*(H[i*q+j]+H[j*q+i]);
+      SymEigen(q,H,theta,Z);
+      Combine(S.data(),n,q,Z.data(),q,nx,0.,T.data());
+      int np = 0;
+      if (q>nx) {
+         Combine(&S[nx*n],n,q-nx,&Z[nx*q],q,nx,0.,&T[nx*n]);
+         np = nx;
+      }
+      std::copy(T.begin(),T.begin()+nx*n,S.begin());
+      for (int c=0; c<nx; ++c) {
+         _K.mult(&S[c*n],&KS[c*n]);
+         _M.mult(&S[c*n],&MS[c*n]);
+         lambda[c] = theta[c];
+      }
+
+//    Residuals and preconditioned residuals of active vectors
+      vector<int> active;
+      nconv = 0;
+      for (int c=0; c<nx; ++c) {
+         double rn=0., mn=0.;
+         for (size_t i=0; i<n; ++i) {
+            r[i] = KS[c*n+i] - lambda[c]*MS[c*n+i];
+            rn += r[i]*r[i], mn += MS[c*n+i]*MS[c*n+i];
+         }
+         if (sqrt(rn)<=_toler*std::max(fabs(lambda[c]),1.e-30)*sqrt(mn)) {
+            if (c<nb)
+               nconv++;
+            continue;
+         }
+         _amg->solve(r,z);
+         std::copy(z.begin(),z.end(),&S[(nx+active.size())*n]);
+         active.push_back(c);
+      }
+      if (_verb>2)
+         cout << "LOBPCG iteration " << _nb_it << ": " << nconv << " converged eigenvalues" << endl;
+      if (nconv>=nb || _nb_it==_max_it || active.size()==0)
+         break;
+
+//    New basis [X W P]
+      int na = int(active.size());
+      q = nx + na;
+      if (np) {
+         for (int a=0; a<na; ++a)
+            std::copy(&T[(nx+active[a])*n],&T[(nx+active[a]+1)*n],&S[(q+a)*n]);
+         q += na;
+      }
+      q = Orthonormalize(_M,S,MS,n,nx,q);
+      q0 = nx;
+   }
+   if (nconv<nb)
+      cout << "Warning: " << nconv << " eigenvalues out of " << nb << " converged within " << _max_it
+           << " iterations." << endl;
+   _lambda.assign(lambda.begin(),lambda.begin()+nb);
+   _x.assign(S.begin(),S.begin()+nb*n);
+   return 0;
+}
+
+} /* namespace RITA */
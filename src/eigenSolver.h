@@ -0,0 +1,103 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Definition of class 'eigenSolver'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include "linearSolver.h"
+
+namespace RITA {
+
+template<class T_> class cholesky;
+template<class T_> class amg;
+
+/*
+ * Methods of the sparse eigenvalue solver
+ */
+enum EigenMethod {
+   LANCZOS_EIGEN = 0,
+   LOBPCG_EIGEN  = 1
+};
+
+
+/*
+ * Eigenvalues and eigenvectors of the generalized symmetric problem
+ *   K x = lambda M x
+ * with M symmetric positive definite (e.g. lumped mass matrix).
+ * LANCZOS_EIGEN: thick restart Lanczos method (equivalent to the implicitly
+ * restarted Lanczos method for symmetric problems) in shift-invert mode, i.e.
+ * applied to (K - sigma M)^{-1} M in the M inner product. It gives the
+ * eigenvalues closest to the shift sigma (the lowest ones for sigma=0). The
+ * sparse factorization of K - sigma M (see cholesky) is kept as long as the
+ * matrices and the shift do not change; its symbolic analysis is also kept
+ * when only the shift changes. If pivots of the factorization had to be
+ * perturbed, the solves are improved by iterative refinement.
+ * LOBPCG_EIGEN: locally optimal block preconditioned conjugate gradient
+ * method, preconditioned by an AMG hierarchy of K. It gives the lowest
+ * eigenvalues and does not need any factorization, which makes it the method
+ * of choice for large 3-D problems.
+ * Eigenvectors are normalized by x^T M x = 1.
+ */
+class eigenSolver
+{
+
+ public:
+
+    eigenSolver();
+    ~eigenSolver();
+    void setVerbose(int verb) { _verb = verb; }
+    void setMethod(EigenMethod m) { _method = m; }
+    void setShift(double s) { _shift = s; }
+    void setTolerance(double toler) { _toler = toler; }
+    void setMaxIter(int max_it) { _max_it = max_it; }
+    int setMatrices(spmat<double>&& K, spmat<double>&& M);
+    int run(int nb);
+    int getNbEigen() const { return int(_lambda.size()); }
+    double getEigenValue(int i) const { return _lambda[i]; }
+    const double* getEigenVector(int i) const { return &_x[i*_K.size()]; }
+    double getResidual(int i) const { return _res[i]; }
+    int getNbIter() const { return _nb_it; }
+
+ private:
+
+    EigenMethod _method;
+    int _verb, _max_it, _nb_it;
+    double _shift, _toler, _fact_shift;
+    spmat<double> _K, _M, _A;
+    cholesky<double> *_fact;
+    amg<double> *_amg;
+    bool _fact_ok, _amg_ok;
+    vector<double> _lambda, _x, _res;
+
+    int factor();
+    void shiftInvert(const double* v, vector<double>& mv, vector<double>& w);
+    int Lanczos(int nb);
+    int LOBPCG(int nb);
+    void residuals(int nb);
+};
+
+} /* namespace RITA */
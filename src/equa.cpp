@@ -26,17 +26,46 @@
 
   ==============================================================================*/
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
 #include "equa.h"
 #include "cmd.h"
 #include "rita.h"
+#include "parallel.h"
+#include "mesh.h"
 
 namespace RITA {
 
+/*
+ * Whether the expression e contains the variable v (as a whole identifier)
+ */
+static bool Depends(const string& e,
+                    const string& v)
+{
+   for (size_t i=e.find(v); i!=string::npos; i=e.find(v,i+1)) {
+      size_t j = i + v.size();
+      if ((i==0 || !(isalnum(e[i-1]) || e[i-1]=='_')) && (j==e.size() || !(isalnum(e[j]) || e[j]=='_')))
+         return true;
+   }
+   return false;
+}
+
+
 equa::equa(rita *r)
      : eq("laplace"), nls(""), spD("feP1"),
-       ls(CG_SOLVER), prec(DILU_PREC), _nb_fields(0), _theMesh(nullptr)
+       ls(CG_SOLVER), prec(DILU_PREC), xprec(NO_EXT_PREC), mixed(false), matrix_free(false),
+       parallel_prec(false), multicolor(false), recycle(false), auto_ls(false), asm_overlap(1),
+       asm_direct(false), asm_coarse(false), _nb_fields(0),
+       _theMesh(nullptr), _smesh(nullptr), _ls_selected(false), _grid_set(false), _mf_dt(0.), _mf_asm(false), _ns_set(false),
+       _ls_dt(0.)
 {
    _rita = r;
+   for (int i=0; i<5; ++i)
+      theSolution[i] = nullptr;
    _verb = 0;
    field.resize(6);
    fn.resize(6);
@@ -66,6 +95,63 @@ int equa::set(string e, Mesh* ms)
 }
 
 
+/*
+ * Equation on a structured mesh: no OFELI equation is created, the equation is
+ * solved by runStructured with the matrix-free operator of the grid.
+ */
+int equa::set(string                e,
+              const structuredMesh* g)
+{
+   ieq = pde_map[e];
+   eq = e;
+   _theMesh = nullptr;
+   _smesh = g;
+   _dim = g->getDim();
+   _nb_dof = g->getNbDOF();
+   setFields();
+   return 0;
+}
+
+
+/*
+ * Equation on a new mesh of the domain (mesh adaptation). Data given by
+ * expressions are evaluated again on this mesh by the solver.
+ */
+void equa::setMesh(Mesh* ms)
+{
+   Iteration s = ls;
+   Preconditioner p = prec;
+   _theMesh = ms;
+   _dim = _theMesh->getDim();
+   _nb_dof = _theMesh->getNbDOF()/_theMesh->getNbNodes();
+   if (theEquation!=nullptr)
+      delete theEquation, theEquation = nullptr;
+   set();
+   ls = s, prec = p;
+   if (set_u) {
+      u.setMesh(*ms,NODE_DOF,_nb_dof);
+      u.setRegex(1);
+   }
+   if (set_bc) {
+      bc.setMesh(*ms,NODE_DOF,_nb_dof);
+      bc.setRegex(1);
+   }
+   if (set_bf) {
+      bf.setMesh(*ms,NODE_DOF,_nb_dof);
+      bf.setRegex(1);
+   }
+   if (set_sf) {
+      sf.setMesh(*ms,SIDE_DOF,_nb_dof);
+      sf.setRegex(1);
+   }
+   b.setSize(_theMesh->getNbEq());
+   _mf = matrixFree();
+   _grid_set = _ns_set = false;
+   _lmass.clear();
+   _ls_dt = 0.;
+}
+
+
 void equa::setFields()
 {
    switch (ieq) {
@@ -175,6 +261,8 @@ void equa::setFields()
 
 void equa::setSize(Vect<double>& v, dataSize s)
 {
+   if (_smesh!=nullptr)
+      return;
    _theMesh = _rita->_theMesh;
    if (_theMesh==nullptr) {
       _rita->msg("pde>","No mesh data available.");
@@ -228,7 +316,8 @@ void equa::setSize(Vect<double>& v, dataSize s)
 
 int equa::setIn()
 {
-   u.setMesh(*_theMesh,NODE_DOF,_nb_dof);
+   if (_smesh==nullptr)
+      u.setMesh(*_theMesh,NODE_DOF,_nb_dof);
    theSolution[0] = &u;
    bool val_ok=false, file_ok=false, save_ok=false;
    _ret = 0;
@@ -497,6 +586,68 @@ int equa::setBF()
 }
 
 
+/*
+ * Additional load case: body force and boundary forces replacing those of the
+ * equation. Load cases are solved together with the equation (see runCases).
+ */
+int equa::setCase()
+{
+   int code = 0;
+   string src = "";
+   std::map<int,string> sfc;
+   const static vector<string> kw {"source","code","val$ue"};
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   if (nb_args==0) {
+      _rita->msg("pde>case>","No arguments");
+      return 1;
+   }
+   for (int i=0; i<nb_args; ++i) {
+      int n = _cmd->getArg("=");
+      switch (n) {
+
+         case 0:
+            src = _cmd->string_token();
+            break;
+
+         case 1:
+            code = _cmd->int_token();
+            if (code<=0) {
+               _rita->msg("pde>case>","Illegal value of code: "+to_string(code));
+               return 1;
+            }
+            break;
+
+         case 2:
+            if (code==0) {
+               _rita->msg("pde>case>","No code given for boundary force "+_cmd->string_token()+".");
+               return 1;
+            }
+            sfc[code] = _cmd->string_token();
+            code = 0;
+            break;
+
+         default:
+            _rita->msg("pde>case>","Unknown argument: "+kw[n]);
+            return 1;
+      }
+   }
+   if (src=="" && sfc.empty()) {
+      _rita->msg("pde>case>","No source or boundary force given for load case.");
+      return 1;
+   }
+   *_rita->ofh << "  case";
+   if (src!="")
+      *_rita->ofh << "  source=" << src;
+   for (auto const& v: sfc)
+      *_rita->ofh << "  code=" << v.first << "  value=" << v.second;
+   *_rita->ofh << endl;
+   case_bf.push_back(src);
+   case_sf.push_back(sfc);
+   return 0;
+}
+
+
 void equa::setNodeBC(int code, string exp, double t, Vect<double>& v)
 {
    const static vector<string> var {"x","y","z","t"};
@@ -511,6 +662,1030 @@ void equa::setNodeBC(int code, string exp, double t, Vect<double>& v)
 }
 
 
+/*
+ * Stationary solution. When a rita preconditioner or mixed precision is
+ * selected, the system is assembled (by element colours in parallel for P1
+ * laplace and heat equations, by OFELI otherwise) and solved by the rita
+ * iterative solver. In matrix-free mode, no matrix is assembled.
+ */
+int equa::run(Vect<double>& u)
+{
+   if (_smesh!=nullptr)
+      return runStructured(u);
+   if (matrix_free && setMatrixFree()) {
+      _rita->msg("solve>","Matrix-free operator available for laplace and heat equations with "
+                 "feP1 in 2-D and 3-D only.","The matrix is assembled instead.");
+      matrix_free = false;
+   }
+   if (matrix_free)
+      return runMatrixFree(u,0.);
+   if (blockSolver())
+      return runNavierStokes(u,0.);
+   if (!ritaSolver()) {
+      theEquation->setSolver(ls,prec);
+      return theEquation->run();
+   }
+   if (parallelAssembly())
+      return runMatrixFree(u,0.);
+   auto t0 = std::chrono::steady_clock::now();
+   theEquation->build();
+   if (_rita->_verb>1)
+      cout << "Assembly time: " << std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count()
+           << " s" << endl;
+   _lsolver.setMatrix(*theEquation->getMatrix());
+   if (auto_ls)
+      selectLinearSolver(theEquation->getRHS());
+   setLinearSolver();
+   Vect<double> x;
+   gatherEq(u,x);
+   int ret = _lsolver.solve(theEquation->getRHS(),x);
+   scatterEq(x,u);
+   return ret;
+}
+
+
+/*
+ * Solution of the stationary equation (in u) and of its load cases (in uc)
+ * with one matrix and one preconditioner or factorization: the right-hand
+ * sides are solved together by linearSolver. With the OFELI assembly, the
+ * matrix is assembled once. The right-hand side being affine in the forces,
+ * that of a load case is b + L(f_c,s_c) - L(f,s), where L is the load vector
+ * assembled by an equation with no matrix terms.
+ */
+int equa::runCases(Vect<double>&           u,
+                   vector<Vect<double> >& uc)
+{
+   uc.assign(case_bf.size(),u);
+   if (matrix_free && setMatrixFree()) {
+      _rita->msg("solve>","Matrix-free operator available for laplace and heat equations with "
+                 "feP1 in 2-D and 3-D only.","The matrix is assembled instead.");
+      matrix_free = false;
+   }
+   if (blockSolver()) {
+      _rita->msg("solve>","Load cases are not available with the block preconditioned solver.");
+      return 1;
+   }
+   bool with_sf = set_sf;
+   for (auto const& c: case_sf)
+      with_sf = with_sf || !c.empty();
+   if (matrix_free || (!with_sf && parallelAssembly()))
+      return runMatrixFree(u,0.,&uc);
+
+   size_t nc = case_bf.size() + 1;
+   vector<Vect<double> > b(nc), x(nc);
+   auto t0 = std::chrono::steady_clock::now();
+   theEquation->build();
+   b[0] = theEquation->getRHS();
+   gatherEq(u,x[0]);
+   _lsolver.setMatrix(*theEquation->getMatrix());
+   if (auto_ls)
+      selectLinearSolver(b[0]);
+   setLinearSolver();
+
+// Loads of the equation and of the cases
+   for (size_t c=1; c<nc; ++c)
+      b[c] = b[0];
+   Vect<double> f, s;
+   Equa<double> *le = newEquation();
+   le->setTerms(0);
+   if (set_bc)
+      le->setInput(BOUNDARY_CONDITION,bc);
+   for (size_t c=0; c<nc; ++c) {
+      if (c==0 && !set_bf && !set_sf)
+         continue;
+      setSize(f,NODES);
+      setSize(s,SIDES);
+      if (c==0) {
+         if (set_bf)
+            f = bf;
+         if (set_sf)
+            s = sf;
+      }
+      else {
+         if (case_bf[c-1]!="")
+            f.set(case_bf[c-1]);
+         for (auto const& v: case_sf[c-1])
+            s.setSideBC(v.first,v.second);
+      }
+      le->setInput(BODY_FORCE,f);
+      le->setInput(BOUNDARY_FORCE,s);
+      le->build();
+      if (c==0) {
+         for (size_t k=1; k<nc; ++k)
+            b[k] -= le->getRHS();
+      }
+      else
+         b[c] += le->getRHS();
+   }
+   delete le;
+   if (_rita->_verb>1)
+      cout << "Assembly time: " << std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count()
+           << " s" << endl;
+   int ret = _lsolver.solve(b,x);
+   scatterEq(x[0],u);
+   for (size_t c=1; c<nc; ++c)
+      scatterEq(x[c],uc[c-1]);
+   return ret;
+}
+
+
+/*
+ * One backward Euler time step for the heat equation with the rita solver:
+ *   (M/dt + K) u^{n+1} = M/dt u^n + b
+ * with M the lumped capacity matrix. Rows of prescribed unknowns are left as
+ * assembled. The matrix is given again to the solver (and the preconditioner
+ * rebuilt) only when the time step changes or the conductivity depends on t.
+ */
+int equa::runOneTimeStep(Vect<double>& u,
+                         double        dt)
+{
+   if (matrix_free && setMatrixFree()) {
+      _rita->msg("solve>","Matrix-free operator available for laplace and heat equations with "
+                 "feP1 in 2-D and 3-D only.","The matrix is assembled instead.");
+      matrix_free = false;
+   }
+   if (matrix_free)
+      return runMatrixFree(u,dt);
+   if (blockSolver())
+      return runNavierStokes(u,dt);
+   if (parallelAssembly())
+      return runMatrixFree(u,dt);
+   if (_lmass.size()==0)
+      setLumpedMass();
+   theEquation->setTerms(DIFFUSION);
+   auto t0 = std::chrono::steady_clock::now();
+   theEquation->build();
+   if (_rita->_verb>1)
+      cout << "Assembly time: " << std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count()
+           << " s" << endl;
+   Vect<double> x, b(theEquation->getRHS());
+   gatherEq(u,x);
+   vector<double> d(b.size(),0.);
+   for (size_t i=0; i<_lmass.size(); ++i) {
+      if (_lmass[i]>0.) {
+         d[i] = _lmass[i]/dt;
+         b[i] += d[i]*x[i];
+      }
+   }
+   bool changed = (dt!=_ls_dt || (_kappa_set && Depends(_kappa_exp,"t")));
+   _lsolver.setMatrix(*theEquation->getMatrix(),d,changed);
+   _ls_dt = dt;
+   if (auto_ls)
+      selectLinearSolver(b);
+   setLinearSolver();
+   int ret = _lsolver.solve(b,x);
+   scatterEq(x,u);
+   return ret;
+}
+
+
+void equa::setLinearSolver()
+{
+   if (ls==DIRECT_SOLVER && xprec!=CHOLESKY_PREC && xprec!=LDLT_PREC) {
+      _rita->msg("solve>","Direct solver of rita needs the factorization cholesky or ldlt.",
+                 "Factorization ldlt is used.");
+      xprec = LDLT_PREC;
+   }
+   if (matrix_free && (xprec==CHOLESKY_PREC || xprec==LDLT_PREC)) {
+      _rita->msg("solve>","Direct solver needs an assembled matrix.","Solver cg is used instead.");
+      ls = CG_SOLVER;
+   }
+   if (matrix_free && (xprec==AMG_PREC || xprec==GMG_PREC || xprec==CHOLESKY_PREC || xprec==LDLT_PREC ||
+                       xprec==ASM_PREC)) {
+      _rita->msg("solve>","Preconditioner "+_rita->rxPrec[xprec]+" needs an assembled matrix.",
+                 "Preconditioner chebyshev is used instead.");
+      xprec = CHEBYSHEV_PREC;
+   }
+   if ((xprec==SCHUR_MASS_PREC || xprec==SCHUR_PCD_PREC) && !blockSolver()) {
+      _rita->msg("solve>","Preconditioner "+_rita->rxPrec[xprec]+" is available for the equation "
+                 "incompressible-navier-stokes with feP1 only.","Preconditioner amg is used instead.");
+      xprec = AMG_PREC;
+   }
+   if (blockSolver() && ls!=GMRES_SOLVER && ls!=BICG_STAB_SOLVER) {
+      _rita->msg("solve>","Linear solver "+_rita->rLs[ls]+" cannot be used for a saddle point system.",
+                 "Linear solver gmres is used instead.");
+      ls = GMRES_SOLVER;
+   }
+   if (recycle && ls!=GMRES_SOLVER) {
+      _rita->msg("solve>","Recycling of a Krylov subspace is available with the linear solver gmres only.",
+                 "Linear solver "+_rita->rLs[ls]+" is used without recycling.");
+      recycle = false;
+   }
+   if (xprec==GMG_PREC && setGrid()) {
+      _rita->msg("solve>","Mesh is not a structured grid of rectangles or cubes: gmg cannot be used.",
+                 "Preconditioner amg is used instead.");
+      xprec = AMG_PREC;
+   }
+   if (xprec==ASM_PREC)
+      setPartition();
+   if (matrix_free && xprec==NO_EXT_PREC && prec!=IDENT_PREC && prec!=DIAG_PREC) {
+      _rita->msg("solve>","Preconditioner "+_rita->rPrec[prec]+" needs an assembled matrix.",
+                 "Preconditioner diag is used instead.");
+      prec = DIAG_PREC;
+   }
+   _lsolver.setVerbose(_rita->_verb);
+   _lsolver.set(ls,prec,xprec);
+   _lsolver.setMixedPrecision(mixed);
+   _lsolver.setMulticolor(multicolor);
+   _lsolver.setRecycle(recycle ? 5 : 0);
+}
+
+
+/*
+ * Choice of the linear solver and preconditioner by trial solves of the first
+ * system (matrix given to _lsolver, right-hand side b) with the combinations
+ * implemented in rita (cg and the direct solver cholesky only for symmetric
+ * matrices): the combination with the smallest setup and solve time is kept.
+ * Trials that cannot beat the best time are stopped. The choice is saved in
+ * $HOME/.rita.ls for the equation, the space discretization and the size
+ * class of the system (power of 2 of the number of equations), so that later
+ * runs do not repeat the trials. Nothing is read or saved if HOME is not set.
+ */
+void equa::selectLinearSolver(const Vect<double>& b)
+{
+   if (_ls_selected)
+      return;
+   _ls_selected = true;
+   size_t n = b.size();
+   if (n==0)
+      return;
+   string key = eq + " " + spD + " " + std::to_string(int(std::log2(double(n))));
+   const char *home = getenv("HOME");
+   string file = home ? string(home) + "/.rita.ls" : "";
+   map<string,std::pair<string,string> > cache;
+   std::ifstream ic;
+   if (home)
+      ic.open(file);
+   string l;
+   while (std::getline(ic,l)) {
+      std::istringstream is(l);
+      string e, s, sz, sl, sp;
+      if (l.size() && l[0]!='#' && (is >> e >> s >> sz >> sl >> sp))
+         cache[e+" "+s+" "+sz] = std::make_pair(sl,sp);
+   }
+   ic.close();
+   auto c = cache.find(key);
+   if (c!=cache.end() && _rita->Ls.count(c->second.first) &&
+       (_rita->Prec.count(c->second.second) || _rita->xPrec.count(c->second.second))) {
+      ls = _rita->Ls[c->second.first];
+      prec = IDENT_PREC;
+      xprec = NO_EXT_PREC;
+      if (_rita->xPrec.count(c->second.second))
+         xprec = _rita->xPrec[c->second.second];
+      else
+         prec = _rita->Prec[c->second.second];
+      if (_rita->_verb)
+         cout << "Linear solver: " << c->second.first << " " << c->second.second
+              << " (from " << file << ")" << endl;
+      return;
+   }
+
+   linearSolver t;
+   t.setVerbose(0);
+   bool sym = _lsolver.isSymmetric();
+   vector<Iteration> sl;
+   if (sym)
+      sl = {CG_SOLVER, BICG_STAB_SOLVER, GMRES_SOLVER};
+   else
+      sl = {BICG_STAB_SOLVER, GMRES_SOLVER};
+   const vector<string> pl {"amg","asm","ilu","dilu","ssor","chebyshev","diag","ident"};
+   double best = -1.;
+   string bs, bp;
+   for (auto s: sl) {
+      for (auto const& p: pl) {
+
+//       A first solve of 10 iterations gives the setup time and the time of an
+//       iteration; the trial is pursued only if it can beat the best one
+         spmat<double> A(_lsolver.getMatrix());
+         t.set(s,_rita->Prec.count(p) ? _rita->Prec[p] : IDENT_PREC,
+               _rita->xPrec.count(p) ? _rita->xPrec[p] : NO_EXT_PREC);
+         t.setMatrix(std::move(A));
+         t.setMaxIter(10);
+         Vect<double> x(n);
+         int ret = t.solve(b,x);
+         double tt = t.getSetupTime() + t.getSolveTime();
+         if (ret && std::abs(t.getNbIter())>0) {
+            double ti = t.getSolveTime()/std::abs(t.getNbIter());
+            int max_it = (best<0. ? 990 : std::min(990,int((best-tt)/ti)));
+            if (max_it>0) {
+               t.setMaxIter(max_it);
+               ret = t.solve(b,x);
+               tt += t.getSolveTime();
+            }
+         }
+         if (_rita->_verb>1)
+            cout << "Trial of " << _rita->rLs[s] << " " << p << ": "
+                 << (ret ? string("stopped") : std::to_string(tt)+" s") << endl;
+         if (ret==0 && (best<0. || tt<best))
+            best = tt, bs = _rita->rLs[s], bp = p;
+      }
+   }
+
+// Direct solver, for systems of moderate size
+   if (sym && n<=200000) {
+      spmat<double> A(_lsolver.getMatrix());
+      t.set(DIRECT_SOLVER,IDENT_PREC,CHOLESKY_PREC);
+      t.setMatrix(std::move(A));
+      t.setMaxIter(1000);
+      Vect<double> x(n);
+      int ret = t.solve(b,x);
+      double tt = t.getSetupTime() + t.getSolveTime();
+      if (_rita->_verb>1)
+         cout << "Trial of direct cholesky: " << (ret ? string("failed") : std::to_string(tt)+" s") << endl;
+      if (ret==0 && (best<0. || tt<best))
+         best = tt, bs = "direct", bp = "cholesky";
+   }
+   if (best<0.) {
+      _rita->msg("solve>","No linear solver converged in the trial solves.",
+                 "Solver "+_rita->rLs[ls]+" with preconditioner "+_rita->rPrec[prec]+" is used.");
+      return;
+   }
+   ls = _rita->Ls[bs];
+   prec = IDENT_PREC;
+   xprec = NO_EXT_PREC;
+   if (_rita->xPrec.count(bp))
+      xprec = _rita->xPrec[bp];
+   else
+      prec = _rita->Prec[bp];
+   if (_rita->_verb)
+      cout << "Linear solver selected: " << bs << " " << bp << " (" << best << " s)" << endl;
+   if (home==nullptr)
+      return;
+   cache[key] = std::make_pair(bs,bp);
+   std::ofstream oc(file);
+   oc << "# rita linear solvers selected by ls auto" << endl;
+   for (auto const& v: cache)
+      oc << v.first << " " << v.second.first << " " << v.second.second << endl;
+}
+
+
+/*
+ * Check whether mesh nodes are those of a structured grid (meshes generated
+ * by the commands rectangle and cube) and give the grid to the linear solver.
+ * Nodes are located by their coordinates, so that their numbering is not
+ * relevant.
+ */
+int equa::setGrid()
+{
+   if (_grid_set)
+      return 0;
+   if (_smesh!=nullptr) {
+      size_t ne[3] = {0,0,0};
+      for (int a=0; a<_dim; ++a)
+         ne[a] = _smesh->getNbElements(a);
+      vector<size_t> node(_smesh->getNbEq());
+      for (size_t i=0; i<node.size(); ++i)
+         node[i] = _smesh->getNodeOfEq(i);
+      _lsolver.setGrid(_dim,ne,node);
+      _grid_set = true;
+      return 0;
+   }
+   size_t nn = _theMesh->getNbNodes(), ne[3] = {0,0,0}, np = 1;
+   if (_nb_dof!=1 || _dim<2)
+      return 1;
+   auto coord = [](const Node* nd, int a) {
+      Point<double> c = nd->getCoord();
+      return (a==0) ? c.x : ((a==1) ? c.y : c.z);
+   };
+   vector<double> xc[3];
+   for (int a=0; a<_dim; ++a) {
+      for (size_t n=1; n<=nn; ++n)
+         xc[a].push_back(coord((*_theMesh)[n],a));
+      std::sort(xc[a].begin(),xc[a].end());
+      double eps = 1.e-8*(xc[a].back()-xc[a].front());
+      xc[a].erase(std::unique(xc[a].begin(),xc[a].end(),
+                              [eps](double u, double v) { return fabs(u-v)<=eps; }),xc[a].end());
+      ne[a] = xc[a].size() - 1;
+      np *= ne[a] + 1;
+   }
+   if (np!=nn)
+      return 1;
+
+   vector<size_t> node(_theMesh->getNbEq());
+   vector<bool> used(nn,false);
+   for (size_t n=1; n<=nn; ++n) {
+      Node *nd = (*_theMesh)[n];
+      size_t g=0, s=1;
+      for (int a=0; a<_dim; ++a) {
+         double x = coord(nd,a);
+         size_t i = std::lower_bound(xc[a].begin(),xc[a].end(),x) - xc[a].begin();
+         if (i==xc[a].size() || (i>0 && x-xc[a][i-1]<xc[a][i]-x))
+            i--;
+         g += i*s;
+         s *= ne[a] + 1;
+      }
+      if (used[g])
+         return 1;
+      used[g] = true;
+      if (nd->getDOF(1)>0)
+         node[nd->getDOF(1)-1] = g;
+   }
+   _lsolver.setGrid(_dim,ne,node);
+   _grid_set = true;
+   return 0;
+}
+
+
+/*
+ * Subdomains of the Schwarz preconditioner from the partition of the mesh
+ * (command partition): each equation goes to the subdomain owning its node.
+ * Without partition of the mesh of the equation, the linear solver
+ * partitions the graph of the matrix.
+ */
+void equa::setPartition()
+{
+   vector<int> part;
+   const partition *pt = (_smesh==nullptr) ? _rita->_mesh->getPartition() : nullptr;
+   if (pt!=nullptr && _rita->_mesh->getMesh()==_theMesh) {
+      const vector<int> &owner = pt->getNodeOwner();
+      size_t nn = _theMesh->getNbNodes();
+      if (_mf_asm) {
+         part.resize(_mf.size());
+         for (size_t n=1; n<=nn; ++n)
+            if (_mf_eq[n-1]>=0)
+               part[_mf_eq[n-1]] = owner[n-1];
+      }
+      else {
+         part.resize(_theMesh->getNbEq());
+         for (size_t n=1; n<=nn; ++n) {
+            Node *nd = (*_theMesh)[n];
+            for (size_t k=1; k<=nd->getNbDOF(); ++k)
+               if (nd->getDOF(k)>0)
+                  part[nd->getDOF(k)-1] = owner[n-1];
+         }
+      }
+   }
+   _lsolver.setSchwarz(part,asm_overlap,asm_direct,asm_coarse);
+}
+
+
+/*
+ * Nodal vector <-> vector of equations. Imposed DOFs that are removed from the
+ * system (equation number 0) take their boundary value
+ */
+void equa::gatherEq(const Vect<double>& u,
+                    Vect<double>&       x)
+{
+   x.setSize(_theMesh->getNbEq());
+   for (size_t n=1; n<=_theMesh->getNbNodes(); ++n) {
+      Node *nd = (*_theMesh)[n];
+      for (size_t k=1; k<=nd->getNbDOF(); ++k)
+         if (nd->getDOF(k)>0)
+            x[nd->getDOF(k)-1] = u(n,k);
+   }
+}
+
+
+void equa::scatterEq(const Vect<double>& x,
+                     Vect<double>&       u)
+{
+   for (size_t n=1; n<=_theMesh->getNbNodes(); ++n) {
+      Node *nd = (*_theMesh)[n];
+      for (size_t k=1; k<=nd->getNbDOF(); ++k) {
+         if (nd->getDOF(k)>0)
+            u(n,k) = x[nd->getDOF(k)-1];
+         else if (set_bc)
+            u(n,k) = bc(n,k);
+      }
+   }
+}
+
+
+/*
+ * Lumped capacity of P1 elements: rho*Cp*|T|/(nb of vertices) per vertex and
+ * degree of freedom. Prescribed unknowns get a zero entry.
+ */
+void equa::setLumpedMass()
+{
+   const static vector<string> var {"x","y","z","t"};
+   OFELI::Fct rho, Cp;
+   if (_rho_set)
+      rho.set(_rho_exp,var);
+   if (_Cp_set)
+      Cp.set(_Cp_exp,var);
+   _lmass.assign(_theMesh->getNbEq(),0.);
+   for (size_t e=1; e<=_theMesh->getNbElements(); ++e) {
+      Element *el = _theMesh->getPtrElement(e);
+      size_t nn = el->getNbNodes();
+      Point<double> c, x[4];
+      for (size_t i=0; i<nn && i<4; ++i) {
+         x[i] = el->getPtrNode(i+1)->getCoord();
+         c += x[i]/double(nn);
+      }
+      double m = 0.;
+      if (nn==2)
+         m = fabs(x[1].x-x[0].x);
+      else if (nn==3)
+         m = 0.5*fabs((x[1].x-x[0].x)*(x[2].y-x[0].y) - (x[2].x-x[0].x)*(x[1].y-x[0].y));
+      else if (nn==4) {
+         Point<double> a=x[1]-x[0], b=x[2]-x[0], d=x[3]-x[0];
+         m = fabs(a.x*(b.y*d.z-b.z*d.y) - a.y*(b.x*d.z-b.z*d.x) + a.z*(b.x*d.y-b.y*d.x))/6.;
+      }
+      vector<double> xt {c.x,c.y,c.z,theTime};
+      if (_rho_set)
+         m *= rho(xt);
+      if (_Cp_set)
+         m *= Cp(xt);
+      for (size_t i=1; i<=nn; ++i) {
+         Node *nd = el->getPtrNode(i);
+         for (size_t k=1; k<=nd->getNbDOF(); ++k)
+            if (nd->getCode(k)<=0 && nd->getDOF(k)>0)
+               _lmass[nd->getDOF(k)-1] += m/nn;
+      }
+   }
+}
+
+
+/*
+ * Matrix-free P1 operator -div(kappa grad u) on the mesh, built once. The
+ * unknowns are the nodes without prescribed value (positive code), numbered
+ * independently from the OFELI equation numbering. kappa is taken at element
+ * centroids.
+ */
+int equa::setMatrixFree()
+{
+   if (_mf.size())
+      return 0;
+   if ((ieq!=LAPLACE && ieq!=HEAT) || spD!="feP1" || _dim<2 || _nb_dof!=1)
+      return 1;
+   const static vector<string> var {"x","y","z","t"};
+   OFELI::Fct kappa;
+   if (_kappa_set)
+      kappa.set(_kappa_exp,var);
+   size_t nn=_theMesh->getNbNodes(), ne=_theMesh->getNbElements();
+   vector<double> coord(_dim*nn), coef(ne,1.);
+   vector<unsigned> elem((_dim+1)*ne);
+   _mf_eq.assign(nn,-1);
+   long neq = 0;
+   for (size_t n=1; n<=nn; ++n) {
+      Node *nd = (*_theMesh)[n];
+      Point<double> x = nd->getCoord();
+      coord[_dim*(n-1)] = x.x, coord[_dim*(n-1)+1] = x.y;
+      if (_dim==3)
+         coord[_dim*(n-1)+2] = x.z;
+      if (nd->getCode(1)<=0)
+         _mf_eq[n-1] = neq++;
+   }
+   for (size_t e=1; e<=ne; ++e) {
+      Element *el = _theMesh->getPtrElement(e);
+      if (int(el->getNbNodes())!=_dim+1)
+         return 1;
+      Point<double> c;
+      for (int i=1; i<=_dim+1; ++i) {
+         elem[(_dim+1)*(e-1)+i-1] = el->getPtrNode(i)->n() - 1;
+         c += el->getPtrNode(i)->getCoord()/double(_dim+1);
+      }
+      if (_kappa_set) {
+         vector<double> xt {c.x,c.y,c.z,theTime};
+         coef[e-1] = kappa(xt);
+      }
+   }
+   if (_mf.set(_dim,coord,elem,_mf_eq,coef))
+      return 1;
+   if (_rita->_verb>1 && matrix_free)
+      cout << "Matrix-free operator: " << _mf.size() << " unknowns, " << _mf.getNbColors()
+           << " element colours, " << _mf.getMemory()/1024 << " kB" << endl;
+   else if (_rita->_verb>1)
+      cout << "Parallel assembly: " << _mf.size() << " unknowns, " << _mf.getNbColors()
+           << " element colours, " << getNbThreads() << " threads" << endl;
+   if (matrix_free)
+      _lsolver.setMatrix(_mf);
+   _mf_dt = 0.;
+   _mf_asm = false;
+   return 0;
+}
+
+
+/*
+ * With a rita solver, the matrix of the laplace and heat equations with feP1
+ * is assembled by matrixFree::assemble, element colours being assembled
+ * concurrently, instead of the sequential OFELI assembly.
+ */
+bool equa::parallelAssembly()
+{
+   return (!set_sf && xprec!=GMG_PREC && setMatrixFree()==0);
+}
+
+
+/*
+ * Stationary problem (dt=0) or backward Euler step of the heat equation with
+ * the matrix-free operator, or with its matrix when assembled in parallel:
+ *   (M/dt + K) u^{n+1} = M/dt u^n + F - K_{free,fixed} u_D
+ * with F the consistent load of the nodal body force and M the lumped
+ * capacity matrix (rho*Cp at element centroids).
+ * Boundary forces are not supported in this mode. If uc is given, the load
+ * cases of the stationary equation are solved together with it.
+ */
+int equa::runMatrixFree(Vect<double>&           u,
+                        double                  dt,
+                        vector<Vect<double> >* uc)
+{
+   size_t nn = _theMesh->getNbNodes();
+   if (set_sf)
+      _rita->msg("solve>","Boundary forces are not taken into account in matrix-free mode.");
+   if (dt>0. && dt!=_mf_dt) {
+      vector<double> c;
+      setCapacity(c);
+      _mf.lumpedMass(c,_mf_mass);
+      for (auto &v: _mf_mass)
+         v /= dt;
+      _mf.setShift(_mf_mass);
+      if (matrix_free)
+         _lsolver.setMatrix(_mf);
+      _mf_dt = dt;
+      _mf_asm = false;
+   }
+   if (!matrix_free && !_mf_asm) {
+      spmat<double> A;
+      auto t0 = std::chrono::steady_clock::now();
+      _mf.assemble(A);
+      if (_rita->_verb>1)
+         cout << "Assembly time: " << std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count()
+              << " s, element data and pattern kept: " << _mf.getMemory()/1024 << " kB" << endl;
+      _lsolver.setMatrix(std::move(A));
+      _mf_asm = true;
+   }
+   vector<double> ud(nn,0.), f(nn,0.);
+   for (size_t n=1; n<=nn; ++n) {
+      if (_mf_eq[n-1]<0 && set_bc)
+         ud[n-1] = bc(n,1);
+      if (set_bf)
+         f[n-1] = bf(n,1);
+   }
+   Vect<double> b(_mf.size()), x(_mf.size());
+   _mf.load(f,&b[0]);
+   _mf.lift(ud,&b[0]);
+   for (size_t n=1; n<=nn; ++n) {
+      long i = _mf_eq[n-1];
+      if (i>=0) {
+         x[i] = u(n,1);
+         if (dt>0.)
+            b[i] += _mf_mass[i]*u(n,1);
+      }
+   }
+   if (auto_ls && !matrix_free)
+      selectLinearSolver(b);
+   setLinearSolver();
+   if (uc==nullptr) {
+      int ret = _lsolver.solve(b,x);
+      for (size_t n=1; n<=nn; ++n)
+         u(n,1) = (_mf_eq[n-1]>=0) ? x[_mf_eq[n-1]] : ud[n-1];
+      return ret;
+   }
+
+// Load cases: loads of their body forces with the same lifting of boundary values
+   const static vector<string> var {"x","y","z","t"};
+   size_t nc = case_bf.size() + 1;
+   vector<Vect<double> > bb(nc), xx(nc);
+   bb[0] = b, xx[0] = x;
+   for (size_t c=1; c<nc; ++c) {
+      std::fill(f.begin(),f.end(),0.);
+      if (case_bf[c-1]!="") {
+         _theFct.set(case_bf[c-1],var);
+         for (size_t n=1; n<=nn; ++n)
+            f[n-1] = _theFct((*_theMesh)[n]->getCoord());
+      }
+      bb[c].setSize(_mf.size());
+      _mf.load(f,&bb[c][0]);
+      _mf.lift(ud,&bb[c][0]);
+   }
+   int ret = _lsolver.solve(bb,xx);
+   for (size_t c=0; c<nc; ++c) {
+      Vect<double> &v = c ? (*uc)[c-1] : u;
+      for (size_t n=1; n<=nn; ++n)
+         v(n,1) = (_mf_eq[n-1]>=0) ? xx[c][_mf_eq[n-1]] : ud[n-1];
+   }
+   return ret;
+}
+
+
+/*
+ * Stationary laplace or heat equation on a structured mesh. The operator is
+ * the matrix-free one of the grid (see matrixFree) with the conductivity taken
+ * at the centre of each cell, or a single value if it does not depend on
+ * space. It is assembled from its stencil, the mesh being still not built,
+ * only for preconditioners that need a matrix.
+ * Boundary values and the source are evaluated at grid nodes.
+ */
+int equa::runStructured(Vect<double>& u)
+{
+   const static vector<string> var {"x","y","z","t"};
+   if ((ieq!=LAPLACE && ieq!=HEAT) || _nb_dof!=1) {
+      _rita->msg("solve>","Structured meshes are available for the laplace and heat equations only.");
+      return 1;
+   }
+   if (set_sf)
+      _rita->msg("solve>","Boundary forces are not taken into account on a structured mesh.");
+   size_t nn = _smesh->getNbNodes();
+   bool mf = (xprec!=AMG_PREC && xprec!=GMG_PREC && xprec!=CHOLESKY_PREC && xprec!=LDLT_PREC &&
+              (xprec!=NO_EXT_PREC || prec==IDENT_PREC || prec==DIAG_PREC));
+   if (_mf.size()==0 || mf!=matrix_free) {
+      vector<double> k(1,1.);
+      if (_kappa_set) {
+         OFELI::Fct kappa;
+         kappa.set(_kappa_exp,var);
+         size_t ne[3] = {1,1,1};
+         bool space = false;
+         for (int a=0; a<_dim; ++a) {
+            ne[a] = _smesh->getNbElements(a);
+            space = space || Depends(_kappa_exp,var[a]);
+         }
+         if (!space)
+            ne[0] = ne[1] = ne[2] = 1;
+         k.resize(ne[0]*ne[1]*ne[2]);
+         vector<double> xt {0.,0.,0.,theTime};
+         for (size_t c=0; c<k.size(); ++c) {
+            size_t i[3] = {c%ne[0], (c/ne[0])%ne[1], c/(ne[0]*ne[1])};
+            for (int a=0; a<_dim; ++a) {
+               double h = space ? _smesh->getSize(a) : _smesh->getMax(a)-_smesh->getMin(a);
+               xt[a] = _smesh->getMin(a) + (i[a]+0.5)*h;
+            }
+            k[c] = kappa(xt);
+         }
+      }
+      _mf.set(*_smesh,k);
+      matrix_free = mf;
+      _mf_asm = false;
+      if (matrix_free)
+         _lsolver.setMatrix(_mf);
+      if (_rita->_verb>1)
+         cout << "Structured mesh operator: " << _mf.size() << " unknowns, " << _mf.getMemory()
+              << " bytes" << endl;
+   }
+   if (!matrix_free && !_mf_asm) {
+      spmat<double> A;
+      _mf.assemble(A);
+      _lsolver.setMatrix(std::move(A));
+      _mf_asm = true;
+   }
+
+   vector<double> ud(nn,0.), f(nn,0.);
+   double x[3];
+   if (set_bc) {
+      for (auto const& v: regex_bc) {
+         _theFct.set(v.second,var);
+         for (size_t n=0; n<nn; ++n) {
+            if (_smesh->getCode(n)==v.first) {
+               _smesh->getCoord(n,x);
+               ud[n] = _theFct(vector<double> {x[0],x[1],x[2],theTime});
+            }
+         }
+      }
+   }
+   if (set_bf && regex_bf!="") {
+      _theFct.set(regex_bf,var);
+      for (size_t n=0; n<nn; ++n) {
+         _smesh->getCoord(n,x);
+         f[n] = _theFct(vector<double> {x[0],x[1],x[2],theTime});
+      }
+   }
+   Vect<double> b(_mf.size()), y(_mf.size());
+   _mf.load(f,&b[0]);
+   _mf.lift(ud,&b[0]);
+   for (size_t i=0; i<_mf.size(); ++i)
+      y[i] = u[_smesh->getNodeOfEq(i)];
+   if (auto_ls && !matrix_free)
+      selectLinearSolver(b);
+   setLinearSolver();
+   int ret = _lsolver.solve(b,y);
+   for (size_t n=0; n<nn; ++n) {
+      long i = _smesh->getEq(n);
+      u[n] = (i>=0) ? y[i] : ud[n];
+   }
+   return ret;
+}
+
+
+/*
+ * Capacity rho*Cp of P1 elements, taken at their centroids
+ */
+void equa::setCapacity(vector<double>& c)
+{
+   const static vector<string> var {"x","y","z","t"};
+   OFELI::Fct rho, Cp;
+   if (_rho_set)
+      rho.set(_rho_exp,var);
+   if (_Cp_set)
+      Cp.set(_Cp_exp,var);
+   c.assign(_theMesh->getNbElements(),1.);
+   for (size_t e=1; e<=c.size(); ++e) {
+      Element *el = _theMesh->getPtrElement(e);
+      Point<double> x;
+      for (int i=1; i<=_dim+1; ++i)
+         x += el->getPtrNode(i)->getCoord()/double(_dim+1);
+      vector<double> xt {x.x,x.y,x.z,theTime};
+      if (_rho_set)
+         c[e-1] *= rho(xt);
+      if (_Cp_set)
+         c[e-1] *= Cp(xt);
+   }
+}
+
+
+/*
+ * Lowest eigenvalues (or closest ones to shift) of K x = lambda M x, K being
+ * the stiffness matrix of the equation without capacity term and M the lumped
+ * mass (rho*Cp) matrix, prescribed unknowns being removed. For the laplace and
+ * heat equations with feP1, K is assembled in parallel by element colours,
+ * otherwise by OFELI. The eigenvalue solver and its factorization are kept
+ * between calls.
+ */
+int equa::runEigen(int         nb,
+                   double      shift,
+                   EigenMethod method)
+{
+   spmat<double> K, M;
+   vector<double> m;
+   auto t0 = std::chrono::steady_clock::now();
+   if (setMatrixFree()==0) {
+      vector<double> c;
+      _mf.setShift(vector<double>());
+      _mf.assemble(K);
+      setCapacity(c);
+      _mf.lumpedMass(c,m);
+      _mf_dt = 0.;
+      _mf_asm = false;
+   }
+   else {
+      if (ieq==HEAT)
+         theEquation->setTerms(DIFFUSION);
+      theEquation->build();
+      Convert(*theEquation->getMatrix(),K);
+      setLumpedMass();
+      m = _lmass;
+   }
+   if (_rita->_verb>1)
+      cout << "Assembly time: " << std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count()
+           << " s" << endl;
+   M.nb_rows = M.nb_cols = m.size();
+   M.row_ptr.resize(m.size()+1);
+   for (size_t i=0; i<m.size(); ++i) {
+      M.row_ptr[i] = i;
+      M.col_ind.push_back(unsigned(i));
+      M.a.push_back(m[i]);
+   }
+   M.row_ptr[m.size()] = m.size();
+   if (_esolver.setMatrices(std::move(K),std::move(M))<0)
+      return 1;
+   _esolver.setVerbose(_rita->_verb);
+   _esolver.setMethod(method);
+   _esolver.setShift(shift);
+   return _esolver.run(nb);
+}
+
+
+/*
+ * Nodal vector of the i-th eigenvector, zero on prescribed unknowns
+ */
+void equa::getEigenVector(int           i,
+                          Vect<double>& u)
+{
+   const double *x = _esolver.getEigenVector(i);
+   for (size_t n=1; n<=_theMesh->getNbNodes(); ++n) {
+      Node *nd = (*_theMesh)[n];
+      if (_mf.size()) {
+         u(n,1) = (_mf_eq[n-1]>=0) ? x[_mf_eq[n-1]] : 0.;
+         continue;
+      }
+      for (size_t k=1; k<=nd->getNbDOF(); ++k)
+         u(n,k) = (nd->getDOF(k)>0) ? x[nd->getDOF(k)-1] : 0.;
+   }
+}
+
+
+/*
+ * Incompressible Navier-Stokes equations solved by rita as a coupled
+ * velocity-pressure system with a block preconditioner (see navierStokes and
+ * schurPrec)
+ */
+bool equa::blockSolver() const
+{
+   return (ieq==INCOMPRESSIBLE_NAVIER_STOKES && spD=="feP1" &&
+           (xprec==SCHUR_MASS_PREC || xprec==SCHUR_PCD_PREC));
+}
+
+
+int equa::setNavierStokes()
+{
+   if (_ns_set)
+      return 0;
+   if (_dim<2 || _nb_dof!=_dim)
+      return 1;
+   const static vector<string> var {"x","y","z","t"};
+   OFELI::Fct rho, mu;
+   if (_rho_set)
+      rho.set(_rho_exp,var);
+   if (_mu_set)
+      mu.set(_mu_exp,var);
+   size_t nn=_theMesh->getNbNodes(), ne=_theMesh->getNbElements();
+   vector<double> coord(_dim*nn), r(ne,1.), m(ne,1.);
+   vector<unsigned> elem((_dim+1)*ne);
+   vector<bool> fixed(_dim*nn);
+   for (size_t n=1; n<=nn; ++n) {
+      Node *nd = (*_theMesh)[n];
+      Point<double> x = nd->getCoord();
+      coord[_dim*(n-1)] = x.x, coord[_dim*(n-1)+1] = x.y;
+      if (_dim==3)
+         coord[_dim*(n-1)+2] = x.z;
+      for (int k=1; k<=_dim; ++k)
+         fixed[_dim*(n-1)+k-1] = (nd->getCode(k)>0);
+   }
+   for (size_t e=1; e<=ne; ++e) {
+      Element *el = _theMesh->getPtrElement(e);
+      if (int(el->getNbNodes())!=_dim+1)
+         return 1;
+      Point<double> c;
+      for (int i=1; i<=_dim+1; ++i) {
+         elem[(_dim+1)*(e-1)+i-1] = el->getPtrNode(i)->n() - 1;
+         c += el->getPtrNode(i)->getCoord()/double(_dim+1);
+      }
+      vector<double> xt {c.x,c.y,c.z,theTime};
+      if (_rho_set)
+         r[e-1] = rho(xt);
+      if (_mu_set)
+         m[e-1] = mu(xt);
+   }
+   if (_ns.set(_dim,coord,elem,fixed))
+      return 1;
+   _ns.setCoef(r,m);
+   _ns_set = true;
+   return 0;
+}
+
+
+/*
+ * Stationary problem (dt=0): Picard iterations on the convection velocity.
+ * Time step (dt>0): linearized backward Euler, the convection velocity is the
+ * one of the previous time step.
+ * The pressure is the second field of the equation (theSolution[1]).
+ */
+int equa::runNavierStokes(Vect<double>& u,
+                          double        dt)
+{
+   if (setNavierStokes()) {
+      _rita->msg("solve>","Block preconditioner requires a mesh of triangles or tetrahedra with "
+                 +to_string(_dim)+" degrees of freedom per node.");
+      return 1;
+   }
+   if (theSolution[1]==nullptr) {
+      _rita->msg("solve>","No pressure field for the incompressible Navier-Stokes equations.");
+      return 1;
+   }
+   if (set_sf)
+      _rita->msg("solve>","Boundary forces are not taken into account by the block preconditioned solver.");
+   Vect<double> &p = *theSolution[1];
+   size_t nn = _theMesh->getNbNodes();
+   if (p.size()!=nn)
+      p.setMesh(*_theMesh,NODE_DOF,1);
+   vector<double> ud(_dim*nn,0.), f(_dim*nn,0.), un(_dim*nn), pn(nn), x, b;
+   for (size_t n=1; n<=nn; ++n) {
+      for (int k=1; k<=_dim; ++k) {
+         size_t i = _dim*(n-1) + k - 1;
+         un[i] = u(n,k);
+         if (set_bc)
+            ud[i] = bc(n,k);
+         if (set_bf)
+            f[i] = bf(n,k);
+      }
+      pn[n-1] = p(n);
+   }
+   _ns.setUnknowns(un,pn,x);
+   setLinearSolver();
+   bool pcd = (xprec==SCHUR_PCD_PREC);
+   vector<double> w(un);
+   int ret = 0, max_it = (dt>0.) ? 1 : 50;
+   for (int it=1; it<=max_it; ++it) {
+      spmat<double> A, M, K, Fp;
+      _ns.build(w,ud,f,un,dt,pcd,A,b,M,K,Fp);
+      _lsolver.setSchur(_ns.getNbVelocity(),M,K,Fp);
+      _lsolver.setMatrix(std::move(A));
+      Vect<double> bb(b.size()), xx(x.size());
+      for (size_t i=0; i<b.size(); ++i)
+         bb[i] = b[i], xx[i] = x[i];
+      ret = _lsolver.solve(bb,xx);
+      for (size_t i=0; i<x.size(); ++i)
+         x[i] = xx[i];
+      vector<double> w1;
+      _ns.getSolution(x,ud,w1,pn);
+      double d=0., s=0.;
+      for (size_t i=0; i<w1.size(); ++i)
+         d += (w1[i]-w[i])*(w1[i]-w[i]), s += w1[i]*w1[i];
+      w.swap(w1);
+      if (dt==0. && _rita->_verb>1)
+         cout << "Picard iteration " << it << ", relative velocity change: " << sqrt(d/std::max(s,1.e-30))
+              << endl;
+      if (ret || d<=1.e-12*s)
+         break;
+   }
+   for (size_t n=1; n<=nn; ++n) {
+      for (int k=1; k<=_dim; ++k)
+         u(n,k) = w[_dim*(n-1)+k-1];
+      p(n) = pn[n-1];
+   }
+   return ret;
+}
+
+
 int equa::setEq()
 {
    int ret = 0;
@@ -1294,7 +2469,21 @@ void equa::setCoef()
 
 void equa::set()
 {
-   int ret = 0;
+   if (_smesh!=nullptr)
+      return;
+   theEquation = newEquation();
+   if (theEquation->SolverIsSet()==false)
+      ls = CG_SOLVER, prec = DILU_PREC;
+}
+
+
+/*
+ * OFELI equation object of the pde, its space discretization and its
+ * coefficients
+ */
+Equa<double> *equa::newEquation()
+{
+   Equa<double> *eq = nullptr;
    switch (ieq) {
 
       case LAPLACE:
@@ -1302,19 +2491,19 @@ void equa::set()
   
             case 1:
                if (spD=="feP1")
-                  theEquation = new Laplace1DL2(*_theMesh);
+                  eq = new Laplace1DL2(*_theMesh);
                else if (spD=="feP2")
-                  theEquation = new Laplace1DL3(*_theMesh);
+                  eq = new Laplace1DL3(*_theMesh);
                break;
 
             case 2:
                if (spD=="feP1")
-                  theEquation = new Laplace2DT3(*_theMesh);
+                  eq = new Laplace2DT3(*_theMesh);
                break;
 
             case 3:
                if (spD=="feP1")
-                  theEquation = new Laplace3DT4(*_theMesh);
+                  eq = new Laplace3DT4(*_theMesh);
                break;
          }
          break;
@@ -1325,32 +2514,32 @@ void equa::set()
 
             case 1:
                if (spD=="feP1") {
-                  theEquation = new DC1DL2(*_theMesh);
-                  theEquation->setTerms(LUMPED_CAPACITY|DIFFUSION);
+                  eq = new DC1DL2(*_theMesh);
+                  eq->setTerms(LUMPED_CAPACITY|DIFFUSION);
                }
                break;
 
             case 2:
                if (spD=="feP1")
-                  theEquation = new DC2DT3(*_theMesh);
+                  eq = new DC2DT3(*_theMesh);
                else if (spD=="feP2")
-                  theEquation = new DC2DT6(*_theMesh);
-               theEquation->setTerms(LUMPED_CAPACITY|DIFFUSION);
+                  eq = new DC2DT6(*_theMesh);
+               eq->setTerms(LUMPED_CAPACITY|DIFFUSION);
                break;
 
             case 3:
                if (spD=="feP1") {
-                  theEquation = new DC3DT4(*_theMesh);
-                  theEquation->setTerms(LUMPED_CAPACITY|DIFFUSION);
+                  eq = new DC3DT4(*_theMesh);
+                  eq->setTerms(LUMPED_CAPACITY|DIFFUSION);
 	       }
                break;
          }
          if (_rho_set)
-            theEquation->set_rho(_rho_exp);
+            eq->set_rho(_rho_exp);
          if (_Cp_set)
-            theEquation->set_Cp(_Cp_exp);
+            eq->set_Cp(_Cp_exp);
          if (_kappa_set)
-            theEquation->set_kappa(_kappa_exp);
+            eq->set_kappa(_kappa_exp);
          break;
 
 
@@ -1359,24 +2548,24 @@ void equa::set()
 
             case 2:
                if (spD=="feP1")
-                  theEquation = new Elas2DT3(*_theMesh);
+                  eq = new Elas2DT3(*_theMesh);
                else if (spD=="feQ1")
-                  theEquation = new Elas2DQ4(*_theMesh);
+                  eq = new Elas2DQ4(*_theMesh);
                break;
 
             case 3:
                if (spD=="feP1")
-                  theEquation = new Elas3DT4(*_theMesh);
+                  eq = new Elas3DT4(*_theMesh);
                else if (spD=="feQ1")
-                  theEquation = new Elas3DH8(*_theMesh);
+                  eq = new Elas3DH8(*_theMesh);
                break;
          }
          if (_rho_set)
-            theEquation->set_rho(_rho_exp);
+            eq->set_rho(_rho_exp);
          if (_young_set)
-            theEquation->set_young(_young_exp);
+            eq->set_young(_young_exp);
          if (_poisson_set)
-            theEquation->set_poisson(_poisson_exp);
+            eq->set_poisson(_poisson_exp);
          break;
 
       case TRUSS:
@@ -1384,13 +2573,13 @@ void equa::set()
 
             case 2:
                if (spD=="feP1")
-                  theEquation = new Bar2DL2(*_theMesh);
+                  eq = new Bar2DL2(*_theMesh);
                break;
          }
          if (_rho_set)
-            theEquation->set_rho(_rho_exp);
+            eq->set_rho(_rho_exp);
          if (_young_set)
-            theEquation->set_young(_young_exp);
+            eq->set_young(_young_exp);
          break;
 
    case INCOMPRESSIBLE_NAVIER_STOKES:
@@ -1398,24 +2587,23 @@ void equa::set()
 
             case 2:
                if (spD=="feP1")
-                  theEquation = new TINS2DT3S(*_theMesh);
+                  eq = new TINS2DT3S(*_theMesh);
                break;
 
             case 3:
                if (spD=="feP1")
-                  theEquation = new TINS3DT4S(*_theMesh);
+                  eq = new TINS3DT4S(*_theMesh);
                break;
          }
          if (_rho_set)
-            theEquation->set_rho(_rho_exp);
+            eq->set_rho(_rho_exp);
          if (_mu_set)
-            theEquation->set_mu(_mu_exp);
+            eq->set_mu(_mu_exp);
          if (_beta_set)
-            theEquation->set_beta(_beta_exp);
+            eq->set_beta(_beta_exp);
          break;
    }
-   if (ret==0 && theEquation->SolverIsSet()==false)
-      ls = CG_SOLVER, prec = DILU_PREC;
+   return eq;
 }
 
 } /* namespace RITA */
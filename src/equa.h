@@ -35,6 +35,10 @@
 using std::map;
 
 #include "data.h"
+#include "linearSolver.h"
+#include "matrixFree.h"
+#include "navierStokes.h"
+#include "eigenSolver.h"
 
 #include "equations/Equa_impl.h"
 #include "equations/Equation_impl.h"
@@ -97,6 +101,12 @@ class equa
     string eq, nls, spD;
     Iteration ls;
     Preconditioner prec;
+    ExtPreconditioner xprec;
+    bool mixed, matrix_free, parallel_prec, multicolor, recycle, auto_ls;
+    int asm_overlap;
+    bool asm_direct, asm_coarse;
+    bool ritaSolver() const { return (xprec!=NO_EXT_PREC || mixed || matrix_free || parallel_prec || multicolor || recycle || auto_ls); }
+    int getNbIter() const { return _lsolver.getNbIter(); }
     vector<string> analytic;
     vector<int> field;
     vector<string> fn;
@@ -104,23 +114,36 @@ class equa
     Equa<double> *theEquation;
     void setFields();
     int set(string e, Mesh* ms);
+    int set(string e, const structuredMesh* g);
+    bool isStructured() const { return _smesh!=nullptr; }
+    void setMesh(Mesh* ms);
     int setEq();
     void set();
+    Equa<double> *newEquation();
     void set(data *d);
     void setCoef();
     int setIn();
     int setBC();
     int setBF();
     int setSF();
+    int setCase();
     void check();
     void set(cmd* cmd) { _cmd = cmd; }
     void setNodeBC(int code, string exp, double t, Vect<double>& v);
     void setSize(Vect<double>& v, dataSize s);
+    int run(Vect<double>& u);
+    int runOneTimeStep(Vect<double>& u, double dt);
+    int runCases(Vect<double>& u, vector<Vect<double> >& uc);
+    int runEigen(int nb, double shift, EigenMethod method);
+    const eigenSolver& getEigenSolver() const { return _esolver; }
+    void getEigenVector(int i, Vect<double>& u);
     Log log;
     bool set_u, set_bc, set_bf, set_sf, set_in;
     Vect<double> u, b, bc, bf, sf, *theSolution[5];
     std::map<int,string> regex_bc, regex_sf;
     string regex_bf, regex_u;
+    vector<string> case_bf;
+    vector<std::map<int,string> > case_sf;
 
  private:
     rita *_rita;
@@ -140,9 +163,38 @@ class equa
                                {"incompressible-porous-1phase",INCOMPRESSIBLE_POROUS_1PHASE}};
     const vector<string> _kw = {"expression","value","file","save"};
     Mesh *_theMesh;
+    const structuredMesh *_smesh;
     string _rho_exp, _Cp_exp, _kappa_exp, _mu_exp,_sigma_exp, _Mu_exp, _epsilon_exp, _omega_exp;
     string _beta_exp, _v_exp, _young_exp, _poisson_exp;
     OFELI::Fct _theFct;
+    linearSolver _lsolver;
+    bool _ls_selected;
+    void selectLinearSolver(const Vect<double>& b);
+    vector<double> _lmass;
+    bool _grid_set;
+    matrixFree _mf;
+    vector<long> _mf_eq;
+    vector<double> _mf_mass;
+    double _mf_dt;
+    bool _mf_asm;
+    int setMatrixFree();
+    bool parallelAssembly();
+    int runMatrixFree(Vect<double>& u, double dt, vector<Vect<double> >* uc=nullptr);
+    int runStructured(Vect<double>& u);
+    void setCapacity(vector<double>& c);
+    eigenSolver _esolver;
+    navierStokes _ns;
+    bool _ns_set;
+    double _ls_dt;
+    bool blockSolver() const;
+    int setNavierStokes();
+    int runNavierStokes(Vect<double>& u, double dt);
+    void setLumpedMass();
+    void setLinearSolver();
+    int setGrid();
+    void setPartition();
+    void gatherEq(const Vect<double>& u, Vect<double>& x);
+    void scatterEq(const Vect<double>& x, Vect<double>& u);
 };
 
 } /* namespace RITA */
@@ -0,0 +1,269 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                          Implementation of class 'gmg'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include <algorithm>
+#include "gmg.h"
+
+using std::endl;
+
+namespace RITA {
+
+template<class T_>
+gmg<T_>::gmg(int                   dim,
+             const size_t*         ne,
+             const vector<size_t>& node)
+        : _dim(dim), _degree(2), _max_levels(20), _coarse_size(1000), _amg(nullptr)
+{
+   _level.push_back(Level());
+   for (int i=0; i<3; ++i)
+      _level[0].ne[i] = (i<dim) ? ne[i] : 0;
+   _level[0].node = node;
+}
+
+
+template<class T_>
+gmg<T_>::~gmg()
+{
+   if (_amg!=nullptr)
+      delete _amg;
+}
+
+
+template<class T_>
+int gmg<T_>::setup(const spmat<T_>& A)
+{
+   _level.resize(1);
+   _level[0].A = A;
+   while (int(_level.size())<_max_levels && _level.back().A.size()>_coarse_size/8) {
+      Level C;
+      if (!coarsen(_level.back(),C))
+         break;
+      Level &F = _level.back();
+      Transpose(F.P,F.R);
+      spmat<T_> AP;
+      Multiply(F.A,F.P,AP);
+      Multiply(F.R,AP,C.A);
+      _level.push_back(std::move(C));
+   }
+   for (auto &L: _level) {
+      size_t n = L.A.size();
+      L.x.resize(n);
+      L.b.resize(n);
+      L.r.resize(n);
+      L.d.resize(n);
+      L.dinv.resize(n);
+
+//    Gershgorin bound of the spectrum of D^{-1}A: an upper bound is required
+//    for the Chebyshev smoother to be stable
+      L.lmax = 0.;
+      for (size_t i=0; i<n; ++i) {
+         T_ d = L.A.diag(i);
+         L.dinv[i] = (d!=T_(0)) ? T_(1)/d : T_(0);
+         double s = 0.;
+         for (size_t k=L.A.row_ptr[i]; k<L.A.row_ptr[i+1]; ++k)
+            s += fabs(L.A.a[k]);
+         L.lmax = std::max(L.lmax,s*fabs(L.dinv[i]));
+      }
+   }
+   if (_amg!=nullptr)
+      delete _amg, _amg = nullptr;
+   if (_level.back().A.size()>_coarse_size) {
+      _amg = new amg<T_>;
+      return _amg->setup(_level.back().A);
+   }
+   _lu.factor(_level.back().A);
+   return 0;
+}
+
+
+/*
+ * Coarse grid of level F and interpolation F.P from it. Unknowns without
+ * off-diagonal coupling (prescribed values) are not interpolated, coarse
+ * nodes that receive no fine unknown are dropped.
+ */
+template<class T_>
+bool gmg<T_>::coarsen(Level& F,
+                      Level& C) const
+{
+   bool cc[3] = {false,false,false}, ok = false;
+   size_t fn[3] = {1,1,1}, cn[3] = {1,1,1};
+   for (int a=0; a<3; ++a) {
+      C.ne[a] = F.ne[a];
+      if (a<_dim) {
+         if (F.ne[a]%2==0 && F.ne[a]>=2)
+            cc[a] = ok = true, C.ne[a] = F.ne[a]/2;
+         fn[a] = F.ne[a] + 1;
+         cn[a] = C.ne[a] + 1;
+      }
+   }
+   if (!ok)
+      return false;
+
+   const spmat<T_> &A = F.A;
+   size_t n = A.size();
+   vector<long> col(cn[0]*cn[1]*cn[2],-1);
+   vector<vector<std::pair<size_t,T_> > > p(n);
+   for (size_t r=0; r<n; ++r) {
+      if (A.row_ptr[r+1]-A.row_ptr[r]<2)
+         continue;
+      size_t g = F.node[r], ijk[3] = {g%fn[0], (g/fn[0])%fn[1], g/(fn[0]*fn[1])};
+      size_t c[3][2];
+      T_ w[3][2];
+      int nc[3];
+      for (int a=0; a<3; ++a) {
+         nc[a] = 1, c[a][0] = ijk[a], w[a][0] = T_(1);
+         if (cc[a]) {
+            c[a][0] = ijk[a]/2;
+            if (ijk[a]%2) {
+               nc[a] = 2, w[a][0] = w[a][1] = T_(0.5);
+               c[a][1] = ijk[a]/2 + 1;
+            }
+         }
+      }
+      for (int k=0; k<nc[2]; ++k)
+         for (int j=0; j<nc[1]; ++j)
+            for (int i=0; i<nc[0]; ++i) {
+               size_t gc = c[0][i] + cn[0]*(c[1][j] + cn[1]*c[2][k]);
+               p[r].push_back(std::make_pair(gc,w[0][i]*w[1][j]*w[2][k]));
+               col[gc] = 0;
+            }
+   }
+
+   C.node.clear();
+   for (size_t g=0; g<col.size(); ++g) {
+      if (col[g]==0) {
+         col[g] = long(C.node.size());
+         C.node.push_back(g);
+      }
+   }
+   spmat<T_> &P = F.P;
+   P.nb_rows = n, P.nb_cols = C.node.size();
+   P.row_ptr.assign(n+1,0);
+   P.col_ind.clear();
+   P.a.clear();
+   for (size_t r=0; r<n; ++r) {
+      std::sort(p[r].begin(),p[r].end());
+      for (auto const& e: p[r]) {
+         P.col_ind.push_back(size_t(col[e.first]));
+         P.a.push_back(e.second);
+      }
+      P.row_ptr[r+1] = P.col_ind.size();
+   }
+   return P.nb_cols>0;
+}
+
+
+/*
+ * Chebyshev smoother of degree _degree for D^{-1}A on [lmax/15,lmax]
+ * (zero: initial guess is zero)
+ */
+template<class T_>
+void gmg<T_>::smooth(const Level& L,
+                     bool         zero) const
+{
+   size_t n = L.A.size();
+   double lmin = L.lmax/15., theta = 0.5*(L.lmax+lmin), delta = 0.5*(L.lmax-lmin);
+   double sigma = theta/delta, rho = 1./sigma;
+   if (zero)
+      std::fill(L.x.begin(),L.x.end(),T_(0));
+   L.A.mult(L.x.data(),L.r.data());
+   for (size_t i=0; i<n; ++i)
+      L.d[i] = T_((L.b[i]-L.r[i])*L.dinv[i]/theta);
+   for (int k=1; k<=_degree; ++k) {
+      for (size_t i=0; i<n; ++i)
+         L.x[i] += L.d[i];
+      if (k==_degree)
+         break;
+      L.A.mult(L.x.data(),L.r.data());
+      double rho1 = 1./(2.*sigma-rho);
+      T_ c1 = T_(rho1*rho), c2 = T_(2.*rho1/delta);
+      for (size_t i=0; i<n; ++i)
+         L.d[i] = c1*L.d[i] + c2*L.dinv[i]*(L.b[i]-L.r[i]);
+      rho = rho1;
+   }
+}
+
+
+template<class T_>
+void gmg<T_>::cycle(size_t l) const
+{
+   const Level &L = _level[l];
+   if (l==_level.size()-1) {
+      if (_amg!=nullptr)
+         _amg->solve(L.b,L.x);
+      else
+         _lu.solve(L.x,L.b);
+      return;
+   }
+   smooth(L,true);
+   L.A.mult(L.x.data(),L.r.data());
+   for (size_t i=0; i<L.r.size(); ++i)
+      L.r[i] = L.b[i] - L.r[i];
+   const Level &C = _level[l+1];
+   L.R.mult(L.r.data(),C.b.data());
+   cycle(l+1);
+   L.P.mult(C.x.data(),L.r.data());
+   for (size_t i=0; i<L.x.size(); ++i)
+      L.x[i] += L.r[i];
+   smooth(L,false);
+}
+
+
+template<class T_>
+void gmg<T_>::solve(const vector<T_>& r,
+                    vector<T_>&       z) const
+{
+   _level[0].b = r;
+   cycle(0);
+   z = _level[0].x;
+}
+
+
+template<class T_>
+void gmg<T_>::print(std::ostream& s) const
+{
+   size_t nnz = 0;
+   s << "Geometric multigrid: " << _level.size() << " levels" << endl;
+   for (size_t l=0; l<_level.size(); ++l) {
+      s << "   Level " << l << ": grid " << _level[l].ne[0];
+      for (int a=1; a<_dim; ++a)
+         s << "x" << _level[l].ne[a];
+      s << ", " << _level[l].A.size() << " unknowns, " << _level[l].A.nnz() << " nonzeros" << endl;
+      nnz += _level[l].A.nnz();
+   }
+   s << "   Operator complexity: " << double(nnz)/_level[0].A.nnz() << endl;
+   if (_amg!=nullptr)
+      s << "   Coarsest level solved by AMG" << endl;
+}
+
+template class gmg<double>;
+template class gmg<float>;
+
+} /* namespace RITA */
@@ -0,0 +1,83 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                            Definition of class 'gmg'
+
+  ==============================================================================*/
+
+
+#pragma once
+
+#include "linearSolver.h"
+#include "amg.h"
+
+namespace RITA {
+
+/*
+ * Geometric multigrid preconditioner for unknowns located at the nodes of a
+ * structured grid of ne[0]*ne[1](*ne[2]) intervals (meshes of rectangles and
+ * cubes). Coarse grids are obtained by halving the number of intervals in each
+ * direction where it is even, prolongation is (bi/tri)linear interpolation and
+ * coarse operators are Galerkin products. Smoothing uses Chebyshev polynomials
+ * in D^{-1}A, whose kernels are plain vector operations. The coarsest level is
+ * solved by LU factorization, or by an AMG cycle if it remains large.
+ */
+template<class T_>
+class gmg : public precond<T_>
+{
+
+ public:
+
+    gmg(int dim, const size_t* ne, const vector<size_t>& node);
+    ~gmg();
+    void setDegree(int k) { _degree = k; }
+    void setCoarseSize(size_t n) { _coarse_size = n; }
+    int setup(const spmat<T_>& A);
+    void solve(const vector<T_>& r, vector<T_>& z) const;
+    void print(std::ostream& s) const;
+    int getNbLevels() const { return int(_level.size()); }
+
+ private:
+
+    struct Level {
+       size_t ne[3];
+       vector<size_t> node;
+       spmat<T_> A, P, R;
+       vector<T_> dinv;
+       double lmax;
+       mutable vector<T_> x, b, r, d;
+    };
+
+    int _dim, _degree, _max_levels;
+    size_t _coarse_size;
+    vector<Level> _level;
+    denseLU<T_> _lu;
+    amg<T_> *_amg;
+
+    bool coarsen(Level& F, Level& C) const;
+    void smooth(const Level& L, bool zero) const;
+    void cycle(size_t l) const;
+};
+
+} /* namespace RITA */
@@ -53,7 +53,7 @@ string H1 =  "rita is an interactive application to solve modelling problems inv
              "ode        Define an ordinary differential equation (or system of equations) to solve\n"
              "pde        Define a partial differential equation (or system of equations) to solve\n"
              "optim      Set problem as an optimization one (Not yet implemented)\n"
-             "eigen      Set problem as an eigenproblem (Not yet implemented)\n"
+             "eigen      Set problem as an eigenproblem\n"
              "solve      Run the constructed model problem with all chosen options\n"
              "license    Print License Agreement of the software\n\n"
              "Global commands are commands that are available in all modes. These are:\n"
@@ -0,0 +1,278 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                          Implementation of class 'ilu'
+
+  ==============================================================================*/
+
+
+
+#include <math.h>
+#include <algorithm>
+#include "ilu.h"
+
+using std::cout;
+using std::endl;
+
+namespace RITA {
+
+template<class T_>
+ilu<T_>::ilu(OFELI::Preconditioner type,
+             bool                  multicolor)
+        : _type(type), _color(multicolor), _nb_colors(0)
+{
+}
+
+
+template<class T_>
+int ilu<T_>::setup(const spmat<T_>& A)
+{
+   size_t n = A.size();
+   _perm.clear();
+   _nb_colors = 0;
+   if (_color)
+      setColors(A);
+   vector<size_t> ip(n);
+   for (size_t i=0; i<n; ++i)
+      ip[_color ? _perm[i] : i] = i;
+
+// Matrix in the new numbering, with sorted column indices
+   _LU.nb_rows = _LU.nb_cols = n;
+   _LU.row_ptr.assign(n+1,0);
+   _LU.col_ind.resize(A.nnz());
+   _LU.a.resize(A.nnz());
+   _diag.resize(n);
+   vector<std::pair<unsigned,T_> > row;
+   for (size_t i=0; i<n; ++i) {
+      size_t o = _color ? _perm[i] : i;
+      row.clear();
+      for (size_t k=A.row_ptr[o]; k<A.row_ptr[o+1]; ++k)
+         row.push_back(std::make_pair(unsigned(ip[A.col_ind[k]]),A.a[k]));
+      std::sort(row.begin(),row.end(),
+                [](const std::pair<unsigned,T_>& p, const std::pair<unsigned,T_>& q) { return p.first<q.first; });
+      size_t k = _LU.row_ptr[i];
+      _diag[i] = size_t(-1);
+      for (auto const& v: row) {
+         if (v.first==i)
+            _diag[i] = k;
+         _LU.col_ind[k] = v.first;
+         _LU.a[k++] = v.second;
+      }
+      _LU.row_ptr[i+1] = k;
+      if (_diag[i]==size_t(-1)) {
+         cout << "Error: Incomplete factorization requires nonzero diagonal entries." << endl;
+         return 1;
+      }
+   }
+   factor();
+   setLevels();
+   return 0;
+}
+
+
+/*
+ * Greedy colouring of the symmetrized graph of A. Unknowns are then numbered
+ * colour by colour: _perm[i] is the original index of unknown i.
+ */
+template<class T_>
+void ilu<T_>::setColors(const spmat<T_>& A)
+{
+   size_t n = A.size();
+   spmat<T_> At;
+   Transpose(A,At);
+   vector<int> color(n,-1);
+   vector<size_t> mark;
+   for (size_t i=0; i<n; ++i) {
+      for (const spmat<T_>* B: {&A,static_cast<const spmat<T_>*>(&At)}) {
+         for (size_t k=B->row_ptr[i]; k<B->row_ptr[i+1]; ++k) {
+            int c = color[B->col_ind[k]];
+            if (c>=0) {
+               if (size_t(c)>=mark.size())
+                  mark.resize(c+1,size_t(-1));
+               mark[c] = i;
+            }
+         }
+      }
+      int c = 0;
+      while (size_t(c)<mark.size() && mark[c]==i)
+         c++;
+      color[i] = c;
+      _nb_colors = std::max(_nb_colors,c+1);
+   }
+   _perm.resize(n);
+   for (size_t i=0; i<n; ++i)
+      _perm[i] = i;
+   std::stable_sort(_perm.begin(),_perm.end(),[&color](size_t p, size_t q) { return color[p]<color[q]; });
+}
+
+
+template<class T_>
+void ilu<T_>::factor()
+{
+   size_t n = _LU.size();
+   const vector<size_t> &rp = _LU.row_ptr;
+   const vector<unsigned> &ci = _LU.col_ind;
+   vector<T_> &a = _LU.a;
+   vector<T_> d(n);
+   _f.assign(n,T_(1));
+   _s.assign(n,T_(1));
+   _dinv.resize(n);
+   if (_type==OFELI::ILU_PREC) {
+      vector<long> pos(n,-1);
+      for (size_t i=0; i<n; ++i) {
+         for (size_t k=rp[i]; k<rp[i+1]; ++k)
+            pos[ci[k]] = long(k);
+         for (size_t k=rp[i]; k<_diag[i]; ++k) {
+            size_t j = ci[k];
+            T_ p = a[_diag[j]];
+            if (p==T_(0))
+               continue;
+            a[k] /= p;
+            for (size_t m=_diag[j]+1; m<rp[j+1]; ++m) {
+               if (pos[ci[m]]>=0)
+                  a[pos[ci[m]]] -= a[k]*a[m];
+            }
+         }
+         for (size_t k=rp[i]; k<rp[i+1]; ++k)
+            pos[ci[k]] = -1;
+         d[i] = a[_diag[i]];
+      }
+   }
+   else {
+      for (size_t i=0; i<n; ++i) {
+         d[i] = a[_diag[i]];
+         if (_type!=OFELI::DILU_PREC)
+            continue;
+         for (size_t k=rp[i]; k<_diag[i]; ++k) {
+            size_t j = ci[k];
+            auto q = std::lower_bound(ci.begin()+_diag[j]+1,ci.begin()+rp[j+1],unsigned(i));
+            if (q!=ci.begin()+rp[j+1] && *q==i && d[j]!=T_(0))
+               d[i] -= a[k]*a[q-ci.begin()]/d[j];
+         }
+      }
+   }
+   for (size_t i=0; i<n; ++i) {
+      if (d[i]==T_(0))
+         d[i] = T_(1);
+      _dinv[i] = T_(1)/d[i];
+      if (_type!=OFELI::ILU_PREC)
+         _f[i] = _dinv[i], _s[i] = d[i];
+   }
+}
+
+
+/*
+ * Level of a row in the forward (backward) solve: 1 + largest level of the
+ * rows it depends on through L (U)
+ */
+template<class T_>
+void ilu<T_>::setLevels()
+{
+   size_t n = _LU.size();
+   vector<size_t> lev(n);
+   for (int t=0; t<2; ++t) {
+      size_t nl = 0;
+      for (size_t ii=0; ii<n; ++ii) {
+         size_t i=t ? n-1-ii : ii, l=0;
+         size_t b=t ? _diag[i]+1 : _LU.row_ptr[i], e=t ? _LU.row_ptr[i+1] : _diag[i];
+         for (size_t k=b; k<e; ++k)
+            l = std::max(l,lev[_LU.col_ind[k]]+1);
+         lev[i] = l;
+         nl = std::max(nl,l+1);
+      }
+      vector<size_t> &ptr=t ? _uptr : _lptr, &row=t ? _urow : _lrow;
+      ptr.assign(nl+1,0);
+      for (size_t i=0; i<n; ++i)
+         ptr[lev[i]+1]++;
+      for (size_t l=0; l<nl; ++l)
+         ptr[l+1] += ptr[l];
+      row.resize(n);
+      vector<size_t> p(ptr.begin(),ptr.end()-1);
+      for (size_t i=0; i<n; ++i)
+         row[p[lev[i]]++] = i;
+   }
+}
+
+
+template<class T_>
+void ilu<T_>::solve(const vector<T_>& r,
+                    vector<T_>&       z) const
+{
+   size_t n = _LU.size();
+   const vector<size_t> &rp = _LU.row_ptr;
+   const vector<unsigned> &ci = _LU.col_ind;
+   const vector<T_> &a = _LU.a;
+   bool p = _perm.size()>0;
+   _y.resize(n);
+   z.resize(n);
+   vector<T_> w;
+   if (p)
+      w.resize(n);
+   T_ *x = p ? w.data() : z.data();
+   for (size_t l=0; l+1<_lptr.size(); ++l) {
+      parallelFor(_lptr[l+1]-_lptr[l],[&](size_t b, size_t e) {
+         for (size_t m=_lptr[l]+b; m<_lptr[l]+e; ++m) {
+            size_t i = _lrow[m];
+            T_ s = p ? r[_perm[i]] : r[i];
+            for (size_t k=rp[i]; k<_diag[i]; ++k)
+               s -= a[k]*_y[ci[k]];
+            _y[i] = s*_f[i];
+         }
+      },256);
+   }
+   for (size_t l=0; l+1<_uptr.size(); ++l) {
+      parallelFor(_uptr[l+1]-_uptr[l],[&](size_t b, size_t e) {
+         for (size_t m=_uptr[l]+b; m<_uptr[l]+e; ++m) {
+            size_t i = _urow[m];
+            T_ s = _y[i]*_s[i];
+            for (size_t k=_diag[i]+1; k<rp[i+1]; ++k)
+               s -= a[k]*x[ci[k]];
+            x[i] = s*_dinv[i];
+         }
+      },256);
+   }
+   if (p) {
+      parallelFor(n,[&](size_t b, size_t e) {
+         for (size_t i=b; i<e; ++i)
+            z[_perm[i]] = w[i];
+      });
+   }
+}
+
+
+template<class T_>
+void ilu<T_>::print(std::ostream& s) const
+{
+   s << ((_type==OFELI::ILU_PREC) ? "ILU(0)" : ((_type==OFELI::DILU_PREC) ? "DILU" : "SSOR"))
+     << " preconditioner: " << _lptr.size()-1 << " levels in L, " << _uptr.size()-1
+     << " levels in U, " << _LU.size()/std::max(size_t(1),_lptr.size()-1) << " rows per level";
+   if (_color)
+      s << " (" << _nb_colors << " colours)";
+   s << endl;
+}
+
+template class ilu<double>;
+template class ilu<float>;
+
+} /* namespace RITA */
@@ -0,0 +1,79 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                            Definition of class 'ilu'
+
+  ==============================================================================*/
+
+
+
+#pragma once
+
+#include "linearSolver.h"
+
+namespace RITA {
+
+/*
+ * Incomplete factorization preconditioners M = (D+L) D^{-1} (D+U) with the
+ * sparsity pattern of A:
+ *   ILU_PREC:  ILU(0), L and U computed by incomplete Gaussian elimination,
+ *   DILU_PREC: L and U are the strict triangular parts of A, D is such that
+ *              diag(M) = diag(A),
+ *   SSOR_PREC: symmetric Gauss-Seidel, L and U as for DILU and D = diag(A).
+ * Triangular solves are level scheduled: rows are grouped by levels such that
+ * the rows of a level only depend on rows of previous levels, and the rows of
+ * a level are solved in parallel. The levels are computed once by setup().
+ * With the multicolor option, unknowns are first renumbered by colours of the
+ * matrix graph; unknowns of a colour are not coupled, so that there are as
+ * many levels as colours. This gives much more parallelism at the price of a
+ * weaker preconditioner (a few more iterations).
+ */
+template<class T_>
+class ilu : public precond<T_>
+{
+
+ public:
+
+    ilu(OFELI::Preconditioner type=OFELI::ILU_PREC, bool multicolor=false);
+    ~ilu() { }
+    int setup(const spmat<T_>& A);
+    void solve(const vector<T_>& r, vector<T_>& z) const;
+    void print(std::ostream& s) const;
+
+ private:
+
+    OFELI::Preconditioner _type;
+    bool _color;
+    int _nb_colors;
+    spmat<T_> _LU;
+    vector<size_t> _diag, _perm, _lptr, _lrow, _uptr, _urow;
+    vector<T_> _f, _s, _dinv;
+    mutable vector<T_> _y;
+
+    void setColors(const spmat<T_>& A);
+    void setLevels();
+    void factor();
+};
+
+} /* namespace RITA */
@@ -0,0 +1,1471 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                     Implementation of class 'linearSolver'
+
+  ==============================================================================*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <algorithm>
+#include "linearSolver.h"
+#include "amg.h"
+#include "gmg.h"
+#include "chebyshev.h"
+#include "ilu.h"
+#include "cholesky.h"
+#include "schurPrec.h"
+#include "schwarz.h"
+#include "matrixFree.h"
+#include "denseEigen.h"
+
+using std::cout;
+using std::endl;
+
+namespace RITA {
+
+template<class T_>
+void Transpose(const spmat<T_>& A,
+               spmat<T_>&       At)
+{
+   At.nb_rows = A.nb_cols;
+   At.nb_cols = A.nb_rows;
+   At.row_ptr.assign(At.nb_rows+1,0);
+   At.col_ind.resize(A.nnz());
+   At.a.resize(A.nnz());
+   for (size_t k=0; k<A.nnz(); ++k)
+      At.row_ptr[A.col_ind[k]+1]++;
+   for (size_t i=0; i<At.nb_rows; ++i)
+      At.row_ptr[i+1] += At.row_ptr[i];
+   vector<size_t> pos(At.row_ptr.begin(),At.row_ptr.end()-1);
+   for (size_t i=0; i<A.nb_rows; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t l = pos[A.col_ind[k]]++;
+         At.col_ind[l] = i;
+         At.a[l] = A.a[k];
+      }
+   }
+}
+
+
+template<class T_>
+void Multiply(const spmat<T_>& A,
+              const spmat<T_>& B,
+              spmat<T_>&       C)
+{
+   C.nb_rows = A.nb_rows;
+   C.nb_cols = B.nb_cols;
+   C.row_ptr.assign(C.nb_rows+1,0);
+   C.col_ind.clear();
+   C.a.clear();
+   vector<long> marker(B.nb_cols,-1);
+   vector<T_> val(B.nb_cols,T_(0));
+   vector<size_t> cols;
+   for (size_t i=0; i<A.nb_rows; ++i) {
+      cols.clear();
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         T_ aij = A.a[k];
+         for (size_t l=B.row_ptr[j]; l<B.row_ptr[j+1]; ++l) {
+            size_t m = B.col_ind[l];
+            if (marker[m]!=long(i)) {
+               marker[m] = long(i);
+               cols.push_back(m);
+               val[m] = aij*B.a[l];
+            }
+            else
+               val[m] += aij*B.a[l];
+         }
+      }
+      std::sort(cols.begin(),cols.end());
+      for (auto const& m: cols) {
+         C.col_ind.push_back(m);
+         C.a.push_back(val[m]);
+      }
+      C.row_ptr[i+1] = C.col_ind.size();
+   }
+}
+
+
+template<class T_>
+double SpectralRadius(const spmat<T_>& A,
+                      int              nb_it)
+{
+   size_t n = A.size();
+   vector<T_> x(n), y(n);
+   for (size_t i=0; i<n; ++i)
+      x[i] = T_(1. + 0.1*((i*7919)%13));
+   double lambda = 1.;
+   for (int it=0; it<nb_it; ++it) {
+      double s = 0.;
+      for (size_t i=0; i<n; ++i)
+         s += double(x[i])*x[i];
+      s = sqrt(s);
+      for (size_t i=0; i<n; ++i)
+         x[i] /= T_(s);
+      A.mult(x.data(),y.data());
+      double ny = 0.;
+      for (size_t i=0; i<n; ++i) {
+         T_ d = A.diag(i);
+         y[i] = (d!=T_(0)) ? y[i]/d : T_(0);
+         ny += double(y[i])*y[i];
+      }
+      lambda = sqrt(ny);
+      x.swap(y);
+   }
+   return lambda;
+}
+
+
+template<class T_>
+void denseLU<T_>::factor(const spmat<T_>& A)
+{
+   size_t n = A.size();
+   _lu.assign(n*n,T_(0));
+   _piv.resize(n);
+   for (size_t i=0; i<n; ++i)
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k)
+         _lu[n*i+A.col_ind[k]] = A.a[k];
+   for (size_t k=0; k<n; ++k) {
+      size_t p = k;
+      for (size_t i=k+1; i<n; ++i)
+         if (fabs(_lu[n*i+k])>fabs(_lu[n*p+k]))
+            p = i;
+      _piv[k] = p;
+      if (p!=k)
+         for (size_t j=0; j<n; ++j)
+            std::swap(_lu[n*k+j],_lu[n*p+j]);
+      T_ d = _lu[n*k+k];
+      if (d==T_(0))
+         continue;
+      for (size_t i=k+1; i<n; ++i) {
+         T_ f = _lu[n*i+k] /= d;
+         for (size_t j=k+1; j<n; ++j)
+            _lu[n*i+j] -= f*_lu[n*k+j];
+      }
+   }
+}
+
+
+template<class T_>
+void denseLU<T_>::solve(vector<T_>&       x,
+                        const vector<T_>& b) const
+{
+   size_t n = b.size();
+   x = b;
+   for (size_t k=0; k<n; ++k)
+      if (_piv[k]!=k)
+         std::swap(x[k],x[_piv[k]]);
+   for (size_t k=0; k<n; ++k)
+      for (size_t i=k+1; i<n; ++i)
+         x[i] -= _lu[n*i+k]*x[k];
+   for (size_t k=n; k-->0;) {
+      for (size_t j=k+1; j<n; ++j)
+         x[k] -= _lu[n*k+j]*x[j];
+      if (_lu[n*k+k]!=T_(0))
+         x[k] /= _lu[n*k+k];
+      else
+         x[k] = 0;
+   }
+}
+
+template<class T_>
+void SubMatrix(const spmat<T_>& A,
+               size_t           i0,
+               size_t           i1,
+               size_t           j0,
+               size_t           j1,
+               spmat<T_>&       B)
+{
+   B.nb_rows = i1 - i0;
+   B.nb_cols = j1 - j0;
+   B.row_ptr.assign(B.nb_rows+1,0);
+   B.col_ind.clear();
+   B.a.clear();
+   for (size_t i=i0; i<i1; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j>=j0 && j<j1) {
+            B.col_ind.push_back(j-j0);
+            B.a.push_back(A.a[k]);
+         }
+      }
+      B.row_ptr[i-i0+1] = B.a.size();
+   }
+}
+
+
+/*
+ * Copy with conversion of the coefficients (e.g. to single precision)
+ */
+template<class T_, class S_>
+static void Copy(const spmat<S_>& A,
+                 spmat<T_>&       B)
+{
+   B.nb_rows = A.nb_rows, B.nb_cols = A.nb_cols;
+   B.row_ptr = A.row_ptr;
+   B.col_ind = A.col_ind;
+   B.a.assign(A.a.begin(),A.a.end());
+}
+
+template void Transpose(const spmat<double>& A, spmat<double>& At);
+template void Transpose(const spmat<float>& A, spmat<float>& At);
+template void Multiply(const spmat<double>& A, const spmat<double>& B, spmat<double>& C);
+template void Multiply(const spmat<float>& A, const spmat<float>& B, spmat<float>& C);
+template void SubMatrix(const spmat<double>& A, size_t i0, size_t i1, size_t j0, size_t j1,
+                        spmat<double>& B);
+template void SubMatrix(const spmat<float>& A, size_t i0, size_t i1, size_t j0, size_t j1,
+                        spmat<float>& B);
+template double SpectralRadius(const spmat<double>& A, int nb_it);
+template double SpectralRadius(const spmat<float>& A, int nb_it);
+template class denseLU<double>;
+template class denseLU<float>;
+
+
+/*
+ * Dot product, accumulated in double precision. The parallel sum is
+ * reproducible (see parallelSum)
+ */
+template<class T_>
+static T_ Dot(const vector<T_>& x,
+              const vector<T_>& y)
+{
+   return T_(parallelSum(x.size(),[&](size_t b, size_t e) {
+      double s = 0.;
+      for (size_t i=b; i<e; ++i)
+         s += double(x[i])*double(y[i]);
+      return s;
+   }));
+}
+
+
+/*
+ * r = b - r (r containing A x on input), returns (r,r)
+ */
+template<class T_>
+static double Residual(const vector<T_>& b,
+                       vector<T_>&       r)
+{
+   return parallelSum(r.size(),[&](size_t e0, size_t e1) {
+      double s = 0.;
+      for (size_t i=e0; i<e1; ++i) {
+         r[i] = b[i] - r[i];
+         s += double(r[i])*double(r[i]);
+      }
+      return s;
+   });
+}
+
+
+/*
+ * Matrix of the harmonic Ritz problem of GCRO-DR: X = G_q^{-T} X, where G is
+ * the (q+1) x q projected operator (stored by columns) and G_q its first q
+ * rows (LU factorization with partial pivoting). Returns 1 if G_q is singular
+ */
+static int HarmonicRitz(size_t                q,
+                        const vector<double>& G,
+                        vector<double>&       X)
+{
+   vector<double> L(q*q);
+   vector<size_t> piv(q);
+   for (size_t i=0; i<q; ++i)
+      for (size_t j=0; j<q; ++j)
+         L[j*q+i] = G[i*(q+1)+j];
+   double nrm = 0.;
+   for (size_t i=0; i<q*q; ++i)
+      nrm = std::max(nrm,fabs(L[i]));
+   for (size_t j=0; j<q; ++j) {
+      size_t l = j;
+      for (size_t i=j+1; i<q; ++i)
+         if (fabs(L[j*q+i])>fabs(L[j*q+l]))
+            l = i;
+      piv[j] = l;
+      if (fabs(L[j*q+l])<=1.e-14*nrm)
+         return 1;
+      if (l!=j)
+         for (size_t c=0; c<q; ++c)
+            std::swap(L[c*q+j],L[c*q+l]);
+      for (size_t i=j+1; i<q; ++i) {
+         double f = L[j*q+i] /= L[j*q+j];
+         for (size_t c=j+1; c<q; ++c)
+            L[c*q+i] -= f*L[c*q+j];
+      }
+   }
+   for (size_t c=0; c<q; ++c) {
+      double *x = &X[c*q];
+      for (size_t j=0; j<q; ++j)
+         std::swap(x[j],x[piv[j]]);
+      for (size_t j=0; j<q; ++j)
+         for (size_t i=j+1; i<q; ++i)
+            x[i] -= L[j*q+i]*x[j];
+      for (size_t j=q; j-->0;) {
+         x[j] /= L[j*q+j];
+         for (size_t i=0; i<j; ++i)
+            x[i] -= L[j*q+i]*x[j];
+      }
+   }
+   return 0;
+}
+
+
+linearSolver::linearSolver()
+             : _ls(OFELI::CG_SOLVER), _prec(OFELI::IDENT_PREC), _xprec(NO_EXT_PREC), _verb(1),
+               _max_it(1000), _nb_it(0), _nb_setup(0), _nb_outer(0), _toler(1.e-8), _res(0.),
+               _setup_time(0.), _solve_time(0.), _pc_ok(false), _mixed(false), _multicolor(false), _pc(nullptr),
+               _pcf(nullptr), _mf(nullptr), _grid_dim(0), _asm_overlap(1), _asm_direct(false), _asm_coarse(false),
+               _schur_nu(0), _recycle(0)
+{
+}
+
+
+linearSolver::~linearSolver()
+{
+   deletePrec();
+}
+
+
+void linearSolver::deletePrec()
+{
+   if (_pc!=nullptr)
+      delete _pc, _pc = nullptr;
+   if (_pcf!=nullptr)
+      delete _pcf, _pcf = nullptr;
+   _pc_ok = false;
+}
+
+
+void linearSolver::set(OFELI::Iteration      ls,
+                       OFELI::Preconditioner prec,
+                       ExtPreconditioner     xprec)
+{
+   if (xprec!=_xprec || prec!=_prec || (xprec==ASM_PREC && (ls==OFELI::CG_SOLVER)!=(_ls==OFELI::CG_SOLVER)))
+      deletePrec();
+   _ls = ls;
+   _prec = prec;
+   _xprec = xprec;
+}
+
+
+void linearSolver::setMixedPrecision(bool mixed)
+{
+   if (mixed!=_mixed)
+      deletePrec();
+   _mixed = mixed;
+}
+
+
+void linearSolver::setMulticolor(bool mc)
+{
+   if (mc!=_multicolor)
+      deletePrec();
+   _multicolor = mc;
+}
+
+
+/*
+ * Structured grid of ne[0]*ne[1]*ne[2] intervals (dim directions), node[i] is
+ * the lexicographic index of the grid node of unknown i
+ */
+void linearSolver::setGrid(int                   dim,
+                           const size_t*         ne,
+                           const vector<size_t>& node)
+{
+   _grid_dim = dim;
+   for (int i=0; i<3; ++i)
+      _grid_ne[i] = (i<dim) ? ne[i] : 0;
+   if (node!=_grid_node)
+      deletePrec();
+   _grid_node = node;
+}
+
+
+/*
+ * Subdomains of the Schwarz preconditioner: part[i] is the subdomain of
+ * unknown i (graph partitioning of the matrix if empty)
+ */
+void linearSolver::setSchwarz(const vector<int>& part,
+                              int                overlap,
+                              bool               direct,
+                              bool               coarse)
+{
+   if (part!=_asm_part || overlap!=_asm_overlap || direct!=_asm_direct || coarse!=_asm_coarse)
+      deletePrec();
+   _asm_part = part;
+   _asm_overlap = overlap;
+   _asm_direct = direct;
+   _asm_coarse = coarse;
+}
+
+
+void Convert(const OFELI::Matrix<double>& A,
+             spmat<double>&               B,
+             const vector<double>&        d)
+{
+   B.clear();
+   B.nb_rows = B.nb_cols = A.getNbRows();
+   B.row_ptr.resize(B.nb_rows+1);
+   for (size_t i=0; i<=B.nb_rows; ++i)
+      B.row_ptr[i] = A.getRowPtr(i);
+   B.col_ind.resize(B.row_ptr[B.nb_rows]);
+   B.a.resize(B.row_ptr[B.nb_rows]);
+   for (size_t i=0; i<B.nb_rows; ++i) {
+      for (size_t k=B.row_ptr[i]; k<B.row_ptr[i+1]; ++k) {
+         size_t j = B.col_ind[k] = A.getColInd(k);
+         B.a[k] = A(i+1,j+1);
+         if (j==i && d.size())
+            B.a[k] += d[i];
+      }
+   }
+}
+
+
+/*
+ * A + diag(d). If changed is false, the caller guarantees that A and d are
+ * those of the last call: the matrix is not copied and the preconditioner is
+ * kept
+ */
+int linearSolver::setMatrix(const OFELI::Matrix<double>& A,
+                            const vector<double>&        d,
+                            bool                         changed)
+{
+   if (!changed && _pc_ok && _mf==nullptr && _A.size()==A.getNbRows())
+      return 0;
+   _mf = nullptr;
+   Convert(A,_A,d);
+   _pc_ok = false;
+   return 1;
+}
+
+
+/*
+ * Symmetry of the assembled matrix, up to rows reduced to their diagonal
+ * entry (prescribed unknowns)
+ */
+bool linearSolver::isSymmetric() const
+{
+   size_t n = _A.size();
+   if (n==0)
+      return false;
+   double amax = 0.;
+   vector<char> fixed(n,1);
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=_A.row_ptr[i]; k<_A.row_ptr[i+1]; ++k) {
+         amax = std::max(amax,fabs(_A.a[k]));
+         if (_A.col_ind[k]!=i && _A.a[k]!=0.)
+            fixed[i] = 0;
+      }
+   }
+   for (size_t i=0; i<n; ++i) {
+      if (fixed[i])
+         continue;
+      for (size_t k=_A.row_ptr[i]; k<_A.row_ptr[i+1]; ++k) {
+         size_t j = _A.col_ind[k];
+         if (j<=i || fixed[j])
+            continue;
+         const unsigned *c0=_A.col_ind.data()+_A.row_ptr[j], *c1=_A.col_ind.data()+_A.row_ptr[j+1];
+         const unsigned *c = std::lower_bound(c0,c1,unsigned(i));
+         double aji = (c!=c1 && *c==i) ? _A.a[_A.row_ptr[j]+(c-c0)] : 0.;
+         if (fabs(_A.a[k]-aji)>1.e-12*amax)
+            return false;
+      }
+   }
+   return true;
+}
+
+
+/*
+ * The operator is not copied: A must live as long as it is used by solve()
+ */
+int linearSolver::setMatrix(const matrixFree& A)
+{
+   _A.clear();
+   _mf = &A;
+   _pc_ok = false;
+   return 1;
+}
+
+
+int linearSolver::setMatrix(spmat<double>&& A)
+{
+   _mf = nullptr;
+   _A = std::move(A);
+   _pc_ok = false;
+   return 1;
+}
+
+
+/*
+ * Saddle point system with nu velocity unknowns: pressure matrices of the
+ * Schur complement approximation (see schurPrec)
+ */
+void linearSolver::setSchur(size_t               nu,
+                            const spmat<double>& M,
+                            const spmat<double>& K,
+                            const spmat<double>& Fp)
+{
+   _schur_nu = nu;
+   _schur_M = M;
+   _schur_K = K;
+   _schur_F = Fp;
+   deletePrec();
+}
+
+
+template<class T_>
+precond<T_> *linearSolver::newPrec()
+{
+   if (_xprec==AMG_PREC)
+      return new amg<T_>;
+   else if (_xprec==GMG_PREC) {
+      if (_grid_dim==0 || _grid_node.size()!=_A.size()) {
+         cout << "Error: Geometric multigrid requires a structured grid." << endl;
+         return nullptr;
+      }
+      return new gmg<T_>(_grid_dim,_grid_ne,_grid_node);
+   }
+   else if (_xprec==CHEBYSHEV_PREC)
+      return new chebyshev<T_>;
+   else if (_xprec==SCHUR_MASS_PREC || _xprec==SCHUR_PCD_PREC) {
+      if (_schur_nu==0 || _schur_nu+_schur_M.size()!=_A.size()) {
+         cout << "Error: Block preconditioner requires a velocity-pressure system." << endl;
+         return nullptr;
+      }
+      spmat<T_> M, K, F;
+      Copy(_schur_M,M);
+      Copy(_schur_K,K);
+      Copy(_schur_F,F);
+      schurPrec<T_> *pc = new schurPrec<T_>(_schur_nu,_xprec==SCHUR_PCD_PREC);
+      pc->setPressure(M,K,F);
+      return pc;
+   }
+   else if (_xprec==NO_EXT_PREC && _prec==OFELI::IDENT_PREC)
+      return new identPrec<T_>;
+   else if (_xprec==NO_EXT_PREC && _prec==OFELI::DIAG_PREC)
+      return new diagPrec<T_>;
+   else if (_xprec==NO_EXT_PREC && (_prec==OFELI::ILU_PREC || _prec==OFELI::DILU_PREC ||
+                                    _prec==OFELI::SSOR_PREC))
+      return new ilu<T_>(_prec,_multicolor);
+   else if (_xprec==CHOLESKY_PREC || _xprec==LDLT_PREC)
+      return new cholesky<T_>(_xprec==LDLT_PREC);
+   else if (_xprec==ASM_PREC)
+      return new schwarz<T_>(_asm_part,_asm_overlap,_asm_direct,_asm_coarse,_ls!=OFELI::CG_SOLVER);
+   cout << "Error: Preconditioner not available in rita." << endl;
+   return nullptr;
+}
+
+
+/*
+ * Preconditioners of a matrix-free operator only use its diagonal and
+ * products with it: diag is the Chebyshev preconditioner of degree 1
+ */
+int linearSolver::setMatrixFreePrec()
+{
+   deletePrec();
+   if (_xprec==NO_EXT_PREC && _prec==OFELI::IDENT_PREC) {
+      _pc = new identPrec<double>;
+      return 0;
+   }
+   if ((_xprec!=NO_EXT_PREC || _prec!=OFELI::DIAG_PREC) && _xprec!=CHEBYSHEV_PREC) {
+      cout << "Error: Preconditioner not available for a matrix-free operator." << endl;
+      return 1;
+   }
+   chebyshev<double> *pc = new chebyshev<double>(_xprec==CHEBYSHEV_PREC ? 4 : 1);
+   vector<double> d;
+   _mf->getDiag(d);
+   const matrixFree *A = _mf;
+   pc->set([A](const double* x, double* y) { A->mult(x,y); },d,_mf->getBound());
+   _pc = pc;
+   return 0;
+}
+
+
+int linearSolver::setPrec()
+{
+   int ret = 0;
+   auto t0 = std::chrono::steady_clock::now();
+   if (_mf) {
+      if ((ret=setMatrixFreePrec()))
+         return ret;
+   }
+   else if (_mixed) {
+      Copy(_A,_Af);
+      if (_pcf==nullptr && (_pcf=newPrec<float>())==nullptr)
+         return 1;
+      ret = _pcf->setup(_Af);
+   }
+   else {
+      if (_pc==nullptr && (_pc=newPrec<double>())==nullptr)
+         return 1;
+      ret = _pc->setup(_A);
+   }
+   _setup_time = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+   _nb_setup++;
+   if (_verb>1) {
+      if (_mixed && _mf==nullptr)
+         _pcf->print(cout);
+      else
+         _pc->print(cout);
+      cout << "Preconditioner setup time: " << _setup_time << " s" << endl;
+   }
+   _pc_ok = (ret==0);
+   return ret;
+}
+
+
+int linearSolver::solve(const OFELI::Vect<double>& b,
+                        OFELI::Vect<double>&       x)
+{
+   size_t n = _mf ? _mf->size() : _A.size();
+   if (n==0 || b.size()!=n) {
+      cout << "Error: Linear system size mismatch." << endl;
+      return 1;
+   }
+   bool direct = (_ls==OFELI::DIRECT_SOLVER && (_xprec==CHOLESKY_PREC || _xprec==LDLT_PREC));
+   if (_ls!=OFELI::CG_SOLVER && _ls!=OFELI::BICG_STAB_SOLVER && _ls!=OFELI::GMRES_SOLVER && !direct) {
+      cout << "Error: This linear solver cannot be combined with a rita preconditioner." << endl;
+      return 1;
+   }
+   if (!_pc_ok) {
+      if (setPrec())
+         return 1;
+   }
+   else if (_verb>1)
+      cout << "Reusing preconditioner set up for a previous matrix." << endl;
+
+   vector<double> bb(n), xx(n,0.);
+   for (size_t i=0; i<n; ++i)
+      bb[i] = b[i];
+   if (x.size()==n) {
+      for (size_t i=0; i<n; ++i)
+         xx[i] = x[i];
+   }
+   else
+      x.setSize(n);
+
+   auto t0 = std::chrono::steady_clock::now();
+   bool gcrodr = (_recycle>0 && _ls==OFELI::GMRES_SOLVER);
+   if (_mf)
+      _nb_it = gcrodr ? GCRODR(*_mf,*_pc,bb,xx) : iterate(*_mf,*_pc,bb,xx);
+   else if (_mixed)
+      _nb_it = refine(bb,xx);
+   else
+      _nb_it = gcrodr ? GCRODR(_A,*_pc,bb,xx) : iterate(_A,*_pc,bb,xx);
+   _solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+   for (size_t i=0; i<n; ++i)
+      x[i] = xx[i];
+   if (_verb>1) {
+      cout << "Number of iterations: " << std::abs(_nb_it);
+      if (_mixed && _mf==nullptr)
+         cout << " (" << _nb_outer << " refinement steps)";
+      cout << ", Relative residual: " << _res << ", Solve time: " << _solve_time << " s" << endl;
+   }
+   if (_nb_it<0 && direct) {
+      if (_verb)
+         cout << "Warning: Iterative refinement of the direct solution stopped at relative residual "
+              << _res << "." << endl;
+      return 0;
+   }
+   if (_nb_it<0) {
+      if (_verb)
+         cout << "Warning: Linear solver did not converge within " << _max_it << " iterations." << endl;
+      return 1;
+   }
+   return 0;
+}
+
+
+/*
+ * Solution of A x[v] = b[v] for several right-hand sides. The preconditioner
+ * is set up once; the number of iterations is the largest one.
+ */
+int linearSolver::solve(const vector<OFELI::Vect<double> >& b,
+                        vector<OFELI::Vect<double> >&       x)
+{
+   size_t n=_mf ? _mf->size() : _A.size(), nv=b.size();
+   x.resize(nv);
+   if (_ls!=OFELI::CG_SOLVER || _mf || _mixed || nv==1) {
+      int ret=0, nb_it=0;
+      double res=0., time=0.;
+      for (size_t v=0; v<nv && ret==0; ++v) {
+         ret = solve(b[v],x[v]);
+         nb_it = std::max(nb_it,std::abs(_nb_it));
+         res = std::max(res,_res);
+         time += _solve_time;
+      }
+      _nb_it=nb_it, _res=res, _solve_time=time;
+      if (_verb>1 && nv>1)
+         cout << "Number of right-hand sides: " << nv << ", Total solve time: " << _solve_time << " s" << endl;
+      return ret;
+   }
+   for (size_t v=0; v<nv; ++v) {
+      if (b[v].size()!=n || n==0) {
+         cout << "Error: Linear system size mismatch." << endl;
+         return 1;
+      }
+   }
+   if (!_pc_ok) {
+      if (setPrec())
+         return 1;
+   }
+   else if (_verb>1)
+      cout << "Reusing preconditioner set up for a previous matrix." << endl;
+
+   vector<vector<double> > bb(nv,vector<double>(n)), xx(nv,vector<double>(n,0.));
+   for (size_t v=0; v<nv; ++v) {
+      for (size_t i=0; i<n; ++i)
+         bb[v][i] = b[v][i];
+      if (x[v].size()==n) {
+         for (size_t i=0; i<n; ++i)
+            xx[v][i] = x[v][i];
+      }
+      else
+         x[v].setSize(n);
+   }
+   auto t0 = std::chrono::steady_clock::now();
+   _nb_it = MultiCG(bb,xx);
+   _solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+   for (size_t v=0; v<nv; ++v)
+      for (size_t i=0; i<n; ++i)
+         x[v][i] = xx[v][i];
+   if (_verb>1)
+      cout << "Number of right-hand sides: " << nv << ", Number of iterations: " << std::abs(_nb_it)
+           << ", Largest relative residual: " << _res << ", Solve time: " << _solve_time << " s" << endl;
+   if (_nb_it<0) {
+      cout << "Warning: Linear solver did not converge within " << _max_it << " iterations." << endl;
+      return 1;
+   }
+   return 0;
+}
+
+
+template<class M_, class T_>
+int linearSolver::iterate(const M_&           A,
+                          const precond<T_>& P,
+                          const vector<T_>&  b,
+                          vector<T_>&        x)
+{
+   if (_ls==OFELI::DIRECT_SOLVER)
+      return Richardson(A,P,b,x);
+   else if (_ls==OFELI::BICG_STAB_SOLVER)
+      return BiCGStab(A,P,b,x);
+   else if (_ls==OFELI::GMRES_SOLVER)
+      return GMRES(A,P,b,x);
+   return CG(A,P,b,x);
+}
+
+
+/*
+ * Iterative refinement: the correction equation A e = b - A x is solved in
+ * single precision, the residual and the solution are updated in double
+ * precision. The inner tolerance is the reduction still needed, bounded by
+ * what single precision can achieve.
+ */
+int linearSolver::refine(const vector<double>& b,
+                         vector<double>&       x)
+{
+   size_t n = _A.size();
+   vector<double> r(n);
+   vector<float> rf(n), ef(n);
+   double nb = sqrt(Dot(b,b)), toler = _toler;
+   if (nb==0.)
+      nb = 1.;
+   int nb_it = 0, ret = 0;
+   for (_nb_outer=0; _nb_outer<50 && nb_it<_max_it; ++_nb_outer) {
+      _A.mult(x.data(),r.data());
+      _res = sqrt(Residual(b,r))/nb;
+      if (_res<toler)
+         break;
+      _toler = std::max(0.5*toler/_res,1.e-5);
+      for (size_t i=0; i<n; ++i)
+         rf[i] = float(r[i]), ef[i] = 0.f;
+      ret = iterate(_Af,*_pcf,rf,ef);
+      nb_it += std::abs(ret);
+      for (size_t i=0; i<n; ++i)
+         x[i] += ef[i];
+   }
+   _toler = toler;
+   if (_res>=toler)
+      return -std::max(nb_it,1);
+   return nb_it;
+}
+
+
+/*
+ * Iterations x += P^{-1}(b - A x). With a factorization of A as P, this is
+ * iterative refinement of the direct solution: it stops after at most 10
+ * steps, or when the residual is no longer reduced.
+ */
+template<class M_, class T_>
+int linearSolver::Richardson(const M_&            A,
+                             const precond<T_>&  P,
+                             const vector<T_>&   b,
+                             vector<T_>&         x)
+{
+   size_t n = A.size();
+   vector<T_> r(n), z(n);
+   double nb = sqrt(double(Dot(b,b))), res = 0.;
+   if (nb==0.)
+      nb = 1.;
+   for (int it=0; it<=std::min(_max_it,10); ++it) {
+      A.mult(x.data(),r.data());
+      _res = sqrt(Residual(b,r))/nb;
+      if (_res<_toler)
+         return it;
+      if (it>0 && _res>0.5*res)
+         return -it;
+      res = _res;
+      P.solve(r,z);
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i=e0; i<e1; ++i)
+            x[i] += z[i];
+      });
+   }
+   return -std::min(_max_it,10);
+}
+
+
+/*
+ * Preconditioned conjugate gradient. The updates of x and r are fused with
+ * the computation of (r,r), and (r,z) is computed in the pass updating p.
+ */
+template<class M_, class T_>
+int linearSolver::CG(const M_&            A,
+                     const precond<T_>&  P,
+                     const vector<T_>&   b,
+                     vector<T_>&         x)
+{
+   size_t n = A.size();
+   vector<T_> r(n), z(n), p(n), q(n);
+   A.mult(x.data(),r.data());
+   double nb = sqrt(double(Dot(b,b)));
+   if (nb==0.)
+      nb = 1.;
+   _res = sqrt(Residual(b,r))/nb;
+   if (_res<_toler)
+      return 0;
+   P.solve(r,z);
+   p = z;
+   T_ rz = Dot(r,z);
+   for (int it=1; it<=_max_it; ++it) {
+      A.mult(p.data(),q.data());
+      T_ alpha = rz/Dot(p,q);
+      double rr = parallelSum(n,[&](size_t e0, size_t e1) {
+         double s = 0.;
+         for (size_t i=e0; i<e1; ++i) {
+            x[i] += alpha*p[i];
+            r[i] -= alpha*q[i];
+            s += double(r[i])*double(r[i]);
+         }
+         return s;
+      });
+      _res = sqrt(rr)/nb;
+      if (_res<_toler)
+         return it;
+      P.solve(r,z);
+      T_ rz1 = Dot(r,z);
+      T_ beta = rz1/rz;
+      rz = rz1;
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i=e0; i<e1; ++i)
+            p[i] = z[i] + beta*p[i];
+      });
+   }
+   return -_max_it;
+}
+
+
+/*
+ * Preconditioned conjugate gradient for several right-hand sides: the
+ * iterations of all systems advance together and the products with A of
+ * their search directions are computed in one pass over the matrix. A system
+ * leaves the iterations once it has converged.
+ */
+int linearSolver::MultiCG(const vector<vector<double> >& b,
+                          vector<vector<double> >&       x)
+{
+   size_t n=_A.size(), nv=b.size();
+   vector<vector<double> > r(nv,vector<double>(n)), z(nv,vector<double>(n,0.));
+   vector<double> X(n*nv), R(n*nv), P(n*nv,0.), Q(n*nv), nb(nv), rz(nv,0.), res(nv);
+   vector<double> pq(nv), rr(nv), alpha(nv,0.), beta(nv,0.);
+   vector<bool> act(nv,false);
+   size_t na = 0;
+   for (size_t v=0; v<nv; ++v) {
+      _A.mult(x[v].data(),r[v].data());
+      nb[v] = sqrt(Dot(b[v],b[v]));
+      if (nb[v]==0.)
+         nb[v] = 1.;
+      res[v] = sqrt(Residual(b[v],r[v]))/nb[v];
+      for (size_t i=0; i<n; ++i)
+         X[i*nv+v] = x[v][i], R[i*nv+v] = r[v][i];
+      if (res[v]<_toler)
+         continue;
+      _pc->solve(r[v],z[v]);
+      for (size_t i=0; i<n; ++i)
+         P[i*nv+v] = z[v][i];
+      rz[v] = Dot(r[v],z[v]);
+      act[v] = true, na++;
+   }
+
+// Vectors of all systems are stored by rows, so that each pass handles all of
+// them; only the preconditioner works on separate vectors. Directions of
+// converged systems are zero.
+   int it = 0;
+   while (na && it<_max_it) {
+      it++;
+      _A.mult(nv,P.data(),Q.data());
+      parallelSum(n,[&](size_t e0, size_t e1, double* s) {
+         for (size_t i=e0; i<e1; ++i)
+            for (size_t v=0; v<nv; ++v)
+               s[v] += P[i*nv+v]*Q[i*nv+v];
+      },pq.data(),int(nv));
+      for (size_t v=0; v<nv; ++v)
+         alpha[v] = act[v] ? rz[v]/pq[v] : 0.;
+      parallelSum(n,[&](size_t e0, size_t e1, double* s) {
+         for (size_t i=e0; i<e1; ++i) {
+            for (size_t v=0; v<nv; ++v) {
+               X[i*nv+v] += alpha[v]*P[i*nv+v];
+               R[i*nv+v] -= alpha[v]*Q[i*nv+v];
+               s[v] += R[i*nv+v]*R[i*nv+v];
+            }
+         }
+      },rr.data(),int(nv));
+      for (size_t v=0; v<nv; ++v) {
+         if (act[v] && (res[v]=sqrt(rr[v])/nb[v])<_toler)
+            act[v] = false, na--;
+      }
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i0=e0; i0<e1; i0+=256) {
+            size_t i1 = std::min(e1,i0+256);
+            for (size_t v=0; v<nv; ++v)
+               if (act[v])
+                  for (size_t i=i0; i<i1; ++i)
+                     r[v][i] = R[i*nv+v];
+         }
+      });
+      for (size_t v=0; v<nv; ++v) {
+         if (act[v])
+            _pc->solve(r[v],z[v]);
+         else
+            std::fill(z[v].begin(),z[v].end(),0.);
+      }
+      parallelSum(n,[&](size_t e0, size_t e1, double* s) {
+         for (size_t v=0; v<nv; ++v)
+            for (size_t i=e0; i<e1; ++i)
+               s[v] += r[v][i]*z[v][i];
+      },pq.data(),int(nv));
+      for (size_t v=0; v<nv; ++v) {
+         beta[v] = act[v] ? pq[v]/rz[v] : 0.;
+         rz[v] = pq[v];
+      }
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i0=e0; i0<e1; i0+=256) {
+            size_t i1 = std::min(e1,i0+256);
+            for (size_t v=0; v<nv; ++v)
+               for (size_t i=i0; i<i1; ++i)
+                  Q[i*nv+v] = z[v][i];
+            for (size_t i=i0; i<i1; ++i)
+               for (size_t v=0; v<nv; ++v)
+                  P[i*nv+v] = Q[i*nv+v] + beta[v]*P[i*nv+v];
+         }
+      });
+   }
+   for (size_t v=0; v<nv; ++v)
+      for (size_t i=0; i<n; ++i)
+         x[v][i] = X[i*nv+v];
+   _res = *std::max_element(res.begin(),res.end());
+   return na ? -_max_it : it;
+}
+
+
+/*
+ * Preconditioned BiCG-Stab. Vector updates are fused with the inner products
+ * that follow them: (s,s) with s, (t,s) and (t,t) in one pass, (r,r) with x
+ * and r.
+ */
+template<class M_, class T_>
+int linearSolver::BiCGStab(const M_&            A,
+                           const precond<T_>&  P,
+                           const vector<T_>&   b,
+                           vector<T_>&         x)
+{
+   size_t n = A.size();
+   vector<T_> r(n), rt(n), p(n,0), v(n,0), s(n), t(n), ph(n), sh(n);
+   A.mult(x.data(),r.data());
+   double nb = sqrt(double(Dot(b,b)));
+   if (nb==0.)
+      nb = 1.;
+   _res = sqrt(Residual(b,r))/nb;
+   if (_res<_toler)
+      return 0;
+   rt = r;
+   T_ rho=1, alpha=1, omega=1;
+   for (int it=1; it<=_max_it; ++it) {
+      T_ rho1 = Dot(rt,r);
+      if (rho1==T_(0))
+         return -it;
+      T_ beta = (rho1/rho)*(alpha/omega);
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i=e0; i<e1; ++i)
+            p[i] = r[i] + beta*(p[i]-omega*v[i]);
+      });
+      P.solve(p,ph);
+      A.mult(ph.data(),v.data());
+      alpha = rho1/Dot(rt,v);
+      double ss = parallelSum(n,[&](size_t e0, size_t e1) {
+         double d = 0.;
+         for (size_t i=e0; i<e1; ++i) {
+            s[i] = r[i] - alpha*v[i];
+            d += double(s[i])*double(s[i]);
+         }
+         return d;
+      });
+      _res = sqrt(ss)/nb;
+      if (_res<_toler) {
+         parallelFor(n,[&](size_t e0, size_t e1) {
+            for (size_t i=e0; i<e1; ++i)
+               x[i] += alpha*ph[i];
+         });
+         return it;
+      }
+      P.solve(s,sh);
+      A.mult(sh.data(),t.data());
+      double ts[2];
+      parallelSum(n,[&](size_t e0, size_t e1, double* d) {
+         for (size_t i=e0; i<e1; ++i) {
+            d[0] += double(t[i])*double(s[i]);
+            d[1] += double(t[i])*double(t[i]);
+         }
+      },ts,2);
+      omega = T_(ts[0]/ts[1]);
+      double rr = parallelSum(n,[&](size_t e0, size_t e1) {
+         double d = 0.;
+         for (size_t i=e0; i<e1; ++i) {
+            x[i] += alpha*ph[i] + omega*sh[i];
+            r[i] = s[i] - omega*t[i];
+            d += double(r[i])*double(r[i]);
+         }
+         return d;
+      });
+      _res = sqrt(rr)/nb;
+      if (_res<_toler)
+         return it;
+      rho = rho1;
+   }
+   return -_max_it;
+}
+
+
+template<class M_, class T_>
+int linearSolver::GMRES(const M_&            A,
+                        const precond<T_>&  P,
+                        const vector<T_>&   b,
+                        vector<T_>&         x,
+                        int                 m)
+{
+   size_t n = A.size();
+   vector<vector<T_> > V(m+1,vector<T_>(n)), Z(m,vector<T_>(n));
+   vector<vector<T_> > H(m+1,vector<T_>(m,0));
+   vector<T_> r(n), g(m+1), cs(m), sn(m);
+   double nb = sqrt(double(Dot(b,b)));
+   if (nb==0.)
+      nb = 1.;
+   int it = 0;
+   while (it<_max_it) {
+      A.mult(x.data(),r.data());
+      T_ beta = T_(sqrt(Residual(b,r)));
+      _res = double(beta)/nb;
+      if (_res<_toler)
+         return it;
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i=e0; i<e1; ++i)
+            V[0][i] = r[i]/beta;
+      });
+      std::fill(g.begin(),g.end(),T_(0));
+      g[0] = beta;
+      int j = 0;
+      for (; j<m && it<_max_it; ++j) {
+         it++;
+         P.solve(V[j],Z[j]);
+         A.mult(Z[j].data(),V[j+1].data());
+
+//       Modified Gram-Schmidt: the projection on V[k] is fused with the inner
+//       product with V[k+1], and the last one with the norm
+         vector<T_> &w = V[j+1];
+         H[0][j] = Dot(w,V[0]);
+         for (int k=0; k<=j; ++k) {
+            const vector<T_> &vk=V[k], &vn=V[k+1];
+            T_ h = H[k][j];
+            H[k+1][j] = T_(parallelSum(n,[&](size_t e0, size_t e1) {
+               double d = 0.;
+               for (size_t i=e0; i<e1; ++i) {
+                  w[i] -= h*vk[i];
+                  d += double(w[i])*double(vn[i]);
+               }
+               return d;
+            }));
+         }
+         H[j+1][j] = sqrt(H[j+1][j]);
+         if (H[j+1][j]!=T_(0)) {
+            T_ h = H[j+1][j];
+            parallelFor(n,[&](size_t e0, size_t e1) {
+               for (size_t i=e0; i<e1; ++i)
+                  w[i] /= h;
+            });
+         }
+         for (int k=0; k<j; ++k) {
+            T_ h = cs[k]*H[k][j] + sn[k]*H[k+1][j];
+            H[k+1][j] = -sn[k]*H[k][j] + cs[k]*H[k+1][j];
+            H[k][j] = h;
+         }
+         T_ d = sqrt(H[j][j]*H[j][j] + H[j+1][j]*H[j+1][j]);
+         cs[j] = H[j][j]/d;
+         sn[j] = H[j+1][j]/d;
+         H[j][j] = d;
+         H[j+1][j] = 0;
+         g[j+1] = -sn[j]*g[j];
+         g[j] *= cs[j];
+         _res = fabs(double(g[j+1]))/nb;
+         if (_res<_toler) {
+            j++;
+            break;
+         }
+      }
+
+//    Update solution with the least squares solution of the Hessenberg system
+      vector<T_> y(j);
+      for (int k=j-1; k>=0; --k) {
+         y[k] = g[k];
+         for (int l=k+1; l<j; ++l)
+            y[k] -= H[k][l]*y[l];
+         y[k] /= H[k][k];
+      }
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i=e0; i<e1; ++i)
+            for (int k=0; k<j; ++k)
+               x[i] += y[k]*Z[k][i];
+      });
+      if (_res<_toler)
+         return it;
+   }
+   return -_max_it;
+}
+
+
+/*
+ * GCRO with deflated restarting. The recycled space U (k vectors, with
+ * A U = C and C orthonormal) is kept from a solve to the next one, e.g. from
+ * a time step to the next: only C = A U is computed again for the new matrix.
+ * Each cycle minimizes the residual over U and a Krylov space of (I - C C^T)A
+ * preconditioned on the right. U is stored in the space of the unknowns, so it
+ * remains valid when the preconditioner is rebuilt.
+ * At the end of a cycle, the new recycled space is spanned by the k harmonic
+ * Ritz vectors of A with respect to [C V] associated to the harmonic Ritz
+ * values of smallest modulus (G^T G p = theta G_q^T p, with A [U Z] = [C V] G
+ * and G_q the first rows of G), i.e. approximate eigenvectors of the
+ * eigenvalues of A closest to the origin, which slow down the convergence.
+ */
+template<class M_>
+int linearSolver::GCRODR(const M_&             A,
+                         const precond<double>& P,
+                         const vector<double>&  b,
+                         vector<double>&        x,
+                         int                    m)
+{
+   size_t n=A.size(), k=std::min(size_t(_recycle),size_t(m/2));
+   vector<double> r(n);
+   double nb = sqrt(Dot(b,b));
+   if (nb==0.)
+      nb = 1.;
+   A.mult(x.data(),r.data());
+   double beta = sqrt(Residual(b,r));
+   _res = beta/nb;
+   if (_res<_toler)
+      return 0;
+
+// Recycled space of the previous solve: C = A U is orthonormalized
+   vector<vector<double> > &U=_U, C;
+   if (U.size() && U[0].size()!=n)
+      U.clear();
+   for (size_t i=0; i<U.size(); ++i) {
+      vector<double> c(n);
+      A.mult(U[i].data(),c.data());
+      for (size_t j=0; j<C.size(); ++j) {
+         double h = Dot(C[j],c);
+         for (size_t l=0; l<n; ++l)
+            c[l] -= h*C[j][l], U[i][l] -= h*U[j][l];
+      }
+      double h = sqrt(Dot(c,c));
+      if (h<=1.e-12*nb) {
+         U.erase(U.begin()+i--);
+         continue;
+      }
+      for (size_t l=0; l<n; ++l)
+         c[l] /= h, U[i][l] /= h;
+      C.push_back(c);
+   }
+   vector<vector<double> > V(m+1,vector<double>(n)), Z(m,vector<double>(n));
+   int it = 0;
+   while (it<_max_it) {
+
+//    The residual is first made orthogonal to C: x += U C^T r, r -= C C^T r
+      size_t kk=C.size(), s=m-kk;
+      vector<double> cr(kk);
+      for (size_t i=0; i<kk; ++i)
+         cr[i] = Dot(C[i],r);
+      if (kk) {
+         parallelFor(n,[&](size_t e0, size_t e1) {
+            for (size_t i=e0; i<e1; ++i) {
+               for (size_t l=0; l<kk; ++l)
+                  x[i] += cr[l]*U[l][i], r[i] -= cr[l]*C[l][i];
+            }
+         });
+         beta = sqrt(Dot(r,r));
+         if (beta==0.)
+            break;
+      }
+
+//    Arnoldi process for (I - C C^T) A M^{-1}, B = C^T A M^{-1} V
+      vector<vector<double> > H(s+1,vector<double>(s,0.)), R(s+1,vector<double>(s,0.)), B(kk,vector<double>(s,0.));
+      vector<double> g(s+1,0.), cs(s), sn(s);
+      vector<const double *> W(kk);
+      for (size_t i=0; i<kk; ++i)
+         W[i] = C[i].data();
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i=e0; i<e1; ++i)
+            V[0][i] = r[i]/beta;
+      });
+      g[0] = beta;
+      size_t j = 0;
+      for (; j<s && it<_max_it; ++j) {
+         it++;
+         P.solve(V[j],Z[j]);
+         vector<double> &w = V[j+1];
+         A.mult(Z[j].data(),w.data());
+
+//       Modified Gram-Schmidt against [C V], fused as in GMRES
+         W.push_back(V[j].data());
+         size_t nq = W.size();
+         vector<double> h(nq+1);
+         h[0] = parallelSum(n,[&](size_t e0, size_t e1) {
+            double d = 0.;
+            for (size_t l=e0; l<e1; ++l)
+               d += w[l]*W[0][l];
+            return d;
+         });
+         for (size_t i=0; i<nq; ++i) {
+            const double *qi=W[i], *qn=(i+1<nq ? W[i+1] : w.data());
+            double hi = h[i];
+            h[i+1] = parallelSum(n,[&](size_t e0, size_t e1) {
+               double d = 0.;
+               for (size_t l=e0; l<e1; ++l) {
+                  w[l] -= hi*qi[l];
+                  d += w[l]*qn[l];
+               }
+               return d;
+            });
+         }
+         for (size_t i=0; i<kk; ++i)
+            B[i][j] = h[i];
+         for (size_t i=0; i<=j; ++i)
+            H[i][j] = h[kk+i];
+         double hn = H[j+1][j] = sqrt(h[nq]);
+         if (hn!=0.) {
+            parallelFor(n,[&](size_t e0, size_t e1) {
+               for (size_t l=e0; l<e1; ++l)
+                  w[l] /= hn;
+            });
+         }
+
+//       Givens rotations on a copy of H give the residual norm
+         for (size_t i=0; i<=j+1; ++i)
+            R[i][j] = H[i][j];
+         for (size_t i=0; i<j; ++i) {
+            double t = cs[i]*R[i][j] + sn[i]*R[i+1][j];
+            R[i+1][j] = -sn[i]*R[i][j] + cs[i]*R[i+1][j];
+            R[i][j] = t;
+         }
+         double d = sqrt(R[j][j]*R[j][j] + R[j+1][j]*R[j+1][j]);
+         cs[j] = R[j][j]/d;
+         sn[j] = R[j+1][j]/d;
+         R[j][j] = d;
+         R[j+1][j] = 0.;
+         g[j+1] = -sn[j]*g[j];
+         g[j] *= cs[j];
+         _res = fabs(g[j+1])/nb;
+         if (_res<_toler || hn==0.) {
+            j++;
+            break;
+         }
+      }
+
+//    Least squares solution: y minimizes the Krylov part of the residual and
+//    the part in C vanishes with yu = -B y
+      vector<double> y(j), yu(kk,0.);
+      for (int i=int(j)-1; i>=0; --i) {
+         y[i] = g[i];
+         for (size_t l=i+1; l<j; ++l)
+            y[i] -= R[i][l]*y[l];
+         y[i] /= R[i][i];
+      }
+      for (size_t i=0; i<kk; ++i)
+         for (size_t l=0; l<j; ++l)
+            yu[i] -= B[i][l]*y[l];
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         for (size_t i=e0; i<e1; ++i) {
+            for (size_t l=0; l<kk; ++l)
+               x[i] += yu[l]*U[l][i];
+            for (size_t l=0; l<j; ++l)
+               x[i] += y[l]*Z[l][i];
+         }
+      });
+      A.mult(x.data(),r.data());
+      beta = sqrt(Residual(b,r));
+      _res = beta/nb;
+      if (k==0 || j<k) {
+         if (_res<_toler)
+            break;
+         continue;
+      }
+
+//    New recycled space from the harmonic Ritz vectors of smallest modulus:
+//    G^T G p = theta G_q^T p, with G = [I B; 0 H] ((kk+j+1) x (kk+j)) such that
+//    A [U Z] = [C V] G and G_q its first kk+j rows
+      size_t q = kk + j;
+      vector<double> G((q+1)*q,0.), X(q*q);
+      for (size_t i=0; i<kk; ++i) {
+         G[i*(q+1)+i] = 1.;
+         for (size_t l=0; l<j; ++l)
+            G[(kk+l)*(q+1)+i] = B[i][l];
+      }
+      for (size_t l=0; l<j; ++l)
+         for (size_t i=0; i<=j; ++i)
+            G[(kk+l)*(q+1)+kk+i] = H[i][l];
+      for (size_t a=0; a<q; ++a)
+         for (size_t c=0; c<q; ++c) {
+            double t = 0.;
+            for (size_t i=0; i<=q; ++i)
+               t += G[a*(q+1)+i]*G[c*(q+1)+i];
+            X[c*q+a] = t;
+         }
+//    The recycled space is kept unchanged if the problem can't be solved
+      denseEigen es;
+      es.setVerbose(0);
+      if (HarmonicRitz(q,G,X) || es.general(q,X.data(),k)) {
+         if (_res<_toler)
+            break;
+         continue;
+      }
+      const vector<double> &Pk = es.getVectors();
+      size_t p = Pk.size()/q;
+
+//    QR factorization of G Pk = Q T; C = [C V] Q and U = [U Z] Pk T^{-1}
+      size_t np = p;
+      vector<double> Q((q+1)*p,0.), T(p*p,0.);
+      for (size_t c=0; c<p; ++c) {
+         for (size_t i=0; i<=q; ++i)
+            for (size_t a=0; a<q; ++a)
+               Q[c*(q+1)+i] += G[a*(q+1)+i]*Pk[c*q+a];
+         for (size_t a=0; a<c; ++a) {
+            double t = 0.;
+            for (size_t i=0; i<=q; ++i)
+               t += Q[a*(q+1)+i]*Q[c*(q+1)+i];
+            T[c*p+a] = t;
+            for (size_t i=0; i<=q; ++i)
+               Q[c*(q+1)+i] -= t*Q[a*(q+1)+i];
+         }
+         double t = 0.;
+         for (size_t i=0; i<=q; ++i)
+            t += Q[c*(q+1)+i]*Q[c*(q+1)+i];
+         if (t<=1.e-24) {
+            np = c;
+            break;
+         }
+         T[c*p+c] = t = sqrt(t);
+         for (size_t i=0; i<=q; ++i)
+            Q[c*(q+1)+i] /= t;
+      }
+//    [U Z] Pk and [C V] Q are computed by chunks of rows and groups of four
+//    new vectors, each vector of [U Z] and [C V] being read once per group
+      vector<vector<double> > U1(np,vector<double>(n)), C1(np,vector<double>(n));
+      parallelFor(n,[&](size_t e0, size_t e1) {
+         double su[4][256], sv[4][256];
+         for (size_t i0=e0; i0<e1; i0+=256) {
+            size_t nr = std::min(e1-i0,size_t(256));
+            for (size_t c0=0; c0<np; c0+=4) {
+               size_t nc = std::min(np-c0,size_t(4));
+               for (size_t c=0; c<4; ++c) {
+                  std::fill(su[c],su[c]+nr,0.);
+                  std::fill(sv[c],sv[c]+nr,0.);
+               }
+               for (size_t a=0; a<=q; ++a) {
+                  double f[4], g[4];
+                  for (size_t c=0; c<4; ++c) {
+                     f[c] = (c<nc && a<q) ? Pk[(c0+c)*q+a] : 0.;
+                     g[c] = (c<nc) ? Q[(c0+c)*(q+1)+a] : 0.;
+                  }
+                  const double *va = (a<kk ? C[a].data() : V[a-kk].data()) + i0;
+                  for (size_t i=0; i<nr; ++i) {
+                     double t = va[i];
+                     sv[0][i] += g[0]*t, sv[1][i] += g[1]*t, sv[2][i] += g[2]*t, sv[3][i] += g[3]*t;
+                  }
+                  if (a==q)
+                     break;
+                  const double *ua = (a<kk ? U[a].data() : Z[a-kk].data()) + i0;
+                  for (size_t i=0; i<nr; ++i) {
+                     double t = ua[i];
+                     su[0][i] += f[0]*t, su[1][i] += f[1]*t, su[2][i] += f[2]*t, su[3][i] += f[3]*t;
+                  }
+               }
+               for (size_t c=0; c<nc; ++c) {
+                  std::copy(su[c],su[c]+nr,&U1[c0+c][i0]);
+                  std::copy(sv[c],sv[c]+nr,&C1[c0+c][i0]);
+               }
+            }
+            size_t i1 = i0 + nr;
+            for (size_t c=0; c<np; ++c) {
+               double *u = U1[c].data();
+               for (size_t a=0; a<c; ++a) {
+                  const double *ua = U1[a].data();
+                  double f = T[c*p+a];
+                  for (size_t i=i0; i<i1; ++i)
+                     u[i] -= f*ua[i];
+               }
+               double f = 1./T[c*p+c];
+               for (size_t i=i0; i<i1; ++i)
+                  u[i] *= f;
+            }
+         }
+      });
+      U.swap(U1);
+      C.swap(C1);
+      if (_res<_toler)
+         break;
+   }
+   if (_res>=_toler)
+      return -_max_it;
+   return it;
+}
+
+} /* namespace RITA */
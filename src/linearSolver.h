@@ -0,0 +1,359 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Definition of class 'linearSolver'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+using std::vector;
+using std::string;
+
+#include "OFELI_Config.h"
+#include "linear_algebra/Vect.h"
+#include "linear_algebra/Matrix.h"
+#include "parallel.h"
+
+namespace RITA {
+
+class matrixFree;
+
+/*
+ * Preconditioners implemented in rita. They complement the ones of
+ * OFELI::Preconditioner and are selected by the same 'ls' command.
+ */
+enum ExtPreconditioner {
+   NO_EXT_PREC = 0,
+   AMG_PREC    = 1,
+   GMG_PREC    = 2,
+   CHEBYSHEV_PREC = 3,
+   SCHUR_MASS_PREC = 4,
+   SCHUR_PCD_PREC = 5,
+   CHOLESKY_PREC = 6,
+   LDLT_PREC = 7,
+   ASM_PREC = 8
+};
+
+
+/*
+ * Sparse matrix in compressed row storage (0-based indices). Column indices
+ * are stored on 32 bits to save memory bandwidth in matrix-vector products,
+ * which are computed by blocks of rows in parallel
+ */
+template<class T_>
+struct spmat
+{
+   size_t nb_rows, nb_cols;
+   vector<size_t> row_ptr;
+   vector<unsigned> col_ind;
+   vector<T_> a;
+
+   spmat() : nb_rows(0), nb_cols(0) { }
+   size_t size() const { return nb_rows; }
+   size_t nnz() const { return a.size(); }
+   void clear() { nb_rows = nb_cols = 0; row_ptr.clear(); col_ind.clear(); a.clear(); }
+
+   T_ diag(size_t i) const
+   {
+      for (size_t k=row_ptr[i]; k<row_ptr[i+1]; ++k)
+         if (col_ind[k]==i)
+            return a[k];
+      return T_(0);
+   }
+
+   void mult(const T_* x, T_* y) const
+   {
+      parallelFor(nb_rows,[&](size_t b, size_t e) {
+         for (size_t i=b; i<e; ++i) {
+            T_ s = 0;
+            for (size_t k=row_ptr[i]; k<row_ptr[i+1]; ++k)
+               s += a[k]*x[col_ind[k]];
+            y[i] = s;
+         }
+      },1024);
+   }
+
+   /*
+    * Y = A X for nv vectors stored by rows (x_v(j) = X[j*nv+v]): each row of A
+    * is read once for all of them. Groups of up to 8 vectors are handled by
+    * kernels of fixed width whose sums stay in registers.
+    */
+   void mult(size_t nv, const T_* X, T_* Y) const
+   {
+      parallelFor(nb_rows,[&](size_t b, size_t e) {
+         for (size_t v0=0; v0<nv; v0+=8) {
+            switch (std::min(nv-v0,size_t(8))) {
+               case 1: multRows<1>(nv,v0,b,e,X,Y); break;
+               case 2: multRows<2>(nv,v0,b,e,X,Y); break;
+               case 3: multRows<3>(nv,v0,b,e,X,Y); break;
+               case 4: multRows<4>(nv,v0,b,e,X,Y); break;
+               case 5: multRows<5>(nv,v0,b,e,X,Y); break;
+               case 6: multRows<6>(nv,v0,b,e,X,Y); break;
+               case 7: multRows<7>(nv,v0,b,e,X,Y); break;
+               default: multRows<8>(nv,v0,b,e,X,Y); break;
+            }
+         }
+      },1024);
+   }
+
+   template<size_t W_>
+   void multRows(size_t nv, size_t v0, size_t b, size_t e, const T_* X, T_* Y) const
+   {
+      for (size_t i=b; i<e; ++i) {
+         T_ s[W_];
+         for (size_t v=0; v<W_; ++v)
+            s[v] = T_(0);
+         for (size_t k=row_ptr[i]; k<row_ptr[i+1]; ++k) {
+            T_ ak = a[k];
+            const T_ *x = X + col_ind[k]*nv + v0;
+            for (size_t v=0; v<W_; ++v)
+               s[v] += ak*x[v];
+         }
+         for (size_t v=0; v<W_; ++v)
+            Y[i*nv+v0+v] = s[v];
+      }
+   }
+
+   bool samePattern(const spmat<T_>& B) const
+   {
+      return (nb_rows==B.nb_rows && nb_cols==B.nb_cols &&
+              row_ptr==B.row_ptr && col_ind==B.col_ind);
+   }
+};
+
+template<class T_> void Transpose(const spmat<T_>& A, spmat<T_>& At);
+template<class T_> void Multiply(const spmat<T_>& A, const spmat<T_>& B, spmat<T_>& C);
+
+/*
+ * B = A(i0:i1-1,j0:j1-1)
+ */
+template<class T_> void SubMatrix(const spmat<T_>& A, size_t i0, size_t i1, size_t j0, size_t j1,
+                                  spmat<T_>& B);
+
+/*
+ * Estimate of the spectral radius of D^{-1}A (power iterations)
+ */
+template<class T_> double SpectralRadius(const spmat<T_>& A, int nb_it=15);
+
+
+/*
+ * Dense LU factorization with partial pivoting, used for the coarsest level
+ * of multigrid preconditioners. Zero pivots (singular operator) are skipped.
+ */
+template<class T_>
+class denseLU
+{
+
+ public:
+
+    denseLU() { }
+    void factor(const spmat<T_>& A);
+    void solve(vector<T_>& x, const vector<T_>& b) const;
+
+ private:
+
+    vector<T_> _lu;
+    vector<size_t> _piv;
+};
+
+
+/*
+ * Abstract preconditioner: setup() is called once per matrix, solve()
+ * returns z = M^{-1} r at each iteration
+ */
+template<class T_>
+class precond
+{
+
+ public:
+
+    precond() { }
+    virtual ~precond() { }
+    virtual int setup(const spmat<T_>& A) = 0;
+    virtual void solve(const vector<T_>& r, vector<T_>& z) const = 0;
+    virtual void print(std::ostream& s) const { }
+};
+
+
+/*
+ * Preconditioners ident and diag of OFELI, for the rita solvers
+ */
+template<class T_>
+class identPrec : public precond<T_>
+{
+
+ public:
+
+    int setup(const spmat<T_>& A) { return 0; }
+    void solve(const vector<T_>& r, vector<T_>& z) const { z = r; }
+};
+
+
+template<class T_>
+class diagPrec : public precond<T_>
+{
+
+ public:
+
+    int setup(const spmat<T_>& A)
+    {
+       _d.resize(A.size());
+       for (size_t i=0; i<A.size(); ++i) {
+          T_ d = A.diag(i);
+          _d[i] = (d!=T_(0)) ? T_(1)/d : T_(1);
+       }
+       return 0;
+    }
+
+    void solve(const vector<T_>& r, vector<T_>& z) const
+    {
+       z.resize(r.size());
+       parallelFor(r.size(),[&](size_t b, size_t e) {
+          for (size_t i=b; i<e; ++i)
+             z[i] = _d[i]*r[i];
+       });
+    }
+
+ private:
+    vector<T_> _d;
+};
+
+
+/*
+ * Driver for the iterative solvers that run inside rita rather than in OFELI.
+ * The matrix is copied from the assembled OFELI matrix. The preconditioner is
+ * kept with it and is only rebuilt when the matrix changes: the caller tells
+ * setMatrix() whether it did, so repeated solves (e.g. time steps with a
+ * constant matrix) neither copy the matrix nor rebuild the preconditioner.
+ * Geometric multigrid needs the structured grid the unknowns live on: see
+ * setGrid().
+ * In mixed precision mode, the matrix and the preconditioner are stored in
+ * single precision and the Krylov iterations run in float; they are used as
+ * inner solver of an iterative refinement whose residuals are computed in
+ * double precision, so that the final accuracy is the one of double.
+ * A matrix-free operator can be given instead of a matrix (see matrixFree);
+ * only the ident, diag and chebyshev preconditioners apply then.
+ * Saddle point systems (velocity unknowns first, then pressure) are
+ * preconditioned by schurPrec with the pressure matrices given by setSchur().
+ * The ilu, dilu and ssor preconditioners use level scheduled triangular
+ * solves (see ilu), optionally after a multicolor renumbering.
+ * The direct solver uses the sparse factorizations cholesky and ldlt (see
+ * cholesky) followed by a few steps of iterative refinement.
+ * The additive Schwarz preconditioner (see schwarz) uses the subdomains given
+ * by setSchwarz(); it is restricted with the nonsymmetric solvers and
+ * symmetric with cg.
+ * With recycling (setRecycle), gmres is replaced by GCRO-DR, which keeps a
+ * deflation space of harmonic Ritz vectors from a solve to the next one, e.g.
+ * over the time steps of a transient problem whose matrix changes slowly.
+ * Several right-hand sides sharing the matrix can be solved together. With
+ * cg, the iterations of all systems advance simultaneously so that each
+ * matrix-vector product streams the matrix once for all of them; the other
+ * solvers handle them one after the other with the same preconditioner (or
+ * factorization).
+ */
+class linearSolver
+{
+
+ public:
+
+    linearSolver();
+    ~linearSolver();
+    void setVerbose(int verb) { _verb = verb; }
+    void set(OFELI::Iteration ls, OFELI::Preconditioner prec, ExtPreconditioner xprec);
+    void setTolerance(double toler) { _toler = toler; }
+    void setMaxIter(int max_it) { _max_it = max_it; }
+    void setMixedPrecision(bool mixed);
+    void setMulticolor(bool mc);
+    void setRecycle(int k) { _recycle = k; }
+    void setGrid(int dim, const size_t* ne, const vector<size_t>& node);
+    void setSchwarz(const vector<int>& part, int overlap, bool direct, bool coarse);
+    int setMatrix(const OFELI::Matrix<double>& A, const vector<double>& d=vector<double>(), bool changed=true);
+    int setMatrix(const matrixFree& A);
+    int setMatrix(spmat<double>&& A);
+    void setSchur(size_t nu, const spmat<double>& M, const spmat<double>& K, const spmat<double>& Fp);
+    int solve(const OFELI::Vect<double>& b, OFELI::Vect<double>& x);
+    int solve(const vector<OFELI::Vect<double> >& b, vector<OFELI::Vect<double> >& x);
+    int getNbIter() const { return _nb_it; }
+    double getResidual() const { return _res; }
+    double getSetupTime() const { return _setup_time; }
+    double getSolveTime() const { return _solve_time; }
+    const spmat<double>& getMatrix() const { return _A; }
+    bool isSymmetric() const;
+
+ private:
+
+    OFELI::Iteration _ls;
+    OFELI::Preconditioner _prec;
+    ExtPreconditioner _xprec;
+    int _verb, _max_it, _nb_it, _nb_setup, _nb_outer;
+    double _toler, _res, _setup_time, _solve_time;
+    bool _pc_ok, _mixed, _multicolor;
+    spmat<double> _A;
+    spmat<float> _Af;
+    precond<double> *_pc;
+    precond<float> *_pcf;
+    const matrixFree *_mf;
+    int _grid_dim;
+    size_t _grid_ne[3];
+    vector<size_t> _grid_node;
+    vector<int> _asm_part;
+    int _asm_overlap;
+    bool _asm_direct, _asm_coarse;
+    size_t _schur_nu;
+    int _recycle;
+    vector<vector<double> > _U;
+    spmat<double> _schur_M, _schur_K, _schur_F;
+
+    int setPrec();
+    void deletePrec();
+    template<class T_>
+    precond<T_> *newPrec();
+    int setMatrixFreePrec();
+    template<class M_, class T_>
+    int iterate(const M_& A, const precond<T_>& P, const vector<T_>& b, vector<T_>& x);
+    int refine(const vector<double>& b, vector<double>& x);
+    template<class M_, class T_>
+    int Richardson(const M_& A, const precond<T_>& P, const vector<T_>& b, vector<T_>& x);
+    template<class M_, class T_>
+    int CG(const M_& A, const precond<T_>& P, const vector<T_>& b, vector<T_>& x);
+    int MultiCG(const vector<vector<double> >& b, vector<vector<double> >& x);
+    template<class M_, class T_>
+    int BiCGStab(const M_& A, const precond<T_>& P, const vector<T_>& b, vector<T_>& x);
+    template<class M_, class T_>
+    int GMRES(const M_& A, const precond<T_>& P, const vector<T_>& b, vector<T_>& x, int m=50);
+    template<class M_>
+    int GCRODR(const M_& A, const precond<double>& P, const vector<double>& b, vector<double>& x, int m=50);
+};
+
+/*
+ * Copy of an assembled OFELI matrix, with d added to its diagonal if given
+ */
+void Convert(const OFELI::Matrix<double>& A, spmat<double>& B, const vector<double>& d=vector<double>());
+
+} /* namespace RITA */
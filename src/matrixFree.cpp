@@ -0,0 +1,655 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                      Implementation of class 'matrixFree'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include <algorithm>
+#include "matrixFree.h"
+#include "parallel.h"
+#include "linearSolver.h"
+
+namespace RITA {
+
+// Edges of a triangle (first 3) or a tetrahedron: pairs of local nodes
+static const int Edge[6][2] = {{0,1},{0,2},{1,2},{0,3},{1,3},{2,3}};
+
+matrixFree::matrixFree()
+           : _dim(0), _nn(0), _nb_edges(0), _nb_nodes(0), _nb_el(0), _nb_eq(0), _structured(false)
+{
+}
+
+
+/*
+ * dim: space dimension, coord: node coordinates (dim per node),
+ * elem: element nodes (dim+1 per element, 0-based), free: equation number of
+ * each node (-1 for a fixed node), coef: coefficient c in each element
+ */
+int matrixFree::set(int                     dim,
+                    const vector<double>&   coord,
+                    const vector<unsigned>& elem,
+                    const vector<long>&     free,
+                    const vector<double>&   coef)
+{
+   if (dim<2 || dim>3)
+      return 1;
+   _dim = dim, _nn = dim + 1;
+   _structured = false;
+   _nb_nodes = free.size();
+   _nb_el = elem.size()/_nn;
+   _coord = coord;
+   _elem = elem;
+   _free = free;
+   _nb_eq = 0;
+   for (auto const& f: _free)
+      if (f>=0)
+         _nb_eq++;
+   _shift.clear();
+   _row_ptr.clear(), _col_ind.clear();
+
+// Element matrices: off-diagonal entries c (c_i.c_k)/(d!|det J|), the rows
+// summing to zero
+   _nb_edges = _nn*(_nn-1)/2;
+   _a.resize(_nb_edges*_nb_el);
+   double c[4][3];
+   for (size_t e=0; e<_nb_el; ++e) {
+      double det = fabs(cofactors(e,c));
+      if (det==0.)
+         return 1;
+      double w = coef[e]/((dim==2 ? 2. : 6.)*det);
+      for (int l=0; l<_nb_edges; ++l) {
+         const double *ci=c[Edge[l][0]], *ck=c[Edge[l][1]];
+         _a[_nb_edges*e+l] = w*(ci[0]*ck[0] + ci[1]*ck[1] + (dim==3 ? ci[2]*ck[2] : 0.));
+      }
+   }
+   setColors();
+   return 0;
+}
+
+
+/*
+ * Operator on the structured mesh g with the coefficient coef, either a single
+ * value or one value per cell, cells being numbered lexicographically (x
+ * first). The unknowns are the free nodes of g, numbered by
+ * structuredMesh::getEq
+ */
+int matrixFree::set(const structuredMesh& g,
+                    const vector<double>& coef)
+{
+   if (g.getDim()<2 || g.getDim()>3)
+      return 1;
+   size_t nc = g.getNbElements(0)*g.getNbElements(1)*(g.getDim()==3 ? g.getNbElements(2) : 1);
+   if (coef.size()!=1 && coef.size()!=nc)
+      return 1;
+   _structured = true;
+   _grid = g;
+   _coef = coef;
+   _dim = g.getDim(), _nn = (_dim==2) ? 3 : 8;
+   _nb_nodes = g.getNbNodes();
+   _nb_el = g.getNbElements();
+   _nb_eq = g.getNbEq();
+   _shift.clear();
+   _coord.clear(), _a.clear(), _elem.clear(), _free.clear();
+   _row_ptr.clear(), _col_ind.clear();
+   _color.assign(1,0);
+   return 0;
+}
+
+
+/*
+ * Row of node n of the structured operator: the element matrices are sums of
+ * tensor products of 1-D stiffness S and mass M matrices,
+ *   2-D: Sx*My + Mx*Sy with lumped M (P1 triangles, either diagonal),
+ *   3-D: Sx*My*Mz + Mx*Sy*Mz + Mx*My*Sz (Q1 hexahedra).
+ * With a constant coefficient so is the assembled matrix, with the 1-D
+ * matrices assembled on each axis. Otherwise the rows of the 1-D element
+ * matrices are combined for each cell around the node (left or right of it
+ * along each axis) and weighted by the coefficient of the cell. Columns
+ * (nodes, including fixed ones) are returned in increasing order with the
+ * coefficients, and their number.
+ */
+int matrixFree::stencil(size_t  n,
+                        size_t* col,
+                        double* a) const
+{
+   size_t i[3], j[3], ic[3], ne[3] = {1,1,1};
+   double s[3][3], m[3][3], v[27];
+   _grid.getIndex(n,i);
+   for (int d=0; d<_dim; ++d)
+      ne[d] = _grid.getNbElements(d);
+   for (int q=0; q<27; ++q)
+      v[q] = 0.;
+   int nc = (_coef.size()==1) ? 1 : 1<<_dim;
+   for (int cell=0; cell<nc; ++cell) {
+      bool in = true;
+      for (int d=0; d<3; ++d) {
+         s[d][0] = s[d][1] = s[d][2] = 0.;
+         m[d][0] = m[d][2] = 0., m[d][1] = 1.;
+         ic[d] = 0;
+         if (d>=_dim)
+            continue;
+         double h = _grid.getSize(d);
+         bool l=(i[d]>0), r=(i[d]<ne[d]);
+         if (nc>1) {
+            int side = (cell>>d)&1;
+            l = l && !side, r = r && side;
+            in = in && (l || r);
+            ic[d] = i[d] - l;
+         }
+         s[d][0] = l ? -1./h : 0.;
+         s[d][2] = r ? -1./h : 0.;
+         s[d][1] = (l+r)/h;
+         if (_dim==2)
+            m[d][1] = 0.5*(l+r)*h;
+         else {
+            m[d][0] = l ? h/6. : 0.;
+            m[d][2] = r ? h/6. : 0.;
+            m[d][1] = (l+r)*h/3.;
+         }
+      }
+      if (!in)
+         continue;
+      double c = _coef[nc>1 ? ic[0]+ne[0]*(ic[1]+ne[1]*ic[2]) : 0];
+      for (int z=0; z<3; ++z)
+         for (int y=0; y<3; ++y)
+            for (int x=0; x<3; ++x)
+               v[9*z+3*y+x] += c*(s[0][x]*m[1][y]*m[2][z] + m[0][x]*s[1][y]*m[2][z] +
+                                  m[0][x]*m[1][y]*s[2][z]);
+   }
+   int k = 0;
+   for (int q=0; q<27; ++q) {
+      if (v[q]==0.)
+         continue;
+      j[0] = i[0] + q%3 - 1, j[1] = i[1] + (q/3)%3 - 1, j[2] = i[2] + q/9 - 1;
+      col[k] = _grid.getNode(j);
+      a[k++] = v[q];
+   }
+   return k;
+}
+
+
+/*
+ * Lumped mass (measure of the dual cell) of node n of the structured mesh
+ */
+double matrixFree::weight(size_t n) const
+{
+   size_t i[3];
+   double w = 1.;
+   _grid.getIndex(n,i);
+   for (int d=0; d<_dim; ++d)
+      w *= 0.5*((i[d]>0) + (i[d]<_grid.getNbElements(d)))*_grid.getSize(d);
+   return w;
+}
+
+
+/*
+ * Greedy colouring: each sweep over the elements not yet coloured forms a
+ * colour with those whose nodes are not used by the current colour. Elements
+ * and their matrices are then reordered by colour.
+ */
+void matrixFree::setColors()
+{
+   vector<int> ec(_nb_el,-1);
+   vector<size_t> mark(_nb_nodes,0);
+   size_t nb_done = 0, c = 0;
+   while (nb_done<_nb_el) {
+      c++;
+      for (size_t e=0; e<_nb_el; ++e) {
+         if (ec[e]>=0)
+            continue;
+         bool ok = true;
+         for (int i=0; i<_nn && ok; ++i)
+            if (mark[_elem[_nn*e+i]]==c)
+               ok = false;
+         if (!ok)
+            continue;
+         for (int i=0; i<_nn; ++i)
+            mark[_elem[_nn*e+i]] = c;
+         ec[e] = int(c-1);
+         nb_done++;
+      }
+   }
+   _color.assign(c+1,0);
+   for (size_t e=0; e<_nb_el; ++e)
+      _color[ec[e]+1]++;
+   for (size_t k=0; k<c; ++k)
+      _color[k+1] += _color[k];
+   vector<size_t> pos(_color.begin(),_color.end()-1);
+   vector<unsigned> el(_elem.size());
+   vector<double> a(_a.size());
+   for (size_t e=0; e<_nb_el; ++e) {
+      size_t f = pos[ec[e]]++;
+      for (int i=0; i<_nn; ++i)
+         el[_nn*f+i] = _elem[_nn*e+i];
+      for (int l=0; l<_nb_edges; ++l)
+         a[_nb_edges*f+l] = _a[_nb_edges*e+l];
+   }
+   _elem.swap(el);
+   _a.swap(a);
+}
+
+
+/*
+ * Values at the nodes of element e of x given by equations (0 at fixed nodes)
+ */
+inline void matrixFree::gather(size_t        e,
+                               const double* x,
+                               long*         f,
+                               double*       v) const
+{
+   for (int i=0; i<_nn; ++i) {
+      f[i] = _free[_elem[_nn*e+i]];
+      v[i] = (f[i]>=0) ? x[f[i]] : 0.;
+   }
+}
+
+
+/*
+ * Cofactor vectors c_i of element e: grad(phi_i) = c_i/det(J). Returns det(J)
+ */
+double matrixFree::cofactors(size_t e,
+                             double c[][3]) const
+{
+   const unsigned *n = &_elem[_nn*e];
+   if (_dim==2) {
+      const double *p0=&_coord[2*n[0]], *p1=&_coord[2*n[1]], *p2=&_coord[2*n[2]];
+      c[0][0] = p1[1] - p2[1], c[0][1] = p2[0] - p1[0];
+      c[1][0] = p2[1] - p0[1], c[1][1] = p0[0] - p2[0];
+      c[2][0] = p0[1] - p1[1], c[2][1] = p1[0] - p0[0];
+      return (p1[0]-p0[0])*(p2[1]-p0[1]) - (p2[0]-p0[0])*(p1[1]-p0[1]);
+   }
+   const double *p0 = &_coord[3*n[0]];
+   double a[3][3];
+   for (int k=0; k<3; ++k)
+      for (int j=0; j<3; ++j)
+         a[k][j] = _coord[3*n[k+1]+j] - p0[j];
+   for (int k=0; k<3; ++k) {
+      const double *u=a[(k+1)%3], *v=a[(k+2)%3];
+      c[k+1][0] = u[1]*v[2] - u[2]*v[1];
+      c[k+1][1] = u[2]*v[0] - u[0]*v[2];
+      c[k+1][2] = u[0]*v[1] - u[1]*v[0];
+   }
+   for (int j=0; j<3; ++j)
+      c[0][j] = -c[1][j] - c[2][j] - c[3][j];
+   return a[0][0]*c[1][0] + a[0][1]*c[1][1] + a[0][2]*c[1][2];
+}
+
+
+void matrixFree::mult(const double* x,
+                      double*       y) const
+{
+   if (_structured) {
+      parallelFor(_nb_eq,[&](size_t b, size_t e) {
+         size_t col[27];
+         double a[27];
+         for (size_t i=b; i<e; ++i) {
+            int nb = stencil(_grid.getNodeOfEq(i),col,a);
+            double s = _shift.size() ? _shift[i]*x[i] : 0.;
+            for (int k=0; k<nb; ++k) {
+               long f = _grid.getEq(col[k]);
+               if (f>=0)
+                  s += a[k]*x[f];
+            }
+            y[i] = s;
+         }
+      },512);
+      return;
+   }
+   parallelFor(_nb_eq,[&](size_t b, size_t e) {
+      for (size_t i=b; i<e; ++i)
+         y[i] = _shift.size() ? _shift[i]*x[i] : 0.;
+   });
+   for (size_t k=0; k+1<_color.size(); ++k) {
+      parallelFor(_color[k+1]-_color[k],[&](size_t b, size_t e) {
+         double v[4], r[4];
+         long f[4];
+         for (size_t el=_color[k]+b; el<_color[k]+e; ++el) {
+            gather(el,x,f,v);
+            const double *a = &_a[_nb_edges*el];
+            r[0] = r[1] = r[2] = r[3] = 0.;
+            for (int l=0; l<_nb_edges; ++l) {
+               int i=Edge[l][0], j=Edge[l][1];
+               double t = a[l]*(v[j]-v[i]);
+               r[i] += t, r[j] -= t;
+            }
+            for (int i=0; i<_nn; ++i)
+               if (f[i]>=0)
+                  y[f[i]] += r[i];
+         }
+      },512);
+   }
+}
+
+
+void matrixFree::getDiag(vector<double>& d) const
+{
+   d.assign(_nb_eq,0.);
+   for (size_t i=0; i<_shift.size(); ++i)
+      d[i] = _shift[i];
+   if (_structured) {
+      size_t col[27];
+      double a[27];
+      for (size_t i=0; i<_nb_eq; ++i) {
+         size_t n = _grid.getNodeOfEq(i);
+         int nb = stencil(n,col,a);
+         for (int k=0; k<nb; ++k)
+            if (col[k]==n)
+               d[i] += a[k];
+      }
+      return;
+   }
+   for (size_t e=0; e<_nb_el; ++e) {
+      for (int l=0; l<_nb_edges; ++l) {
+         for (int m=0; m<2; ++m) {
+            long f = _free[_elem[_nn*e+Edge[l][m]]];
+            if (f>=0)
+               d[f] -= _a[_nb_edges*e+l];
+         }
+      }
+   }
+}
+
+
+/*
+ * Gershgorin bound of the spectrum of D^{-1}A, using the sums of absolute
+ * values of element matrix rows
+ */
+double matrixFree::getBound() const
+{
+   double lmax = 0.;
+   vector<double> d, s(_nb_eq,0.);
+   getDiag(d);
+   for (size_t i=0; i<_shift.size(); ++i)
+      s[i] = fabs(_shift[i]);
+   for (size_t i=0; i<_nb_eq && _structured; ++i) {
+      size_t col[27];
+      double a[27];
+      int nb = stencil(_grid.getNodeOfEq(i),col,a);
+      for (int k=0; k<nb; ++k)
+         if (_grid.getEq(col[k])>=0)
+            s[i] += fabs(a[k]);
+   }
+   for (size_t e=0; e<_nb_el && !_structured; ++e) {
+      const double *a = &_a[_nb_edges*e];
+      double r[4] = {0.,0.,0.,0.};
+      for (int l=0; l<_nb_edges; ++l)
+         r[Edge[l][0]] -= a[l], r[Edge[l][1]] -= a[l];
+      for (int l=0; l<_nb_edges; ++l) {
+         long f=_free[_elem[_nn*e+Edge[l][0]]], g=_free[_elem[_nn*e+Edge[l][1]]];
+         if (f>=0 && g>=0)
+            s[f] += fabs(a[l]), s[g] += fabs(a[l]);
+      }
+      for (int i=0; i<_nn; ++i) {
+         long f = _free[_elem[_nn*e+i]];
+         if (f>=0)
+            s[f] += fabs(r[i]);
+      }
+   }
+   for (size_t i=0; i<_nb_eq; ++i)
+      if (d[i]!=0.)
+         lmax = std::max(lmax,s[i]/d[i]);
+   return lmax;
+}
+
+
+/*
+ * b -= A u for the values u of fixed nodes (u is given at all nodes)
+ */
+void matrixFree::lift(const vector<double>& u,
+                      double*               b) const
+{
+   if (_structured) {
+      parallelFor(_nb_eq,[&](size_t b0, size_t e0) {
+         size_t col[27];
+         double a[27];
+         for (size_t i=b0; i<e0; ++i) {
+            int nb = stencil(_grid.getNodeOfEq(i),col,a);
+            for (int k=0; k<nb; ++k)
+               if (_grid.getEq(col[k])<0)
+                  b[i] -= a[k]*u[col[k]];
+         }
+      },512);
+      return;
+   }
+   for (size_t k=0; k+1<_color.size(); ++k) {
+      parallelFor(_color[k+1]-_color[k],[&](size_t b0, size_t e0) {
+         for (size_t e=_color[k]+b0; e<_color[k]+e0; ++e) {
+            const unsigned *n = &_elem[_nn*e];
+            const double *a = &_a[_nb_edges*e];
+            for (int l=0; l<_nb_edges; ++l) {
+               unsigned i=n[Edge[l][0]], j=n[Edge[l][1]];
+               long fi=_free[i], fj=_free[j];
+               if (fi>=0 && fj<0)
+                  b[fi] -= a[l]*u[j];
+               else if (fi<0 && fj>=0)
+                  b[fj] -= a[l]*u[i];
+            }
+         }
+      },512);
+   }
+}
+
+
+/*
+ * b += consistent P1 load of f (given at nodes):
+ * int_T f phi_i = |T|/((d+1)(d+2)) (f_i + sum_j f_j)
+ * or lumped load f_i |dual cell of i| on a structured mesh
+ */
+void matrixFree::load(const vector<double>& f,
+                      double*               b) const
+{
+   if (_structured) {
+      parallelFor(_nb_eq,[&](size_t b0, size_t e0) {
+         for (size_t i=b0; i<e0; ++i) {
+            size_t n = _grid.getNodeOfEq(i);
+            b[i] += f[n]*weight(n);
+         }
+      },512);
+      return;
+   }
+   double fact = (_dim==2) ? 1./24. : 1./120.;
+   for (size_t k=0; k+1<_color.size(); ++k) {
+      parallelFor(_color[k+1]-_color[k],[&](size_t b0, size_t e0) {
+         double c[4][3];
+         for (size_t e=_color[k]+b0; e<_color[k]+e0; ++e) {
+            const unsigned *n = &_elem[_nn*e];
+            double s = 0., det = fabs(cofactors(e,c));
+            for (int i=0; i<_nn; ++i)
+               s += f[n[i]];
+            for (int i=0; i<_nn; ++i)
+               if (_free[n[i]]>=0)
+                  b[_free[n[i]]] += fact*det*(f[n[i]]+s);
+         }
+      },512);
+   }
+}
+
+
+/*
+ * Lumped mass matrix with coefficient coef given in each element (a single
+ * value on a structured mesh)
+ */
+void matrixFree::lumpedMass(const vector<double>& coef,
+                            vector<double>&       m) const
+{
+   double c[4][3], fact = (_dim==2) ? 1./6. : 1./24.;
+   m.assign(_nb_eq,0.);
+   if (_structured) {
+      for (size_t i=0; i<_nb_eq; ++i)
+         m[i] = coef[0]*weight(_grid.getNodeOfEq(i));
+      return;
+   }
+   for (size_t e=0; e<_nb_el; ++e) {
+      double det = fabs(cofactors(e,c));
+      for (int i=0; i<_nn; ++i) {
+         long f = _free[_elem[_nn*e+i]];
+         if (f>=0)
+            m[f] += fact*coef[e]*det;
+      }
+   }
+}
+
+
+/*
+ * CSR pattern of the couplings between free nodes, kept for the next
+ * assemblies
+ */
+void matrixFree::setPattern()
+{
+   vector<vector<unsigned> > row(_nb_eq);
+   for (size_t e=0; e<_nb_el; ++e) {
+      for (int i=0; i<_nn; ++i) {
+         long f = _free[_elem[_nn*e+i]];
+         if (f<0)
+            continue;
+         for (int k=0; k<_nn; ++k) {
+            long g = _free[_elem[_nn*e+k]];
+            if (g>=0)
+               row[f].push_back(unsigned(g));
+         }
+      }
+   }
+   _row_ptr.assign(_nb_eq+1,0);
+   _col_ind.clear();
+   for (size_t i=0; i<_nb_eq; ++i) {
+      std::sort(row[i].begin(),row[i].end());
+      row[i].erase(std::unique(row[i].begin(),row[i].end()),row[i].end());
+      _col_ind.insert(_col_ind.end(),row[i].begin(),row[i].end());
+      _row_ptr[i+1] = _col_ind.size();
+      vector<unsigned>().swap(row[i]);
+   }
+}
+
+
+/*
+ * Position of the entry (i,j) in the pattern
+ */
+inline size_t matrixFree::position(long i,
+                                   long j) const
+{
+   const unsigned *c0=&_col_ind[0]+_row_ptr[i], *c1=&_col_ind[0]+_row_ptr[i+1];
+   return std::lower_bound(c0,c1,unsigned(j)) - &_col_ind[0];
+}
+
+
+/*
+ * Assembly of the operator (including the shift) in A. Elements of a colour
+ * have no common node and then update distinct matrix rows: the colours are
+ * assembled one after the other, each one by all threads. Positions of the
+ * entries are searched in the (short) rows of the pattern.
+ */
+void matrixFree::assemble(spmat<double>& A)
+{
+   if (_structured) {
+      assembleGrid(A);
+      return;
+   }
+   if (_row_ptr.size()==0)
+      setPattern();
+   A.nb_rows = A.nb_cols = _nb_eq;
+   A.row_ptr = _row_ptr;
+   A.col_ind = _col_ind;
+   A.a.assign(_col_ind.size(),0.);
+   for (size_t i=0; i<_shift.size(); ++i)
+      A.a[position(i,i)] += _shift[i];
+   for (size_t k=0; k+1<_color.size(); ++k) {
+      parallelFor(_color[k+1]-_color[k],[&](size_t b, size_t e) {
+         long f[4];
+         size_t d[4];
+         for (size_t el=_color[k]+b; el<_color[k]+e; ++el) {
+            for (int i=0; i<_nn; ++i) {
+               f[i] = _free[_elem[_nn*el+i]];
+               if (f[i]>=0)
+                  d[i] = position(f[i],f[i]);
+            }
+            const double *a = &_a[_nb_edges*el];
+            for (int l=0; l<_nb_edges; ++l) {
+               int i=Edge[l][0], j=Edge[l][1];
+               if (f[i]>=0)
+                  A.a[d[i]] -= a[l];
+               if (f[j]>=0)
+                  A.a[d[j]] -= a[l];
+               if (f[i]>=0 && f[j]>=0)
+                  A.a[position(f[i],f[j])] += a[l], A.a[position(f[j],f[i])] += a[l];
+            }
+         }
+      },512);
+   }
+}
+
+
+/*
+ * Assembly on a structured mesh: row lengths are counted, then rows are
+ * filled concurrently. Stencil columns are increasing and so are the
+ * equation numbers of the free nodes.
+ */
+void matrixFree::assembleGrid(spmat<double>& A) const
+{
+   A.nb_rows = A.nb_cols = _nb_eq;
+   A.row_ptr.assign(_nb_eq+1,0);
+   parallelFor(_nb_eq,[&](size_t b, size_t e) {
+      size_t col[27];
+      double a[27];
+      for (size_t i=b; i<e; ++i) {
+         int nb = stencil(_grid.getNodeOfEq(i),col,a);
+         for (int k=0; k<nb; ++k)
+            if (_grid.getEq(col[k])>=0)
+               A.row_ptr[i+1]++;
+      }
+   },512);
+   for (size_t i=0; i<_nb_eq; ++i)
+      A.row_ptr[i+1] += A.row_ptr[i];
+   A.col_ind.resize(A.row_ptr[_nb_eq]);
+   A.a.resize(A.row_ptr[_nb_eq]);
+   parallelFor(_nb_eq,[&](size_t b, size_t e) {
+      size_t col[27];
+      double a[27];
+      for (size_t i=b; i<e; ++i) {
+         size_t n=_grid.getNodeOfEq(i), p=A.row_ptr[i];
+         int nb = stencil(n,col,a);
+         for (int k=0; k<nb; ++k) {
+            long f = _grid.getEq(col[k]);
+            if (f<0)
+               continue;
+            A.col_ind[p] = unsigned(f);
+            A.a[p++] = a[k] + ((col[k]==n && _shift.size()) ? _shift[i] : 0.);
+         }
+      }
+   },512);
+}
+
+
+size_t matrixFree::getMemory() const
+{
+   if (_structured)
+      return sizeof(_grid) + (_coef.size()+_shift.size())*sizeof(double);
+   return _coord.size()*sizeof(double) + _a.size()*sizeof(double) + _elem.size()*sizeof(unsigned)
+        + _free.size()*sizeof(long) + _shift.size()*sizeof(double) + _color.size()*sizeof(size_t)
+        + _row_ptr.size()*sizeof(size_t) + _col_ind.size()*sizeof(unsigned);
+}
+
+} /* namespace RITA */
@@ -0,0 +1,107 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                        Definition of class 'matrixFree'
+
+  ==============================================================================*/
+
+
+#pragma once
+
+#include <vector>
+#include "structuredMesh.h"
+using std::vector;
+
+namespace RITA {
+
+template<class T_> struct spmat;
+
+/*
+ * Matrix-free P1 finite element operator  -div(c grad u) + diag(s)  on a mesh
+ * of triangles (2-D) or tetrahedra (3-D).
+ * Node coordinates, element connectivity and the geometric factors of each
+ * element are stored: the off-diagonal entries c (c_i.c_k)/(d!|det J|) of its
+ * matrix (c_i cofactors of the Jacobian J), 3 in 2-D and 6 in 3-D, whose
+ * rows sum to zero. A product then costs a few operations per element edge.
+ * In 3-D this is more memory than a CSR matrix (about 6 tetrahedra per
+ * node), the gain being the assembly and the OFELI matrix avoided; in 2-D it
+ * is about the size of the CSR matrix. Elements are grouped by colours
+ * such that elements of a colour share no node, so that each colour is
+ * processed in parallel without conflicts.
+ * Unknowns are the free nodes (free[n]>=0), fixed nodes only contribute to
+ * the right-hand side through lift().
+ * The operator can also be assembled in a sparse matrix by assemble(), the
+ * elements of each colour being assembled concurrently. The sparsity pattern
+ * is then kept for the next assemblies (getMemory() counts it).
+ * On a structured mesh (see structuredMesh) only the grid and the coefficient
+ * c, constant or given in each cell, are stored: the operator is the tensor
+ * product stencil of P1 triangles (2-D, 5 points) or Q1 hexahedra (3-D, 27
+ * points), computed row by row from the grid indices of the node. Loads and
+ * masses are then lumped.
+ */
+class matrixFree
+{
+
+ public:
+
+    matrixFree();
+    ~matrixFree() { }
+    int set(int dim, const vector<double>& coord, const vector<unsigned>& elem,
+            const vector<long>& free, const vector<double>& coef);
+    int set(const structuredMesh& g, const vector<double>& coef);
+    void setShift(const vector<double>& s) { _shift = s; }
+    size_t size() const { return _nb_eq; }
+    void mult(const double* x, double* y) const;
+    void getDiag(vector<double>& d) const;
+    double getBound() const;
+    void lift(const vector<double>& u, double* b) const;
+    void load(const vector<double>& f, double* b) const;
+    void lumpedMass(const vector<double>& coef, vector<double>& m) const;
+    void assemble(spmat<double>& A);
+    size_t getMemory() const;
+    int getNbColors() const { return int(_color.size()) - 1; }
+
+ private:
+
+    int _dim, _nn, _nb_edges;
+    size_t _nb_nodes, _nb_el, _nb_eq;
+    bool _structured;
+    structuredMesh _grid;
+    vector<double> _coef, _coord, _a, _shift;
+    vector<unsigned> _elem;
+    vector<long> _free;
+    vector<size_t> _color, _row_ptr;
+    vector<unsigned> _col_ind;
+
+    double cofactors(size_t e, double c[][3]) const;
+    void gather(size_t e, const double* x, long* f, double* v) const;
+    void setColors();
+    void setPattern();
+    size_t position(long i, long j) const;
+    int stencil(size_t n, size_t* col, double* a) const;
+    double weight(size_t n) const;
+    void assembleGrid(spmat<double>& A) const;
+};
+
+} /* namespace RITA */
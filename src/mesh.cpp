@@ -27,11 +27,18 @@
   ==============================================================================*/
 
 #include <iostream>
+#include <sstream>
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
 #include "mesh.h"
 #include "mesh/saveMesh.h"
 #include "rita.h"
 #include "data.h"
+#include "renumber.h"
+#include "meshCache.h"
+#include "meshReader.h"
+#include "parallel.h"
 
 #ifdef USE_GMSH
 #include <gmsh.h>
@@ -58,14 +65,265 @@ mesh::MeshData_Ptr mesh::MESH_DATA [] = { nullptr,
                                           &mesh::Plot,
                                           &mesh::Clear,
                                           &mesh::Save,
-                                          &mesh::Read
+                                          &mesh::Read,
+                                          &mesh::Renumber,
+                                          &mesh::Partition
                                         };
 
+
+/*
+ * Copy of a mesh to the arrays of the mesh cache and back
+ */
+static void MeshCache(OFELI::Mesh& ms,
+                      meshCache&   c)
+{
+   size_t nn=ms.getNbNodes(), ne=ms.getNbElements(), ns=ms.getNbSides();
+   c.dim = ms.getDim();
+   c.nb_dof = (nn>0) ? ms[1]->getNbDOF() : 1;
+   c.coord.resize(3*nn);
+   c.node_code.resize(c.nb_dof*nn);
+   for (size_t n=1; n<=nn; ++n) {
+      OFELI::Point<double> x = ms[n]->getCoord();
+      c.coord[3*n-3] = x.x, c.coord[3*n-2] = x.y, c.coord[3*n-1] = x.z;
+      for (int k=1; k<=c.nb_dof; ++k)
+         c.node_code[c.nb_dof*(n-1)+k-1] = ms[n]->getCode(k);
+   }
+   c.el_ptr.assign(1,0), c.el_node.clear(), c.el_shape.clear(), c.el_code.clear();
+   for (size_t e=1; e<=ne; ++e) {
+      OFELI::Element *el = ms.getPtrElement(e);
+      for (size_t i=1; i<=el->getNbNodes(); ++i)
+         c.el_node.push_back(el->getPtrNode(i)->n()-1);
+      c.el_ptr.push_back(c.el_node.size());
+      c.el_shape.push_back(el->getShape());
+      c.el_code.push_back(el->getCode());
+   }
+   c.sd_ptr.assign(1,0), c.sd_node.clear(), c.sd_shape.clear(), c.sd_code.clear();
+   for (size_t s=1; s<=ns; ++s) {
+      OFELI::Side *sd = ms.getPtrSide(s);
+      for (size_t i=1; i<=sd->getNbNodes(); ++i)
+         c.sd_node.push_back(sd->getPtrNode(i)->n()-1);
+      c.sd_ptr.push_back(c.sd_node.size());
+      c.sd_shape.push_back(sd->getShape());
+      for (int k=1; k<=c.nb_dof; ++k)
+         c.sd_code.push_back(k<=int(sd->getNbDOF()) ? sd->getCode(k) : 0);
+   }
+}
+
+
+/*
+ * OFELI mesh built from the arrays of a mesh cache. The arrays are released
+ * as soon as nodes and elements are built, so that the arrays and the mesh
+ * are not held in memory together.
+ */
+static OFELI::Mesh *CacheMesh(meshCache& c)
+{
+   size_t nn=c.coord.size()/3, ne=c.el_shape.size(), ns=c.sd_shape.size();
+   OFELI::Mesh *ms = new OFELI::Mesh;
+   ms->setDim(c.dim);
+   vector<OFELI::Node *> nd(nn);
+   for (size_t n=0; n<nn; ++n) {
+      nd[n] = new OFELI::Node(n+1,OFELI::Point<double>(c.coord[3*n],c.coord[3*n+1],c.coord[3*n+2]));
+      nd[n]->setNbDOF(c.nb_dof);
+      for (int k=1; k<=c.nb_dof; ++k)
+         nd[n]->setCode(k,c.node_code[c.nb_dof*n+k-1]);
+      ms->Add(nd[n]);
+   }
+   vector<double>().swap(c.coord);
+   vector<int>().swap(c.node_code);
+   for (size_t e=0; e<ne; ++e) {
+      OFELI::Element *el = new OFELI::Element(e+1,c.el_shape[e],c.el_code[e]);
+      for (size_t i=c.el_ptr[e]; i<c.el_ptr[e+1]; ++i)
+         el->Add(nd[c.el_node[i]]);
+      ms->Add(el);
+   }
+   vector<size_t>().swap(c.el_ptr), vector<size_t>().swap(c.el_node);
+   vector<int>().swap(c.el_shape), vector<int>().swap(c.el_code);
+   for (size_t s=0; s<ns; ++s) {
+      OFELI::Side *sd = new OFELI::Side(s+1,c.sd_shape[s]);
+      for (size_t i=c.sd_ptr[s]; i<c.sd_ptr[s+1]; ++i)
+         sd->Add(nd[c.sd_node[i]]);
+      sd->setNbDOF(c.nb_dof);
+      for (int k=1; k<=c.nb_dof; ++k)
+         sd->setCode(k,c.sd_code[c.nb_dof*s+k-1]);
+      ms->Add(sd);
+   }
+   c = meshCache();
+   ms->NumberEquations();
+   return ms;
+}
+
+
+/*
+ * Mesh of an OFELI (.m) or gmsh (.msh) mesh file. The file is parsed by
+ * chunks by meshReader, which allocates the mesh arrays from the counts of
+ * the file; files it does not read (other gmsh versions) are read by OFELI.
+ * With bench, the OFELI reader is also timed on the same file.
+ */
+static OFELI::Mesh *ReadMesh(const string& file,
+                             int           nb_dof,
+                             int           verb,
+                             bool          bench)
+{
+   auto ofeli = [&file,nb_dof]() {
+      OFELI::Mesh *m = nullptr;
+      if (file.substr(file.find_last_of(".")+1)=="msh") {
+         m = new OFELI::Mesh;
+         m->get(file,GMSH,nb_dof);
+      }
+      else
+         m = new OFELI::Mesh(file);
+      return m;
+   };
+   meshReader rd;
+   meshCache c;
+   OFELI::Mesh *ms = nullptr;
+   if (rd.read(file,c,nb_dof)==0) {
+      auto t0 = std::chrono::steady_clock::now();
+      ms = CacheMesh(c);
+      double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+      if (verb>1 || bench)
+         cout << "Mesh file " << file << ": " << rd.getSize()/1048576. << " MB parsed in " << rd.getTime()
+              << " s (" << rd.getRate() << " MB/s), arrays: " << rd.getMemory()/1048576.
+              << " MB, mesh built in " << t << " s" << endl;
+   }
+   else {
+      if (verb>1)
+         cout << rd.getError() << " File read by OFELI." << endl;
+      ms = ofeli();
+   }
+   if (bench) {
+      auto t0 = std::chrono::steady_clock::now();
+      OFELI::Mesh *m = ofeli();
+      double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+      cout << "OFELI reader: " << m->getNbNodes() << " nodes, " << m->getNbElements() << " elements in "
+           << t << " s (" << rd.getSize()/1048576./t << " MB/s)" << endl;
+      delete m;
+   }
+   return ms;
+}
+
+#ifdef USE_GMSH
+/*
+ * OFELI mesh of the current gmsh model, copied through the gmsh API: nodes,
+ * elements of the model dimension and sides (elements of dimension dim-1 on
+ * physical entities). Elements and sides take the tag of the physical group
+ * of their entity. Nodes take the tags of physical points or, if they have
+ * none, of the physical curves (2-D) or surfaces (3-D) they lie on.
+ */
+static OFELI::Mesh *GmshMesh(int nb_dof)
+{
+   static const map<int,int> shape {{1,OFELI::LINE},{2,OFELI::TRIANGLE},{3,OFELI::QUADRILATERAL},
+                                    {4,OFELI::TETRAHEDRON},{5,OFELI::HEXAHEDRON},{6,OFELI::PENTAHEDRON}};
+   auto physical = [](int d, int t) {
+      vector<int> p;
+      gmsh::model::getPhysicalGroupsForEntity(d,t,p);
+      return p.size() ? p[0] : 0;
+   };
+   int dim = gmsh::model::getDimension();
+   vector<std::size_t> tags;
+   vector<double> x, u;
+   gmsh::model::mesh::getNodes(tags,x,u,-1,-1,false,false);
+   map<std::size_t,OFELI::Node *> nd;
+   map<std::size_t,int> code;
+   for (int d: {0,dim-1}) {
+      gmsh::vectorpair ent;
+      gmsh::model::getEntities(ent,d);
+      for (auto const& e: ent) {
+         int c = physical(e.first,e.second);
+         if (c==0)
+            continue;
+         vector<std::size_t> et;
+         vector<double> ex, eu;
+         gmsh::model::mesh::getNodes(et,ex,eu,e.first,e.second,true,false);
+         for (auto t: et) {
+            if (code[t]==0)
+               code[t] = c;
+         }
+      }
+   }
+   OFELI::Mesh *ms = new OFELI::Mesh;
+   ms->setDim(dim);
+   for (size_t i=0; i<tags.size(); ++i) {
+      OFELI::Node *n = new OFELI::Node(i+1,OFELI::Point<double>(x[3*i],x[3*i+1],x[3*i+2]));
+      n->setNbDOF(nb_dof);
+      auto c = code.find(tags[i]);
+      if (c!=code.end()) {
+         for (int k=1; k<=nb_dof; ++k)
+            n->setCode(k,c->second);
+      }
+      nd[tags[i]] = n;
+      ms->Add(n);
+   }
+   size_t ne=0, ns=0;
+   for (int d: {dim,dim-1}) {
+      gmsh::vectorpair ent;
+      gmsh::model::getEntities(ent,d);
+      for (auto const& e: ent) {
+         int c = physical(e.first,e.second);
+         if (d<dim && c==0)
+            continue;
+         vector<int> types;
+         vector<vector<std::size_t> > et, en;
+         gmsh::model::mesh::getElements(types,et,en,e.first,e.second);
+         for (size_t i=0; i<types.size(); ++i) {
+            auto s = shape.find(types[i]);
+            if (s==shape.end() || et[i].size()==0)
+               continue;
+            size_t nn = en[i].size()/et[i].size();
+            for (size_t k=0; k<et[i].size(); ++k) {
+               if (d==dim) {
+                  OFELI::Element *el = new OFELI::Element(++ne,s->second,c ? c : 1);
+                  for (size_t j=0; j<nn; ++j)
+                     el->Add(nd[en[i][k*nn+j]]);
+                  ms->Add(el);
+               }
+               else {
+                  OFELI::Side *sd = new OFELI::Side(++ns,s->second);
+                  for (size_t j=0; j<nn; ++j)
+                     sd->Add(nd[en[i][k*nn+j]]);
+                  sd->setNbDOF(nb_dof);
+                  for (int j=1; j<=nb_dof; ++j)
+                     sd->setCode(j,c);
+                  ms->Add(sd);
+               }
+            }
+         }
+      }
+   }
+   ms->NumberEquations();
+   return ms;
+}
+
+
+/*
+ * Mesh of a gmsh geometry file, generated in process
+ */
+static OFELI::Mesh *GeoMesh(const string& file,
+                            int           nb_dof,
+                            int           verb)
+{
+   OFELI::Mesh *ms = nullptr;
+   gmsh::initialize();
+   gmsh::option::setNumber("General.Terminal",verb>1);
+   try {
+      gmsh::open(file);
+      gmsh::model::mesh::generate(gmsh::model::getDimension());
+      ms = GmshMesh(nb_dof);
+   }
+   catch (...) {
+      if (ms!=nullptr)
+         delete ms, ms = nullptr;
+   }
+   gmsh::finalize();
+   return ms;
+}
+#endif
+
 mesh::mesh(rita*      r,
            cmd*       command,
            configure* config)
      : _rita(r), _saved(false), _generated(false), _geo(false), _ret(0), _generator(0),
-       _theMesh(nullptr), _theDomain(nullptr), _nb_Ccontour(0), _nb_Scontour(0), _nb_Vcontour(0),
+       _theMesh(nullptr), _grid(nullptr), _part_mesh(nullptr), _theDomain(nullptr), _nb_Ccontour(0), _nb_Scontour(0), _nb_Vcontour(0),
        _nb_sub_domain(0), _nb_point(0), _nb_curve(0), _nb_surface(0), _nb_volume(0), _configure(config),
        _cmd(command)
 {
@@ -75,7 +333,8 @@ mesh::mesh(rita*      r,
 mesh::~mesh()
 {
    if (_theMesh!=nullptr)
-      delete _theMesh, _theMesh = nullptr;
+      delete _theMesh, _theMesh = _part_mesh = nullptr;
+   clearGrid();
    if (_theDomain!=nullptr)
       delete _theDomain, _theDomain = nullptr;
 }
@@ -87,7 +346,7 @@ int mesh::run()
    _data = _rita->_data;
    const vector<string> kw {"help","?","set","1d","rect$angle","cube","point","curve",
                             "surface","volume","contour","code","gen$erate","nbdof",
-                            "list","plot","clear","save","read","end","<","quit","exit","EXIT"};
+                            "list","plot","clear","save","read","renum$ber","part$ition","end","<","quit","exit","EXIT"};
 #ifndef USE_GMSH
    _theDomain = new OFELI::Domain;
 #endif
@@ -102,16 +361,16 @@ int mesh::run()
          _rita->msg("mesh>","Unknown Command "+_cmd->token(),
                     "Available commands:\n"
                     "1d, rectangle, cube, point, curve, surface, volume, contour, code\n"
-                    "generate, list, plot, clear, save, read, end, <"
+                    "generate, list, plot, clear, save, read, renumber, partition, end, <"
                     "Global commands:\nhelp, ?, set, quit, exit");
          continue;
       }
-      else if (_key==19 || _key==20) {
+      else if (_key==21 || _key==22) {
           *_rita->ofh << "  end" << endl;
           _ret = 0;
          return _ret;
       }
-      else if (_key>20) {
+      else if (_key>22) {
          _ret = 100;
          return _ret;
       }
@@ -137,18 +396,31 @@ void mesh::getHelp()
    cout << "contour   : Define a contour as a sequence of curves or surfaces" << endl;
 //   cout << "subdomain : Define a subdomain" << endl;
    cout << "code      : Set code for points, lines, surfaces, volumes" << endl;
-   cout << "generate  : Generate mesh of a polygon" << endl;
+   cout << "generate  : Generate mesh of a polygon [save=file] [geo=file]" << endl;
    cout << "list      : List mesh data" << endl;
    cout << "plot      : Plot mesh" << endl;
    cout << "clear     : Clear mesh" << endl;
    cout << "read      : Read mesh from file" << endl;
    cout << "save      : Save mesh in file" << endl;
+   cout << "renumber  : Renumber mesh nodes and elements (rcm, hilbert, nested-dissection)" << endl;
+   cout << "partition : Partition mesh elements in subdomains [nb=N] [save=file]" << endl;
    cout << "end or <  : Return to higher level" << endl;
 }
 
 
 void mesh::List()
 {
+   if (_theMesh==nullptr && _grid!=nullptr) {
+      cout << "Structured mesh data\n" << endl;
+      cout << "Space dimension:    " << _grid->getDim() << endl;
+      cout << "Subdivisions:       " << _grid->getNbElements(0);
+      for (int a=1; a<_grid->getDim(); ++a)
+         cout << " x " << _grid->getNbElements(a);
+      cout << endl;
+      cout << "Number of nodes:    " << _grid->getNbNodes() << endl;
+      cout << "Number of elements: " << _grid->getNbElements() << endl;
+      return;
+   }
    if (_generated==0) {
       cout << "Geometry data\n" << endl;
       cout << "Space dimension:    " << _theMesh->getDim() << endl;
@@ -273,7 +545,7 @@ void mesh::set1D()
          return;
       }
       if (_theMesh!=nullptr)
-         delete _theMesh, _theMesh = nullptr;
+         _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
       _theMesh = new OFELI::Mesh(xmin,xmax,ne,cmin,cmax,1,size_t(_nb_dof));
       _data->addMesh(_theMesh,"M-"+to_string(_data->getNbMeshes()));
       _theMesh->removeImposedDOF();
@@ -384,7 +656,7 @@ void mesh::set1D()
                   break;
                }
                if (_theMesh!=nullptr)
-                  delete _theMesh, _theMesh = nullptr;
+                  _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
                _theMesh = new OFELI::Mesh(xmin,xmax,ne,cmin,cmax,1,size_t(_nb_dof));
                _theMesh->removeImposedDOF();
                _saved = true;
@@ -408,7 +680,7 @@ void mesh::set1D()
                   cout << "Getting back to higher level ..." << endl;
                if (!_saved) {
                   if (_theMesh!=nullptr)
-                     delete _theMesh, _theMesh = nullptr;
+                     _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
                   _theMesh = new OFELI::Mesh(xmin,xmax,ne,cmin,cmax,1,size_t(_nb_dof));
                   _theMesh->removeImposedDOF();
                   _saved = true;
@@ -446,7 +718,7 @@ void mesh::setRectangle()
 {
    double xmin=0., xmax=1., ymin=0., ymax=1.;
    int c[4] = {0,0,0,0}, cv[4] = {0,0,0,0};
-   int nb=0, nx=10, ny=10, ret=0, ret1=0, ret2=0, ret3=0, ret4=0;
+   int nb=0, nx=10, ny=10, ret=0, ret1=0, ret2=0, ret3=0, ret4=0, structured=0;
    _nb_dof = 1;
    _dim = 2;
    _ret = 0;
@@ -465,10 +737,12 @@ void mesh::setRectangle()
                            "                condition to prescribe.\n"
                            "d: Number of degrees of freedom associated to any generated node. Default value is 1.\n"
                            "file: Name of the file where the generated mesh will be stored. By default the mesh\n"
-                           "      remains in memory but is not saved in file.";
+                           "      remains in memory but is not saved in file.\n"
+                           "s: If 1, the mesh is structured: only the rectangle, subdivisions and codes are\n"
+                           "   stored, nodes and elements are computed when needed. Default value is 0.";
    _mesh_file = "rita-rectangle.m";
    const vector<string> kw {"help","?","set","min","max","ne","codes","nbdof","save","end","<",
-                            "quit","exit","EXIT"};
+                            "quit","exit","EXIT","struct$ured"};
    _cmd->set(kw);
    int nb_args = _cmd->getNbArgs();
    if (nb_args==0) {
@@ -552,6 +826,10 @@ void mesh::setRectangle()
             _mesh_file = _cmd->string_token(0);
             break;
 
+         case 14:
+            structured = _cmd->int_token(0);
+            break;
+
          default:
             _rita->msg("mesh>rectangle>","Unknown argument: "+kw[n]);
             return;
@@ -566,9 +844,20 @@ void mesh::setRectangle()
          _rita->msg("mesh>rectangle>","ymax: "+to_string(ymax)+" must be > ymin: "+to_string(ymin));
          return;
       }
+      if (structured) {
+         double a[3]={xmin,ymin,0.}, b[3]={xmax,ymax,0.};
+         size_t ne[3]={size_t(nx),size_t(ny),0};
+         int fc[6]={c[3],c[1],c[0],c[2],0,0};
+         setGrid(2,a,b,ne,fc);
+         *_rita->ofh << "  rectangle min=" << xmin << "," << ymin << " max=" << xmax << "," << ymax;
+         *_rita->ofh << "  ne=" << nx << "," << ny << "  codes=" << c[0] << "," << c[1] << "," << c[2];
+         *_rita->ofh << "," << c[3] << "  nbdof=" << _nb_dof << "  structured=1" << endl;
+         return;
+      }
+      clearGrid();
       if (!_saved) {
          if (_theMesh!=nullptr)
-            delete _theMesh, _theMesh = nullptr;
+            _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
          _theMesh = new OFELI::Mesh(xmin,xmax,ymin,ymax,nx,ny,c[3],c[1],c[0],c[2],TRIANGLE,size_t(_nb_dof));
          _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
          _data->theMesh.push_back(_theMesh);
@@ -708,7 +997,7 @@ void mesh::setRectangle()
                   break;
                }
                if (_theMesh!=nullptr)
-                  delete _theMesh, _theMesh = nullptr;
+                  _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
                _theMesh = new OFELI::Mesh(xmin,xmax,ymin,ymax,nx,ny,c[3],c[1],c[0],c[2],TRIANGLE,size_t(_nb_dof));
                _saved = true;
                _generator = 2;
@@ -731,7 +1020,7 @@ void mesh::setRectangle()
                *_rita->ofh << "    end" << endl;
                if (!_saved) {
                   if (_theMesh!=nullptr)
-                     delete _theMesh, _theMesh = nullptr;
+                     _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
                   _theMesh = new OFELI::Mesh(xmin,xmax,ymin,ymax,nx,ny,c[3],c[1],c[0],c[2],TRIANGLE,size_t(_nb_dof));
                   _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
                   _data->theMesh.push_back(_theMesh);
@@ -767,10 +1056,48 @@ void mesh::setRectangle()
 }
 
 
+/*
+ * Structured mesh of a rectangle or a cube: nothing but the grid is stored,
+ * the OFELI mesh is not built
+ */
+void mesh::setGrid(int           dim,
+                   const double* xmin,
+                   const double* xmax,
+                   const size_t* ne,
+                   const int*    code)
+{
+   if (_grid==nullptr)
+      _grid = new structuredMesh;
+   if (_grid->set(dim,xmin,xmax,ne,code,_nb_dof)) {
+      _rita->msg("mesh>","Illegal data for structured mesh.");
+      clearGrid();
+      _ret = 1;
+      return;
+   }
+   if (_theMesh!=nullptr)
+      _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
+   _saved = false;
+   _generator = 1;
+   _generated = true;
+   _ret = 0;
+   if (_verb)
+      cout << "Structured mesh: " << _grid->getNbNodes() << " nodes, " << _grid->getNbElements()
+           << " elements, " << _grid->getMemory() << " bytes" << endl;
+}
+
+
+void mesh::clearGrid()
+{
+   if (_grid!=nullptr)
+      delete _grid, _grid = nullptr;
+}
+
+
 void mesh::setCube()
 {
    double xmin=0., xmax=1., ymin=0., ymax=1., zmin=0., zmax=1.;
    int nb=0, ret=0, nx=10, ny=10, nz=10, cxmin=0, cxmax=0, cymin=0, cymax=0, czmin=0, czmax=0;
+   int structured=0;
    _nb_dof = 1;
    _dim = 3;
    const static string H = "cube [min=mx,my,mz] [max=Mx,My,Mz] [ne=nx,ny,nz]  [codes=cxm,cxM,cym,cyM,czm,czMs]\n"
@@ -787,7 +1114,9 @@ void mesh::setCube()
                            "conditions. A code 0 (Default value) means no condition to prescribe.\n"
                            "d: Number of degrees of freedom associated to any generated node. Default value is 1.\n"
                            "file: Name of the file where the generated mesh will be stored. By default the mesh\n"
-                           "      remains in memory but is not saved in file.";
+                           "      remains in memory but is not saved in file.\n"
+                           "s: If 1, the mesh is structured: only the cube, subdivisions and codes are stored,\n"
+                           "   nodes and elements are computed when needed. Default value is 0.";
    *_rita->ofh << "  cube" << endl;
    _saved = false;
    _ret = 0;
@@ -798,7 +1127,7 @@ void mesh::setCube()
       cout << "Default nb of dof: 1" << endl;
    }
    const vector<string> kw {"help","?","set","min","max","ne","codes","nbdof","save","end","<",
-                            "quit","exit","EXIT"};
+                            "quit","exit","EXIT","struct$ured"};
 
    _cmd->set(kw);
    int nb_args = _cmd->getNbArgs();
@@ -863,7 +1192,7 @@ void mesh::setCube()
             }
             break;
 
-         case  8:
+         case  6:
             if (nb==1)
                cxmin = cxmax = cymin = cymax = czmin = czmax = _cmd->int_token(0);
             else if (nb==6) {
@@ -881,14 +1210,18 @@ void mesh::setCube()
             }
             break;
 
-         case  9:
+         case  7:
             _nb_dof = _cmd->int_token(0);
             break;
 
-         case 10:
+         case  8:
             _mesh_file = _cmd->string_token(0);
             break;
 
+         case 14:
+            structured = _cmd->int_token(0);
+            break;
+
          default:
             _rita->msg("mesh>cube>","Unknown argument: "+kw[n]);
 	    return;
@@ -907,9 +1240,20 @@ void mesh::setCube()
          _rita->msg("mesh>cube>","Value of zmax: "+to_string(zmax)+" must be > zmin: "+to_string(zmin));
          return;
       }
+      if (structured) {
+         double a[3]={xmin,ymin,zmin}, b[3]={xmax,ymax,zmax};
+         size_t ne[3]={size_t(nx),size_t(ny),size_t(nz)};
+         int fc[6]={cxmin,cxmax,cymin,cymax,czmin,czmax};
+         setGrid(3,a,b,ne,fc);
+         *_rita->ofh << "  cube min=" << xmin << "," << ymin << "," << zmin << " max=" << xmax << "," << ymax << "," << zmax;
+         *_rita->ofh << " ne=" << nx << "," << ny << "," << nz << " codes=" << cxmin << "," << cxmax << "," << cymin << ",";
+         *_rita->ofh << cymax << "," << czmin << "," << czmax << " nbdof=" << _nb_dof << " structured=1" << endl;
+         return;
+      }
+      clearGrid();
       if (!_saved) {
          if (_theMesh!=nullptr)
-            delete _theMesh, _theMesh = nullptr;
+            _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
          _theMesh = new OFELI::Mesh(xmin,xmax,ymin,ymax,zmin,zmax,nx,ny,nz,cxmin,cxmax,cymin,
                                     cymax,czmin,czmax,HEXAHEDRON,size_t(_nb_dof));
          _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
@@ -1033,7 +1377,7 @@ void mesh::setCube()
                   break;
                }
                if (_theMesh!=nullptr)
-                  delete _theMesh, _theMesh = nullptr;
+                  _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
                _mesh_file = "rita-cube.m";
                if (_cmd->getNbArgs()>0)
                   _cmd->get(_mesh_file);
@@ -1056,7 +1400,7 @@ void mesh::setCube()
                   cout << "Getting back to higher level ..." << endl;
                if (!_saved) {
                   if (_theMesh!=nullptr)
-                     delete _theMesh, _theMesh = nullptr;
+                     _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
                   _theMesh = new OFELI::Mesh(xmin,xmax,ymin,ymax,zmin,zmax,nx,ny,nz,cxmin,
                                              cxmax,cymin,cymax,czmin,czmax,HEXAHEDRON,size_t(_nb_dof));
                   _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
@@ -2018,9 +2362,36 @@ void mesh::saveDomain(const string& file)
 }
 
 
+/*
+ * Mesh generation. The mesh is written in file only if save=file is given,
+ * in gmsh format if its extension is .msh, and the geometry in a gmsh .geo
+ * file only if geo=file is given.
+ */
 void mesh::Generate()
 {
+   string file="", geo_file="";
+   const vector<string> kw {"help","?","set","save","geo","end","<","quit","exit","EXIT"};
    _ret = 0;
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   for (int i=0; i<nb_args; ++i) {
+      int n = _cmd->getArg();
+      switch (n) {
+
+         case 3:
+            file = _cmd->string_token();
+            break;
+
+         case 4:
+            geo_file = _cmd->string_token();
+            break;
+
+         default:
+            _rita->msg("mesh>generate>","Unknown argument: "+_cmd->token());
+            _ret = 1;
+            return;
+      }
+   }
    if (_generator>0 && _generator<=3) {
       if (_generator==1) {
          _rita->msg("mesh>generate>","A 1-D mesh has already been generated.");
@@ -2035,13 +2406,58 @@ void mesh::Generate()
    }
    _generator = 10;
    if (_theMesh!=nullptr)
-      delete _theMesh, _theMesh = nullptr;
+      _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
    _mesh_file = "rita.m";
-   
-// Save geo gmsh file and generate gmsh mesh
-   if (!_geo)
-      saveGeo("rita.geo");
+   if (geo_file!="")
+      saveGeo(geo_file);
+
+// Generate the mesh, unless the same geometry has already been meshed
+   string desc=getGeometry(), cache_file;
+   if (_configure->getMeshCache())
+      cache_file = meshCache::path(meshCache::key(desc));
+   meshCache mc;
+   if (cache_file!="" && mc.load(cache_file,desc)==0) {
+      _theMesh = CacheMesh(mc);
+      if (_verb)
+         cout << "Mesh read from cache file " << cache_file << endl;
+#ifndef USE_GMSH
+      _generator = 4;
+#endif
+   }
+   else {
+      if (GenerateMesh()) {
+         _ret = 1;
+         return;
+      }
+      if (cache_file!="") {
+         MeshCache(*_theMesh,mc);
+         if (mc.save(cache_file,desc) && _verb)
+            cout << "Warning: Mesh could not be stored in cache file " << cache_file << endl;
+      }
+   }
+   _generated = true;
+   if (file.size()>4 && file.substr(file.size()-4)==".msh")
+      saveMesh(file,*_theMesh,GMSH);
+   else if (file!="")
+      _theMesh->save(file);
+   *_rita->ofh << "  generate";
+   if (file!="")
+      *_rita->ofh << " save=" << file;
+   if (geo_file!="")
+      *_rita->ofh << " geo=" << geo_file;
+   *_rita->ofh << endl;
+   _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
+   _data->theMesh.push_back(_theMesh);
+   _ret = 0;
+   return;
+}
+
 
+/*
+ * Mesh of the geometry data by gmsh or, without gmsh, by OFELI
+ */
+int mesh::GenerateMesh()
+{
 #ifdef USE_GMSH
    if (_verb)
       cout << "Starting mesh generation using Gmsh ..." << endl;
@@ -2071,26 +2487,66 @@ void mesh::Generate()
    gmsh::model::setPhysicalName(2,4,"Domain");
    gmsh::model::geo::synchronize();
    gmsh::model::mesh::generate(2);
-   gmsh::write("rita.msh");
+   try {
+      _theMesh = GmshMesh(_nb_dof);
+   }
+   catch (...) {
+      if (_theMesh!=nullptr)
+         _data->clearIndex(_theMesh), delete _theMesh, _theMesh = _part_mesh = nullptr;
+   }
    gmsh::finalize();
+   if (_theMesh==nullptr) {
+      _rita->msg("mesh>generate>","Gmsh mesh generation failed.");
+      return 1;
+   }
    if (_verb)
       cout << "Gmsh mesh generation complete." << endl;
-   _theMesh = new OFELI::Mesh("rita.msh",false,NODE_DOF,_nb_dof);
-   _generated = true;
 #else
    _theDomain->setDim(_dim);
    _theDomain->setNbDOF(size_t(_nb_dof));
    saveDomain("rita.dom");
    _theDomain->genMesh(_mesh_file);
    _theMesh = new OFELI::Mesh(_mesh_file,false,NODE_DOF,2);
-   _generated = true;
    _generator = 4;
 #endif
-   *_rita->ofh << "  generate" << endl;
-   _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
-   _data->theMesh.push_back(_theMesh);
-   _ret = 0;
-   return;
+   return 0;
+}
+
+
+/*
+ * Normalized description of the geometry and generator settings: the key of
+ * the mesh cache
+ */
+string mesh::getGeometry() const
+{
+   std::ostringstream s;
+   s.precision(17);
+#ifdef USE_GMSH
+   s << "gmsh";
+#ifdef GMSH_API_VERSION
+   s << " " << GMSH_API_VERSION;
+#endif
+#else
+   s << "ofeli";
+#endif
+   s << "\ndim " << _dim << "\nnbdof " << _nb_dof << "\n";
+   for (auto const& v: _points)
+      s << "p " << v.first << " " << v.second.x << " " << v.second.y << " " << v.second.z
+        << " " << v.second.h << "\n";
+   const vector<std::pair<string,const map<int,Entity> *> > ent {
+      {"c",&_curve}, {"s",&_surface}, {"v",&_volume}, {"cc",&_Ccontour}, {"sc",&_Scontour},
+      {"vc",&_Vcontour}, {"pk",&_Pcode}, {"ck",&_Ccode}, {"sk",&_Scode}, {"vk",&_Vcode}};
+   for (auto const& e: ent) {
+      for (auto const& v: *e.second) {
+         s << e.first << " " << v.first << " " << v.second.type;
+         for (auto i: v.second.l)
+            s << " " << i;
+         s << "\n";
+      }
+   }
+   for (auto const& d: _subdomains)
+      s << "d " << d.ln << " " << d.orientation << " " << d.code << "\n";
+   return s.str();
 }
 
 
@@ -2135,8 +2591,8 @@ void mesh::Read()
    int ret=0;
    ifstream ip;
    string dom_file, file, bamg_file, geo_file, out_file, Cmd, msh_file;
-   int mesh_ok=0, geo_ok=0, gmsh_ok=0;
-   const vector<string> kw {"help","?","set","mesh","geo","gmsh","end","<","quit","exit","EXIT"};
+   int mesh_ok=0, geo_ok=0, gmsh_ok=0, bench=0;
+   const vector<string> kw {"help","?","set","mesh","geo","gmsh","end","<","quit","exit","EXIT","bench"};
    _cmd->set(kw);
    int nb_args = _cmd->getNbArgs();
    for (int i=0; i<nb_args; ++i) {
@@ -2158,6 +2614,10 @@ void mesh::Read()
             gmsh_ok++;
             break;
 
+         case 11:
+            bench = _cmd->int_token();
+            break;
+
          default:
             _rita->msg("mesh>read>","Unknown argument: "+_kw[n]);
             _ret = 1;
@@ -2190,7 +2650,7 @@ void mesh::Read()
             _ret = 1;
             return;
          }
-         _theMesh = new OFELI::Mesh(file);
+         _theMesh = ReadMesh(file,_nb_dof,_verb,bench);
          if (_theMesh->getNbNodes()==0) {
             _rita->msg("mesh>read>","Empty mesh");
             _ret = 1;
@@ -2209,7 +2669,15 @@ void mesh::Read()
             _ret = 1;
             return;
          }
-         msh_file = file.substr(0,file.rfind(".")) + "msh";
+#ifdef USE_GMSH
+         _theMesh = GeoMesh(file,_nb_dof,_verb);
+         if (_theMesh==nullptr) {
+            _rita->msg("mesh>read>","Gmsh failed to mesh file: "+file);
+            _ret = 1;
+            return;
+         }
+#else
+         msh_file = file.substr(0,file.rfind(".")) + ".msh";
          Cmd = "gmsh -2 " + file + " -o " + msh_file;
          if (system(Cmd.c_str())) {
             _rita->msg("mesh>read>:","Unrecognizable system command.");
@@ -2217,7 +2685,8 @@ void mesh::Read()
             return;
          }
          _theMesh = new OFELI::Mesh;
-         _theMesh->get(file,GMSH);
+         _theMesh->get(msh_file,GMSH);
+#endif
          _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
          _data->theMesh.push_back(_theMesh);
          _generated = true;
@@ -2230,8 +2699,7 @@ void mesh::Read()
             return;
          }
          _generated = true;
-         _theMesh = new OFELI::Mesh;
-         _theMesh->get(file,GMSH);
+         _theMesh = ReadMesh(file,_nb_dof,_verb,bench);
          _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
          _data->theMesh.push_back(_theMesh);
          *_rita->ofh << "  gmsh=" << file;
@@ -2251,7 +2719,7 @@ void mesh::Read()
                _cmd->setNbArg(0);
                cout << "\nAvailable Commands\n";
                cout << "mesh     : Read mesh in OFELI mesh file\n";
-               cout << "geo      : Read mesh in OFELI mesh file\n";
+               cout << "geo      : Mesh gmsh geometry file\n";
                cout << "gmsh     : Read mesh in gmsh file" << endl;
                cout << "< or end : Go back to mesh menu" << endl;
                break;
@@ -2269,7 +2737,7 @@ void mesh::Read()
                ip.open(file);
                if (ip.is_open()) {
                   ip.close();
-                  _theMesh = new OFELI::Mesh(file);
+                  _theMesh = ReadMesh(file,_nb_dof,_verb,false);
                   *_rita->ofh << "  read mesh " << file << endl;
                   if (_theMesh->getNbNodes()==0) {
                      _rita->msg("mesh>read>mesh>","Empty mesh");
@@ -2296,12 +2764,20 @@ void mesh::Read()
                }
                ret = _cmd->get(file);
                if (!ret) {
-                  if (file.substr(file.find_last_of(".")+1)!=".geo") {
+                  if (file.substr(file.find_last_of(".")+1)!="geo") {
                      _rita->msg("mesh>read>geo>","File extension must be \".geo\"");
                      _ret = 1;
                      break;
                   }
-                  msh_file = file.substr(0,file.rfind(".")) + "msh";
+#ifdef USE_GMSH
+                  _theMesh = GeoMesh(file,_nb_dof,_verb);
+                  if (_theMesh==nullptr) {
+                     _rita->msg("mesh>read>geo>","Gmsh failed to mesh file: "+file);
+                     _ret = 1;
+                     break;
+                  }
+#else
+                  msh_file = file.substr(0,file.rfind(".")) + ".msh";
                   Cmd = "gmsh -2 " + file + " -o " + msh_file;
                   if (system(Cmd.c_str())) {
                      _rita->msg("mesh>read>geo>","Unrecognizable system command.");
@@ -2310,6 +2786,7 @@ void mesh::Read()
                   }
                   _theMesh = new OFELI::Mesh;
                   _theMesh->get(msh_file,GMSH);
+#endif
                   *_rita->ofh << "  read geo " << file << endl;
                   _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
                   _data->theMesh.push_back(_theMesh);
@@ -2331,8 +2808,7 @@ void mesh::Read()
                      _ret = 1;
                      break;
                   }
-                  _theMesh = new OFELI::Mesh;
-                  _theMesh->get(file,GMSH);
+                  _theMesh = ReadMesh(file,_nb_dof,_verb,false);
                   _data->mesh_name.push_back("M"+to_string(_data->theMesh.size()));
                   _data->theMesh.push_back(_theMesh);
                   *_rita->ofh << "  read gmsh " << file << endl;
@@ -2373,6 +2849,276 @@ void mesh::Read()
 }
 
 
+/*
+ * Renumber nodes and elements of the current mesh. The mesh is rebuilt with
+ * the new numbering, node and side codes being kept, and fields already
+ * defined on nodes or elements of this mesh are permuted accordingly.
+ * Renumbering is allowed only before equations are defined since these
+ * store the mesh numbering.
+ */
+void mesh::Renumber()
+{
+   int method = 0;
+   string m = "rcm";
+   const vector<string> kw {"help","?","set","method","end","<","quit","exit","EXIT"};
+   const vector<string> mth {"rcm","hilbert","nested-dissection"};
+   _ret = 0;
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   for (int i=0; i<nb_args; ++i) {
+      int n = _cmd->getArg();
+      switch (n) {
+
+         case 3:
+            m = _cmd->string_token();
+            break;
+
+         default:
+            _rita->msg("mesh>renumber>","Unknown argument: "+_cmd->token());
+            _ret = 1;
+            return;
+      }
+   }
+   auto it = std::find(mth.begin(),mth.end(),m);
+   if (it==mth.end()) {
+      _rita->msg("mesh>renumber>","Unknown renumbering method: "+m,
+                 "Available methods: rcm, hilbert, nested-dissection");
+      _ret = 1;
+      return;
+   }
+   method = int(it-mth.begin());
+   if (_theMesh==nullptr || _theMesh->getNbNodes()==0) {
+      _rita->msg("mesh>renumber>","No mesh to renumber.");
+      _ret = 1;
+      return;
+   }
+   if (_rita->_nb_pde>0) {
+      _rita->msg("mesh>renumber>","Mesh must be renumbered before equations are defined.");
+      _ret = 1;
+      return;
+   }
+
+   OFELI::Mesh *ms = _theMesh;
+   int dim = ms->getDim();
+   size_t nn=ms->getNbNodes(), ne=ms->getNbElements(), ns=ms->getNbSides();
+   vector<double> coord(dim*nn);
+   vector<size_t> el_ptr(1,0), el_node;
+   for (size_t n=1; n<=nn; ++n) {
+      OFELI::Point<double> x = (*ms)[n]->getCoord();
+      for (int a=0; a<dim; ++a)
+         coord[dim*(n-1)+a] = (a==0) ? x.x : ((a==1) ? x.y : x.z);
+   }
+   for (size_t e=1; e<=ne; ++e) {
+      OFELI::Element *el = ms->getPtrElement(e);
+      for (size_t i=1; i<=el->getNbNodes(); ++i)
+         el_node.push_back(el->getPtrNode(i)->n()-1);
+      el_ptr.push_back(el_node.size());
+   }
+   renumber rn;
+   if (rn.set(dim,coord,el_ptr,el_node) || rn.run(method)) {
+      _rita->msg("mesh>renumber>","Renumbering failed.");
+      _ret = 1;
+      return;
+   }
+   const vector<size_t> &np=rn.getNodePerm(), &ep=rn.getElementPerm();
+
+// Rebuild mesh with new numbering
+   vector<size_t> inp(nn), iep(ne);
+   for (size_t n=0; n<nn; ++n)
+      inp[np[n]] = n + 1;
+   for (size_t e=0; e<ne; ++e)
+      iep[ep[e]] = e + 1;
+   OFELI::Mesh *nms = new OFELI::Mesh;
+   nms->setDim(dim);
+   vector<OFELI::Node *> nd(nn+1);
+   for (size_t i=1; i<=nn; ++i) {
+      OFELI::Node *od = (*ms)[inp[i-1]];
+      nd[inp[i-1]] = new OFELI::Node(i,od->getCoord());
+      nd[inp[i-1]]->setNbDOF(od->getNbDOF());
+      for (size_t k=1; k<=od->getNbDOF(); ++k)
+         nd[inp[i-1]]->setCode(k,od->getCode(k));
+      nms->Add(nd[inp[i-1]]);
+   }
+   for (size_t i=1; i<=ne; ++i) {
+      OFELI::Element *oe = ms->getPtrElement(iep[i-1]);
+      OFELI::Element *el = new OFELI::Element(i,oe->getShape(),oe->getCode());
+      for (size_t k=1; k<=oe->getNbNodes(); ++k)
+         el->Add(nd[oe->getPtrNode(k)->n()]);
+      nms->Add(el);
+   }
+   for (size_t s=1; s<=ns; ++s) {
+      OFELI::Side *os = ms->getPtrSide(s);
+      OFELI::Side *sd = new OFELI::Side(s,os->getShape());
+      for (size_t k=1; k<=os->getNbNodes(); ++k)
+         sd->Add(nd[os->getPtrNode(k)->n()]);
+      sd->setNbDOF(os->getNbDOF());
+      for (size_t k=1; k<=os->getNbDOF(); ++k)
+         sd->setCode(k,os->getCode(k));
+      nms->Add(sd);
+   }
+   if (ms->getNbEq()<ms->getNbDOF())
+      nms->removeImposedDOF();
+   else
+      nms->NumberEquations();
+
+// Permute fields defined on this mesh
+   for (int f=0; f<_data->getNbFields(); ++f) {
+      OFELI::Vect<double> *u = _data->u[f];
+      if (!u->WithMesh() || &(u->getMesh())!=ms)
+         continue;
+      OFELI::Vect<double> v(*u);
+      if (_data->FieldSizeType[f]==NODES) {
+         size_t nb = v.size()/nn;
+         u->setMesh(*nms,NODE_DOF,nb);
+         for (size_t n=0; n<nn; ++n)
+            for (size_t k=0; k<nb; ++k)
+               (*u)[nb*np[n]+k] = v[nb*n+k];
+      }
+      else if (_data->FieldSizeType[f]==ELEMENTS) {
+         size_t nb = v.size()/ne;
+         u->setMesh(*nms,ELEMENT_DOF,nb);
+         for (size_t e=0; e<ne; ++e)
+            for (size_t k=0; k<nb; ++k)
+               (*u)[nb*ep[e]+k] = v[nb*e+k];
+      }
+      else if (_data->FieldSizeType[f]==SIDES) {
+         u->setMesh(*nms,SIDE_DOF,v.size()/ns);
+         *u = v;
+      }
+   }
+   for (auto &M: _data->theMesh) {
+      if (M==ms)
+         M = nms;
+   }
+   if (_rita->_theMesh==ms)
+      _rita->_theMesh = nms;
+   _theMesh = nms;
+   _part_mesh = nullptr;
+   _data->clearIndex(ms);
+   delete ms;
+
+   cout << "Mesh renumbered by " << m << ": bandwidth " << rn.getBandwidth(false) << " -> "
+        << rn.getBandwidth() << ", profile " << rn.getProfile(false) << " -> " << rn.getProfile()
+        << endl;
+   *_rita->ofh << "  renumber method=" << m << endl;
+}
+
+
+/*
+ * Partition of the mesh elements in nb subdomains by multilevel k-way
+ * partitioning of the dual graph. The partition (element and node lists,
+ * interface and halo of each subdomain) is kept for the parallel solvers
+ * and can be saved in a text file.
+ */
+void mesh::Partition()
+{
+   int nb = getNbThreads();
+   string file = "";
+   const vector<string> kw {"help","?","set","nb","save","end","<","quit","exit","EXIT"};
+   _ret = 0;
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   for (int i=0; i<nb_args; ++i) {
+      int n = _cmd->getArg();
+      switch (n) {
+
+         case 3:
+            nb = _cmd->int_token();
+            break;
+
+         case 4:
+            file = _cmd->string_token();
+            break;
+
+         default:
+            _rita->msg("mesh>partition>","Unknown argument: "+_cmd->token());
+            _ret = 1;
+            return;
+      }
+   }
+   if (_theMesh==nullptr || _theMesh->getNbElements()==0) {
+      _rita->msg("mesh>partition>","No mesh to partition.");
+      _ret = 1;
+      return;
+   }
+   OFELI::Mesh *ms = _theMesh;
+   size_t nn=ms->getNbNodes(), ne=ms->getNbElements();
+   if (nb<1 || size_t(nb)>ne) {
+      _rita->msg("mesh>partition>","Illegal number of subdomains: "+to_string(nb));
+      _ret = 1;
+      return;
+   }
+   vector<size_t> el_ptr(1,0), el_node;
+   for (size_t e=1; e<=ne; ++e) {
+      OFELI::Element *el = ms->getPtrElement(e);
+      for (size_t i=1; i<=el->getNbNodes(); ++i)
+         el_node.push_back(el->getPtrNode(i)->n()-1);
+      el_ptr.push_back(el_node.size());
+   }
+   auto t0 = std::chrono::steady_clock::now();
+   if (_partition.set(ms->getDim(),nn,el_ptr,el_node) || _partition.run(nb)) {
+      _rita->msg("mesh>partition>","Partitioning failed.");
+      _part_mesh = nullptr;
+      _ret = 1;
+      return;
+   }
+   double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+   _part_mesh = ms;
+   size_t ni=0, nh=0;
+   for (int p=0; p<nb; ++p) {
+      ni += _partition.getSubdomain(p).interface.size();
+      nh += _partition.getSubdomain(p).halo_elements.size();
+   }
+   cout << "Mesh partitioned in " << nb << " subdomains: edge cut " << _partition.getEdgeCut()
+        << ", load imbalance " << _partition.getImbalance() << endl;
+   if (_verb>1) {
+      cout << "Coarsening levels: " << _partition.getNbLevels() << ", interface nodes: " << ni
+           << ", halo elements: " << nh << ", time: " << t << " s" << endl;
+      for (int p=0; p<nb; ++p) {
+         const partition::Subdomain &sd = _partition.getSubdomain(p);
+         cout << "Subdomain " << p+1 << ": " << sd.elements.size() << " elements, " << sd.nodes.size()
+              << " nodes, " << sd.interface.size() << " interface nodes, " << sd.halo_elements.size()
+              << " halo elements" << endl;
+      }
+   }
+   *_rita->ofh << "  partition nb=" << nb;
+   if (file!="") {
+      ofstream fs(file.c_str());
+      fs << "# Mesh partition saved by rita: " << nb << " subdomains, element and node numbers" << endl;
+      auto put = [&fs](const string& h, const vector<size_t>& l) {
+         fs << h << " " << l.size() << endl;
+         for (size_t i=0; i<l.size(); ++i)
+            fs << l[i]+1 << ((i%10==9 || i+1==l.size()) ? "\n" : " ");
+      };
+      for (int p=0; p<nb; ++p) {
+         const partition::Subdomain &sd = _partition.getSubdomain(p);
+         fs << "subdomain " << p+1 << endl;
+         put("elements",sd.elements);
+         put("nodes",sd.nodes);
+         put("interface",sd.interface);
+         put("halo_elements",sd.halo_elements);
+         put("halo_nodes",sd.halo_nodes);
+      }
+      *_rita->ofh << "  save=" << file;
+      if (_verb)
+         cout << "Partition saved in file " << file << endl;
+   }
+   *_rita->ofh << endl;
+}
+
+
+/*
+ * Partition of the current mesh, nullptr if the mesh has not been
+ * partitioned since it was created
+ */
+const partition* mesh::getPartition() const
+{
+   if (_theMesh==nullptr || _part_mesh!=_theMesh)
+      return nullptr;
+   return &_partition;
+}
+
+
 void mesh::Save()
 {
    string domain_f="rita.dom", geo_f="rita.geo", mesh_f="rita.m", gmsh_f="rita.msh";
@@ -2454,6 +3200,15 @@ void mesh::Save()
       _ret = 1;
       return;
    }
+   if (_theMesh==nullptr && _grid!=nullptr) {
+      if (domain_ok+geo_ok+mesh_ok+gmsh_ok+gnuplot_ok+matlab_ok+tecplot_ok>0 || _grid->save(vtk_f)) {
+         _rita->msg("mesh>save>","A structured mesh can be saved in vtk format only.");
+         _ret = 1;
+         return;
+      }
+      *_rita->ofh << "  save  vtk=" << vtk_f << endl;
+      return;
+   }
    *_rita->ofh << "  save";
    if (domain_ok) {
       saveDomain(domain_f);
@@ -2706,9 +3461,12 @@ void mesh::Save()
 void mesh::Clear()
 {
    _cmd->setNbArg(0);
-   if (_theMesh!=nullptr)
+   if (_theMesh!=nullptr) {
+      _data->clearIndex(_theMesh);
       delete _theMesh;
-   _theMesh = nullptr;
+   }
+   _theMesh = _part_mesh = nullptr;
+   clearGrid();
    _saved = false;
    _dim = 1;
    _ret = 0;
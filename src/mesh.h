@@ -34,6 +34,8 @@
 #include "mesh/Mesh.h"
 #include "mesh/Domain.h"
 #include "configure.h"
+#include "structuredMesh.h"
+#include "partition.h"
 
 using std::map;
 
@@ -56,6 +58,8 @@ class mesh
     void set(OFELI::Mesh* ms) { _theMesh = ms; }
     OFELI::Mesh* get() const { return _theMesh; }
     OFELI::Mesh* getMesh() const { return _theMesh; }
+    structuredMesh* getGrid() const { return _grid; }
+    const partition* getPartition() const;
     void set(configure* config) { _configure = config; }
 
  private:
@@ -69,10 +73,13 @@ class mesh
    bool _saved, _generated, _geo;
    int _verb, _dim, _nb_dof, _ret, _key, _generator;
    OFELI::Mesh *_theMesh;
+   structuredMesh *_grid;
+   partition _partition;
+   OFELI::Mesh *_part_mesh;
    OFELI::Domain *_theDomain;
    string _mesh_file;
    typedef void (mesh::* MeshData_Ptr)();
-   static MeshData_Ptr MESH_DATA[20];
+   static MeshData_Ptr MESH_DATA[22];
    std::vector<string> _kw;
    int _nb_Ccontour, _nb_Scontour, _nb_Vcontour;
    int _nb_sub_domain, _nb_point, _nb_curve, _nb_surface, _nb_volume;
@@ -93,6 +100,8 @@ class mesh
    void set1D();
    void setRectangle();
    void setCube();
+   void setGrid(int dim, const double* xmin, const double* xmax, const size_t* ne, const int* code);
+   void clearGrid();
    void setPoint();
    void setCurve();
    void setSurface();
@@ -103,10 +112,14 @@ class mesh
    void setCode();
    void saveDomain(const string& file);
    void Generate();
+   int GenerateMesh();
+   string getGeometry() const;
    void setNbDOF();
    void Plot();
    void Clear();
    void Read();
+   void Renumber();
+   void Partition();
    void Save();
    void saveGeo(const string& file);
 };
@@ -0,0 +1,527 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Implementation of class 'meshAdapt'
+
+  ==============================================================================*/
+
+
+
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include "meshAdapt.h"
+
+namespace RITA {
+
+static const size_t NONE = size_t(-1);
+
+meshAdapt::meshAdapt()
+          : _nb_dof(1)
+{
+}
+
+
+/*
+ * coord: node coordinates (2 per node), el_node: element nodes (3 per element),
+ * node_code, sd_code: nb_dof codes per node and per side, sd_node: side nodes
+ * (2 per side). Elements are rotated so that their first node is opposite to
+ * their longest edge.
+ */
+int meshAdapt::set(int                   nb_dof,
+                   const vector<double>& coord,
+                   const vector<size_t>& el_node,
+                   const vector<int>&    el_code,
+                   const vector<int>&    node_code,
+                   const vector<size_t>& sd_node,
+                   const vector<int>&    sd_code)
+{
+   size_t nn=coord.size()/2, ne=el_node.size()/3, ns=sd_node.size()/2;
+   if (nb_dof<1 || coord.size()%2 || el_node.size()%3 || el_code.size()!=ne ||
+       node_code.size()!=nb_dof*nn || sd_code.size()!=nb_dof*ns)
+      return 1;
+   for (auto n: el_node) {
+      if (n>=nn)
+         return 1;
+   }
+   for (auto n: sd_node) {
+      if (n>=nn)
+         return 1;
+   }
+   _nb_dof = nb_dof;
+   _coord = coord, _el = el_node, _el_code = el_code, _node_code = node_code;
+   _sd = sd_node, _sd_code = sd_code;
+   auto len = [this](size_t a, size_t b) {
+      double dx=_coord[2*a]-_coord[2*b], dy=_coord[2*a+1]-_coord[2*b+1];
+      return dx*dx + dy*dy;
+   };
+   for (size_t e=0; e<ne; ++e) {
+      size_t *v = &_el[3*e];
+      double l0=len(v[1],v[2]), l1=len(v[2],v[0]), l2=len(v[0],v[1]);
+      if (l1>l0 && l1>=l2)
+         std::rotate(v,v+1,v+3);
+      else if (l2>l0 && l2>l1)
+         std::rotate(v,v+2,v+3);
+   }
+   _pa.assign(nn,NONE), _pb.assign(nn,NONE);
+   _ta.resize(nn), _te.resize(ne);
+   std::iota(_ta.begin(),_ta.end(),0);
+   std::iota(_te.begin(),_te.end(),0);
+   _tb = _ta;
+   return 0;
+}
+
+
+/*
+ * Edges of the mesh: ed holds the 2 nodes of each edge, el_ed the edge opposite
+ * to each node of each element and nb_el the number of elements of each edge.
+ */
+void meshAdapt::setEdges(vector<size_t>& ed,
+                         vector<size_t>& el_ed,
+                         vector<int>&    nb_el) const
+{
+   size_t ne = getNbElements();
+   std::unordered_map<uint64_t,size_t> m;
+   m.reserve(3*ne);
+   ed.clear(), nb_el.clear();
+   el_ed.resize(3*ne);
+   for (size_t e=0; e<ne; ++e) {
+      for (int k=0; k<3; ++k) {
+         size_t a=_el[3*e+(k+1)%3], b=_el[3*e+(k+2)%3];
+         if (a>b)
+            std::swap(a,b);
+         auto it = m.emplace(uint64_t(a)<<32|b,ed.size()/2);
+         if (it.second) {
+            ed.push_back(a), ed.push_back(b);
+            nb_el.push_back(0);
+         }
+         el_ed[3*e+k] = it.first->second;
+         nb_el[it.first->second]++;
+      }
+   }
+}
+
+
+void meshAdapt::gradient(size_t                e,
+                         const vector<double>& u,
+                         double&               area,
+                         double                g[2]) const
+{
+   const size_t *v = &_el[3*e];
+   double x[3], y[3];
+   for (int i=0; i<3; ++i)
+      x[i] = _coord[2*v[i]], y[i] = _coord[2*v[i]+1];
+   double d = (x[1]-x[0])*(y[2]-y[0]) - (x[2]-x[0])*(y[1]-y[0]);
+   area = 0.5*fabs(d);
+   g[0] = g[1] = 0.;
+   for (int i=0; i<3; ++i) {
+      int j=(i+1)%3, k=(i+2)%3;
+      g[0] += u[v[i]]*(y[j]-y[k])/d;
+      g[1] += u[v[i]]*(x[k]-x[j])/d;
+   }
+}
+
+
+/*
+ * Element contributions eta of the estimator method (ZZ_ESTIMATOR or
+ * RESIDUAL_ESTIMATOR) for the solution u and the source f (node values, used
+ * by the residual estimator only). Returns the estimate.
+ */
+double meshAdapt::estimate(int                   method,
+                           const vector<double>& u,
+                           const vector<double>& f,
+                           vector<double>&       eta) const
+{
+   size_t nn=getNbNodes(), ne=getNbElements();
+   vector<double> ge(2*ne), area(ne);
+   for (size_t e=0; e<ne; ++e)
+      gradient(e,u,area[e],&ge[2*e]);
+   eta.assign(ne,0.);
+
+   if (method==ZZ_ESTIMATOR) {
+      vector<double> g(2*nn,0.), w(nn,0.);
+      for (size_t e=0; e<ne; ++e) {
+         for (int i=0; i<3; ++i) {
+            size_t n = _el[3*e+i];
+            g[2*n] += area[e]*ge[2*e], g[2*n+1] += area[e]*ge[2*e+1];
+            w[n] += area[e];
+         }
+      }
+      for (size_t n=0; n<nn; ++n) {
+         if (w[n]>0.)
+            g[2*n] /= w[n], g[2*n+1] /= w[n];
+      }
+
+//    Edge midpoint quadrature, exact for the squared linear difference
+      for (size_t e=0; e<ne; ++e) {
+         double s = 0.;
+         for (int i=0; i<3; ++i) {
+            size_t a=_el[3*e+i], b=_el[3*e+(i+1)%3];
+            double dx = 0.5*(g[2*a]+g[2*b]) - ge[2*e], dy = 0.5*(g[2*a+1]+g[2*b+1]) - ge[2*e+1];
+            s += dx*dx + dy*dy;
+         }
+         eta[e] = area[e]*s/3.;
+      }
+   }
+
+   else {
+      vector<size_t> ed, el_ed;
+      vector<int> nb_el;
+      setEdges(ed,el_ed,nb_el);
+      vector<size_t> e1(nb_el.size(),NONE);
+      vector<double> jump(nb_el.size(),0.);
+      for (size_t e=0; e<ne; ++e) {
+         for (int k=0; k<3; ++k) {
+            size_t i = el_ed[3*e+k];
+            if (nb_el[i]!=2)
+               continue;
+            if (e1[i]==NONE) {
+               e1[i] = e;
+               continue;
+            }
+            size_t a=ed[2*i], b=ed[2*i+1];
+            double tx=_coord[2*b]-_coord[2*a], ty=_coord[2*b+1]-_coord[2*a+1];
+            double j = (ge[2*e]-ge[2*e1[i]])*ty - (ge[2*e+1]-ge[2*e1[i]+1])*tx;
+            jump[i] = 0.5*j*j;
+         }
+      }
+      for (size_t e=0; e<ne; ++e) {
+         double h=0., s=0.;
+         for (int i=0; i<3; ++i) {
+            size_t a=_el[3*e+i], b=_el[3*e+(i+1)%3];
+            double dx=_coord[2*a]-_coord[2*b], dy=_coord[2*a+1]-_coord[2*b+1];
+            h = std::max(h,dx*dx+dy*dy);
+            double fm = f.size() ? 0.5*(f[a]+f[b]) : 0.;
+            s += fm*fm;
+            eta[e] += jump[el_ed[3*e+i]];
+         }
+         eta[e] += h*area[e]*s/3.;
+      }
+   }
+
+   double s = 0.;
+   for (size_t e=0; e<ne; ++e) {
+      s += eta[e];
+      eta[e] = sqrt(eta[e]);
+   }
+   return sqrt(s);
+}
+
+
+/*
+ * Energy seminorm of u
+ */
+double meshAdapt::getEnergy(const vector<double>& u) const
+{
+   double s=0., a, g[2];
+   for (size_t e=0; e<getNbElements(); ++e) {
+      gradient(e,u,a,g);
+      s += a*(g[0]*g[0]+g[1]*g[1]);
+   }
+   return sqrt(s);
+}
+
+
+/*
+ * flag is 1 for elements to refine, -1 for elements that can be coarsened
+ */
+void meshAdapt::mark(const vector<double>& eta,
+                     double                theta,
+                     double                coarsen,
+                     vector<int>&          flag) const
+{
+   size_t ne = eta.size();
+   vector<size_t> order(ne);
+   std::iota(order.begin(),order.end(),0);
+   std::sort(order.begin(),order.end(),[&eta](size_t i, size_t j) { return eta[i]>eta[j]; });
+   double total = 0., s = 0.;
+   for (auto v: eta)
+      total += v*v;
+   flag.assign(ne,0);
+   for (size_t i=0; i<ne && s<theta*total; ++i) {
+      flag[order[i]] = 1;
+      s += eta[order[i]]*eta[order[i]];
+   }
+   if (coarsen>0.) {
+      for (size_t e=0; e<ne; ++e) {
+         if (flag[e]==0 && eta[e]*eta[e]<coarsen*total/ne)
+            flag[e] = -1;
+      }
+   }
+}
+
+
+/*
+ * Bisection of the elements with flag>0 and of the elements needed to keep
+ * the mesh conforming. Returns the number of created nodes.
+ */
+size_t meshAdapt::refine(const vector<int>& flag)
+{
+   size_t nn=getNbNodes(), ne=getNbElements(), ns=getNbSides();
+   vector<size_t> ed, el_ed;
+   vector<int> nb_el;
+   setEdges(ed,el_ed,nb_el);
+   size_t ned = nb_el.size();
+   vector<char> cut(ned,0);
+   for (size_t e=0; e<ne; ++e) {
+      if (flag[e]>0)
+         cut[el_ed[3*e]] = 1;
+   }
+
+// Closure: an element with a cut edge has its refinement edge cut
+   for (bool more=true; more;) {
+      more = false;
+      for (size_t e=0; e<ne; ++e) {
+         if (!cut[el_ed[3*e]] && (cut[el_ed[3*e+1]] || cut[el_ed[3*e+2]]))
+            cut[el_ed[3*e]] = 1, more = true;
+      }
+   }
+
+// New nodes at the midpoints of cut edges. Nodes on boundary edges take the
+// codes of the side or, without side, the codes common to both ends
+   std::unordered_map<uint64_t,size_t> mid;
+   _ta.resize(nn), _tb.resize(nn);
+   std::iota(_ta.begin(),_ta.end(),0);
+   _tb = _ta;
+   for (size_t i=0; i<ned; ++i) {
+      if (!cut[i])
+         continue;
+      size_t a=ed[2*i], b=ed[2*i+1], m=getNbNodes();
+      mid[uint64_t(a)<<32|b] = m;
+      _coord.push_back(0.5*(_coord[2*a]+_coord[2*b]));
+      _coord.push_back(0.5*(_coord[2*a+1]+_coord[2*b+1]));
+      for (int k=0; k<_nb_dof; ++k) {
+         int c = _node_code[_nb_dof*a+k];
+         _node_code.push_back((nb_el[i]==1 && c==_node_code[_nb_dof*b+k]) ? c : 0);
+      }
+      _pa.push_back(a), _pb.push_back(b);
+      _ta.push_back(a), _tb.push_back(b);
+   }
+   auto midpoint = [&mid](size_t a, size_t b) {
+      auto it = mid.find(a<b ? uint64_t(a)<<32|b : uint64_t(b)<<32|a);
+      return (it==mid.end()) ? NONE : it->second;
+   };
+
+   vector<size_t> sd;
+   vector<int> sd_code;
+   for (size_t s=0; s<ns; ++s) {
+      size_t a=_sd[2*s], b=_sd[2*s+1], m=midpoint(a,b);
+      const int *c = &_sd_code[_nb_dof*s];
+      if (m==NONE) {
+         sd.push_back(a), sd.push_back(b);
+         sd_code.insert(sd_code.end(),c,c+_nb_dof);
+         continue;
+      }
+      std::copy(c,c+_nb_dof,&_node_code[_nb_dof*m]);
+      for (size_t p: {a,m,m,b})
+         sd.push_back(p);
+      for (int j=0; j<2; ++j)
+         sd_code.insert(sd_code.end(),c,c+_nb_dof);
+   }
+   _sd.swap(sd), _sd_code.swap(sd_code);
+
+// Bisection: [p1,p2,p3] gives [m,p1,p2] and [m,p3,p1], m being the midpoint
+// of the refinement edge p2p3. Children are bisected again if their
+// refinement edge is cut
+   vector<size_t> el;
+   vector<int> el_code;
+   el.reserve(_el.size()+6*mid.size()), _te.clear();
+   for (size_t e=0; e<ne; ++e) {
+      size_t stack[12], top=0;
+      std::copy(&_el[3*e],&_el[3*e]+3,stack);
+      top = 3;
+      while (top) {
+         top -= 3;
+         size_t p1=stack[top], p2=stack[top+1], p3=stack[top+2], m=midpoint(p2,p3);
+         if (m==NONE) {
+            el.push_back(p1), el.push_back(p2), el.push_back(p3);
+            el_code.push_back(_el_code[e]);
+            _te.push_back(e);
+            continue;
+         }
+         size_t c[6] = {m,p3,p1,m,p1,p2};
+         std::copy(c,c+6,stack+top);
+         top += 6;
+      }
+   }
+   _el.swap(el), _el_code.swap(el_code);
+   return mid.size();
+}
+
+
+/*
+ * Removal of the nodes created by bisection whose elements all have flag<0.
+ * Returns the number of removed nodes.
+ */
+size_t meshAdapt::coarsen(const vector<int>& flag)
+{
+   size_t nn=getNbNodes(), ne=getNbElements(), ns=getNbSides();
+   vector<int> valence(nn,0), newest(nn,0);
+   vector<char> marked(nn,1);
+   for (size_t e=0; e<ne; ++e) {
+      for (int i=0; i<3; ++i) {
+         size_t n = _el[3*e+i];
+         valence[n]++;
+         if (flag[e]>=0)
+            marked[n] = 0;
+      }
+      newest[_el[3*e]]++;
+   }
+   vector<char> good(nn,0);
+   for (size_t n=0; n<nn; ++n)
+      good[n] = _pa[n]!=NONE && marked[n] && valence[n]==newest[n] &&
+                (valence[n]==2 || valence[n]==4);
+   vector<vector<size_t> > star(nn);
+   for (size_t e=0; e<ne; ++e) {
+      if (good[_el[3*e]])
+         star[_el[3*e]].push_back(e);
+   }
+
+// Children [m,a,b] and [m,c,a] give back [a,b,c], where b and c are the
+// nodes of the bisected edge
+   vector<size_t> parent(3*ne);
+   vector<char> removed(ne,0), keep(nn,1);
+   for (size_t n=0; n<nn; ++n) {
+      if (!good[n])
+         continue;
+      const vector<size_t>& st = star[n];
+      vector<size_t> p;
+      bool ok = true;
+      for (size_t i=0; i<st.size() && ok; ++i) {
+         const size_t *t1 = &_el[3*st[i]];
+         for (size_t j=0; j<st.size(); ++j) {
+            const size_t *t2 = &_el[3*st[j]];
+            if (j!=i && t1[1]==t2[2] && t1[1]!=_pa[n] && t1[1]!=_pb[n]) {
+               ok = (t1[2]==_pa[n] && t2[1]==_pb[n]) || (t1[2]==_pb[n] && t2[1]==_pa[n]);
+               p.push_back(st[i]), p.push_back(st[j]);
+               break;
+            }
+         }
+      }
+      if (!ok || p.size()!=st.size())
+         continue;
+      for (size_t i=0; i<p.size(); i+=2) {
+         const size_t *t1=&_el[3*p[i]], *t2=&_el[3*p[i+1]];
+         parent[3*p[i]] = t1[1], parent[3*p[i]+1] = t1[2], parent[3*p[i]+2] = t2[1];
+         removed[p[i+1]] = 1;
+      }
+      for (auto e: st) {
+         if (!removed[e])
+            removed[e] = 2;
+      }
+      keep[n] = 0;
+   }
+
+// Renumber nodes
+   vector<size_t> num(nn,NONE);
+   size_t k = 0;
+   _ta.clear();
+   for (size_t n=0; n<nn; ++n) {
+      if (keep[n])
+         num[n] = k++, _ta.push_back(n);
+   }
+   if (k==nn)
+      return 0;
+   _tb = _ta;
+   vector<double> coord(2*k);
+   vector<int> node_code(_nb_dof*k);
+   vector<size_t> pa(k), pb(k);
+   for (size_t n=0; n<nn; ++n) {
+      if (!keep[n])
+         continue;
+      size_t m = num[n];
+      coord[2*m] = _coord[2*n], coord[2*m+1] = _coord[2*n+1];
+      std::copy(&_node_code[_nb_dof*n],&_node_code[_nb_dof*n]+_nb_dof,&node_code[_nb_dof*m]);
+      bool p = _pa[n]!=NONE && keep[_pa[n]] && keep[_pb[n]];
+      pa[m] = p ? num[_pa[n]] : NONE;
+      pb[m] = p ? num[_pb[n]] : NONE;
+   }
+   vector<size_t> el;
+   vector<int> el_code;
+   _te.clear();
+   for (size_t e=0; e<ne; ++e) {
+      if (removed[e]==1)
+         continue;
+      const size_t *v = (removed[e]==2) ? &parent[3*e] : &_el[3*e];
+      for (int i=0; i<3; ++i)
+         el.push_back(num[v[i]]);
+      el_code.push_back(_el_code[e]);
+      _te.push_back(e);
+   }
+
+// Sides [a,m] and [m,b] are merged
+   vector<size_t> sd, other(nn,NONE);
+   vector<int> sd_code;
+   for (size_t s=0; s<ns; ++s) {
+      size_t a=_sd[2*s], b=_sd[2*s+1];
+      if (keep[a] && keep[b]) {
+         sd.push_back(num[a]), sd.push_back(num[b]);
+         sd_code.insert(sd_code.end(),&_sd_code[_nb_dof*s],&_sd_code[_nb_dof*s]+_nb_dof);
+      }
+      else {
+         size_t m=keep[a] ? b : a, q=keep[a] ? a : b;
+         if (other[m]==NONE)
+            other[m] = q;
+         else {
+            sd.push_back(num[other[m]]), sd.push_back(num[q]);
+            sd_code.insert(sd_code.end(),&_sd_code[_nb_dof*s],&_sd_code[_nb_dof*s]+_nb_dof);
+         }
+      }
+   }
+   _coord.swap(coord), _node_code.swap(node_code), _pa.swap(pa), _pb.swap(pb);
+   _el.swap(el), _el_code.swap(el_code), _sd.swap(sd), _sd_code.swap(sd_code);
+   return nn - k;
+}
+
+
+/*
+ * Vector u of the previous mesh (nb values per node) mapped to the current one
+ */
+void meshAdapt::transfer(vector<double>& u,
+                         size_t          nb) const
+{
+   vector<double> v(nb*_ta.size());
+   for (size_t n=0; n<_ta.size(); ++n) {
+      for (size_t k=0; k<nb; ++k)
+         v[nb*n+k] = 0.5*(u[nb*_ta[n]+k] + u[nb*_tb[n]+k]);
+   }
+   u.swap(v);
+}
+
+
+void meshAdapt::transferElement(vector<double>& u,
+                                size_t          nb) const
+{
+   vector<double> v(nb*_te.size());
+   for (size_t e=0; e<_te.size(); ++e) {
+      for (size_t k=0; k<nb; ++k)
+         v[nb*e+k] = u[nb*_te[e]+k];
+   }
+   u.swap(v);
+}
+
+} /* namespace RITA */
@@ -0,0 +1,107 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                         Definition of class 'meshAdapt'
+
+  ==============================================================================*/
+
+
+
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+using std::vector;
+
+namespace RITA {
+
+enum EstimatorType {
+   ZZ_ESTIMATOR       = 0,
+   RESIDUAL_ESTIMATOR = 1
+};
+
+/*
+ * Adaptation of 2-D triangle meshes for P1 finite elements.
+ * Error estimators (element contributions eta_T, the estimate being the
+ * square root of the sum of eta_T^2):
+ *   zz: Zienkiewicz-Zhu gradient recovery, eta_T is the L2 norm on T of the
+ *       difference between the recovered (area averaged) nodal gradient and
+ *       the gradient of the solution,
+ *   residual: h_T^2 ||f||_T^2 + 1/2 sum of h_E ||[du/dn]||_E^2 over the interior
+ *       edges of T, for -Delta u = f.
+ * Marking is the bulk criterion: the elements with the largest contributions
+ * are refined until their sum reaches the fraction theta of the estimate.
+ * Elements with eta_T^2 below coarsen times the mean value are coarsening
+ * candidates.
+ * Refinement is by newest vertex bisection, the first node of each element
+ * being its newest vertex and the opposite edge its refinement edge. The
+ * initial refinement edge is the longest edge. Coarsening removes nodes
+ * created by bisection, whose elements (4 inside the domain, 2 on the
+ * boundary) all have them as newest vertex and are all marked.
+ * Node, element and side numbers are 0-based. After refine or coarsen,
+ * transfer maps vectors of the previous mesh to the new one: linear
+ * interpolation for node vectors, values of the parent or of a child for
+ * element vectors.
+ */
+class meshAdapt
+{
+
+ public:
+
+    meshAdapt();
+    ~meshAdapt() { }
+    int set(int nb_dof, const vector<double>& coord, const vector<size_t>& el_node,
+            const vector<int>& el_code, const vector<int>& node_code,
+            const vector<size_t>& sd_node, const vector<int>& sd_code);
+    double estimate(int method, const vector<double>& u, const vector<double>& f,
+                    vector<double>& eta) const;
+    double getEnergy(const vector<double>& u) const;
+    void mark(const vector<double>& eta, double theta, double coarsen, vector<int>& flag) const;
+    size_t refine(const vector<int>& flag);
+    size_t coarsen(const vector<int>& flag);
+    void transfer(vector<double>& u, size_t nb) const;
+    void transferElement(vector<double>& u, size_t nb) const;
+    size_t getNbNodes() const { return _coord.size()/2; }
+    size_t getNbElements() const { return _el.size()/3; }
+    size_t getNbSides() const { return _sd.size()/2; }
+    const vector<double>& getCoord() const { return _coord; }
+    const vector<size_t>& getElements() const { return _el; }
+    const vector<size_t>& getSides() const { return _sd; }
+    const vector<int>& getNodeCodes() const { return _node_code; }
+    const vector<int>& getElementCodes() const { return _el_code; }
+    const vector<int>& getSideCodes() const { return _sd_code; }
+
+ private:
+
+    int _nb_dof;
+    vector<double> _coord;
+    vector<size_t> _el, _sd, _pa, _pb, _ta, _tb, _te;
+    vector<int> _el_code, _node_code, _sd_code;
+
+    void setEdges(vector<size_t>& ed, vector<size_t>& el_ed, vector<int>& nb_el) const;
+    void gradient(size_t e, const vector<double>& u, double& area, double g[2]) const;
+};
+
+} /* namespace RITA */
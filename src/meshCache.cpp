@@ -0,0 +1,176 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Implementation of class 'meshCache'
+
+  ==============================================================================*/
+
+
+
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "meshCache.h"
+
+namespace RITA {
+
+struct Header {
+   char     magic[8];
+   int32_t  version, dim, nb_dof, pad;
+   uint64_t desc, nn, ne, nen, ns, nsn;
+};
+
+static const char MAGIC[8] = {'R','I','T','A','M','S','H','\0'};
+
+
+string meshCache::key(const string& desc)
+{
+   uint64_t h = 14695981039346656037ULL;
+   for (unsigned char c: desc)
+      h = (h^c)*1099511628211ULL;
+   char s[17];
+   snprintf(s,sizeof(s),"%016llx",(unsigned long long)h);
+   return s;
+}
+
+
+/*
+ * Cache file of a key. The directory is created if needed. $HOME/.rita is
+ * the configuration file, hence the directory name. Returns an empty string
+ * if HOME is not set: the mesh is then not cached.
+ */
+string meshCache::path(const string& key)
+{
+   const char *home = getenv("HOME");
+   if (home==nullptr)
+      return "";
+   string dir = string(home) + "/.rita.cache";
+   mkdir(dir.c_str(),0755);
+   return dir + "/" + key + ".bin";
+}
+
+
+/*
+ * Write to a temporary file renamed at the end, so that a concurrent run never
+ * maps an incomplete file.
+ */
+int meshCache::save(const string& file,
+                    const string& desc) const
+{
+   Header h;
+   memcpy(h.magic,MAGIC,8);
+   h.version = 1, h.dim = dim, h.nb_dof = nb_dof, h.pad = 0;
+   h.desc = desc.size();
+   h.nn = coord.size()/3, h.ne = el_shape.size(), h.nen = el_node.size();
+   h.ns = sd_shape.size(), h.nsn = sd_node.size();
+   if (el_ptr.size()!=h.ne+1 || sd_ptr.size()!=h.ns+1 || node_code.size()!=h.nn*nb_dof ||
+       el_code.size()!=h.ne || sd_code.size()!=h.ns*nb_dof)
+      return 1;
+   string tmp = file + "." + std::to_string(getpid());
+   FILE *fp = fopen(tmp.c_str(),"wb");
+   if (fp==nullptr)
+      return 1;
+   vector<uint64_t> p;
+   auto put = [fp](const void *a, size_t n) { return n==0 || fwrite(a,1,n,fp)==n; };
+   auto put64 = [&](const vector<size_t>& v) {
+      p.assign(v.begin(),v.end());
+      return put(p.data(),8*p.size());
+   };
+   const char zero[8] = {0};
+   bool ok = put(&h,sizeof(h)) && put(desc.data(),desc.size()) && put(zero,(8-desc.size()%8)%8)
+          && put(coord.data(),8*coord.size()) && put64(el_ptr) && put64(el_node)
+          && put64(sd_ptr) && put64(sd_node)
+          && put(node_code.data(),4*node_code.size()) && put(el_shape.data(),4*h.ne)
+          && put(el_code.data(),4*h.ne) && put(sd_shape.data(),4*h.ns)
+          && put(sd_code.data(),4*sd_code.size());
+   if (fclose(fp) || !ok || rename(tmp.c_str(),file.c_str())) {
+      remove(tmp.c_str());
+      return 1;
+   }
+   return 0;
+}
+
+
+/*
+ * Returns 0 if file holds a mesh of the description desc, 1 otherwise.
+ */
+int meshCache::load(const string& file,
+                    const string& desc)
+{
+   int fd = open(file.c_str(),O_RDONLY);
+   if (fd<0)
+      return 1;
+   struct stat st;
+   if (fstat(fd,&st) || size_t(st.st_size)<sizeof(Header)) {
+      close(fd);
+      return 1;
+   }
+   size_t size = st.st_size;
+   void *m = mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fd,0);
+   close(fd);
+   if (m==MAP_FAILED)
+      return 1;
+   const char *b = static_cast<const char *>(m);
+   Header h;
+   memcpy(&h,b,sizeof(h));
+   size_t off = sizeof(h) + h.desc + (8-h.desc%8)%8;
+   size_t need = off + 8*(3*h.nn+h.ne+1+h.nen+h.ns+1+h.nsn) + 4*(h.nb_dof*(h.nn+h.ns)+2*h.ne+h.ns);
+   int ret = 1;
+   if (memcmp(h.magic,MAGIC,8)==0 && h.version==1 && h.nb_dof>0 && need==size &&
+       h.desc==desc.size() && memcmp(b+sizeof(h),desc.data(),h.desc)==0) {
+      auto get64 = [&](vector<size_t>& v, size_t n) {
+         const uint64_t *q = reinterpret_cast<const uint64_t *>(b+off);
+         v.assign(q,q+n);
+         off += 8*n;
+      };
+      auto get32 = [&](vector<int>& v, size_t n) {
+         const int32_t *q = reinterpret_cast<const int32_t *>(b+off);
+         v.assign(q,q+n);
+         off += 4*n;
+      };
+      dim = h.dim, nb_dof = h.nb_dof;
+      const double *x = reinterpret_cast<const double *>(b+off);
+      coord.assign(x,x+3*h.nn);
+      off += 24*h.nn;
+      get64(el_ptr,h.ne+1), get64(el_node,h.nen);
+      get64(sd_ptr,h.ns+1), get64(sd_node,h.nsn);
+      get32(node_code,h.nb_dof*h.nn), get32(el_shape,h.ne), get32(el_code,h.ne);
+      get32(sd_shape,h.ns), get32(sd_code,h.nb_dof*h.ns);
+      ret = (el_ptr.back()==h.nen && sd_ptr.back()==h.nsn) ? 0 : 1;
+      for (size_t i=0; i<h.nen && !ret; ++i)
+         ret = el_node[i]>=h.nn;
+      for (size_t i=0; i<h.nsn && !ret; ++i)
+         ret = sd_node[i]>=h.nn;
+   }
+   munmap(m,size);
+   return ret;
+}
+
+} /* namespace RITA */
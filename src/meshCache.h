@@ -0,0 +1,72 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                         Definition of class 'meshCache'
+
+  ==============================================================================*/
+
+
+
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+using std::vector;
+using std::string;
+
+namespace RITA {
+
+/*
+ * Binary cache of generated meshes.
+ * A mesh is stored in $HOME/.rita.cache/<key>.bin (nothing if HOME is not
+ * set or with set mesh-cache=0) where key is a 64-bit
+ * FNV-1a hash of a normalized description of the geometry and generator
+ * settings. The description is also stored in the file and compared on
+ * loading, so that a hash collision only causes a regeneration.
+ * The file is a 64-byte header followed by the arrays below, 8-byte arrays
+ * first, so that it can be mapped in memory and read without parsing.
+ * Node, element and side numbers are 0-based.
+ */
+class meshCache
+{
+
+ public:
+
+    meshCache() : dim(0), nb_dof(0) { }
+    ~meshCache() { }
+    static string key(const string& desc);
+    static string path(const string& key);
+    int save(const string& file, const string& desc) const;
+    int load(const string& file, const string& desc);
+
+    int dim, nb_dof;
+    vector<double> coord;                           // 3 per node
+    vector<size_t> el_ptr, el_node, sd_ptr, sd_node;
+    vector<int> node_code, el_shape, el_code;       // nb_dof codes per node
+    vector<int> sd_shape, sd_code;                  // nb_dof codes per side
+};
+
+} /* namespace RITA */
@@ -0,0 +1,779 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                      Implementation of class 'meshReader'
+
+  ==============================================================================*/
+
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <limits>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#if __cplusplus>=201703L
+#include <charconv>
+#endif
+#include "meshReader.h"
+#include "OFELI_Config.h"
+
+namespace RITA {
+
+static const size_t none = size_t(-1);
+
+static inline bool IsSpace(char c)
+{
+   return c==' ' || c=='\n' || c=='\r' || c=='\t' || c=='\f' || c=='\v';
+}
+
+
+/*
+ * Parsing of the number [b,e): std::from_chars where available, otherwise
+ * an exact fast path for at most 19 significant digits and a power of 10
+ * exactly representable (Clinger), strtod for the other numbers
+ */
+static bool ParseDouble(const char* b,
+                        const char* e,
+                        double&     x)
+{
+   if (b<e && *b=='+')
+      b++;
+#if defined(__cpp_lib_to_chars)
+   auto r = std::from_chars(b,e,x);
+   return r.ec==std::errc() && r.ptr==e;
+#else
+   static const double p10[] = {1.e0,1.e1,1.e2,1.e3,1.e4,1.e5,1.e6,1.e7,1.e8,1.e9,1.e10,1.e11,
+                                1.e12,1.e13,1.e14,1.e15,1.e16,1.e17,1.e18,1.e19,1.e20,1.e21,1.e22};
+   const char *p = b;
+   bool neg=false, exact=true, digits=false;
+   if (p<e && *p=='-')
+      neg = true, p++;
+   uint64_t m = 0;
+   int nd=0, ex=0;
+   for (; p<e && *p>='0' && *p<='9'; ++p) {
+      digits = true;
+      if (nd<19) {
+         m = 10*m + (*p-'0');
+         nd += (m>0);
+      }
+      else
+         ex++, exact = exact && (*p=='0');
+   }
+   if (p<e && *p=='.') {
+      for (++p; p<e && *p>='0' && *p<='9'; ++p) {
+         digits = true;
+         if (nd<19) {
+            m = 10*m + (*p-'0');
+            nd += (m>0);
+            ex--;
+         }
+         else
+            exact = exact && (*p=='0');
+      }
+   }
+   if (!digits)
+      return false;
+   if (p<e && (*p=='e' || *p=='E')) {
+      bool en = false;
+      if (++p<e && (*p=='-' || *p=='+'))
+         en = (*p++=='-');
+      if (p==e)
+         return false;
+      int v = 0;
+      for (; p<e && *p>='0' && *p<='9'; ++p)
+         v = std::min(10*v + (*p-'0'),100000);
+      ex += en ? -v : v;
+   }
+   if (p!=e)
+      return false;
+   if (exact && m<(uint64_t(1)<<53) && ex>=-22 && ex<=22) {
+      x = (ex<0) ? double(m)/p10[-ex] : double(m)*p10[ex];
+      if (neg)
+         x = -x;
+      return true;
+   }
+   string s(b,e);
+   char *q;
+   x = strtod(s.c_str(),&q);
+   return *q=='\0';
+#endif
+}
+
+
+static bool ParseLong(const char* b,
+                      const char* e,
+                      long&       i)
+{
+   bool neg = false;
+   if (b<e && (*b=='-' || *b=='+'))
+      neg = (*b++=='-');
+   if (b==e)
+      return false;
+   i = 0;
+   for (; b<e; ++b) {
+      if (*b<'0' || *b>'9')
+         return false;
+      i = 10*i + (*b-'0');
+   }
+   if (neg)
+      i = -i;
+   return true;
+}
+
+
+/*
+ * Shapes of the OFELI mesh file and codes of the degrees of freedom, given as
+ * the digits of the code of a node or side
+ */
+static int Shape(string s)
+{
+   static const std::map<string,int> shape {{"line",OFELI::LINE},{"tria",OFELI::TRIANGLE},
+                                            {"quad",OFELI::QUADRILATERAL},{"tetr",OFELI::TETRAHEDRON},
+                                            {"hexa",OFELI::HEXAHEDRON},{"pent",OFELI::PENTAHEDRON},
+                                            {"pris",OFELI::PENTAHEDRON}};
+   std::transform(s.begin(),s.end(),s.begin(),::tolower);
+   auto it = shape.find(s.substr(0,4));
+   return (it==shape.end()) ? 0 : it->second;
+}
+
+
+static void Codes(long         mark,
+                  int          nb_dof,
+                  vector<int>& code)
+{
+   size_t k = code.size();
+   code.resize(k+nb_dof);
+   if (nb_dof==1) {
+      code[k] = int(mark);
+      return;
+   }
+   for (int i=nb_dof-1; i>=0; --i, mark/=10)
+      code[k+i] = int(mark%10);
+}
+
+
+/*
+ * gmsh element types: number of nodes, dimension and OFELI shape (0 for the
+ * types that are not OFELI elements: points, pyramids, high order elements)
+ */
+static const int GmshType[32][3] = {{0,0,0},
+   {2,1,OFELI::LINE},{3,2,OFELI::TRIANGLE},{4,2,OFELI::QUADRILATERAL},{4,3,OFELI::TETRAHEDRON},
+   {8,3,OFELI::HEXAHEDRON},{6,3,OFELI::PENTAHEDRON},{5,3,0},{3,1,0},{6,2,0},{9,2,0},{10,3,0},{27,3,0},
+   {18,3,0},{14,3,0},{1,0,0},{8,2,0},{20,3,0},{15,3,0},{13,3,0},{9,2,0},{10,2,0},{12,2,0},{15,2,0},
+   {15,2,0},{21,2,0},{4,1,0},{5,1,0},{6,1,0},{20,3,0},{35,3,0},{56,3,0}};
+
+
+meshReader::meshReader(size_t chunk)
+           : _fp(nullptr), _buf(std::max(chunk,size_t(4096))), _p(nullptr), _end(nullptr), _eof(true),
+             _size(0), _memory(0), _time(0.)
+{
+}
+
+
+meshReader::~meshReader()
+{
+   if (_fp)
+      fclose(_fp);
+}
+
+
+int meshReader::error(const string& s)
+{
+   _error = s;
+   return 1;
+}
+
+
+/*
+ * Next chunk of the file after the unread part of the buffer, false at the
+ * end of the file
+ */
+bool meshReader::more()
+{
+   if (_eof)
+      return false;
+   size_t r = _end - _p;
+   if (r==_buf.size())
+      return false;
+   memmove(&_buf[0],_p,r);
+   size_t n = fread(&_buf[r],1,_buf.size()-r,_fp);
+   _p = &_buf[0];
+   _end = _p + r + n;
+   _eof = (n==0);
+   return n>0;
+}
+
+
+/*
+ * Next word [b,e) of the file
+ */
+bool meshReader::token(const char*& b,
+                       const char*& e)
+{
+   for (;;) {
+      while (_p<_end && IsSpace(*_p))
+         _p++;
+      if (_p==_end) {
+         if (!more())
+            return false;
+         continue;
+      }
+      char *q = _p;
+      while (q<_end && !IsSpace(*q))
+         q++;
+      if (q==_end && !_eof) {
+         if (!more())
+            return false;
+         continue;
+      }
+      b = _p, e = q;
+      _p = q;
+      return true;
+   }
+}
+
+
+bool meshReader::get(double& x)
+{
+   const char *b, *e;
+   return token(b,e) && ParseDouble(b,e,x);
+}
+
+
+bool meshReader::get(long& i)
+{
+   const char *b, *e;
+   return token(b,e) && ParseLong(b,e,i);
+}
+
+
+bool meshReader::get(string& s)
+{
+   const char *b, *e;
+   if (!token(b,e))
+      return false;
+   s.assign(b,e);
+   return true;
+}
+
+
+bool meshReader::getBytes(void*  x,
+                          size_t n)
+{
+   if (size_t(_end-_p)>=n) {
+      memcpy(x,_p,n);
+      _p += n;
+      return true;
+   }
+   char *q = static_cast<char *>(x);
+   while (n>0) {
+      if (_p==_end && !more())
+         return false;
+      size_t k = std::min(n,size_t(_end-_p));
+      memcpy(q,_p,k);
+      q += k, _p += k, n -= k;
+   }
+   return true;
+}
+
+
+/*
+ * Skipping of the file up to the end of the string s
+ */
+bool meshReader::skip(const string& s)
+{
+   for (;;) {
+      char *q = std::search(_p,_end,s.begin(),s.end());
+      if (q!=_end) {
+         _p = q + s.size();
+         return true;
+      }
+      _p = std::max(_p,_end-s.size()+1);
+      if (!more())
+         return false;
+   }
+}
+
+
+/*
+ * Next XML tag: name and pairs of attribute names and values
+ */
+bool meshReader::tag(string&         name,
+                     vector<string>& att)
+{
+   const char *b, *e;
+   do {
+      if (!token(b,e))
+         return false;
+   } while (*b!='<');
+   att.clear();
+   bool end = false;
+   for (bool first=true; !end; first=false) {
+      if (!first && !token(b,e))
+         return false;
+      string s(b,e);
+      end = (s.back()=='>');
+      while (s.size() && (s.back()=='>' || s.back()=='/' || s.back()=='?'))
+         s.pop_back();
+      if (first)
+         name = s.substr(1);
+      else {
+         size_t i = s.find('=');
+         if (i==string::npos)
+            continue;
+         string v = s.substr(i+1);
+         v.erase(std::remove(v.begin(),v.end(),'"'),v.end());
+         att.push_back(s.substr(0,i));
+         att.push_back(v);
+      }
+   }
+   return true;
+}
+
+
+int meshReader::read(const string& file,
+                     meshCache&    c,
+                     int           nb_dof)
+{
+   auto t0 = std::chrono::steady_clock::now();
+   _error = "";
+   if (_fp)
+      fclose(_fp);
+   _fp = fopen(file.c_str(),"rb");
+   if (_fp==nullptr)
+      return error("Unable to open file: "+file);
+   fseek(_fp,0,SEEK_END);
+   _size = ftell(_fp);
+   fseek(_fp,0,SEEK_SET);
+   _p = _end = &_buf[0];
+   _eof = false;
+   c = meshCache();
+   const char *b, *e;
+   int ret = 1;
+   if (!token(b,e))
+      ret = error("Empty file: "+file);
+   else {
+      _p = const_cast<char *>(b);
+      if (*b=='$')
+         ret = readGmsh(c,nb_dof);
+      else if (*b=='<')
+         ret = readOFELI(c);
+      else
+         ret = error("Unknown format of file: "+file);
+   }
+   fclose(_fp);
+   _fp = nullptr;
+   _memory = _buf.size() + sizeof(double)*c.coord.capacity() +
+             sizeof(size_t)*(c.el_ptr.capacity()+c.el_node.capacity()+c.sd_ptr.capacity()+c.sd_node.capacity()) +
+             sizeof(int)*(c.node_code.capacity()+c.el_shape.capacity()+c.el_code.capacity()+
+                          c.sd_shape.capacity()+c.sd_code.capacity());
+   _time = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+   if (ret)
+      c = meshCache();
+   return ret;
+}
+
+
+int meshReader::readOFELI(meshCache& c)
+{
+   string name;
+   vector<string> att;
+   auto value = [&att](const string& key, int def) {
+      for (size_t i=0; i<att.size(); i+=2)
+         if (att[i]==key)
+            return atoi(att[i+1].c_str());
+      return def;
+   };
+   const char *b, *e;
+   c.dim = 0, c.nb_dof = 1;
+   c.el_ptr.assign(1,0), c.sd_ptr.assign(1,0);
+   while (tag(name,att)) {
+      if (name=="Mesh") {
+         c.dim = value("dim",0), c.nb_dof = value("nb_dof",1);
+         if (c.dim<1 || c.dim>3 || c.nb_dof<1 || c.nb_dof>9)
+            return error("Illegal dimension or number of degrees of freedom.");
+      }
+
+//    Nodes: dim coordinates and a code
+      else if (name=="Nodes") {
+         if (c.dim==0)
+            return error("Nodes given before the mesh dimension.");
+         for (;;) {
+            if (!token(b,e))
+               return error("Unexpected end of file in nodes.");
+            if (*b=='<')
+               break;
+            double x[3] = {0.,0.,0.};
+            long code;
+            bool ok = ParseDouble(b,e,x[0]);
+            for (int a=1; a<c.dim && ok; ++a)
+               ok = get(x[a]);
+            if (!ok || !get(code))
+               return error("Error in nodes.");
+            c.coord.insert(c.coord.end(),x,x+3);
+            Codes(code,c.nb_dof,c.node_code);
+         }
+      }
+
+//    Elements and sides: node numbers and a code
+      else if (name=="Elements" || name=="Sides") {
+         bool el = (name=="Elements");
+         int shape=0, m=value("nodes",0);
+         for (size_t i=0; i<att.size(); i+=2)
+            if (att[i]=="shape")
+               shape = Shape(att[i+1]);
+         if (shape==0 || m<=0)
+            return error("Unknown shape or number of nodes of "+name+".");
+         vector<size_t> &ptr=el ? c.el_ptr : c.sd_ptr, &nd=el ? c.el_node : c.sd_node;
+         for (;;) {
+            if (!token(b,e))
+               return error("Unexpected end of file in "+name+".");
+            if (*b=='<')
+               break;
+            long n, code;
+            bool ok = ParseLong(b,e,n) && n>0;
+            nd.push_back(n-1);
+            for (int i=1; i<m && ok; ++i) {
+               ok = get(n) && n>0;
+               nd.push_back(n-1);
+            }
+            if (!ok || !get(code))
+               return error("Error in "+name+".");
+            ptr.push_back(nd.size());
+            if (el) {
+               c.el_shape.push_back(shape);
+               c.el_code.push_back(int(code));
+            }
+            else {
+               c.sd_shape.push_back(shape);
+               Codes(code,c.nb_dof,c.sd_code);
+            }
+         }
+      }
+   }
+   size_t nn = c.coord.size()/3;
+   if (nn==0)
+      return error("Mesh has no nodes.");
+   for (size_t i=0; i<c.el_node.size(); ++i)
+      if (c.el_node[i]>=nn)
+         return error("Element with a node number larger than the number of nodes.");
+   for (size_t i=0; i<c.sd_node.size(); ++i)
+      if (c.sd_node[i]>=nn)
+         return error("Side with a node number larger than the number of nodes.");
+   return 0;
+}
+
+
+int meshReader::readGmsh(meshCache& c,
+                         int        nb_dof)
+{
+   string s;
+   double version;
+   long ft, ds;
+   if (!get(s) || s!="$MeshFormat" || !get(version) || !get(ft) || !get(ds))
+      return error("Error in gmsh mesh format.");
+   int v = int(10.*version+0.5);
+   bool bin = (ft==1);
+   if (v!=22 && v!=41)
+      return error("Unsupported gmsh format "+std::to_string(version)+": only formats 2.2 and 4.1 are read.");
+   if (bin && (v!=41 || (ds!=4 && ds!=8)))
+      return error("Binary gmsh files are only read in format 4.1.");
+   if (bin) {
+      int32_t one = 0;
+      if (!skip("\n") || !getBytes(&one,4) || one!=1)
+         return error("Binary gmsh file of another byte order.");
+   }
+   if (!skip("$EndMeshFormat"))
+      return error("Error in gmsh mesh format.");
+
+// Integers, sizes and reals of the ASCII or binary file
+   auto getInt = [&](long& i) {
+      if (!bin)
+         return get(i);
+      int32_t j;
+      bool ok = getBytes(&j,4);
+      i = j;
+      return ok;
+   };
+   auto getSize = [&](long& i) {
+      if (!bin)
+         return get(i);
+      bool ok;
+      if (ds==8) {
+         uint64_t j;
+         ok = getBytes(&j,8), i = long(j);
+      }
+      else {
+         uint32_t j;
+         ok = getBytes(&j,4), i = long(j);
+      }
+      return ok;
+   };
+   auto getReal = [&](double& x) {
+      return bin ? getBytes(&x,8) : get(x);
+   };
+
+// Node tags: node index tag-min_tag as long as tags are consecutive, then a map
+   long min_tag=1, max_tag=-1;
+   size_t nn = 0;
+   bool consecutive = true;
+   vector<size_t> index;
+   auto setIndex = [&](long t, size_t k) {
+      if (t<min_tag || (max_tag>=0 && t>max_tag))
+         return false;
+      if (consecutive && size_t(t-min_tag)==k)
+         return true;
+      if (consecutive) {
+         consecutive = false;
+         index.assign(max_tag>=0 ? max_tag-min_tag+1 : k,none);
+         for (size_t j=0; j<k; ++j)
+            index[j] = j;
+      }
+      if (size_t(t-min_tag)>=index.size())
+         index.resize(t-min_tag+1,none);
+      index[t-min_tag] = k;
+      return true;
+   };
+   auto getIndex = [&](long t) {
+      if (t<min_tag)
+         return none;
+      size_t i = t - min_tag;
+      if (consecutive)
+         return (i<nn) ? i : none;
+      return (i<index.size()) ? index[i] : none;
+   };
+
+// Elements by dimension; below the largest dimension, only those of physical
+// entities are kept
+   struct Block {
+      vector<size_t> ptr, node;
+      vector<int> shape, code;
+   } blk[4];
+   for (int d=0; d<4; ++d)
+      blk[d].ptr.assign(1,0);
+   std::map<std::pair<long,long>,int> phys;
+   vector<int> ncode;
+   long ne=0, nr=0;
+   int top = 0;
+   auto addElement = [&](int type, int d, int code, const vector<size_t>& en) {
+      int shape = GmshType[type][2];
+      if (d==0) {
+         if (code)
+            ncode[en[0]] = code;
+         return;
+      }
+      if (shape==0 || (d<top && code==0))
+         return;
+      top = std::max(top,d);
+      Block &b = blk[d];
+      if (b.shape.size()==b.shape.capacity()) {
+         size_t n = b.shape.size(), m = std::max(n+1,std::min(2*n,n+size_t(nr)));
+         b.shape.reserve(m), b.code.reserve(m), b.ptr.reserve(m+1), b.node.reserve(m*en.size());
+      }
+      b.node.insert(b.node.end(),en.begin(),en.end());
+      b.ptr.push_back(b.node.size());
+      b.shape.push_back(shape);
+      b.code.push_back(code);
+   };
+
+   while (get(s)) {
+
+//    Physical tags of entities
+      if (s=="$Entities" && v==41) {
+         if (bin && !skip("\n"))
+            return error("Error in gmsh entities.");
+         long n[4], t, np, p, nb;
+         for (int d=0; d<4; ++d)
+            if (!getSize(n[d]))
+               return error("Error in gmsh entities.");
+         for (int d=0; d<4; ++d) {
+            for (long i=0; i<n[d]; ++i) {
+               double x;
+               bool ok = getInt(t);
+               for (int j=0; j<(d ? 6 : 3) && ok; ++j)
+                  ok = getReal(x);
+               ok = ok && getSize(np);
+               for (long j=0; j<np && ok; ++j) {
+                  ok = getInt(p);
+                  if (j==0)
+                     phys[{d,t}] = int(p);
+               }
+               if (d>0) {
+                  ok = ok && getSize(nb);
+                  for (long j=0; j<nb && ok; ++j)
+                     ok = getInt(p);
+               }
+               if (!ok)
+                  return error("Error in gmsh entities.");
+            }
+         }
+         if (!skip("$EndEntities"))
+            return error("Error in gmsh entities.");
+      }
+
+//    Nodes, stored as they are read in the arrays allocated from the header
+      else if (s=="$Nodes") {
+         if (bin && !skip("\n"))
+            return error("Error in gmsh nodes.");
+         long nb=1, n=0, t;
+         if (v==41) {
+            if (!getSize(nb) || !getSize(n) || !getSize(min_tag) || !getSize(max_tag))
+               return error("Error in gmsh nodes.");
+         }
+         else if (!get(n))
+            return error("Error in gmsh nodes.");
+         c.coord.assign(3*n,0.);
+         ncode.assign(n,0);
+         for (long k=0; k<nb; ++k) {
+            long ed=0, et=0, par=0, m=n;
+            if (v==41 && (!getInt(ed) || !getInt(et) || !getInt(par) || !getSize(m)))
+               return error("Error in gmsh nodes.");
+            if (size_t(m)>size_t(n)-nn)
+               return error("More gmsh nodes than given in the header.");
+            int code = 0;
+            auto it = phys.find({ed,et});
+            if (ed==0 && it!=phys.end())
+               code = it->second;
+            for (long i=0; i<m; ++i) {
+               double x[3];
+               if (v==41) {
+                  if (!getSize(t) || !setIndex(t,nn+i))
+                     return error("Error in gmsh node tags.");
+               }
+               else if (!get(t) || !setIndex(t,nn+i) || !get(x[0]) || !get(x[1]) || !get(x[2]))
+                  return error("Error in gmsh nodes.");
+               else {
+                  for (int a=0; a<3; ++a)
+                     c.coord[3*(nn+i)+a] = x[a];
+               }
+            }
+            for (long i=0; i<m && v==41; ++i) {
+               double x;
+               for (int a=0; a<3+(par ? ed : 0); ++a) {
+                  if (!getReal(x))
+                     return error("Error in gmsh nodes.");
+                  if (a<3)
+                     c.coord[3*(nn+i)+a] = x;
+               }
+               ncode[nn+i] = code;
+            }
+            nn += m;
+         }
+         if (nn!=size_t(n) || !skip("$EndNodes"))
+            return error("Error in gmsh nodes.");
+      }
+
+//    Elements
+      else if (s=="$Elements") {
+         if (bin && !skip("\n"))
+            return error("Error in gmsh elements.");
+         long nb=1, t, tmin, tmax;
+         vector<size_t> en;
+         if (v==41) {
+            if (!getSize(nb) || !getSize(ne) || !getSize(tmin) || !getSize(tmax))
+               return error("Error in gmsh elements.");
+         }
+         else if (!get(ne))
+            return error("Error in gmsh elements.");
+         nr = ne;
+         for (long k=0; k<nb; ++k) {
+            long ed=0, et=0, type=0, m=ne;
+            if (v==41) {
+               if (!getInt(ed) || !getInt(et) || !getInt(type) || !getSize(m))
+                  return error("Error in gmsh elements.");
+               if (type<1 || type>31)
+                  return error("Unknown gmsh element type "+std::to_string(type)+".");
+            }
+            auto it = phys.find({ed,et});
+            int code = (it==phys.end()) ? 0 : it->second;
+            for (long i=0; i<m; ++i) {
+               if (v==22) {
+                  long nt, p;
+                  if (!get(t) || !get(type) || !get(nt) || type<1 || type>31)
+                     return error("Error in gmsh elements.");
+                  code = 0, ed = GmshType[type][1];
+                  for (long j=0; j<nt; ++j) {
+                     if (!get(p))
+                        return error("Error in gmsh elements.");
+                     if (j==0)
+                        code = int(p);
+                  }
+               }
+               else if (!getSize(t))
+                  return error("Error in gmsh elements.");
+               en.resize(GmshType[type][0]);
+               for (auto &j: en) {
+                  if (!getSize(t) || (j=getIndex(t))==none)
+                     return error("Element with an unknown gmsh node.");
+               }
+               addElement(int(type),int(ed),code,en);
+               nr--;
+            }
+         }
+         if (!skip("$EndElements"))
+            return error("Error in gmsh elements.");
+      }
+
+//    Other sections are skipped
+      else if (s.size()>1 && s[0]=='$' && s.compare(0,4,"$End")) {
+         if (!skip("$End"+s.substr(1)))
+            return error("Unterminated gmsh section "+s+".");
+      }
+   }
+   index.clear(), index.shrink_to_fit();
+   if (nn==0 || top==0)
+      return error("gmsh mesh with no nodes or no elements.");
+
+// Elements of the largest dimension, sides of physical entities below, and
+// codes of nodes of sides
+   c.dim = top;
+   c.nb_dof = nb_dof;
+   c.el_ptr.swap(blk[top].ptr), c.el_node.swap(blk[top].node);
+   c.el_shape.swap(blk[top].shape), c.el_code.swap(blk[top].code);
+   for (auto &k: c.el_code)
+      k = k ? k : 1;
+   Block &b = blk[top-1];
+   c.sd_ptr.assign(1,0);
+   for (size_t i=0; i+1<b.ptr.size(); ++i) {
+      if (b.code[i]==0)
+         continue;
+      c.sd_node.insert(c.sd_node.end(),b.node.begin()+b.ptr[i],b.node.begin()+b.ptr[i+1]);
+      c.sd_ptr.push_back(c.sd_node.size());
+      c.sd_shape.push_back(b.shape[i]);
+      c.sd_code.insert(c.sd_code.end(),nb_dof,b.code[i]);
+      for (size_t j=b.ptr[i]; j<b.ptr[i+1]; ++j)
+         if (ncode[b.node[j]]==0)
+            ncode[b.node[j]] = b.code[i];
+   }
+   for (int d=0; d<4; ++d)
+      blk[d] = Block();
+   c.node_code.resize(nb_dof*nn);
+   for (size_t n=0; n<nn; ++n)
+      for (int k=0; k<nb_dof; ++k)
+         c.node_code[nb_dof*n+k] = ncode[n];
+   return 0;
+}
+
+} /* namespace RITA */
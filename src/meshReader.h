@@ -0,0 +1,92 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                         Definition of class 'meshReader'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include "meshCache.h"
+using std::vector;
+using std::string;
+
+namespace RITA {
+
+/*
+ * Streaming reader of mesh files in the arrays of a meshCache: OFELI mesh
+ * files (.m) and gmsh files (.msh) in format 2.2 (ASCII) or 4.1 (ASCII or
+ * binary).
+ * The file is read in chunks of fixed size, numbers being parsed in place
+ * in the buffer, so that the file is never held in memory. Arrays are
+ * allocated from the counts of the gmsh headers (OFELI files give no counts).
+ * As the OFELI mesh built from these arrays is about 5 times larger, reading
+ * a mesh needs about 1.2 times its final memory when the arrays are released
+ * while it is built.
+ * gmsh meshes follow the rules of the gmsh API reader: elements have the
+ * largest dimension, sides are the elements of lower dimension on physical
+ * entities, and elements and sides take the tag of the physical group of
+ * their entity. Nodes take the tags of physical points or, if they have
+ * none, of the sides they belong to.
+ */
+class meshReader
+{
+
+ public:
+
+    meshReader(size_t chunk=size_t(1)<<22);
+    ~meshReader();
+    int read(const string& file, meshCache& c, int nb_dof=1);
+    size_t getSize() const { return _size; }
+    double getTime() const { return _time; }
+    double getRate() const { return (_time>0.) ? _size/1048576./_time : 0.; }
+    size_t getMemory() const { return _memory; }
+    const string& getError() const { return _error; }
+
+ private:
+
+    FILE *_fp;
+    vector<char> _buf;
+    char *_p, *_end;
+    bool _eof;
+    size_t _size, _memory;
+    double _time;
+    string _error;
+
+    bool more();
+    bool token(const char*& b, const char*& e);
+    bool get(double& x);
+    bool get(long& i);
+    bool get(string& s);
+    bool getBytes(void* x, size_t n);
+    bool skip(const string& s);
+    bool tag(string& name, vector<string>& att);
+    int error(const string& s);
+    int readOFELI(meshCache& c);
+    int readGmsh(meshCache& c, int nb_dof);
+};
+
+} /* namespace RITA */
@@ -0,0 +1,381 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                      Implementation of class 'meshTransfer'
+
+  ==============================================================================*/
+
+#include <math.h>
+#include <algorithm>
+#include "meshTransfer.h"
+#include "parallel.h"
+
+namespace RITA {
+
+typedef double Simplex[4][3];
+
+/*
+ * Splitting of element e in simplices, returns their number
+ */
+static int Split(const spatialIndex& ms,
+                 size_t              e,
+                 Simplex*            s)
+{
+   static const int tri[2][3] = {{0,1,2},{0,2,3}};
+   static const int tet[6][4] = {{0,1,2,6},{0,2,3,6},{0,3,7,6},{0,7,4,6},{0,4,5,6},{0,5,1,6}};
+   int d=ms.getDim(), m=int(ms.getNbNodes(e));
+   int ns = (m==d+1) ? 1 : ((d==2) ? 2 : 6);
+   const size_t *nd = ms.getNodes(e);
+   for (int k=0; k<ns; ++k) {
+      for (int i=0; i<=d; ++i) {
+         int l = (m==d+1) ? i : ((d==2) ? tri[k][i] : tet[k][i]);
+         const double *x = ms.getCoord(nd[l]);
+         for (int a=0; a<3; ++a)
+            s[k][i][a] = (a<d) ? x[a] : 0.;
+      }
+   }
+   return ns;
+}
+
+
+static void Bounds(int            d,
+                   const Simplex* s,
+                   int            ns,
+                   double*        lo,
+                   double*        hi)
+{
+   for (int a=0; a<d; ++a) {
+      lo[a] = hi[a] = s[0][0][a];
+      for (int k=0; k<ns; ++k)
+         for (int i=0; i<=d; ++i)
+            lo[a] = std::min(lo[a],s[k][i][a]), hi[a] = std::max(hi[a],s[k][i][a]);
+   }
+}
+
+
+static bool Overlap(int           d,
+                    const double* lo1,
+                    const double* hi1,
+                    const double* lo2,
+                    const double* hi2)
+{
+   for (int a=0; a<d; ++a)
+      if (hi1[a]<lo2[a] || hi2[a]<lo1[a])
+         return false;
+   return true;
+}
+
+
+static double Measure(int            d,
+                      const Simplex& s)
+{
+   if (d==1)
+      return fabs(s[1][0]-s[0][0]);
+   double u[3], v[3], w[3];
+   for (int a=0; a<3; ++a)
+      u[a] = s[1][a] - s[0][a], v[a] = s[2][a] - s[0][a], w[a] = (d==3) ? s[3][a] - s[0][a] : 0.;
+   if (d==2)
+      return 0.5*fabs(u[0]*v[1] - u[1]*v[0]);
+   return fabs(u[0]*(v[1]*w[2]-v[2]*w[1]) - u[1]*(v[0]*w[2]-v[2]*w[0]) + u[2]*(v[0]*w[1]-v[1]*w[0]))/6.;
+}
+
+
+/*
+ * Clipping of the polygon p (np vertices) by the half-plane n.x+n[3]>=0 in
+ * q, returns the number of vertices of q
+ */
+static int Clip(const double (*p)[3],
+                int           np,
+                const double* n,
+                double        (*q)[3])
+{
+   int nq = 0;
+   for (int i=0; i<np; ++i) {
+      const double *a=p[i], *b=p[(i+1)%np];
+      double fa = n[0]*a[0] + n[1]*a[1] + n[3];
+      double fb = n[0]*b[0] + n[1]*b[1] + n[3];
+      if (fa>=0.) {
+         for (int l=0; l<3; ++l)
+            q[nq][l] = a[l];
+         nq++;
+      }
+      if ((fa>0. && fb<0.) || (fa<0. && fb>0.)) {
+         double t = fa/(fa-fb);
+         for (int l=0; l<3; ++l)
+            q[nq][l] = a[l] + t*(b[l]-a[l]);
+         nq++;
+      }
+   }
+   return nq;
+}
+
+
+/*
+ * Measure of the intersection of two simplices: clipping of the first one by
+ * the half-spaces bounded by the faces of the second one
+ */
+static double Intersection(int            d,
+                           const Simplex& s,
+                           const Simplex& t)
+{
+   if (d==1) {
+      double l = std::max(std::min(s[0][0],s[1][0]),std::min(t[0][0],t[1][0]));
+      double h = std::min(std::max(s[0][0],s[1][0]),std::max(t[0][0],t[1][0]));
+      return std::max(0.,h-l);
+   }
+
+// Triangles: clipping of a polygon by the 3 sides
+   if (d==2) {
+      double p[2][8][3];
+      int np=3, c=0;
+      for (int i=0; i<3; ++i)
+         p[0][i][0] = s[i][0], p[0][i][1] = s[i][1], p[0][i][2] = 0.;
+      for (int k=0; k<3 && np>2; ++k, c=1-c) {
+         const double *a=t[k], *b=t[(k+1)%3], *o=t[(k+2)%3];
+         double n[4] = {a[1]-b[1], b[0]-a[0], 0., 0.};
+         n[3] = -n[0]*a[0] - n[1]*a[1];
+         if (n[0]*o[0]+n[1]*o[1]+n[3]<0.)
+            n[0] = -n[0], n[1] = -n[1], n[3] = -n[3];
+         np = Clip(p[c],np,n,p[1-c]);
+      }
+      double ar = 0.;
+      for (int i=0; i<np; ++i) {
+         const double *a=p[c][i], *b=p[c][(i+1)%np];
+         ar += a[0]*b[1] - a[1]*b[0];
+      }
+      return (np>2) ? 0.5*fabs(ar) : 0.;
+   }
+
+// Tetrahedra: planes of the faces of t, oriented towards t. The result is 0
+// if s is outside one of them, the measure of s if s is inside all of them
+   static const int fv[4][3] = {{1,2,3},{0,3,2},{0,1,3},{0,2,1}};
+   double n[4][4];
+   bool in = true;
+   for (int k=0; k<4; ++k) {
+      const double *a=t[fv[k][0]], *b=t[fv[k][1]], *c=t[fv[k][2]], *o=t[k];
+      n[k][0] = (b[1]-a[1])*(c[2]-a[2]) - (b[2]-a[2])*(c[1]-a[1]);
+      n[k][1] = (b[2]-a[2])*(c[0]-a[0]) - (b[0]-a[0])*(c[2]-a[2]);
+      n[k][2] = (b[0]-a[0])*(c[1]-a[1]) - (b[1]-a[1])*(c[0]-a[0]);
+      n[k][3] = -(n[k][0]*a[0] + n[k][1]*a[1] + n[k][2]*a[2]);
+      if (n[k][0]*o[0]+n[k][1]*o[1]+n[k][2]*o[2]+n[k][3]<0.)
+         for (int l=0; l<4; ++l)
+            n[k][l] = -n[k][l];
+      int nin = 0;
+      for (int i=0; i<4; ++i)
+         nin += (n[k][0]*s[i][0]+n[k][1]*s[i][1]+n[k][2]*s[i][2]+n[k][3]>=0.);
+      if (nin==0)
+         return 0.;
+      in = in && (nin==4);
+   }
+   if (in)
+      return Measure(3,s);
+
+// Clipping of s by the planes: the part of a tetrahedron inside a plane is
+// a tetrahedron (1 node inside) or a prism (2 or 3 nodes inside) split in 3
+// tetrahedra
+   double T[2][81][4][3];
+   int nt[2]={1,0}, c=0;
+   for (int i=0; i<4; ++i)
+      for (int l=0; l<3; ++l)
+         T[0][0][i][l] = s[i][l];
+   for (int k=0; k<4 && nt[c]>0; ++k, c=1-c) {
+      const double *nk = n[k];
+      nt[1-c] = 0;
+      for (int j=0; j<nt[c]; ++j) {
+         const double (*x)[3] = T[c][j];
+         double f[4];
+         int in[4], out[4], ni=0, no=0;
+         for (int i=0; i<4; ++i) {
+            f[i] = nk[0]*x[i][0] + nk[1]*x[i][1] + nk[2]*x[i][2] + nk[3];
+            if (f[i]>=0.)
+               in[ni++] = i;
+            else
+               out[no++] = i;
+         }
+         if (ni==0)
+            continue;
+         double (*y)[4][3] = &T[1-c][nt[1-c]];
+         if (ni==4) {
+            std::copy(&x[0][0],&x[0][0]+12,&y[0][0][0]);
+            nt[1-c]++;
+            continue;
+         }
+
+//       Points of the plane on the edges (in[i],out[j])
+         double e[3][3][3];
+         for (int i=0; i<ni; ++i)
+            for (int o=0; o<no; ++o) {
+               double t = f[in[i]]/(f[in[i]]-f[out[o]]);
+               for (int l=0; l<3; ++l)
+                  e[i][o][l] = x[in[i]][l] + t*(x[out[o]][l]-x[in[i]][l]);
+            }
+         const double *p[6];
+         if (ni==1) {
+            const double *q[4] = {x[in[0]],e[0][0],e[0][1],e[0][2]};
+            for (int i=0; i<4; ++i)
+               for (int l=0; l<3; ++l)
+                  y[0][i][l] = q[i][l];
+            nt[1-c]++;
+            continue;
+         }
+         if (ni==2) {
+            p[0] = x[in[0]], p[1] = e[0][0], p[2] = e[0][1];
+            p[3] = x[in[1]], p[4] = e[1][0], p[5] = e[1][1];
+         }
+         else {
+            p[0] = x[in[0]], p[1] = x[in[1]], p[2] = x[in[2]];
+            p[3] = e[0][0], p[4] = e[1][0], p[5] = e[2][0];
+         }
+         static const int pr[3][4] = {{0,1,2,3},{1,2,3,4},{2,3,4,5}};
+         for (int m=0; m<3; ++m)
+            for (int i=0; i<4; ++i)
+               for (int l=0; l<3; ++l)
+                  y[m][i][l] = p[pr[m][i]][l];
+         nt[1-c] += 3;
+      }
+   }
+   double vol = 0.;
+   for (int j=0; j<nt[c]; ++j)
+      vol += Measure(3,T[c][j]);
+   return vol;
+}
+
+
+meshTransfer::meshTransfer(const spatialIndex& source,
+                           const spatialIndex& target)
+             : _src(source), _tgt(target), _dim(source.getDim())
+{
+}
+
+
+double meshTransfer::measure(const spatialIndex& ms,
+                             size_t              e)
+{
+   Simplex s[6];
+   int ns = Split(ms,e,s);
+   double m = 0.;
+   for (int k=0; k<ns; ++k)
+      m += Measure(ms.getDim(),s[k]);
+   return m;
+}
+
+
+/*
+ * Nodal field u of the source mesh at the nodes of the target mesh (nb_dof
+ * values per node); returns the number of target nodes outside the source
+ * mesh
+ */
+size_t meshTransfer::interpolate(const double* u,
+                                 int           nb_dof,
+                                 double*       v) const
+{
+   size_t np = _tgt.getNbNodes();
+   if (np==0 || _tgt.getDim()!=_dim)
+      return np;
+   vector<long> el;
+   vector<double> w;
+   size_t nf = _src.locate(np,_tgt.getCoord(0),el,w,true);
+   _src.interpolate(el,w,u,nb_dof,v);
+   return np - nf;
+}
+
+
+/*
+ * Element field u of the source mesh at the centroids of the target
+ * elements; returns the number of centroids outside the source mesh
+ */
+size_t meshTransfer::sample(const double* u,
+                            int           nb_dof,
+                            double*       v) const
+{
+   size_t ne = _tgt.getNbElements();
+   if (ne==0 || _tgt.getDim()!=_dim)
+      return ne;
+   vector<double> x(_dim*ne,0.);
+   parallelFor(ne,[&](size_t b, size_t e) {
+      for (size_t i=b; i<e; ++i) {
+         const size_t *nd = _tgt.getNodes(i);
+         size_t m = _tgt.getNbNodes(i);
+         for (size_t k=0; k<m; ++k)
+            for (int a=0; a<_dim; ++a)
+               x[_dim*i+a] += _tgt.getCoord(nd[k])[a]/m;
+      }
+   });
+   vector<long> el;
+   vector<double> w;
+   size_t nf = _src.locate(ne,&x[0],el,w,true);
+   for (size_t i=0; i<ne; ++i)
+      for (int k=0; k<nb_dof; ++k)
+         v[nb_dof*i+k] = (el[i]<0) ? 0. : u[nb_dof*el[i]+k];
+   return ne - nf;
+}
+
+
+/*
+ * L2 projection of the element field u of the source mesh on the elements
+ * of the target mesh
+ */
+void meshTransfer::project(const double* u,
+                           int           nb_dof,
+                           double*       v) const
+{
+   size_t ne = _tgt.getNbElements();
+   if (_tgt.getDim()!=_dim)
+      return;
+   parallelFor(ne,[&](size_t b, size_t e) {
+      Simplex S[6], T[6];
+      vector<size_t> cand;
+      vector<double> s(nb_dof);
+      double lo[3], hi[3], l[3], h[3], ls[6][3], hs[6][3];
+      for (size_t i=b; i<e; ++i) {
+         int ns = Split(_tgt,i,S);
+         double mt = 0.;
+         for (int p=0; p<ns; ++p) {
+            mt += Measure(_dim,S[p]);
+            Bounds(_dim,S+p,1,ls[p],hs[p]);
+         }
+         Bounds(_dim,S,ns,lo,hi);
+         _src.getElements(lo,hi,cand);
+         std::fill(s.begin(),s.end(),0.);
+         for (size_t K: cand) {
+            int nt = Split(_src,K,T);
+            Bounds(_dim,T,nt,l,h);
+            if (!Overlap(_dim,lo,hi,l,h))
+               continue;
+            double vol = 0.;
+            for (int q=0; q<nt; ++q) {
+               Bounds(_dim,T+q,1,l,h);
+               for (int p=0; p<ns; ++p)
+                  if (Overlap(_dim,ls[p],hs[p],l,h))
+                     vol += Intersection(_dim,S[p],T[q]);
+            }
+            for (int k=0; k<nb_dof; ++k)
+               s[k] += vol*u[nb_dof*K+k];
+         }
+         for (int k=0; k<nb_dof; ++k)
+            v[nb_dof*i+k] = (mt>0.) ? s[k]/mt : 0.;
+      }
+   },16);
+}
+
+} /* namespace RITA */
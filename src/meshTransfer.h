@@ -0,0 +1,67 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                        Definition of class 'meshTransfer'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include "spatialIndex.h"
+
+namespace RITA {
+
+/*
+ * Transfer of fields from a source mesh to a target mesh, both given by
+ * their spatial index:
+ * interpolate() evaluates a nodal field of the source mesh at the nodes of
+ * the target mesh, sample() takes the values of an element field at the
+ * centroids of the target elements; target points outside the source mesh
+ * get the value of its nearest point. project() is the L2 projection of an
+ * element field (piecewise constant) on the target elements: the value on a
+ * target element is the mean of the source field over it, computed from the
+ * exact measures of its intersections with the source elements, so that
+ * the integral of the field is preserved over the part of the domain
+ * covered by both meshes. Quadrilaterals and hexahedra are split in
+ * triangles and tetrahedra for the intersections.
+ * Target points and elements are processed in parallel.
+ */
+class meshTransfer
+{
+
+ public:
+
+    meshTransfer(const spatialIndex& source, const spatialIndex& target);
+    ~meshTransfer() { }
+    size_t interpolate(const double* u, int nb_dof, double* v) const;
+    size_t sample(const double* u, int nb_dof, double* v) const;
+    void project(const double* u, int nb_dof, double* v) const;
+    static double measure(const spatialIndex& ms, size_t e);
+
+ private:
+
+    const spatialIndex &_src, &_tgt;
+    int _dim;
+};
+
+} /* namespace RITA */
@@ -0,0 +1,390 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                      Implementation of class 'navierStokes'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include <algorithm>
+#include "navierStokes.h"
+
+namespace RITA {
+
+navierStokes::navierStokes()
+             : _dim(0), _nn(0), _nb_nodes(0), _nb_el(0), _nu(0)
+{
+}
+
+
+/*
+ * dim: space dimension, coord: node coordinates (dim per node), elem:
+ * element nodes (dim+1 per element, 0-based), fixed: prescribed velocity
+ * components (dim per node)
+ */
+int navierStokes::set(int                     dim,
+                      const vector<double>&   coord,
+                      const vector<unsigned>& elem,
+                      const vector<bool>&     fixed)
+{
+   if (dim<2 || dim>3)
+      return 1;
+   _dim = dim, _nn = dim + 1;
+   _nb_nodes = coord.size()/dim;
+   _nb_el = elem.size()/_nn;
+   _coord = coord;
+   _elem = elem;
+   _rho.assign(_nb_el,1.);
+   _mu.assign(_nb_el,1.);
+
+// Velocity equations, component by component
+   _eq.assign(dim*_nb_nodes,-1);
+   _nu = 0;
+   for (int c=0; c<dim; ++c)
+      for (size_t n=0; n<_nb_nodes; ++n)
+         if (!fixed[dim*n+c])
+            _eq[dim*n+c] = _nu++;
+
+// Node graph
+   vector<vector<unsigned> > nb(_nb_nodes);
+   for (size_t e=0; e<_nb_el; ++e)
+      for (int i=0; i<_nn; ++i)
+         for (int j=0; j<_nn; ++j)
+            nb[elem[_nn*e+i]].push_back(elem[_nn*e+j]);
+   _adj_ptr.assign(_nb_nodes+1,0);
+   _adj.clear();
+   for (size_t n=0; n<_nb_nodes; ++n) {
+      std::sort(nb[n].begin(),nb[n].end());
+      nb[n].erase(std::unique(nb[n].begin(),nb[n].end()),nb[n].end());
+      _adj.insert(_adj.end(),nb[n].begin(),nb[n].end());
+      _adj_ptr[n+1] = _adj.size();
+      vector<unsigned>().swap(nb[n]);
+   }
+
+// Matrix pattern. Rows are built in the order of equations. For each edge
+// (a,b) of the node graph, _pos[c] gives the position of the entry (u_ac,u_bc)
+// (-1 if one of them is prescribed) and _pos[dim] that of (p_a,p_b).
+// In a velocity row, the pressure entries follow the velocity ones.
+   size_t na = _adj.size();
+   _A.nb_rows = _A.nb_cols = size();
+   _A.row_ptr.assign(size()+1,0);
+   _A.col_ind.clear();
+   for (int c=0; c<=dim; ++c)
+      _pos[c].assign(na,-1);
+   for (int c=0; c<dim; ++c) {
+      for (size_t a=0; a<_nb_nodes; ++a) {
+         long i = _eq[dim*a+c];
+         if (i<0)
+            continue;
+         for (size_t k=_adj_ptr[a]; k<_adj_ptr[a+1]; ++k) {
+            long j = _eq[dim*_adj[k]+c];
+            if (j>=0) {
+               _pos[c][k] = _A.col_ind.size();
+               _A.col_ind.push_back(j);
+            }
+         }
+         for (size_t k=_adj_ptr[a]; k<_adj_ptr[a+1]; ++k)
+            _A.col_ind.push_back(_nu+_adj[k]);
+         _A.row_ptr[i+1] = _A.col_ind.size();
+      }
+   }
+   for (size_t a=0; a<_nb_nodes; ++a) {
+      for (int c=0; c<dim; ++c)
+         for (size_t k=_adj_ptr[a]; k<_adj_ptr[a+1]; ++k)
+            if (_eq[dim*_adj[k]+c]>=0)
+               _A.col_ind.push_back(_eq[dim*_adj[k]+c]);
+      for (size_t k=_adj_ptr[a]; k<_adj_ptr[a+1]; ++k) {
+         _pos[dim][k] = _A.col_ind.size();
+         _A.col_ind.push_back(_nu+_adj[k]);
+      }
+      _A.row_ptr[_nu+a+1] = _A.col_ind.size();
+   }
+   _A.a.assign(_A.col_ind.size(),0.);
+
+// Boundary faces (faces of a single element), stored with the opposite node
+// and their element. Outflow nodes are on a boundary face with a free velocity
+// component
+   vector<vector<unsigned> > face;
+   for (size_t e=0; e<_nb_el; ++e) {
+      for (int i=0; i<_nn; ++i) {
+         vector<unsigned> f;
+         for (int j=0; j<_nn; ++j)
+            if (j!=i)
+               f.push_back(elem[_nn*e+j]);
+         std::sort(f.begin(),f.end());
+         f.push_back(elem[_nn*e+i]);
+         f.push_back(unsigned(e));
+         face.push_back(f);
+      }
+   }
+   std::sort(face.begin(),face.end());
+   auto same = [dim](const vector<unsigned>& f, const vector<unsigned>& g) {
+      return std::equal(f.begin(),f.begin()+dim,g.begin());
+   };
+   _outflow.assign(_nb_nodes,false);
+   _bface.clear();
+   for (size_t k=0; k<face.size(); ++k) {
+      if ((k>0 && same(face[k],face[k-1])) || (k+1<face.size() && same(face[k],face[k+1])))
+         continue;
+      _bface.insert(_bface.end(),face[k].begin(),face[k].end());
+      for (int i=0; i<dim; ++i)
+         for (int c=0; c<dim; ++c)
+            if (!fixed[dim*face[k][i]+c])
+               _outflow[face[k][i]] = true;
+   }
+   double c[4][3];
+   for (size_t e=0; e<_nb_el; ++e)
+      if (cofactors(e,c)==0.)
+         return 1;
+   return 0;
+}
+
+
+double navierStokes::cofactors(size_t e,
+                               double c[][3]) const
+{
+   const unsigned *n = &_elem[_nn*e];
+   if (_dim==2) {
+      const double *p0=&_coord[2*n[0]], *p1=&_coord[2*n[1]], *p2=&_coord[2*n[2]];
+      c[0][0] = p1[1] - p2[1], c[0][1] = p2[0] - p1[0];
+      c[1][0] = p2[1] - p0[1], c[1][1] = p0[0] - p2[0];
+      c[2][0] = p0[1] - p1[1], c[2][1] = p1[0] - p0[0];
+      return (p1[0]-p0[0])*(p2[1]-p0[1]) - (p2[0]-p0[0])*(p1[1]-p0[1]);
+   }
+   const double *p0 = &_coord[3*n[0]];
+   double a[3][3];
+   for (int k=0; k<3; ++k)
+      for (int j=0; j<3; ++j)
+         a[k][j] = _coord[3*n[k+1]+j] - p0[j];
+   for (int k=0; k<3; ++k) {
+      const double *u=a[(k+1)%3], *v=a[(k+2)%3];
+      c[k+1][0] = u[1]*v[2] - u[2]*v[1];
+      c[k+1][1] = u[2]*v[0] - u[0]*v[2];
+      c[k+1][2] = u[0]*v[1] - u[1]*v[0];
+   }
+   for (int j=0; j<3; ++j)
+      c[0][j] = -c[1][j] - c[2][j] - c[3][j];
+   return a[0][0]*c[1][0] + a[0][1]*c[1][1] + a[0][2]*c[1][2];
+}
+
+
+/*
+ * Position of node b in the list of neighbours of node a
+ */
+size_t navierStokes::local(size_t a,
+                           size_t b) const
+{
+   return std::lower_bound(_adj.begin()+_adj_ptr[a],_adj.begin()+_adj_ptr[a+1],unsigned(b)) - _adj.begin();
+}
+
+
+/*
+ * Matrix and right-hand side of the Oseen problem with convection velocity w,
+ * prescribed velocities ud, body force f and previous velocity un (dt>0).
+ * M, K and Fp are the pressure matrices of the Schur complement approximation
+ * of schurPrec (pcd: pressure convection-diffusion, otherwise pressure mass).
+ */
+void navierStokes::build(const vector<double>& w,
+                         const vector<double>& ud,
+                         const vector<double>& f,
+                         const vector<double>& un,
+                         double                dt,
+                         bool                  pcd,
+                         spmat<double>&        A,
+                         vector<double>&       b,
+                         spmat<double>&        M,
+                         spmat<double>&        K,
+                         spmat<double>&        Fp) const
+{
+   const double delta = 0.1;
+   double fact = (_dim==2) ? 0.5 : 1./6.;
+   A = _A;
+   b.assign(size(),0.);
+   spmat<double> P;
+   P.nb_rows = P.nb_cols = _nb_nodes;
+   P.row_ptr = _adj_ptr;
+   P.col_ind = _adj;
+   P.a.assign(_adj.size(),0.);
+   M = K = P;
+   if (pcd)
+      Fp = P;
+   else
+      Fp.clear();
+   if (!pcd && dt==0.)
+      K.clear();
+
+   double c[4][3];
+   for (size_t e=0; e<_nb_el; ++e) {
+      const unsigned *n = &_elem[_nn*e];
+      double det = cofactors(e,c), vol = fact*fabs(det);
+      double rho = _rho[e], mu = _mu[e];
+      double h2 = pow(fabs(det),2./_dim);
+      double wm[3] = {0.,0.,0.};
+      for (int i=0; i<_nn; ++i)
+         for (int k=0; k<_dim; ++k)
+            wm[k] += w[_dim*n[i]+k]/_nn;
+
+//    Streamline diffusion where the element Peclet number is larger than 1
+      double wn = sqrt(wm[0]*wm[0] + wm[1]*wm[1] + wm[2]*wm[2]), tau = 0.;
+      double pe = 0.5*rho*wn*sqrt(h2)/mu;
+      if (pe>1.)
+         tau = 0.5*sqrt(h2)/wn*(1.-1./pe);
+      for (int i=0; i<_nn; ++i) {
+         size_t a = n[i];
+         for (int j=0; j<_nn; ++j) {
+            size_t bn = n[j], l = local(a,bn);
+            double kij=0., wc=0., mij = vol*(i==j ? 2. : 1.)/((_dim+1)*(_dim+2));
+            for (int k=0; k<_dim; ++k) {
+               kij += c[i][k]*c[j][k];
+               wc += wm[k]*c[j][k];
+            }
+            kij *= vol/(det*det);
+            double nij = vol*wc/(det*(_dim+1));
+            double fij = mu*kij + rho*nij + (dt>0. ? rho*mij/dt : 0.);
+            if (tau>0.) {
+               double wi=0.;
+               for (int k=0; k<_dim; ++k)
+                  wi += wm[k]*c[i][k];
+               fij += rho*tau*vol*wi*wc/(det*det);
+            }
+
+//          Velocity rows
+            for (int k=0; k<_dim; ++k) {
+               long r = _eq[_dim*a+k];
+               if (r<0)
+                  continue;
+               b[r] += mij*f[_dim*bn+k];
+               if (dt>0.)
+                  b[r] += rho*mij/dt*un[_dim*bn+k];
+               if (_pos[k][l]>=0)
+                  A.a[_pos[k][l]] += fij;
+               else
+                  b[r] -= fij*ud[_dim*bn+k];
+//             (u_ak,p_b): -int phi_b d_k phi_a
+               size_t nv = A.row_ptr[r+1] - A.row_ptr[r] - (_adj_ptr[a+1] - _adj_ptr[a]);
+               A.a[A.row_ptr[r]+nv+l-_adj_ptr[a]] -= vol*c[i][k]/(det*(_dim+1));
+            }
+
+//          Pressure row: -int phi_a d_k phi_b, stabilization
+            size_t pr = _nu + a;
+            for (int k=0; k<_dim; ++k) {
+               double d = -vol*c[j][k]/(det*(_dim+1));
+               long s = _eq[_dim*bn+k];
+               if (s>=0) {
+                  unsigned *p = std::lower_bound(&A.col_ind[A.row_ptr[pr]],&A.col_ind[A.row_ptr[pr+1]],
+                                                 unsigned(s));
+                  A.a[p-&A.col_ind[0]] += d;
+               }
+               else
+                  b[pr] -= d*ud[_dim*bn+k];
+            }
+            A.a[_pos[_dim][l]] -= delta*h2/(mu+rho*wn*sqrt(h2))*kij;
+
+//          Pressure matrices
+            if (pcd) {
+               M.a[l] += mij;
+               K.a[l] += kij;
+               Fp.a[l] += fij;
+            }
+            else {
+               M.a[l] += mij/mu;
+               if (dt>0.)
+                  K.a[l] += dt/rho*kij;
+            }
+         }
+      }
+   }
+
+// Robin condition of Fp on inflow faces: -rho int (w.n) p q where w.n<0
+   if (pcd) {
+      for (size_t k=0; k<_bface.size(); k+=_nn+1) {
+         const unsigned *f = &_bface[k];
+         double nv[3] = {0.,0.,0.}, wm[3] = {0.,0.,0.}, meas=0., wn=0., s=0., rho=_rho[f[_nn]];
+         const double *p0 = &_coord[_dim*f[0]], *p1 = &_coord[_dim*f[1]], *q = &_coord[_dim*f[_dim]];
+         if (_dim==2)
+            nv[0] = p1[1] - p0[1], nv[1] = p0[0] - p1[0];
+         else {
+            const double *p2 = &_coord[3*f[2]];
+            double u[3] = {p1[0]-p0[0],p1[1]-p0[1],p1[2]-p0[2]}, v[3] = {p2[0]-p0[0],p2[1]-p0[1],p2[2]-p0[2]};
+            nv[0] = 0.5*(u[1]*v[2]-u[2]*v[1]);
+            nv[1] = 0.5*(u[2]*v[0]-u[0]*v[2]);
+            nv[2] = 0.5*(u[0]*v[1]-u[1]*v[0]);
+         }
+         for (int j=0; j<_dim; ++j) {
+            s += nv[j]*(p0[j]-q[j]);
+            meas += nv[j]*nv[j];
+            for (int i=0; i<_dim; ++i)
+               wm[j] += w[_dim*f[i]+j]/_dim;
+         }
+         meas = sqrt(meas);
+         for (int j=0; j<_dim; ++j)
+            wn += wm[j]*nv[j]/meas;
+         if (s<0.)
+            wn = -wn;
+         if (wn>=0.)
+            continue;
+         for (int i=0; i<_dim; ++i)
+            for (int j=0; j<_dim; ++j)
+               Fp.a[local(f[i],f[j])] -= rho*wn*meas*(i==j ? 2. : 1.)/(_dim*(_dim+1));
+      }
+
+//    Dirichlet conditions of the PCD operators at outflow nodes
+      for (size_t a=0; a<_nb_nodes; ++a) {
+         for (size_t k=_adj_ptr[a]; k<_adj_ptr[a+1]; ++k) {
+            if (_adj[k]!=a && (_outflow[a] || _outflow[_adj[k]]))
+               K.a[k] = Fp.a[k] = 0.;
+         }
+      }
+   }
+}
+
+
+void navierStokes::setUnknowns(const vector<double>& u,
+                               const vector<double>& p,
+                               vector<double>&       x) const
+{
+   x.resize(size());
+   for (size_t i=0; i<_dim*_nb_nodes; ++i)
+      if (_eq[i]>=0)
+         x[_eq[i]] = u[i];
+   for (size_t n=0; n<_nb_nodes; ++n)
+      x[_nu+n] = p[n];
+}
+
+
+void navierStokes::getSolution(const vector<double>& x,
+                               const vector<double>& ud,
+                               vector<double>&       u,
+                               vector<double>&       p) const
+{
+   u.resize(_dim*_nb_nodes);
+   p.resize(_nb_nodes);
+   for (size_t i=0; i<_dim*_nb_nodes; ++i)
+      u[i] = (_eq[i]>=0) ? x[_eq[i]] : ud[i];
+   for (size_t n=0; n<_nb_nodes; ++n)
+      p[n] = x[_nu+n];
+}
+
+} /* namespace RITA */
@@ -0,0 +1,90 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Definition of class 'navierStokes'
+
+  ==============================================================================*/
+
+
+#pragma once
+
+#include "linearSolver.h"
+
+namespace RITA {
+
+/*
+ * Coupled velocity-pressure system of the incompressible Navier-Stokes
+ * equations linearized around a velocity w (Oseen problem):
+ *    rho/dt u + rho (w.grad) u - mu Lap u + grad p = f + rho/dt u^n
+ *    div u = 0
+ * P1/P1 finite elements on triangles or tetrahedra, with the pressure
+ * stabilization of Brezzi-Pitkaranta. dt=0 gives the stationary problem.
+ * Unknowns are the velocity components without prescribed value (numbered
+ * component by component) followed by the pressure at all nodes, which is
+ * the ordering expected by schurPrec. The matrix pattern is built once in
+ * set(), build() only computes coefficients.
+ * Nodal vectors (velocities, forces) hold dim values per node.
+ * Boundary nodes where the velocity is not prescribed are outflow nodes, where
+ * the pressure Laplacian and convection-diffusion operators of PCD have
+ * Dirichlet conditions, and the convection-diffusion operator has a Robin
+ * condition on inflow boundaries (Elman, Silvester, Wathen).
+ */
+class navierStokes
+{
+
+ public:
+
+    navierStokes();
+    ~navierStokes() { }
+    int set(int dim, const vector<double>& coord, const vector<unsigned>& elem,
+            const vector<bool>& fixed);
+    void setCoef(const vector<double>& rho, const vector<double>& mu) { _rho = rho; _mu = mu; }
+    size_t size() const { return _nu + _nb_nodes; }
+    size_t getNbVelocity() const { return _nu; }
+    void build(const vector<double>& w, const vector<double>& ud, const vector<double>& f,
+               const vector<double>& un, double dt, bool pcd, spmat<double>& A, vector<double>& b,
+               spmat<double>& M, spmat<double>& K, spmat<double>& Fp) const;
+    void setUnknowns(const vector<double>& u, const vector<double>& p, vector<double>& x) const;
+    void getSolution(const vector<double>& x, const vector<double>& ud, vector<double>& u,
+                     vector<double>& p) const;
+
+ private:
+
+    int _dim, _nn;
+    size_t _nb_nodes, _nb_el, _nu;
+    vector<double> _coord, _rho, _mu;
+    vector<unsigned> _elem;
+    vector<long> _eq;
+    vector<size_t> _adj_ptr;
+    vector<unsigned> _adj;
+    vector<long> _pos[4];
+    vector<bool> _outflow;
+    vector<unsigned> _bface;
+    spmat<double> _A;
+
+    double cofactors(size_t e, double c[][3]) const;
+    size_t local(size_t a, size_t b) const;
+};
+
+} /* namespace RITA */
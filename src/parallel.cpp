@@ -0,0 +1,144 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                      Implementation of parallel utilities
+
+  ==============================================================================*/
+
+
+#include <mutex>
+#include <condition_variable>
+#include "parallel.h"
+
+namespace RITA {
+
+static int nb_threads = 0;
+
+int getNbThreads()
+{
+   if (nb_threads<=0)
+      nb_threads = std::max(1,int(std::thread::hardware_concurrency()));
+   return nb_threads;
+}
+
+
+void setNbThreads(int n)
+{
+   nb_threads = n;
+}
+
+
+/*
+ * Pool of worker threads. Worker k (k>=1) runs task(k) of each call to run()
+ * with nt>k, then goes back to sleep. Workers are added when more threads are
+ * requested and are never removed.
+ */
+class threadPool
+{
+
+ public:
+
+    threadPool() : _gen(0), _nb_tasks(0), _pending(0), _stop(false), _task(nullptr) { }
+
+    ~threadPool()
+    {
+       {
+          std::lock_guard<std::mutex> lk(_m);
+          _stop = true;
+       }
+       _cv.notify_all();
+       for (auto &t: _th)
+          t.join();
+    }
+
+    void run(size_t                             nt,
+             const std::function<void(size_t)>& task)
+    {
+       std::lock_guard<std::mutex> lr(_run);
+       {
+          std::lock_guard<std::mutex> lk(_m);
+          while (_th.size()+1<nt)
+             _th.push_back(std::thread(&threadPool::work,this,_th.size()+1,_gen));
+          _task = &task;
+          _nb_tasks = nt;
+          _pending = nt - 1;
+          _gen++;
+       }
+       _cv.notify_all();
+       in_pool = true;
+       task(0);
+       in_pool = false;
+       std::unique_lock<std::mutex> lk(_m);
+       _done.wait(lk,[this] { return _pending==0; });
+    }
+
+    static thread_local bool in_pool;
+
+ private:
+
+    std::vector<std::thread> _th;
+    std::mutex _m, _run;
+    std::condition_variable _cv, _done;
+    size_t _gen, _nb_tasks, _pending;
+    bool _stop;
+    const std::function<void(size_t)> *_task;
+
+    void work(size_t id,
+              size_t gen)
+    {
+       in_pool = true;
+       std::unique_lock<std::mutex> lk(_m);
+       while (1) {
+          _cv.wait(lk,[this,gen] { return _stop || _gen!=gen; });
+          if (_stop)
+             return;
+          gen = _gen;
+          if (id>=_nb_tasks)
+             continue;
+          const std::function<void(size_t)> *task = _task;
+          lk.unlock();
+          (*task)(id);
+          lk.lock();
+          if (--_pending==0)
+             _done.notify_one();
+       }
+    }
+};
+
+thread_local bool threadPool::in_pool = false;
+
+
+void parallelRun(size_t                             nt,
+                 const std::function<void(size_t)>& task)
+{
+   static threadPool pool;
+   if (nt<=1 || threadPool::in_pool) {
+      for (size_t t=0; t<nt; ++t)
+         task(t);
+      return;
+   }
+   pool.run(nt,task);
+}
+
+} /* namespace RITA */
@@ -0,0 +1,116 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                        Definition of parallel utilities
+
+  ==============================================================================*/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+namespace RITA {
+
+/*
+ * Number of threads used by the parallel kernels of rita (default: number of
+ * hardware threads)
+ */
+int getNbThreads();
+void setNbThreads(int n);
+
+
+/*
+ * Run task(0), ..., task(nt-1) concurrently: task(0) in the calling thread,
+ * the others in a pool of threads created once and kept waiting between
+ * calls. Calls made from a pool thread are run sequentially.
+ */
+void parallelRun(size_t nt, const std::function<void(size_t)>& task);
+
+
+/*
+ * Run f(begin,end) on consecutive chunks of [0,n), one per thread. Small
+ * ranges are run by the calling thread.
+ */
+template<class F_>
+void parallelFor(size_t n,
+                 F_     f,
+                 size_t min_size=2048)
+{
+   size_t nt = size_t(getNbThreads());
+   if (nt<=1 || n<std::max<size_t>(min_size,2)) {
+      f(size_t(0),n);
+      return;
+   }
+   nt = std::min(nt,n/std::max<size_t>(1,min_size/2));
+   size_t chunk = (n+nt-1)/nt;
+   parallelRun(nt,[&](size_t t) {
+      size_t b=std::min(n,t*chunk), e=std::min(n,b+chunk);
+      if (b<e)
+         f(b,e);
+   });
+}
+
+
+/*
+ * Sums s[0], ..., s[m-1] over [0,n): f(begin,end,s) adds to s the
+ * contributions of a range. The range is split in blocks of fixed size whose
+ * partial sums are added in block order, so that the result does not depend on
+ * the number of threads and is reproducible.
+ */
+template<class F_>
+void parallelSum(size_t  n,
+                 F_      f,
+                 double* s,
+                 int     m)
+{
+   const size_t bs = 4096;
+   size_t nb = (n+bs-1)/bs;
+   std::vector<double> ps(nb*m,0.);
+   parallelFor(nb,[&](size_t b, size_t e) {
+      for (size_t k=b; k<e; ++k)
+         f(k*bs,std::min(n,(k+1)*bs),&ps[k*m]);
+   },2);
+   for (int j=0; j<m; ++j)
+      s[j] = 0.;
+   for (size_t k=0; k<nb; ++k)
+      for (int j=0; j<m; ++j)
+         s[j] += ps[k*m+j];
+}
+
+
+template<class F_>
+double parallelSum(size_t n,
+                   F_     f)
+{
+   double s = 0.;
+   parallelSum(n,[&f](size_t b, size_t e, double* p) { p[0] += f(b,e); },&s,1);
+   return s;
+}
+
+} /* namespace RITA */
@@ -0,0 +1,479 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                      Implementation of class 'partition'
+
+  ==============================================================================*/
+
+#include <math.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include "partition.h"
+
+namespace RITA {
+
+static const size_t npos = size_t(-1);
+
+partition::partition()
+          : _nb_parts(0), _nb_levels(0), _nb_nodes(0), _cut(0), _tol(0.03), _imbalance(0.)
+{
+}
+
+
+/*
+ * Dual graph of a mesh: dim is the space dimension, element e has the nodes
+ * el_node[el_ptr[e]], ..., el_node[el_ptr[e+1]-1]
+ */
+int partition::set(int                   dim,
+                   size_t                nb_nodes,
+                   const vector<size_t>& el_ptr,
+                   const vector<size_t>& el_node)
+{
+   if (el_ptr.size()<2)
+      return 1;
+   size_t ne = el_ptr.size() - 1;
+   int nc = (dim<=1) ? 1 : dim;
+   _nb_nodes = nb_nodes;
+   _el_ptr = el_ptr, _el_node = el_node;
+   vector<size_t> n_ptr(nb_nodes+1,0), n_el(el_node.size());
+   for (auto const& n: el_node) {
+      if (n>=nb_nodes)
+         return 1;
+      n_ptr[n+1]++;
+   }
+   for (size_t n=0; n<nb_nodes; ++n)
+      n_ptr[n+1] += n_ptr[n];
+   vector<size_t> pos(n_ptr.begin(),n_ptr.end()-1);
+   for (size_t e=0; e<ne; ++e)
+      for (size_t k=el_ptr[e]; k<el_ptr[e+1]; ++k)
+         n_el[pos[el_node[k]]++] = e;
+
+   _g = Graph();
+   _g.ptr.assign(1,0);
+   _g.vw.assign(ne,1);
+   vector<int> cnt(ne,0);
+   vector<size_t> touched;
+   for (size_t e=0; e<ne; ++e) {
+      for (size_t k=el_ptr[e]; k<el_ptr[e+1]; ++k) {
+         size_t n = el_node[k];
+         for (size_t l=n_ptr[n]; l<n_ptr[n+1]; ++l) {
+            size_t f = n_el[l];
+            if (f!=e && cnt[f]++==0)
+               touched.push_back(f);
+         }
+      }
+      for (auto const& f: touched) {
+         if (cnt[f]>=nc) {
+            _g.adj.push_back(f);
+            _g.ew.push_back(1);
+         }
+         cnt[f] = 0;
+      }
+      touched.clear();
+      _g.ptr.push_back(_g.adj.size());
+   }
+   return 0;
+}
+
+
+/*
+ * Graph given by its adjacency lists g_adj[g_ptr[i]], ..., g_adj[g_ptr[i+1]-1]
+ * (symmetric). Self loops are ignored. No subdomain data is built.
+ */
+int partition::setGraph(const vector<size_t>& g_ptr,
+                        const vector<size_t>& g_adj)
+{
+   if (g_ptr.size()<2)
+      return 1;
+   size_t n = g_ptr.size() - 1;
+   _el_ptr.clear(), _el_node.clear();
+   _nb_nodes = 0;
+   _g = Graph();
+   _g.ptr.assign(1,0);
+   _g.vw.assign(n,1);
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=g_ptr[i]; k<g_ptr[i+1]; ++k) {
+         if (g_adj[k]>=n)
+            return 1;
+         if (g_adj[k]!=i) {
+            _g.adj.push_back(g_adj[k]);
+            _g.ew.push_back(1);
+         }
+      }
+      _g.ptr.push_back(_g.adj.size());
+   }
+   return 0;
+}
+
+
+/*
+ * Heavy edge matching of g: vertices are visited in random order and matched
+ * with the unmatched neighbour of heaviest edge, provided that the weight of
+ * the pair does not exceed maxw. Coarse vertices are numbered in g.cmap.
+ */
+void partition::coarsen(Graph& g,
+                        Graph& c,
+                        int    maxw) const
+{
+   size_t n=g.size(), nc=0;
+   vector<size_t> order(n), match(n,npos);
+   std::iota(order.begin(),order.end(),0);
+   std::mt19937 rng(12345);
+   std::shuffle(order.begin(),order.end(),rng);
+   for (auto const& v: order) {
+      if (match[v]!=npos)
+         continue;
+      size_t best = v;
+      int bw = 0;
+      for (size_t k=g.ptr[v]; k<g.ptr[v+1]; ++k) {
+         size_t u = g.adj[k];
+         if (match[u]==npos && u!=v && g.ew[k]>bw && g.vw[v]+g.vw[u]<=maxw)
+            best = u, bw = g.ew[k];
+      }
+      match[v] = best, match[best] = v;
+   }
+   g.cmap.assign(n,npos);
+   vector<size_t> first;
+   for (size_t v=0; v<n; ++v) {
+      if (g.cmap[v]!=npos)
+         continue;
+      g.cmap[v] = g.cmap[match[v]] = nc++;
+      first.push_back(v);
+   }
+   c = Graph();
+   c.vw.assign(nc,0);
+   c.ptr.assign(1,0);
+   vector<size_t> pos(nc,npos);
+   for (size_t cv=0; cv<nc; ++cv) {
+      size_t v=first[cv], start=c.adj.size();
+      for (int i=0; i<2; ++i) {
+         size_t f = i ? match[v] : v;
+         if (i && f==v)
+            break;
+         c.vw[cv] += g.vw[f];
+         for (size_t k=g.ptr[f]; k<g.ptr[f+1]; ++k) {
+            size_t cu = g.cmap[g.adj[k]];
+            if (cu==cv)
+               continue;
+            if (pos[cu]!=npos && pos[cu]>=start && c.adj[pos[cu]]==cu)
+               c.ew[pos[cu]] += g.ew[k];
+            else {
+               pos[cu] = c.adj.size();
+               c.adj.push_back(cu);
+               c.ew.push_back(g.ew[k]);
+            }
+         }
+      }
+      c.ptr.push_back(c.adj.size());
+   }
+}
+
+
+/*
+ * Recursive bisection of the subgraph of g induced by the vertices v in nb
+ * parts numbered from first. Each bisection grows a region from a few seeds,
+ * adding the frontier vertex of largest gain (decrease of the cut) until
+ * the region has its share of the weight, and keeps the smallest cut.
+ */
+void partition::bisect(const Graph&    g,
+                       vector<size_t>& v,
+                       int             nb,
+                       int             first,
+                       vector<int>&    part) const
+{
+   if (nb==1 || v.size()<2) {
+      for (auto const& x: v)
+         part[x] = first;
+      return;
+   }
+   int n1 = nb/2;
+   size_t n = v.size();
+   vector<int> in(g.size(),0);
+   long w = 0;
+   for (auto const& x: v)
+      in[x] = 1, w += g.vw[x];
+   double target = double(w)*n1/nb;
+
+   vector<char> best_side;
+   long best_cut = -1;
+   const int nb_seeds = 4;
+   for (int s=0; s<nb_seeds; ++s) {
+      size_t seed = v[(s*n)/nb_seeds];
+      if (s==0) {
+//       Pseudo-peripheral vertex: last vertex reached by a BFS
+         vector<char> seen(g.size(),0);
+         vector<size_t> q(1,v[0]);
+         seen[v[0]] = 1;
+         for (size_t i=0; i<q.size(); ++i)
+            for (size_t k=g.ptr[q[i]]; k<g.ptr[q[i]+1]; ++k)
+               if (in[g.adj[k]] && !seen[g.adj[k]])
+                  seen[g.adj[k]] = 1, q.push_back(g.adj[k]);
+         seed = q.back();
+      }
+      vector<char> side(g.size(),0), front(g.size(),0);
+      vector<long> gain(g.size(),0);
+      vector<size_t> frontier;
+      for (auto const& x: v)
+         for (size_t k=g.ptr[x]; k<g.ptr[x+1]; ++k)
+            if (in[g.adj[k]])
+               gain[x] -= g.ew[k];
+      long wr = 0;
+      size_t next = 0;
+      while (wr<target) {
+         size_t x = npos;
+         long gx = 0;
+         for (size_t i=0; i<frontier.size(); ++i) {
+            size_t y = frontier[i];
+            if (side[y]) {
+               frontier[i--] = frontier.back();
+               frontier.pop_back();
+               continue;
+            }
+            if (x==npos || gain[y]>gx)
+               x = y, gx = gain[y];
+         }
+         if (x==npos) {
+            x = seed;
+            while (side[x]) {
+               while (side[v[next]])
+                  next++;
+               x = v[next];
+            }
+         }
+         if (wr>0 && fabs(wr+g.vw[x]-target)>fabs(wr-target))
+            break;
+         side[x] = 1;
+         wr += g.vw[x];
+         for (size_t k=g.ptr[x]; k<g.ptr[x+1]; ++k) {
+            size_t y = g.adj[k];
+            if (!in[y] || side[y])
+               continue;
+            gain[y] += 2*g.ew[k];
+            if (!front[y])
+               front[y] = 1, frontier.push_back(y);
+         }
+      }
+      long cut = 0;
+      for (auto const& x: v)
+         for (size_t k=g.ptr[x]; k<g.ptr[x+1]; ++k)
+            if (in[g.adj[k]] && side[x] && !side[g.adj[k]])
+               cut += g.ew[k];
+      if (best_cut<0 || cut<best_cut)
+         best_cut = cut, best_side.swap(side);
+   }
+   vector<size_t> v1, v2;
+   for (auto const& x: v)
+      (best_side[x] ? v1 : v2).push_back(x);
+   vector<size_t>().swap(v);
+   bisect(g,v1,n1,first,part);
+   bisect(g,v2,nb-n1,first+n1,part);
+}
+
+
+/*
+ * Greedy k-way refinement: boundary vertices are moved to the adjacent part
+ * with the largest gain if the balance constraint holds. Moves with no gain
+ * are done if they improve the balance, and vertices of overweight parts are
+ * moved even with a negative gain.
+ */
+void partition::refine(const Graph& g,
+                       vector<int>& part) const
+{
+   size_t n = g.size();
+   long w = 0;
+   vector<long> pw(_nb_parts,0), conn(_nb_parts,0);
+   int vmax = 0;
+   for (size_t v=0; v<n; ++v) {
+      w += g.vw[v];
+      pw[part[v]] += g.vw[v];
+      vmax = std::max(vmax,g.vw[v]);
+   }
+   long maxw = std::max(long((1.+_tol)*w/_nb_parts),long(w/_nb_parts)+vmax);
+   vector<int> touched;
+   for (int pass=0; pass<10; ++pass) {
+      size_t moved = 0;
+      for (size_t v=0; v<n; ++v) {
+         int p = part[v];
+         for (size_t k=g.ptr[v]; k<g.ptr[v+1]; ++k) {
+            int q = part[g.adj[k]];
+            if (conn[q]==0 && q!=p)
+               touched.push_back(q);
+            conn[q] += g.ew[k];
+         }
+         int best = -1;
+         long bg = 0;
+         bool over = (pw[p]>maxw);
+         for (auto const& q: touched) {
+            long gain = conn[q] - conn[p];
+            if (pw[q]+g.vw[v]>maxw || pw[p]<=g.vw[v])
+               continue;
+            bool ok = (gain>0) || (gain==0 && pw[q]+g.vw[v]<pw[p]) || over;
+            if (ok && (best<0 || gain>bg || (gain==bg && pw[q]<pw[best])))
+               best = q, bg = gain;
+         }
+         for (auto const& q: touched)
+            conn[q] = 0;
+         conn[p] = 0;
+         touched.clear();
+         if (best>=0) {
+            part[v] = best;
+            pw[p] -= g.vw[v], pw[best] += g.vw[v];
+            moved++;
+         }
+      }
+      if (moved==0)
+         break;
+   }
+}
+
+
+/*
+ * Partition in nb parts. Returns 1 if there are less vertices than parts.
+ */
+int partition::run(int nb)
+{
+   size_t n = _g.size();
+   if (nb<1 || n<size_t(nb))
+      return 1;
+   _nb_parts = nb;
+   vector<int> part(n,0);
+   vector<Graph> lev;
+   long w = std::accumulate(_g.vw.begin(),_g.vw.end(),0L);
+   size_t target = std::max<size_t>(15*nb,64);
+   int maxw = std::max(1,int(1.5*w/target));
+   auto G = [&](size_t l) -> Graph& { return l ? lev[l-1] : _g; };
+   lev.reserve(64);
+   while (nb>1 && G(lev.size()).size()>target) {
+      Graph c;
+      coarsen(G(lev.size()),c,maxw);
+      if (c.size()>0.95*G(lev.size()).size())
+         break;
+      lev.push_back(std::move(c));
+   }
+   _nb_levels = int(lev.size()) + 1;
+
+   Graph &gc = G(lev.size());
+   part.assign(gc.size(),0);
+   vector<size_t> v(gc.size());
+   std::iota(v.begin(),v.end(),0);
+   bisect(gc,v,nb,0,part);
+   refine(gc,part);
+   for (size_t l=lev.size(); l>0; --l) {
+      Graph &g = G(l-1);
+      vector<int> pf(g.size());
+      for (size_t i=0; i<g.size(); ++i)
+         pf[i] = part[g.cmap[i]];
+      part.swap(pf);
+      refine(g,part);
+      vector<size_t>().swap(g.cmap);
+      if (l>1)
+         lev.pop_back();
+   }
+   _part.swap(part);
+
+   _cut = 0;
+   vector<long> pw(nb,0);
+   for (size_t i=0; i<n; ++i) {
+      pw[_part[i]] += _g.vw[i];
+      for (size_t k=_g.ptr[i]; k<_g.ptr[i+1]; ++k)
+         if (_part[_g.adj[k]]!=_part[i])
+            _cut += _g.ew[k];
+   }
+   _cut /= 2;
+   _imbalance = *std::max_element(pw.begin(),pw.end())*double(nb)/double(w);
+   _sd.clear(), _owner.clear();
+   if (_el_ptr.size())
+      setSubdomains();
+   return 0;
+}
+
+
+/*
+ * Elements, nodes, interface nodes and halo of each subdomain
+ */
+void partition::setSubdomains()
+{
+   size_t ne = _el_ptr.size() - 1;
+   _sd.assign(_nb_parts,Subdomain());
+   _owner.assign(_nb_nodes,-1);
+   vector<size_t> n_ptr(_nb_nodes+1,0), n_el(_el_node.size());
+   for (auto const& n: _el_node)
+      n_ptr[n+1]++;
+   for (size_t n=0; n<_nb_nodes; ++n)
+      n_ptr[n+1] += n_ptr[n];
+   vector<size_t> pos(n_ptr.begin(),n_ptr.end()-1);
+   vector<char> shared(_nb_nodes,0);
+   for (size_t e=0; e<ne; ++e) {
+      int p = _part[e];
+      _sd[p].elements.push_back(e);
+      for (size_t k=_el_ptr[e]; k<_el_ptr[e+1]; ++k) {
+         size_t n = _el_node[k];
+         n_el[pos[n]++] = e;
+         if (_owner[n]<0)
+            _owner[n] = p;
+         else if (_owner[n]!=p)
+            shared[n] = 1, _owner[n] = std::min(_owner[n],p);
+      }
+   }
+   vector<int> mark(_nb_nodes,-1), emark(ne,-1);
+   for (int p=0; p<_nb_parts; ++p) {
+      Subdomain &sd = _sd[p];
+      for (auto const& e: sd.elements) {
+         for (size_t k=_el_ptr[e]; k<_el_ptr[e+1]; ++k) {
+            size_t n = _el_node[k];
+            if (mark[n]!=p) {
+               mark[n] = p;
+               sd.nodes.push_back(n);
+               if (shared[n])
+                  sd.interface.push_back(n);
+            }
+         }
+      }
+      std::sort(sd.nodes.begin(),sd.nodes.end());
+      std::sort(sd.interface.begin(),sd.interface.end());
+      for (auto const& n: sd.interface) {
+         for (size_t l=n_ptr[n]; l<n_ptr[n+1]; ++l) {
+            size_t f = n_el[l];
+            if (_part[f]!=p && emark[f]!=p) {
+               emark[f] = p;
+               sd.halo_elements.push_back(f);
+            }
+         }
+      }
+      std::sort(sd.halo_elements.begin(),sd.halo_elements.end());
+      for (auto const& f: sd.halo_elements) {
+         for (size_t k=_el_ptr[f]; k<_el_ptr[f+1]; ++k) {
+            size_t n = _el_node[k];
+            if (mark[n]!=p) {
+               mark[n] = p;
+               sd.halo_nodes.push_back(n);
+            }
+         }
+      }
+      std::sort(sd.halo_nodes.begin(),sd.halo_nodes.end());
+   }
+}
+
+} /* namespace RITA */
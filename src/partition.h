@@ -0,0 +1,99 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                        Definition of class 'partition'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+using std::vector;
+
+namespace RITA {
+
+/*
+ * Multilevel k-way graph partitioning.
+ * The graph is coarsened by heavy edge matching until it has a few vertices
+ * per part, the coarsest graph is split by recursive bisection (greedy graph
+ * growing), and the partition is projected back level by level, being
+ * improved at each level by a greedy k-way refinement of boundary vertices
+ * that reduces the edge cut under the balance constraint
+ *   weight(part) <= (1+tol) * total weight / nb.
+ * For a mesh (set), the partitioned graph is the dual graph: elements are
+ * adjacent if they share a side (2 nodes in 2-D, 3 in 3-D). Each subdomain
+ * then gets its elements and nodes, its interface nodes (shared with other
+ * subdomains) and a halo: the elements of other subdomains sharing a node
+ * with it, and their nodes that are not in the subdomain. A node is owned by
+ * the subdomain of smallest index among those containing it.
+ * Any graph can also be partitioned by setGraph (e.g. the graph of a matrix).
+ * Vertex, element and node numbers are 0-based.
+ */
+class partition
+{
+
+ public:
+
+    struct Subdomain {
+       vector<size_t> elements, nodes, interface, halo_elements, halo_nodes;
+    };
+
+    partition();
+    ~partition() { }
+    int set(int dim, size_t nb_nodes, const vector<size_t>& el_ptr, const vector<size_t>& el_node);
+    int setGraph(const vector<size_t>& g_ptr, const vector<size_t>& g_adj);
+    void setTolerance(double tol) { _tol = tol; }
+    int run(int nb);
+    int getNbParts() const { return _nb_parts; }
+    const vector<int>& getPart() const { return _part; }
+    const vector<int>& getNodeOwner() const { return _owner; }
+    const Subdomain& getSubdomain(int p) const { return _sd[p]; }
+    size_t getEdgeCut() const { return _cut; }
+    double getImbalance() const { return _imbalance; }
+    int getNbLevels() const { return _nb_levels; }
+
+ private:
+
+    struct Graph {
+       vector<size_t> ptr, adj, cmap;
+       vector<int> ew, vw;
+       size_t size() const { return vw.size(); }
+    };
+
+    int _nb_parts, _nb_levels;
+    size_t _nb_nodes, _cut;
+    double _tol, _imbalance;
+    vector<size_t> _el_ptr, _el_node;
+    vector<int> _part, _owner;
+    vector<Subdomain> _sd;
+    Graph _g;
+
+    void coarsen(Graph& g, Graph& c, int maxw) const;
+    void bisect(const Graph& g, vector<size_t>& v, int nb, int first, vector<int>& part) const;
+    void refine(const Graph& g, vector<int>& part) const;
+    void setSubdomains();
+};
+
+} /* namespace RITA */
@@ -0,0 +1,371 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Implementation of class 'renumber'
+
+  ==============================================================================*/
+
+
+
+#include <stdint.h>
+#include <algorithm>
+#include <numeric>
+#include "renumber.h"
+
+namespace RITA {
+
+renumber::renumber()
+         : _dim(0), _nb_nodes(0), _nb_el(0)
+{
+}
+
+
+/*
+ * dim: space dimension, coord: node coordinates (dim per node),
+ * el_ptr, el_node: element connectivity in compressed form, the nodes of
+ * element e being el_node[el_ptr[e]], ..., el_node[el_ptr[e+1]-1] (0-based).
+ */
+int renumber::set(int                   dim,
+                  const vector<double>& coord,
+                  const vector<size_t>& el_ptr,
+                  const vector<size_t>& el_node)
+{
+   if (dim<1 || dim>3 || coord.size()%dim || el_ptr.size()==0)
+      return 1;
+   _dim = dim;
+   _nb_nodes = coord.size()/dim;
+   _nb_el = el_ptr.size() - 1;
+   if (el_ptr.back()!=el_node.size())
+      return 1;
+   for (auto n: el_node) {
+      if (n>=_nb_nodes)
+         return 1;
+   }
+   _coord = coord;
+   _el_ptr = el_ptr;
+   _el_node = el_node;
+   _np.clear();
+   _ep.clear();
+   setGraph();
+   return 0;
+}
+
+
+/*
+ * Node graph: two nodes are adjacent if they belong to a same element.
+ */
+void renumber::setGraph()
+{
+   vector<vector<size_t> > adj(_nb_nodes);
+   for (size_t e=0; e<_nb_el; ++e) {
+      for (size_t i=_el_ptr[e]; i<_el_ptr[e+1]; ++i) {
+         for (size_t j=_el_ptr[e]; j<_el_ptr[e+1]; ++j) {
+            if (_el_node[i]!=_el_node[j])
+               adj[_el_node[i]].push_back(_el_node[j]);
+         }
+      }
+   }
+   _g_ptr.assign(_nb_nodes+1,0);
+   _g_adj.clear();
+   for (size_t n=0; n<_nb_nodes; ++n) {
+      std::sort(adj[n].begin(),adj[n].end());
+      adj[n].erase(std::unique(adj[n].begin(),adj[n].end()),adj[n].end());
+      _g_adj.insert(_g_adj.end(),adj[n].begin(),adj[n].end());
+      _g_ptr[n+1] = _g_adj.size();
+   }
+}
+
+
+int renumber::run(int method)
+{
+   if (_nb_nodes==0)
+      return 1;
+   if (method==RCM_RENUMBER)
+      RCM();
+   else if (method==HILBERT_RENUMBER)
+      Hilbert();
+   else if (method==ND_RENUMBER) {
+      vector<size_t> nodes(_nb_nodes);
+      std::iota(nodes.begin(),nodes.end(),0);
+      _np.assign(_nb_nodes,0);
+      _side.assign(_nb_nodes,0);
+      Dissection(nodes,0);
+      _side.clear();
+   }
+   else
+      return 1;
+   setElements();
+   return 0;
+}
+
+
+/*
+ * Breadth first search from s through nodes with mark[n]==0. Visited nodes are
+ * appended to order level by level, neighbours being taken by increasing
+ * degree, and marked -1. last is the position in order of the first node of
+ * the last level. Returns the number of levels.
+ */
+size_t renumber::BFS(size_t          s,
+                     vector<int>&    mark,
+                     vector<size_t>& order,
+                     size_t&         last) const
+{
+   size_t nb_levels = 0, b = order.size();
+   order.push_back(s);
+   mark[s] = -1;
+   while (b<order.size()) {
+      size_t e = order.size();
+      last = b;
+      nb_levels++;
+      for (size_t i=b; i<e; ++i) {
+         size_t n = order[i], k = order.size();
+         for (size_t j=_g_ptr[n]; j<_g_ptr[n+1]; ++j) {
+            size_t m = _g_adj[j];
+            if (mark[m]==0) {
+               mark[m] = -1;
+               order.push_back(m);
+            }
+         }
+         std::stable_sort(order.begin()+k,order.end(),
+                          [this](size_t p, size_t q) { return degree(p)<degree(q); });
+      }
+      b = e;
+   }
+   return nb_levels;
+}
+
+
+/*
+ * Reverse Cuthill-McKee ordering. Each connected component is started from a
+ * pseudo-peripheral node obtained by the George-Liu algorithm.
+ */
+void renumber::RCM()
+{
+   vector<int> mark(_nb_nodes,0);
+   vector<size_t> order, nd(_nb_nodes);
+   order.reserve(_nb_nodes);
+   std::iota(nd.begin(),nd.end(),0);
+   std::stable_sort(nd.begin(),nd.end(),[this](size_t p, size_t q) { return degree(p)<degree(q); });
+   for (auto s: nd) {
+      if (mark[s])
+         continue;
+      vector<size_t> lr;
+      size_t last = 0, nl = BFS(s,mark,lr,last);
+      while (1) {
+         size_t x = lr[last];
+         for (size_t i=last+1; i<lr.size(); ++i) {
+            if (degree(lr[i])<degree(x))
+               x = lr[i];
+         }
+         for (auto n: lr)
+            mark[n] = 0;
+         vector<size_t> lx;
+         size_t lastx = 0, nx = BFS(x,mark,lx,lastx);
+         if (nx<=nl)
+            break;
+         lr.swap(lx);
+         last = lastx, nl = nx;
+      }
+      for (auto n: lr)
+         mark[n] = 1;
+      order.insert(order.end(),lr.begin(),lr.end());
+   }
+   _np.resize(_nb_nodes);
+   for (size_t i=0; i<_nb_nodes; ++i)
+      _np[order[i]] = _nb_nodes - 1 - i;
+}
+
+
+/*
+ * Hilbert curve ordering. Coordinates are scaled to integers of b bits and
+ * the Hilbert index is obtained by Skilling's transform (AIP Conf. Proc. 707,
+ * 2004).
+ */
+void renumber::Hilbert()
+{
+   const int b = (_dim==1) ? 63 : ((_dim==2) ? 31 : 21);
+   const uint64_t top = (uint64_t(1)<<b) - 1;
+   double xmin[3], xmax[3];
+   for (int a=0; a<_dim; ++a) {
+      xmin[a] = xmax[a] = _coord[a];
+      for (size_t n=1; n<_nb_nodes; ++n) {
+         xmin[a] = std::min(xmin[a],_coord[_dim*n+a]);
+         xmax[a] = std::max(xmax[a],_coord[_dim*n+a]);
+      }
+   }
+   vector<uint64_t> key(_nb_nodes);
+   for (size_t n=0; n<_nb_nodes; ++n) {
+      uint64_t X[3] = {0,0,0};
+      for (int a=0; a<_dim; ++a) {
+         double h = xmax[a] - xmin[a];
+         if (h>0.)
+            X[a] = uint64_t((_coord[_dim*n+a]-xmin[a])/h*double(top));
+         X[a] = std::min(X[a],top);
+      }
+      const uint64_t M = uint64_t(1)<<(b-1);
+      for (uint64_t Q=M; Q>1; Q>>=1) {
+         uint64_t P = Q - 1;
+         for (int i=0; i<_dim; ++i) {
+            if (X[i]&Q)
+               X[0] ^= P;
+            else {
+               uint64_t t = (X[0]^X[i]) & P;
+               X[0] ^= t, X[i] ^= t;
+            }
+         }
+      }
+      for (int i=1; i<_dim; ++i)
+         X[i] ^= X[i-1];
+      uint64_t t = 0;
+      for (uint64_t Q=M; Q>1; Q>>=1) {
+         if (X[_dim-1]&Q)
+            t ^= Q - 1;
+      }
+      uint64_t k = 0;
+      for (int q=b-1; q>=0; --q) {
+         for (int i=0; i<_dim; ++i)
+            k = (k<<1) | (((X[i]^t)>>q)&1);
+      }
+      key[n] = k;
+   }
+   vector<size_t> order(_nb_nodes);
+   std::iota(order.begin(),order.end(),0);
+   std::stable_sort(order.begin(),order.end(),[&key](size_t p, size_t q) { return key[p]<key[q]; });
+   _np.resize(_nb_nodes);
+   for (size_t i=0; i<_nb_nodes; ++i)
+      _np[order[i]] = i;
+}
+
+
+/*
+ * Nested dissection of nodes, numbered from first. The set is bisected at the
+ * median of its largest extent. Nodes of the first half having a neighbour in
+ * the second half form the separator, numbered last.
+ */
+void renumber::Dissection(vector<size_t>& nodes,
+                          size_t          first)
+{
+   const size_t leaf = 32;
+   size_t nn = nodes.size();
+   if (nn<=leaf) {
+      for (size_t i=0; i<nn; ++i)
+         _np[nodes[i]] = first + i;
+      return;
+   }
+   int a = 0;
+   double ext = -1.;
+   for (int d=0; d<_dim; ++d) {
+      double xmin=_coord[_dim*nodes[0]+d], xmax=xmin;
+      for (auto n: nodes) {
+         xmin = std::min(xmin,_coord[_dim*n+d]);
+         xmax = std::max(xmax,_coord[_dim*n+d]);
+      }
+      if (xmax-xmin>ext)
+         ext = xmax - xmin, a = d;
+   }
+   size_t h = nn/2;
+   std::nth_element(nodes.begin(),nodes.begin()+h,nodes.end(),
+                    [this,a](size_t p, size_t q) { return _coord[_dim*p+a]<_coord[_dim*q+a]; });
+   for (size_t i=0; i<nn; ++i)
+      _side[nodes[i]] = (i<h) ? 1 : 2;
+   vector<size_t> left, right(nodes.begin()+h,nodes.end()), sep;
+   for (size_t i=0; i<h; ++i) {
+      size_t n = nodes[i];
+      bool s = false;
+      for (size_t j=_g_ptr[n]; j<_g_ptr[n+1] && !s; ++j)
+         s = (_side[_g_adj[j]]==2);
+      if (s)
+         sep.push_back(n);
+      else
+         left.push_back(n);
+   }
+   for (auto n: nodes)
+      _side[n] = 0;
+   nodes.clear();
+   nodes.shrink_to_fit();
+   size_t nl=left.size(), nr=right.size();
+   Dissection(left,first);
+   Dissection(right,first+nl);
+   first += nl + nr;
+   for (size_t i=0; i<sep.size(); ++i)
+      _np[sep[i]] = first + i;
+}
+
+
+/*
+ * Elements are sorted by their smallest new node number.
+ */
+void renumber::setElements()
+{
+   vector<size_t> key(_nb_el,0), order(_nb_el);
+   for (size_t e=0; e<_nb_el; ++e) {
+      key[e] = _nb_nodes;
+      for (size_t i=_el_ptr[e]; i<_el_ptr[e+1]; ++i)
+         key[e] = std::min(key[e],_np[_el_node[i]]);
+   }
+   std::iota(order.begin(),order.end(),0);
+   std::stable_sort(order.begin(),order.end(),[&key](size_t p, size_t q) { return key[p]<key[q]; });
+   _ep.resize(_nb_el);
+   for (size_t i=0; i<_nb_el; ++i)
+      _ep[order[i]] = i;
+}
+
+
+/*
+ * Maximal distance |p(i)-p(j)| between numbers of adjacent nodes, p being the
+ * new numbering if renumbered is true and the original one otherwise.
+ */
+size_t renumber::getBandwidth(bool renumbered) const
+{
+   bool p = renumbered && _np.size()==_nb_nodes;
+   size_t bw = 0;
+   for (size_t n=0; n<_nb_nodes; ++n) {
+      size_t i = p ? _np[n] : n;
+      for (size_t j=_g_ptr[n]; j<_g_ptr[n+1]; ++j) {
+         size_t k = p ? _np[_g_adj[j]] : _g_adj[j];
+         bw = std::max(bw,(k>i) ? k-i : i-k);
+      }
+   }
+   return bw;
+}
+
+
+/*
+ * Envelope size: sum over rows of the distance between the diagonal and the
+ * first nonzero entry of the row.
+ */
+size_t renumber::getProfile(bool renumbered) const
+{
+   bool p = renumbered && _np.size()==_nb_nodes;
+   size_t pf = 0;
+   for (size_t n=0; n<_nb_nodes; ++n) {
+      size_t i = p ? _np[n] : n, m = i;
+      for (size_t j=_g_ptr[n]; j<_g_ptr[n+1]; ++j)
+         m = std::min(m,p ? _np[_g_adj[j]] : _g_adj[j]);
+      pf += i - m;
+   }
+   return pf;
+}
+
+} /* namespace RITA */
@@ -0,0 +1,91 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                         Definition of class 'renumber'
+
+  ==============================================================================*/
+
+
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+using std::vector;
+
+namespace RITA {
+
+enum RenumberMethod {
+   RCM_RENUMBER = 0,
+   HILBERT_RENUMBER = 1,
+   ND_RENUMBER = 2
+};
+
+/*
+ * Renumbering of mesh nodes and elements to improve the locality of the
+ * assembled matrix and of the vectors attached to the mesh.
+ * The node graph is built from element connectivity. Available orderings:
+ *   rcm: Reverse Cuthill-McKee from a pseudo-peripheral node, minimizes the
+ *        bandwidth,
+ *   hilbert: Nodes sorted along a Hilbert space filling curve, improves cache
+ *        reuse without using the graph,
+ *   nested-dissection: Recursive coordinate bisection, the separator of each
+ *        bisection being numbered after both halves.
+ * Elements are then sorted by their smallest new node number.
+ * Node and element numbers are 0-based. Node n of the original mesh becomes
+ * node getNodePerm()[n].
+ */
+class renumber
+{
+
+ public:
+
+    renumber();
+    ~renumber() { }
+    int set(int dim, const vector<double>& coord, const vector<size_t>& el_ptr,
+            const vector<size_t>& el_node);
+    int run(int method);
+    const vector<size_t>& getNodePerm() const { return _np; }
+    const vector<size_t>& getElementPerm() const { return _ep; }
+    size_t getBandwidth(bool renumbered=true) const;
+    size_t getProfile(bool renumbered=true) const;
+
+ private:
+
+    int _dim;
+    size_t _nb_nodes, _nb_el;
+    vector<double> _coord;
+    vector<size_t> _el_ptr, _el_node, _g_ptr, _g_adj, _np, _ep;
+    vector<int> _side;
+
+    size_t degree(size_t n) const { return _g_ptr[n+1] - _g_ptr[n]; }
+    void setGraph();
+    size_t BFS(size_t s, vector<int>& mark, vector<size_t>& order, size_t& last) const;
+    void RCM();
+    void Hilbert();
+    void Dissection(vector<size_t>& nodes, size_t first);
+    void setElements();
+};
+
+} /* namespace RITA */
@@ -125,7 +125,7 @@ rita::Mode_Ptr rita::MODE [] = {
 rita::rita()
      : meshOK(false), solveOK(false), dataOK(false), _load(false), _ae(nullptr),
        _ode(nullptr), _pde(nullptr), _script_file(""), _in(nullptr), _verb(1), _ret(0),
-       _default_field(true), _theMesh(nullptr), _exit_ok(false), _nb_eq(0),
+       _default_field(true), _theMesh(nullptr), _grid(nullptr), _exit_ok(false), _nb_eq(0),
        _nb_fields(0), _ieq(0), _ifield(0), _nb_ae(0), _nb_ode(0), _nb_pde(0),
        _analysis_type(NONE)
 {
@@ -146,6 +146,10 @@ rita::rita()
    _time_step = 0.1;
    _adapted_time_step = 0;
    _scheme = "backward-euler";
+   _nb_eigv = 1;
+   _eigen_vectors = false;
+   _eigen_shift = 0.;
+   _eigen_method = "lanczos";
 }
 
 
@@ -335,7 +339,8 @@ void rita::setMesh()
    _theMesh = new OFELI::Mesh;
    _ret = _mesh->run();
    _theMesh = _mesh->get();
-   if (_theMesh)
+   _grid = _mesh->getGrid();
+   if (_theMesh || _grid)
       meshOK = true;
    if (_verb>1)
       cout << "Leaving mode 'mesh' ..." << endl;
@@ -557,7 +562,91 @@ void rita::setOptim()
 
 void rita::setEigen()
 {
+   _ret = 0;
+   string method=_eigen_method, matrix="";
+   bool vectors = _eigen_vectors;
+   static const string H = "eigen [nb=n] [vectors] [shift=s] [method=m]\n"
+                           "eigen matrix=M [vectors]\n\n"
+                           "n: Number of eigenvalues to compute, the lowest ones or the closest ones to s.\n"
+                           "   Default value is 1.\n"
+                           "vectors: Toggle meaning that eigenvectors are saved in files.\n"
+                           "s: Shift. Eigenvalues are computed near s. Default value is 0.\n"
+                           "m: Eigenvalue solver to choose among the values: lanczos (Thick restart Lanczos\n"
+                           "   in shift-invert mode with a sparse factorization), lobpcg (LOBPCG with an algebraic\n"
+                           "   multigrid preconditioner, for the lowest eigenvalues of large problems).\n"
+                           "   Default value is lanczos.\n"
+                           "M: Name of a symmetric matrix defined in data. Its whole spectrum is computed\n"
+                           "   by a dense solver instead of the eigenvalue problem of the equation.\n";
+   static const vector<string> kw_method {"lanczos","lobpcg"};
+   static const vector<string> kw {"help","?","set","nb","vec$tors","shift","method","matrix"};
+   _cmd->set(kw);
+   _nb_args = _cmd->getNbArgs();
+   for (int k=0; k<_nb_args; ++k) {
+      switch (_cmd->getArg()) {
+
+         case 0:
+         case 1:
+            cout << H << endl;
+            _ret = 0;
+            return;
+
+         case 2:
+            setConfigure();
+            return;
+
+         case 3:
+            _nb_eigv = _cmd->int_token();
+            break;
+
+         case 4:
+            _eigen_vectors = true;
+            break;
+
+         case 5:
+            _eigen_shift = _cmd->double_token();
+            break;
+
+         case 6:
+            method = _cmd->string_token();
+            break;
+
+         case 7:
+            matrix = _cmd->string_token();
+            break;
+
+         default:
+            msg("eigen>","Unknown argument: "+_cmd->Arg());
+            _ret = 1;
+            return;
+      }
+   }
+   if (matrix!="") {
+      *ofh << "eigen  matrix=" << matrix;
+      if (_eigen_vectors)
+         *ofh << "  vectors";
+      *ofh << endl;
+      _data->setVerbose(_verb);
+      _ret = _data->runDenseEigen(matrix,false,_eigen_vectors);
+      _eigen_vectors = vectors;
+      return;
+   }
+   if (_nb_eigv<1) {
+      msg("eigen>","Number of eigenvalues must be positive.");
+      _nb_eigv = 1;
+      _ret = 1;
+      return;
+   }
+   if (find(kw_method.begin(),kw_method.end(),method)==kw_method.end()) {
+      msg("eigen>","The eigenvalue solver "+method+" is unknown.","Available values: lanczos, lobpcg");
+      _ret = 1;
+      return;
+   }
+   _eigen_method = method;
    _analysis_type = EIGEN;
+   *ofh << "eigen  nb=" << _nb_eigv;
+   if (_eigen_vectors)
+      *ofh << "  vectors";
+   *ofh << "  shift=" << _eigen_shift << "  method=" << _eigen_method << endl;
 }
 
 
@@ -633,7 +722,10 @@ void rita::setPDE()
       return;
    }
    _pde = new equa(this);
-   _pde->set(pde_name,_theMesh);
+   if (_theMesh==nullptr && _grid!=nullptr)
+      _pde->set(pde_name,_grid);
+   else
+      _pde->set(pde_name,_theMesh);
    *ofh << "pde " << pde_name << endl;
    runPDE();
    if (_ret && _pde!=nullptr) {
@@ -691,7 +783,7 @@ int rita::set_ls(string ls,
       return 1;
    }
    auto it2 = Prec.find(prec);
-   if (it2==Prec.end()) {
+   if (it2==Prec.end() && xPrec.find(prec)==xPrec.end()) {
       msg("equation>pde>ls>","Unknown linear preconditioner: "+prec);
       return 1;
    }
@@ -729,6 +821,15 @@ void rita::setSummary()
    cout << "---------------------------------------------------------------" << endl;
    if (meshOK==false)
       msg("summary>","No mesh defined.");
+   else if (_theMesh==nullptr && _grid!=nullptr) {
+      cout << "MESH DATA" << endl;
+      cout << "Structured mesh:    " << _grid->getNbElements(0);
+      for (int a=1; a<_grid->getDim(); ++a)
+         cout << " x " << _grid->getNbElements(a);
+      cout << endl;
+      cout << "Number of nodes:    " << _grid->getNbNodes() << endl;
+      cout << "Number of elements: " << _grid->getNbElements() << endl << endl;
+   }
    else {
       cout << "MESH DATA" << endl;
       cout << "Number of nodes:    " << _theMesh->getNbNodes() << endl;
@@ -750,6 +851,8 @@ void rita::setSummary()
       cout << "Analysis is an eigenproblem analysis." << endl;
       cout << "Number of eigenvalues to extract: " << _nb_eigv << endl;
       cout << "Extract eigenvectors ? " << _eigen_vectors << endl;
+      cout << "Shift: " << _eigen_shift << endl;
+      cout << "Eigenvalue solver: " << _eigen_method << endl;
    }
    else if (_analysis_type == OPTIMIZATION) {
       cout << "Analysis is optimization." << endl;
@@ -761,7 +864,24 @@ void rita::setSummary()
       //      cout << "Field: " << PDE[i]->field << endl;
       cout << "Space discretization method: " << PDE[i]->spD << endl;
       cout << "Linear system solver: " << rLs[PDE[i]->ls] << endl;
-      cout << "Linear system preconditioner: " << rPrec[PDE[i]->prec] << endl;
+      if (PDE[i]->auto_ls)
+         cout << "Linear solver and preconditioner selected by trial solves" << endl;
+      else if (PDE[i]->ls==OFELI::DIRECT_SOLVER && (PDE[i]->xprec==CHOLESKY_PREC || PDE[i]->xprec==LDLT_PREC))
+         cout << "Sparse factorization: supernodal " << rxPrec[PDE[i]->xprec] << endl;
+      else if (PDE[i]->xprec==ASM_PREC)
+         cout << "Linear system preconditioner: asm, overlap " << PDE[i]->asm_overlap
+              << (PDE[i]->asm_direct ? ", direct subdomain solver" : ", ilu subdomain solver")
+              << (PDE[i]->asm_coarse ? ", coarse space correction" : "") << endl;
+      else if (PDE[i]->xprec!=NO_EXT_PREC)
+         cout << "Linear system preconditioner: " << rxPrec[PDE[i]->xprec] << endl;
+      else
+         cout << "Linear system preconditioner: " << rPrec[PDE[i]->prec] << endl;
+      if (PDE[i]->mixed)
+         cout << "Linear system solved in mixed precision" << endl;
+      if (PDE[i]->matrix_free)
+         cout << "Linear system solved with a matrix-free operator" << endl;
+      if (PDE[i]->parallel_prec || PDE[i]->multicolor)
+         cout << "Level scheduled preconditioner" << (PDE[i]->multicolor ? " with multicolor ordering" : "") << endl;
    }
    cout << "---------------------------------------------------------------" << endl;
 }
@@ -43,6 +43,7 @@ using std::string;
 
 #include "ritaException.h"
 #include "OFELI.h"
+#include "linearSolver.h"
 
 
 namespace RITA {
@@ -64,6 +65,7 @@ class help;
 class solve;
 class mesh;
 class equa;
+class structuredMesh;
 
 #define CATCH                                                   \
    catch(OFELIException &e) {                                   \
@@ -143,7 +145,7 @@ class rita
    data *_data;
    odae *_ae, *_ode;
    equa *_pde;
-   string _script_file, _scheme;
+   string _script_file, _scheme, _eigen_method;
    ifstream _icf, *_in;
    cmd *_cmd;
    int _verb, _key, _ret, _opt;
@@ -156,12 +158,13 @@ class rita
    optim *_optim;
    approximation *_approx;
    integration *_integration;
-   double _init_time, _time_step, _final_time;
+   double _init_time, _time_step, _final_time, _eigen_shift;
    int _adapted_time_step, _nb_eigv, _nb_args;
    bool _eigen_vectors, _default_field;
    std::vector<equa *> PDE;
    std::vector<odae *> ALGEBRAIC, ODE;
    OFELI::Mesh* _theMesh;
+   structuredMesh* _grid;
    bool _analysis_ok, _exit_ok;
    int _nb_eq, _nb_fields, _ieq, _ifield, _nb_ae, _nb_ode, _nb_pde;
    int _dim, _analysis_type;
@@ -248,6 +251,22 @@ class rita
                                               {OFELI::DILU_PREC,"dilu"},
                                               {OFELI::ILU_PREC,"ilu"},
                                               {OFELI::SSOR_PREC,"ssor"}};
+   map<string,ExtPreconditioner> xPrec = {{"amg",AMG_PREC},
+                                          {"gmg",GMG_PREC},
+                                          {"chebyshev",CHEBYSHEV_PREC},
+                                          {"schur-mass",SCHUR_MASS_PREC},
+                                          {"schur-pcd",SCHUR_PCD_PREC},
+                                          {"cholesky",CHOLESKY_PREC},
+                                          {"ldlt",LDLT_PREC},
+                                          {"asm",ASM_PREC}};
+   map<ExtPreconditioner,string> rxPrec = {{AMG_PREC,"amg"},
+                                           {GMG_PREC,"gmg"},
+                                           {CHEBYSHEV_PREC,"chebyshev"},
+                                           {SCHUR_MASS_PREC,"schur-mass"},
+                                           {SCHUR_PCD_PREC,"schur-pcd"},
+                                           {CHOLESKY_PREC,"cholesky"},
+                                           {LDLT_PREC,"ldlt"},
+                                           {ASM_PREC,"asm"}};
    vector<int> _eq_type;
    int setSpaceDiscretization(string& sp);
 };
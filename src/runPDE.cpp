@@ -39,32 +39,42 @@ namespace RITA {
 
 void rita::runPDE()
 {
-   int nb_args = 0, nb_fields = 0, nb=0;
-   bool field_ok = false;
+   int nb_args = 0, nb_fields = 0, nb=0, ov=1;
+   bool field_ok = false, asm_direct=false, asm_coarse=false;
    vector<string> field_name;
-   string str = "", str1 = "";
+   string str = "", str1 = "", str2 = "", str3 = "";
    _pde->set(_cmd);
    _pde->log.field = true;
    _ret = 0;
    if (_analysis_type==NONE)
       _analysis_type = STEADY_STATE;
-   if (_theMesh==nullptr) {
+   if (_theMesh==nullptr && _grid==nullptr) {
       msg("pde>","No mesh created");
       _pde->log.mesh = true;
       _ret = 1;
       return;
    }
-   else if (_theMesh->getNbNodes()==0) {
+   else if (_theMesh!=nullptr && _theMesh->getNbNodes()==0) {
       msg("pde>","Empty mesh");
       _pde->log.mesh = true;
       _ret = 1;
       return;
    }
    _pde->ls = OFELI::CG_SOLVER;
-   _pde->prec = OFELI::DILU_PREC;
+   _pde->prec = _pde->isStructured() ? OFELI::DIAG_PREC : OFELI::DILU_PREC;
+   _pde->xprec = NO_EXT_PREC;
+   _pde->mixed = false;
+   _pde->matrix_free = false;
+   _pde->parallel_prec = false;
+   _pde->multicolor = false;
+   _pde->recycle = false;
+   _pde->auto_ls = false;
+   _pde->asm_overlap = 1;
+   _pde->asm_direct = _pde->asm_coarse = false;
    _pde->spD = "feP1";
    const static vector<string> kw {"help","?","set","field","coef","in$it","bc","bf","source","sf",
-                                   "traction","space","ls","nls","clear","end","<","quit","exit","EXIT"};
+                                   "traction","space","ls","nls","clear","end","<","quit","exit","EXIT",
+                                   "case"};
 
    while (1) {
       if ((nb_args=_cmd->readline("rita>pde> "))<0)
@@ -80,6 +90,7 @@ void rita::runPDE()
             cout << "bc:       Set boundary conditions\n";
             cout << "source:   Set sources or body forces\n";
             cout << "sf:       Set side (boundary) forces\n";
+            cout << "case:     Add a load case\n";
             cout << "space:    Space discretization method\n";
             cout << "ls:       Set linear system solver\n";
             cout << "nls:      Set nonlinear system iteration procedure\n";
@@ -142,7 +153,7 @@ void rita::runPDE()
             break;
 
          case 12:
-            if (_cmd->setNbArg(1,"Linear solver and optional preconditioner to be supplied.",1)) {
+            if (_cmd->setNbArg(1,"Linear solver, optional preconditioner and option to be supplied.",1)) {
                msg("pde>ls>","Missing linear solver data.","",1);
                break;
             }
@@ -150,14 +161,78 @@ void rita::runPDE()
             if (nb==0)
                msg("pde>ls>","Missing linear solver data.");
             _ret = _cmd->get(str);
-            str1 = "ident";
+            if (!_ret && str=="auto") {
+               *ofh << "  ls auto" << endl;
+               _pde->auto_ls = true;
+               _pde->ls = OFELI::CG_SOLVER;
+               _pde->prec = OFELI::DILU_PREC;
+               _pde->xprec = NO_EXT_PREC;
+               _pde->mixed = _pde->matrix_free = _pde->parallel_prec = false;
+               _pde->multicolor = _pde->recycle = false;
+               break;
+            }
+            str1 = "ident", str2 = "double";
             if (nb>1)
                _ret += _cmd->get(str1);
+
+//          Options of the Schwarz preconditioner may follow: overlap=k, direct, coarse
+            ov = 1, asm_direct = asm_coarse = false;
+            for (int k=2; k<nb && !_ret; ++k) {
+               _ret += _cmd->get(str3);
+               if (str1=="asm" && str3.substr(0,8)=="overlap=") {
+                  try {
+                     ov = std::stoi(str3.substr(8));
+                  }
+                  catch (...) {
+                     ov = -1;
+                  }
+                  if (ov<0) {
+                     msg("pde>ls>","Illegal overlap: "+str3.substr(8));
+                     _ret = 1;
+                  }
+               }
+               else if (str1=="asm" && (str3=="direct" || str3=="coarse")) {
+                  asm_direct = asm_direct || (str3=="direct");
+                  asm_coarse = asm_coarse || (str3=="coarse");
+               }
+               else
+                  str2 = str3;
+            }
+            if (!_ret && str2!="double" && str2!="mixed" && str2!="matrix-free" && str2!="parallel" &&
+                str2!="multicolor" && str2!="recycle") {
+               msg("pde>ls>","Unknown option: "+str2,
+                   "Available values: double, mixed, matrix-free, parallel, multicolor, recycle");
+               _ret = 1;
+            }
             if (!_ret) {
-               *ofh << "  ls " << str << " " << str1 << endl;
+               *ofh << "  ls " << str << " " << str1;
+               if (str1=="asm") {
+                  *ofh << " overlap=" << ov;
+                  if (asm_direct)
+                     *ofh << " direct";
+                  if (asm_coarse)
+                     *ofh << " coarse";
+               }
+               if (str2!="double")
+                  *ofh << " " << str2;
+               *ofh << endl;
                if (!set_ls(str,str1)) {
+                  _pde->asm_overlap = ov;
+                  _pde->asm_direct = asm_direct;
+                  _pde->asm_coarse = asm_coarse;
+                  _pde->mixed = (str2=="mixed");
+                  _pde->matrix_free = (str2=="matrix-free");
+                  _pde->parallel_prec = (str2=="parallel");
+                  _pde->multicolor = (str2=="multicolor");
+                  _pde->recycle = (str2=="recycle");
+                  _pde->auto_ls = false;
                   _pde->ls = Ls[str];
-                  _pde->prec = Prec[str1];
+                  _pde->prec = OFELI::IDENT_PREC;
+                  _pde->xprec = NO_EXT_PREC;
+                  if (xPrec.count(str1))
+                     _pde->xprec = xPrec[str1];
+                  else
+                     _pde->prec = Prec[str1];
                }
             }
             else
@@ -199,7 +274,11 @@ void rita::runPDE()
                   break;
                }
                for (int i=0; i<nb_fields; ++i) {
-                  _ifield = _data->addField(field_name[i],NODES,0,_pde->nb_dof[i]);
+                  if (_pde->isStructured())
+                     _ifield = _data->addField(field_name[i],GIVEN_SIZE,
+                                               int(_grid->getNbNodes())*_pde->nb_dof[i]);
+                  else
+                     _ifield = _data->addField(field_name[i],NODES,0,_pde->nb_dof[i]);
                   _data->FieldEquation[_ifield] = _nb_eq;
                   _data->FieldType[_ifield] = PDE_EQ;
                   _pde->fn[i] = field_name[i];
@@ -207,7 +286,7 @@ void rita::runPDE()
                }
                _nb_fields = _data->getNbFields();
                _pde->log.field = false;
-               _pde->b.setSize(_theMesh->getNbEq());
+               _pde->b.setSize(_pde->isStructured() ? _grid->getNbEq() : _theMesh->getNbEq());
                if (_verb) {
                   cout << "Summary of PDE attributes:" << endl;
                   cout << "   PDE name: " << _pde->eq << endl;
@@ -216,7 +295,7 @@ void rita::runPDE()
                      cout << _pde->fn[i] << ", ";
                   cout << _pde->fn[nb_fields-1] << endl;
                   cout << "   PDE space discretization: " << _pde->spD << endl;
-                  cout << "   PDE linear solver: " << rLs[_pde->ls] << endl;
+                  cout << "   PDE linear solver: " << (_pde->auto_ls ? "auto" : rLs[_pde->ls]) << endl;
                }
                _ret = 0;
             }
@@ -240,6 +319,10 @@ void rita::runPDE()
             _ret = 200;
             return;
 
+         case 20:
+            _ret = _pde->setCase();
+            break;
+
          case -2:
          case -3:
          case -4:
@@ -247,7 +330,7 @@ void rita::runPDE()
 
          default:
             msg("pde>","Unknown Command "+_cmd->token(),
-                "Available commands: field, coef, in, bc, bf, sf, space, ls, nls, clear, end, <\n"
+                "Available commands: field, coef, in, bc, bf, sf, case, space, ls, nls, clear, end, <\n"
                 "Global commands:    help, ?, set, quit, exit");
             break;
       }
@@ -0,0 +1,131 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                       Implementation of class 'schurPrec'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include "schurPrec.h"
+
+using std::endl;
+
+namespace RITA {
+
+template<class T_>
+schurPrec<T_>::schurPrec(size_t nu,
+                         bool   pcd)
+              : _nu(nu), _np(0), _pcd(pcd), _k_set(false)
+{
+}
+
+
+template<class T_>
+void schurPrec<T_>::setPressure(const spmat<T_>& M,
+                                const spmat<T_>& K,
+                                const spmat<T_>& Fp)
+{
+   _np = M.size();
+   _dm.resize(_np);
+   for (size_t i=0; i<_np; ++i) {
+      T_ s = 0;
+      for (size_t k=M.row_ptr[i]; k<M.row_ptr[i+1]; ++k)
+         s += M.a[k];
+      _dm[i] = (s!=T_(0)) ? T_(1)/s : T_(1);
+   }
+   _k_set = (K.size()>0);
+   if (_k_set)
+      _K.setup(K);
+   _Fp = Fp;
+}
+
+
+template<class T_>
+int schurPrec<T_>::setup(const spmat<T_>& A)
+{
+   if (_np==0 || _nu+_np!=A.size())
+      return 1;
+   if (_pcd && (!_k_set || _Fp.size()!=_np))
+      return 1;
+   spmat<T_> F;
+   SubMatrix(A,0,_nu,0,_nu,F);
+   SubMatrix(A,0,_nu,_nu,A.size(),_Bt);
+   _F.setup(F);
+   _ru.resize(_nu), _zu.resize(_nu);
+   _rp.resize(_np), _zp.resize(_np), _t.resize(_np);
+   return 0;
+}
+
+
+template<class T_>
+void schurPrec<T_>::solve(const vector<T_>& r,
+                          vector<T_>&       z) const
+{
+   z.resize(_nu+_np);
+   for (size_t i=0; i<_np; ++i)
+      _rp[i] = r[_nu+i];
+
+// Pressure: z_p = -S^{-1} r_p
+   if (_pcd) {
+      _K.solve(_rp,_zp);
+      _Fp.mult(_zp.data(),_t.data());
+      for (size_t i=0; i<_np; ++i)
+         z[_nu+i] = -_dm[i]*_t[i];
+   }
+   else {
+      if (_k_set)
+         _K.solve(_rp,_zp);
+      for (size_t i=0; i<_np; ++i)
+         z[_nu+i] = -_dm[i]*_rp[i] - (_k_set ? _zp[i] : T_(0));
+   }
+
+// Velocity: z_u = F^{-1} (r_u - B^T z_p)
+   _Bt.mult(z.data()+_nu,_zu.data());
+   for (size_t i=0; i<_nu; ++i)
+      _ru[i] = r[i] - _zu[i];
+   _F.solve(_ru,_zu);
+   for (size_t i=0; i<_nu; ++i)
+      z[i] = _zu[i];
+}
+
+
+template<class T_>
+void schurPrec<T_>::print(std::ostream& s) const
+{
+   s << "Block triangular preconditioner: " << _nu << " velocity and " << _np
+     << " pressure unknowns, Schur complement approximation: " << (_pcd ? "PCD" : "pressure mass")
+     << endl;
+   s << "Velocity block: ";
+   _F.print(s);
+   if (_k_set) {
+      s << "Pressure Laplacian: ";
+      _K.print(s);
+   }
+}
+
+template class schurPrec<double>;
+template class schurPrec<float>;
+
+} /* namespace RITA */
@@ -0,0 +1,79 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                         Definition of class 'schurPrec'
+
+  ==============================================================================*/
+
+
+#pragma once
+
+#include "linearSolver.h"
+#include "amg.h"
+
+namespace RITA {
+
+/*
+ * Block triangular preconditioner for saddle point systems
+ *     | F  B^T |
+ *     | B  -C  |
+ * where the first nu unknowns are velocities and the others pressures:
+ *     P = | F  B^T |,  F^{-1} ~ one AMG V-cycle,  S^{-1} ~ Schur complement
+ *         | 0  -S  |
+ * The Schur complement C + B F^{-1} B^T is approximated with pressure
+ * matrices given by setPressure():
+ *  - pressure mass (Cahouet-Chabard): S^{-1} = M^{-1} + K^{-1}, M the pressure
+ *    mass weighted by 1/mu, K the pressure Laplacian weighted by dt/rho
+ *    (empty matrix for a stationary problem),
+ *  - pressure convection-diffusion (PCD): S^{-1} = M^{-1} Fp K^{-1}, with M and
+ *    K the pressure mass and Laplacian, Fp the convection-diffusion operator
+ *    on the pressure space.
+ * M^{-1} is replaced by the inverse of the lumped mass and K^{-1} by one AMG
+ * V-cycle.
+ */
+template<class T_>
+class schurPrec : public precond<T_>
+{
+
+ public:
+
+    schurPrec(size_t nu, bool pcd=false);
+    ~schurPrec() { }
+    void setPressure(const spmat<T_>& M, const spmat<T_>& K, const spmat<T_>& Fp);
+    int setup(const spmat<T_>& A);
+    void solve(const vector<T_>& r, vector<T_>& z) const;
+    void print(std::ostream& s) const;
+
+ private:
+
+    size_t _nu, _np;
+    bool _pcd;
+    spmat<T_> _Bt, _Fp;
+    vector<T_> _dm;
+    amg<T_> _F, _K;
+    bool _k_set;
+    mutable vector<T_> _ru, _zu, _rp, _zp, _t;
+};
+
+} /* namespace RITA */
@@ -0,0 +1,440 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                         Implementation of class 'schwarz'
+
+  ==============================================================================*/
+
+
+#include <math.h>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include "schwarz.h"
+#include "ilu.h"
+#include "cholesky.h"
+#include "partition.h"
+
+using std::cout;
+using std::endl;
+
+namespace RITA {
+
+/*
+ * Symmetry of A up to sqrt(eps)|A| (sorted column indices)
+ */
+template<class T_>
+static bool Symmetric(const spmat<T_>& A)
+{
+   double amax = 0.;
+   for (auto const& v: A.a)
+      amax = std::max(amax,double(std::abs(v)));
+   double eps = sqrt(double(std::numeric_limits<T_>::epsilon()))*amax;
+   for (size_t i=0; i<A.size(); ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j<=i)
+            continue;
+         const unsigned *c0=A.col_ind.data()+A.row_ptr[j], *c1=A.col_ind.data()+A.row_ptr[j+1];
+         const unsigned *c = std::lower_bound(c0,c1,unsigned(i));
+         double aji = (c!=c1 && *c==i) ? double(A.a[A.row_ptr[j]+(c-c0)]) : 0.;
+         if (fabs(double(A.a[k])-aji)>eps)
+            return false;
+      }
+   }
+   return true;
+}
+
+
+template<class T_>
+schwarz<T_>::schwarz(const vector<int>& part,
+                     int                overlap,
+                     bool               direct,
+                     bool               coarse,
+                     bool               restricted)
+            : _part(part), _nb(0), _overlap(std::max(0,overlap)), _direct(direct), _coarse(coarse),
+              _restricted(restricted), _n(0)
+{
+}
+
+
+template<class T_>
+schwarz<T_>::~schwarz()
+{
+   clear();
+}
+
+
+template<class T_>
+void schwarz<T_>::clear()
+{
+   for (auto &sd: _sd) {
+      if (sd.solver!=nullptr)
+         delete sd.solver;
+   }
+   _sd.clear();
+}
+
+
+/*
+ * Subdomain of each unknown: the given partition if it matches A, else a
+ * partition of the graph of A + A^T in as many parts as threads
+ */
+template<class T_>
+void schwarz<T_>::setPart(const spmat<T_>& A)
+{
+   size_t n = A.size();
+   if (_part.size()==n) {
+      _p = _part;
+      _nb = 1;
+      for (auto const& p: _p)
+         _nb = std::max(_nb,p+1);
+      return;
+   }
+   vector<size_t> ptr(n+1,0), adj, pos;
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j!=i)
+            ptr[i+1]++, ptr[j+1]++;
+      }
+   }
+   for (size_t i=0; i<n; ++i)
+      ptr[i+1] += ptr[i];
+   adj.resize(ptr[n]);
+   pos.assign(ptr.begin(),ptr.end()-1);
+   for (size_t i=0; i<n; ++i) {
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         size_t j = A.col_ind[k];
+         if (j!=i)
+            adj[pos[i]++] = j, adj[pos[j]++] = i;
+      }
+   }
+
+// Duplicates (entries present in both triangles) are removed
+   size_t m = 0;
+   for (size_t i=0; i<n; ++i) {
+      size_t b=ptr[i], e=ptr[i+1];
+      std::sort(adj.begin()+b,adj.begin()+e);
+      ptr[i] = m;
+      for (size_t k=b; k<e; ++k) {
+         if (k==b || adj[k]!=adj[k-1])
+            adj[m++] = adj[k];
+      }
+   }
+   ptr[n] = m;
+   adj.resize(m);
+   partition pt;
+   int nb = getNbThreads();
+   if (nb>1 && pt.setGraph(ptr,adj)==0 && pt.run(nb)==0) {
+      _p = pt.getPart();
+      _nb = nb;
+   }
+   else {
+      _p.assign(n,0);
+      _nb = 1;
+   }
+}
+
+
+/*
+ * Subdomain p: unknowns [first,last) owned by p and 'overlap' layers of
+ * neighbours, local matrix and its factorization. loc is a work array of
+ * size n filled with -1, given back in that state.
+ */
+template<class T_>
+int schwarz<T_>::setSubdomain(const spmat<T_>& A,
+                              int              p,
+                              const size_t*    first,
+                              const size_t*    last,
+                              vector<int>&     loc)
+{
+   Subdomain &sd = _sd[p];
+   vector<size_t> &idx = sd.idx;
+   idx.assign(first,last);
+   if (idx.empty())
+      return 0;
+   for (auto const& i: idx)
+      loc[i] = 0;
+   size_t b = 0;
+   for (int l=0; l<_overlap; ++l) {
+      size_t e = idx.size();
+      for (size_t k=b; k<e; ++k) {
+         for (size_t q=A.row_ptr[idx[k]]; q<A.row_ptr[idx[k]+1]; ++q) {
+            size_t j = A.col_ind[q];
+            if (loc[j]<0) {
+               loc[j] = 0;
+               idx.push_back(j);
+            }
+         }
+      }
+      b = e;
+   }
+   std::sort(idx.begin(),idx.end());
+   size_t m = idx.size();
+   sd.own.resize(m);
+   for (size_t i=0; i<m; ++i) {
+      loc[idx[i]] = int(i);
+      sd.own[i] = (_p[idx[i]]==p);
+   }
+
+   spmat<T_> B;
+   B.nb_rows = B.nb_cols = m;
+   B.row_ptr.assign(1,0);
+   for (size_t i=0; i<m; ++i) {
+      for (size_t k=A.row_ptr[idx[i]]; k<A.row_ptr[idx[i]+1]; ++k) {
+         int j = loc[A.col_ind[k]];
+         if (j>=0) {
+            B.col_ind.push_back(unsigned(j));
+            B.a.push_back(A.a[k]);
+         }
+      }
+      B.row_ptr.push_back(B.col_ind.size());
+   }
+   for (auto const& i: idx)
+      loc[i] = -1;
+
+// L D L^T factorization if asked and possible, ILU(0) otherwise
+   int ret = 1;
+   sd.direct = (_direct && Symmetric(B));
+   if (sd.direct) {
+      sd.solver = new cholesky<T_>(true);
+      if ((ret=sd.solver->setup(B))) {
+         delete sd.solver;
+         sd.direct = false;
+      }
+   }
+   if (ret) {
+      sd.solver = new ilu<T_>(OFELI::ILU_PREC,false);
+      ret = sd.solver->setup(B);
+   }
+   sd.r.resize(m);
+   sd.z.resize(m);
+   return ret;
+}
+
+
+/*
+ * Coarse space: Z(i,q) = 1 if unknown i is in subdomain q. AZ = A Z is kept
+ * for the update of the residual, A0 = Z^T A Z is factored.
+ */
+template<class T_>
+void schwarz<T_>::setCoarse(const spmat<T_>& A)
+{
+   size_t nb = size_t(_nb);
+   _AZ.clear();
+   _AZ.nb_rows = _n, _AZ.nb_cols = nb;
+   _AZ.row_ptr.assign(1,0);
+   vector<T_> s(nb,T_(0));
+   vector<char> in(nb,0);
+   vector<unsigned> q;
+   spmat<T_> A0;
+   A0.nb_rows = A0.nb_cols = nb;
+   A0.a.assign(nb*nb,T_(0));
+   for (size_t i=0; i<_n; ++i) {
+      q.clear();
+      for (size_t k=A.row_ptr[i]; k<A.row_ptr[i+1]; ++k) {
+         unsigned c = unsigned(_p[A.col_ind[k]]);
+         if (!in[c])
+            q.push_back(c), in[c] = 1;
+         s[c] += A.a[k];
+      }
+      std::sort(q.begin(),q.end());
+      for (auto const& c: q) {
+         _AZ.col_ind.push_back(c);
+         _AZ.a.push_back(s[c]);
+         A0.a[nb*_p[i]+c] += s[c];
+         s[c] = T_(0), in[c] = 0;
+      }
+      _AZ.row_ptr.push_back(_AZ.col_ind.size());
+   }
+   for (size_t i=0; i<=nb; ++i)
+      A0.row_ptr.push_back(i*nb);
+   for (size_t i=0; i<nb; ++i)
+      for (size_t j=0; j<nb; ++j)
+         A0.col_ind.push_back(unsigned(j));
+   _lu.factor(A0);
+}
+
+
+template<class T_>
+int schwarz<T_>::setup(const spmat<T_>& A)
+{
+   clear();
+   _n = A.size();
+   setPart(A);
+   _sd.resize(_nb);
+   for (auto &sd: _sd)
+      sd.solver = nullptr, sd.direct = false;
+
+// Unknowns owned by each subdomain
+   vector<size_t> optr(_nb+1,0), olist(_n);
+   for (size_t i=0; i<_n; ++i)
+      optr[_p[i]+1]++;
+   for (int p=0; p<_nb; ++p)
+      optr[p+1] += optr[p];
+   vector<size_t> pos(optr.begin(),optr.end()-1);
+   for (size_t i=0; i<_n; ++i)
+      olist[pos[_p[i]]++] = i;
+
+   std::atomic<int> next(0), err(0);
+   size_t nt = std::min(size_t(getNbThreads()),size_t(_nb));
+   parallelRun(nt,[&](size_t t) {
+      vector<int> loc(_n,-1);
+      int p;
+      while ((p=next++)<_nb) {
+         if (setSubdomain(A,p,&olist[0]+optr[p],&olist[0]+optr[p+1],loc))
+            err++;
+      }
+   });
+   if (err) {
+      cout << "Error: Factorization of a Schwarz subdomain failed." << endl;
+      return 1;
+   }
+
+// Positions of the local values of each unknown, for the additive variant
+   _off.assign(_nb+1,0);
+   for (int p=0; p<_nb; ++p)
+      _off[p+1] = _off[p] + _sd[p].idx.size();
+   _cover_ptr.clear(), _cover_pos.clear();
+   if (!_restricted) {
+      _cover_ptr.assign(_n+1,0);
+      for (auto const& sd: _sd)
+         for (auto const& i: sd.idx)
+            _cover_ptr[i+1]++;
+      for (size_t i=0; i<_n; ++i)
+         _cover_ptr[i+1] += _cover_ptr[i];
+      _cover_pos.resize(_off[_nb]);
+      pos.assign(_cover_ptr.begin(),_cover_ptr.end()-1);
+      for (int p=0; p<_nb; ++p)
+         for (size_t i=0; i<_sd[p].idx.size(); ++i)
+            _cover_pos[pos[_sd[p].idx[i]]++] = _off[p] + i;
+      _zbuf.resize(_off[_nb]);
+   }
+   if (_coarse)
+      setCoarse(A);
+   return 0;
+}
+
+
+/*
+ * Local solves of all subdomains: each unknown takes the correction of its
+ * subdomain (restricted) or the sum of the corrections (additive)
+ */
+template<class T_>
+void schwarz<T_>::localSolve(const vector<T_>& r,
+                             vector<T_>&       z) const
+{
+   std::atomic<int> next(0);
+   size_t nt = std::min(size_t(getNbThreads()),size_t(_nb));
+   parallelRun(nt,[&](size_t t) {
+      int p;
+      while ((p=next++)<_nb) {
+         const Subdomain &sd = _sd[p];
+         size_t m = sd.idx.size();
+         if (m==0)
+            continue;
+         for (size_t i=0; i<m; ++i)
+            sd.r[i] = r[sd.idx[i]];
+         sd.solver->solve(sd.r,sd.z);
+         if (_restricted) {
+            for (size_t i=0; i<m; ++i)
+               if (sd.own[i])
+                  z[sd.idx[i]] = sd.z[i];
+         }
+         else
+            std::copy(sd.z.begin(),sd.z.end(),_zbuf.begin()+_off[p]);
+      }
+   });
+   if (!_restricted) {
+      parallelFor(_n,[&](size_t b, size_t e) {
+         for (size_t i=b; i<e; ++i) {
+            T_ s = 0;
+            for (size_t k=_cover_ptr[i]; k<_cover_ptr[i+1]; ++k)
+               s += _zbuf[_cover_pos[k]];
+            z[i] = s;
+         }
+      });
+   }
+}
+
+
+template<class T_>
+void schwarz<T_>::solve(const vector<T_>& r,
+                        vector<T_>&       z) const
+{
+   z.resize(_n);
+   if (!_coarse) {
+      localSolve(r,z);
+      return;
+   }
+   vector<T_> zr(_nb,T_(0));
+   for (size_t i=0; i<_n; ++i)
+      zr[_p[i]] += r[i];
+   _lu.solve(_c,zr);
+   if (_restricted) {
+      vector<T_> r1(_n);
+      parallelFor(_n,[&](size_t b, size_t e) {
+         for (size_t i=b; i<e; ++i) {
+            T_ s = r[i];
+            for (size_t k=_AZ.row_ptr[i]; k<_AZ.row_ptr[i+1]; ++k)
+               s -= _AZ.a[k]*_c[_AZ.col_ind[k]];
+            r1[i] = s;
+         }
+      });
+      localSolve(r1,z);
+   }
+   else
+      localSolve(r,z);
+   parallelFor(_n,[&](size_t b, size_t e) {
+      for (size_t i=b; i<e; ++i)
+         z[i] += _c[_p[i]];
+   });
+}
+
+
+template<class T_>
+void schwarz<T_>::print(std::ostream& s) const
+{
+   size_t mmin=_n, mmax=0;
+   int nd = 0;
+   for (auto const& sd: _sd) {
+      mmin = std::min(mmin,sd.idx.size());
+      mmax = std::max(mmax,sd.idx.size());
+      nd += sd.direct;
+   }
+   s << (_restricted ? "Restricted additive" : "Additive") << " Schwarz preconditioner: " << _nb
+     << " subdomains, overlap " << _overlap << endl;
+   s << "Unknowns per subdomain: " << mmin << " to " << mmax << " (" << _n << " unknowns)" << endl;
+   if (_direct)
+      s << "Local solver: L D L^T factorization (" << nd << " subdomains), ILU(0) otherwise" << endl;
+   else
+      s << "Local solver: ILU(0)" << endl;
+   if (_coarse)
+      s << "Coarse space correction: " << _nb << " vectors" << endl;
+}
+
+template class schwarz<double>;
+template class schwarz<float>;
+
+} /* namespace RITA */
@@ -0,0 +1,92 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                           Definition of class 'schwarz'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include "linearSolver.h"
+
+namespace RITA {
+
+/*
+ * Additive Schwarz domain decomposition preconditioner. The unknowns are
+ * split in subdomains, given by part (subdomain of each unknown, e.g. from
+ * the partition of the mesh) or, if part is empty, by the multilevel
+ * partitioning of the graph of A in as many subdomains as threads. Each
+ * subdomain is extended by 'overlap' layers of neighbours in the graph of A
+ * and its matrix is factored, by ILU(0) or, if direct is set and the local
+ * matrix is symmetric, by the sparse L D L^T factorization. Local problems
+ * are set up and solved concurrently, one subdomain at a time per thread.
+ * In restricted mode (RAS), each unknown takes the correction of the
+ * subdomain that owns it; otherwise the corrections of overlapping
+ * subdomains are added, which keeps the preconditioner symmetric (for cg).
+ * The optional coarse space has one vector per subdomain (the indicator of
+ * its unknowns) and its Galerkin matrix is factored by dense LU. The coarse
+ * correction is applied first and the local solves act on the updated
+ * residual in restricted mode; both corrections are added otherwise.
+ */
+template<class T_>
+class schwarz : public precond<T_>
+{
+
+ public:
+
+    schwarz(const vector<int>& part, int overlap=1, bool direct=false, bool coarse=false,
+            bool restricted=true);
+    ~schwarz();
+    int setup(const spmat<T_>& A);
+    void solve(const vector<T_>& r, vector<T_>& z) const;
+    void print(std::ostream& s) const;
+    int getNbSubdomains() const { return _nb; }
+
+ private:
+
+    struct Subdomain {
+       vector<size_t> idx;
+       vector<char> own;
+       precond<T_> *solver;
+       bool direct;
+       mutable vector<T_> r, z;
+    };
+
+    vector<int> _part, _p;
+    int _nb, _overlap;
+    bool _direct, _coarse, _restricted;
+    size_t _n;
+    vector<Subdomain> _sd;
+    vector<size_t> _cover_ptr, _cover_pos, _off;
+    spmat<T_> _AZ;
+    denseLU<T_> _lu;
+    mutable vector<T_> _zbuf, _c;
+
+    void clear();
+    void setPart(const spmat<T_>& A);
+    int setSubdomain(const spmat<T_>& A, int p, const size_t* first, const size_t* last, vector<int>& loc);
+    void setCoarse(const spmat<T_>& A);
+    void localSolve(const vector<T_>& r, vector<T_>& z) const;
+};
+
+} /* namespace RITA */
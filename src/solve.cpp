@@ -26,6 +26,11 @@
 
   ==============================================================================*/
 
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <algorithm>
 #include "rita.h"
 #include "solve.h"
 #include "configure.h"
@@ -33,7 +38,10 @@
 #include "equa.h"
 #include "stationary.h"
 #include "transient.h"
+#include "eigen.h"
 #include "optim.h"
+#include "mesh.h"
+#include "meshAdapt.h"
 #include "util/macros.h"
 
 namespace RITA {
@@ -63,7 +71,8 @@ void solve::set(OFELI::Mesh *ms)
 int solve::run()
 {
    _nb_eq = _rita->getNbEq();
-   if ((_rita->_analysis_type==STEADY_STATE||_rita->_analysis_type==TRANSIENT) && _nb_eq==0) {
+   if ((_rita->_analysis_type==STEADY_STATE||_rita->_analysis_type==TRANSIENT||
+        _rita->_analysis_type==EIGEN) && _nb_eq==0) {
       _rita->msg("solve>","No equation defined.");
       _ret = 1;
       return _ret;
@@ -117,6 +126,8 @@ int solve::run()
             _cmd->setNbArg(0);
             cout << "\nAvailable Commands:\n";
             cout << "run:      Run the model\n";
+            cout << "adapt:    Run a stationary model with mesh adaptation\n";
+            cout << "probe:    Values of a field at given points\n";
             cout << "save:     Save output, can be executed before run\n";
             cout << "display:  Display solution and related data\n";
             cout << "plot:     Plot solution\n";
@@ -221,13 +232,23 @@ int solve::run()
             _ret = 200;
             return _ret;
 
+         case 15:
+            if (_verb)
+               cout << "Running stationary solver with mesh adaptation ..." << endl;
+            _ret = run_adapt();
+            break;
+
+         case 16:
+            _ret = probe();
+            break;
+
          case -2:
             break;
 
          default:
             _rita->msg("solve>","Unknown command: "+_cmd->token(),
                        "Available commands for this mode:\n"
-                       "help, ?, run, save, display, plot, analytic, error, post, end, <, exit");
+                       "help, ?, run, adapt, probe, save, display, plot, analytic, error, post, end, <, exit");
             break;
       }
    }
@@ -247,8 +268,500 @@ int solve::run_steady()
 }
 
 
+/*
+ * Mesh of the arrays of meshAdapt, with nb_dof degrees of freedom per node
+ */
+static OFELI::Mesh *AdaptedMesh(const meshAdapt& a,
+                                int              nb_dof,
+                                bool             imposed)
+{
+   const vector<double>& x = a.getCoord();
+   const vector<size_t> &el=a.getElements(), &sd=a.getSides();
+   const vector<int> &nc=a.getNodeCodes(), &ec=a.getElementCodes(), &sc=a.getSideCodes();
+   OFELI::Mesh *ms = new OFELI::Mesh;
+   ms->setDim(2);
+   vector<OFELI::Node *> nd(a.getNbNodes());
+   for (size_t n=0; n<nd.size(); ++n) {
+      nd[n] = new OFELI::Node(n+1,OFELI::Point<double>(x[2*n],x[2*n+1]));
+      nd[n]->setNbDOF(nb_dof);
+      for (int k=1; k<=nb_dof; ++k)
+         nd[n]->setCode(k,nc[nb_dof*n+k-1]);
+      ms->Add(nd[n]);
+   }
+   for (size_t e=0; e<a.getNbElements(); ++e) {
+      OFELI::Element *t = new OFELI::Element(e+1,OFELI::TRIANGLE,ec[e]);
+      for (int i=0; i<3; ++i)
+         t->Add(nd[el[3*e+i]]);
+      ms->Add(t);
+   }
+   for (size_t s=0; s<a.getNbSides(); ++s) {
+      OFELI::Side *l = new OFELI::Side(s+1,OFELI::LINE);
+      l->Add(nd[sd[2*s]]);
+      l->Add(nd[sd[2*s+1]]);
+      l->setNbDOF(nb_dof);
+      for (int k=1; k<=nb_dof; ++k)
+         l->setCode(k,sc[nb_dof*s+k-1]);
+      ms->Add(l);
+   }
+   if (imposed)
+      ms->removeImposedDOF();
+   else
+      ms->NumberEquations();
+   return ms;
+}
+
+
+/*
+ * Stationary solution with mesh adaptation: solve, estimate, mark, refine (and
+ * coarsen), transfer the fields and solve again (see meshAdapt), for laplace
+ * and heat equations with feP1 in 2-D. The loop stops when the estimated
+ * relative error is below tol, when the number of degrees of freedom reaches
+ * max_dof or after max_it steps. The accuracy reached is then looked for by
+ * uniform refinement of the initial mesh, to compare the numbers of degrees
+ * of freedom.
+ */
+int solve::run_adapt()
+{
+   int est=ZZ_ESTIMATOR, max_it=10, max_dof=100000;
+   double tol=1.e-2, theta=0.5, coarsen=0.;
+   string e = "zz";
+   const vector<string> kw {"help","?","set","est$imator","tol","max_dof","max_it","theta","coarsen",
+                            "end","<","quit","exit","EXIT"};
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   for (int i=0; i<nb_args; ++i) {
+      int n = _cmd->getArg();
+      switch (n) {
+
+         case 3:
+            e = _cmd->string_token();
+            break;
+
+         case 4:
+            tol = _cmd->double_token();
+            break;
+
+         case 5:
+            max_dof = _cmd->int_token();
+            break;
+
+         case 6:
+            max_it = _cmd->int_token();
+            break;
+
+         case 7:
+            theta = _cmd->double_token();
+            break;
+
+         case 8:
+            coarsen = _cmd->double_token();
+            break;
+
+         default:
+            _rita->msg("solve>adapt>","Unknown argument: "+_cmd->token());
+            return 1;
+      }
+   }
+   if (e=="residual")
+      est = RESIDUAL_ESTIMATOR;
+   else if (e!="zz") {
+      _rita->msg("solve>adapt>","Unknown error estimator: "+e,"Available estimators: zz, residual");
+      return 1;
+   }
+   if (theta<=0. || theta>1.) {
+      _rita->msg("solve>adapt>","Illegal value of theta: "+to_string(theta));
+      return 1;
+   }
+   OFELI::Mesh *ms0 = _rita->_theMesh;
+   equa *pde = (_nb_eq==1 && _rita->_eq_type[0]==PDE_EQ) ? _rita->PDE[0] : nullptr;
+   if (_rita->_analysis_type!=STEADY_STATE || pde==nullptr || pde->spD!="feP1" ||
+       (pde->ieq!=equa::LAPLACE && pde->ieq!=equa::HEAT) || ms0==nullptr || ms0->getDim()!=2 ||
+       pde->isStructured()) {
+      _rita->msg("solve>adapt>","Mesh adaptation available for stationary laplace and heat equations "
+                 "with feP1 in 2-D only.");
+      return 1;
+   }
+   *_rita->ofh << "  adapt estimator=" << e << " tol=" << tol << " max_dof=" << max_dof
+               << " max_it=" << max_it << " theta=" << theta << " coarsen=" << coarsen << endl;
+
+// Arrays of the initial mesh
+   size_t nn=ms0->getNbNodes(), ne=ms0->getNbElements(), ns=ms0->getNbSides();
+   int nb_dof = ms0->getNbDOF()/nn;
+   bool imposed = ms0->getNbEq()<ms0->getNbDOF();
+   vector<double> coord(2*nn);
+   vector<size_t> el_node, sd_node;
+   vector<int> node_code(nb_dof*nn), el_code, sd_code;
+   for (size_t n=1; n<=nn; ++n) {
+      OFELI::Node *nd = (*ms0)[n];
+      coord[2*n-2] = nd->getCoord().x, coord[2*n-1] = nd->getCoord().y;
+      for (int k=1; k<=nb_dof; ++k)
+         node_code[nb_dof*(n-1)+k-1] = nd->getCode(k);
+   }
+   for (size_t i=1; i<=ne; ++i) {
+      OFELI::Element *el = ms0->getPtrElement(i);
+      if (el->getNbNodes()!=3) {
+         _rita->msg("solve>adapt>","Mesh adaptation available for triangles only.");
+         return 1;
+      }
+      for (size_t k=1; k<=3; ++k)
+         el_node.push_back(el->getPtrNode(k)->n()-1);
+      el_code.push_back(el->getCode());
+   }
+   for (size_t i=1; i<=ns; ++i) {
+      OFELI::Side *sd = ms0->getPtrSide(i);
+      if (sd->getNbNodes()!=2)
+         continue;
+      for (size_t k=1; k<=2; ++k)
+         sd_node.push_back(sd->getPtrNode(k)->n()-1);
+      for (int k=1; k<=nb_dof; ++k)
+         sd_code.push_back(k<=int(sd->getNbDOF()) ? sd->getCode(k) : 0);
+   }
+   meshAdapt a;
+   if (a.set(nb_dof,coord,el_node,el_code,node_code,sd_node,sd_code)) {
+      _rita->msg("solve>adapt>","Mesh adaptation failed.");
+      return 1;
+   }
+   meshAdapt a0 = a;
+
+// Fields on the mesh, carried to the adapted meshes
+   vector<int> fld;
+   vector<vector<double> > val;
+   for (int f=0; f<_data->getNbFields(); ++f) {
+      OFELI::Vect<double> *u = _data->u[f];
+      if (u->WithMesh() && &(u->getMesh())==ms0 &&
+          (_data->FieldSizeType[f]==NODES || _data->FieldSizeType[f]==ELEMENTS)) {
+         fld.push_back(f);
+         val.push_back(vector<double>(u->size()));
+      }
+   }
+   int uf = pde->field[0];
+   auto get = [&]() {
+      for (size_t i=0; i<fld.size(); ++i) {
+         OFELI::Vect<double> *u = _data->u[fld[i]];
+         val[i].resize(u->size());
+         for (size_t j=0; j<u->size(); ++j)
+            val[i][j] = (*u)[j];
+      }
+   };
+   auto transfer = [&](const meshAdapt& m, size_t nn0, size_t ne0) {
+      for (size_t i=0; i<fld.size(); ++i) {
+         if (_data->FieldSizeType[fld[i]]==NODES)
+            m.transfer(val[i],val[i].size()/nn0);
+         else
+            m.transferElement(val[i],val[i].size()/ne0);
+      }
+   };
+   auto attach = [&](OFELI::Mesh* ms, const meshAdapt& m) {
+      _rita->_theMesh = ms;
+      pde->setMesh(ms);
+      for (size_t i=0; i<fld.size(); ++i) {
+         OFELI::Vect<double> *u = _data->u[fld[i]];
+         if (_data->FieldSizeType[fld[i]]==NODES)
+            u->setMesh(*ms,NODE_DOF,val[i].size()/m.getNbNodes());
+         else
+            u->setMesh(*ms,ELEMENT_DOF,val[i].size()/m.getNbElements());
+         for (size_t j=0; j<val[i].size(); ++j)
+            (*u)[j] = val[i][j];
+      }
+   };
+   auto error = [&](const meshAdapt& m, vector<double>& eta) {
+      OFELI::Vect<double> &u = *_data->u[uf];
+      size_t n = m.getNbNodes(), nb = u.size()/n;
+      vector<double> v(n), f;
+      for (size_t i=0; i<n; ++i)
+         v[i] = u[nb*i];
+      if (est==RESIDUAL_ESTIMATOR && pde->set_bf && pde->bf.size()==nb*n) {
+         f.resize(n);
+         for (size_t i=0; i<n; ++i)
+            f[i] = pde->bf[nb*i];
+      }
+      double s = m.getEnergy(v);
+      return m.estimate(est,v,f,eta)/(s>0. ? s : 1.);
+   };
+
+   stationary st(_rita);
+   st.setSave(_isave,_fformat,_save_file);
+   OFELI::Mesh *ms = ms0;
+   vector<vector<double> > val0;
+   vector<double> eta;
+   vector<int> flag;
+   double E=0., E0=0.;
+   int ret = 0;
+   try {
+      for (int it=0; ; ++it) {
+         if ((ret=st.run()))
+            break;
+         E = error(a,eta);
+         cout << "Adaptation step " << it << ": " << ms->getNbEq() << " DOF, estimated relative error "
+              << E << endl;
+         get();
+         if (it==0)
+            E0 = E, val0 = val;
+         if (E<=tol || it>=max_it || int(ms->getNbEq())>=max_dof)
+            break;
+         a.mark(eta,theta,coarsen,flag);
+         if (coarsen>0.) {
+            vector<double> fl(flag.begin(),flag.end());
+            size_t n0=a.getNbNodes(), e0=a.getNbElements();
+            if (a.coarsen(flag)) {
+               transfer(a,n0,e0);
+               a.transferElement(fl,1);
+               flag.assign(fl.begin(),fl.end());
+            }
+         }
+         size_t n0=a.getNbNodes(), e0=a.getNbElements();
+         a.refine(flag);
+         transfer(a,n0,e0);
+         OFELI::Mesh *nms = AdaptedMesh(a,nb_dof,imposed);
+         attach(nms,a);
+         if (ms!=ms0) {
+            _data->clearIndex(ms);
+            delete ms;
+         }
+         ms = nms;
+      }
+      if (ret) {
+         if (ms!=ms0) {
+            val = val0;
+            attach(ms0,a0);
+            _data->clearIndex(ms);
+            delete ms;
+         }
+         _rita->msg("solve>adapt>","Solution failed.","Initial mesh and fields are restored.");
+         return ret;
+      }
+
+//    Uniform refinement of the initial mesh until the same accuracy is reached
+//    (the number of DOF being limited to 4 times that of the adapted mesh)
+      if (ms!=ms0) {
+         size_t N=ms->getNbEq(), Nu=ms0->getNbEq(), Np=Nu;
+         double Eu=E0, Ep=E0;
+         vector<vector<double> > val_a = val;
+         val = val0;
+         meshAdapt au = a0;
+         OFELI::Mesh *ums = nullptr;
+         st.setSaveResults(0);
+         while (Eu>E && Nu<=4*N) {
+            vector<int> all(au.getNbElements(),1);
+            size_t n0=au.getNbNodes(), e0=au.getNbElements();
+            au.refine(all);
+            transfer(au,n0,e0);
+            OFELI::Mesh *nms = AdaptedMesh(au,nb_dof,imposed);
+            attach(nms,au);
+            if (ums!=nullptr) {
+               _data->clearIndex(ums);
+               delete ums;
+            }
+            ums = nms;
+            if ((ret=st.run()))
+               break;
+            Np = Nu, Ep = Eu;
+            Nu = ums->getNbEq(), Eu = error(au,eta);
+            if (_verb>1)
+               cout << "Uniform refinement: " << Nu << " DOF, estimated relative error " << Eu << endl;
+            get();
+         }
+         st.setSaveResults(1);
+
+//       Back to the adapted mesh, which replaces the initial one
+         val = val_a;
+         attach(ms,a);
+         if (ums!=nullptr) {
+            _data->clearIndex(ums);
+            delete ums;
+         }
+         for (auto &M: _data->theMesh) {
+            if (M==ms0)
+               M = ms;
+         }
+         if (_rita->_mesh->get()==ms0)
+            _rita->_mesh->set(ms);
+         _data->clearIndex(ms0);
+         delete ms0;
+         if (ret) {
+            _rita->msg("solve>adapt>","Solution failed.");
+            return ret;
+         }
+
+//       Without reaching E, DOF extrapolated from the convergence rate of the
+//       last two uniform meshes
+         double Nr = Nu;
+         if (Eu>E && Ep>Eu && Nu>Np)
+            Nr = Nu*pow(Eu/E,log(double(Nu)/Np)/log(Ep/Eu));
+         cout << "Adapted mesh: " << N << " DOF for the estimated relative error " << E << endl;
+         cout << "Uniform refinement: " << (Eu>E ? "about " : "") << size_t(Nr) << " DOF" << endl;
+      }
+      _solved = true;
+   } CATCH
+   return ret;
+}
+
+/*
+ * Values of a field at points given in the command (point=x,y,z) or in a
+ * file (points=file, one point per line, lines starting with # skipped).
+ * The points are located in the mesh of the field by its spatial index, nodal
+ * fields are interpolated in the element of each point and element fields
+ * take the value of this element. Values are printed or saved in a file,
+ * NaN for points outside the mesh.
+ */
+int solve::probe()
+{
+   string fd="", pfile="", file="";
+   vector<double> px;
+   int nb = 0;
+   const vector<string> kw {"help","?","set","field","point","points","save","end","<","quit","exit","EXIT"};
+   _cmd->set(kw);
+   int nb_args = _cmd->getNbArgs();
+   for (int i=0; i<nb_args; ++i) {
+      int n = _cmd->getArgs(nb);
+      switch (n) {
+
+         case 3:
+            fd = _cmd->string_token(0);
+            break;
+
+         case 4:
+            if (nb>3) {
+               _rita->msg("solve>probe>","A point has at most 3 coordinates.");
+               return 1;
+            }
+            for (int j=0; j<3; ++j)
+               px.push_back(j<nb ? _cmd->double_token(j) : 0.);
+            break;
+
+         case 5:
+            pfile = _cmd->string_token(0);
+            break;
+
+         case 6:
+            file = _cmd->string_token(0);
+            break;
+
+         default:
+            _rita->msg("solve>probe>","Unknown argument: "+_cmd->token());
+            return 1;
+      }
+   }
+   if (fd=="" && _data->getNbFields()==1)
+      fd = _data->Field[0];
+   int k = _data->checkField(fd);
+   if (k<0) {
+      _rita->msg("solve>probe>",fd=="" ? string("No field given.") : "Unknown field: "+fd);
+      return 1;
+   }
+   OFELI::Vect<double> *u = _data->u[k];
+   dataSize st = _data->FieldSizeType[k];
+   if (!u->WithMesh() || (st!=NODES && st!=ELEMENTS)) {
+      _rita->msg("solve>probe>","Field "+fd+" is not defined on the nodes or elements of a mesh.");
+      return 1;
+   }
+   OFELI::Mesh &ms = u->getMesh();
+   int dim = ms.getDim();
+
+// Points: 3 coordinates each in px, then dim coordinates each in x
+   if (pfile!="") {
+      std::ifstream ip(pfile.c_str());
+      if (!ip) {
+         _rita->msg("solve>probe>","Unable to open file: "+pfile);
+         return 1;
+      }
+      std::ostringstream ss;
+      ss << ip.rdbuf();
+      string buf = ss.str();
+      const char *c=buf.c_str(), *end=c+buf.size();
+      while (c<end) {
+         const char *eol = std::find(c,end,'\n');
+         if (*c!='#') {
+            double y[3] = {0.,0.,0.};
+            int j = 0;
+            char *q;
+            for (; j<3; ++j) {
+               double z = strtod(c,&q);
+               if (q==c || q>eol)
+                  break;
+               y[j] = z;
+               c = q;
+            }
+            if (j>0)
+               px.insert(px.end(),y,y+3);
+         }
+         c = eol + 1;
+      }
+   }
+   size_t np = px.size()/3;
+   if (np==0) {
+      _rita->msg("solve>probe>","No point given.");
+      return 1;
+   }
+   vector<double> x(dim*np);
+   for (size_t p=0; p<np; ++p)
+      for (int a=0; a<dim; ++a)
+         x[dim*p+a] = px[3*p+a];
+
+   auto t0 = std::chrono::steady_clock::now();
+   const spatialIndex &si = _data->getIndex(ms);
+   if (si.empty()) {
+      _rita->msg("solve>probe>","Point location is not available for the elements of this mesh.");
+      return 1;
+   }
+   vector<long> el;
+   vector<double> w;
+   size_t nf = si.locate(np,&x[0],el,w);
+   size_t nd = (st==NODES) ? u->size()/ms.getNbNodes() : u->size()/ms.getNbElements();
+   vector<double> v(nd*np);
+   if (st==NODES)
+      si.interpolate(el,w,&(*u)[0],int(nd),&v[0]);
+   else {
+      for (size_t p=0; p<np; ++p)
+         for (size_t j=0; j<nd; ++j)
+            v[nd*p+j] = (el[p]<0) ? std::numeric_limits<double>::quiet_NaN() : (*u)[nd*el[p]+j];
+   }
+   double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+
+   std::ofstream of;
+   if (file!="")
+      of.open(file.c_str());
+   ostream &os = (file!="") ? of : cout;
+   const string xn[3] = {"x","y","z"};
+   os << "#";
+   for (int a=0; a<dim; ++a)
+      os << " " << xn[a];
+   for (size_t j=0; j<nd; ++j)
+      os << " " << fd << (nd>1 ? to_string(j+1) : "");
+   os << endl;
+   for (size_t p=0; p<np; ++p) {
+      for (int a=0; a<dim; ++a)
+         os << x[dim*p+a] << " ";
+      for (size_t j=0; j<nd; ++j)
+         os << v[nd*p+j] << (j+1<nd ? " " : "\n");
+   }
+   os.flush();
+   if (_verb)
+      cout << "Field " << fd << " probed at " << np << " points (" << np-nf << " outside the mesh) in "
+           << t << " s" << endl;
+   *_rita->ofh << "  probe field=" << fd;
+   for (size_t p=0; p<px.size()/3 && pfile==""; ++p) {
+      *_rita->ofh << " point=" << px[3*p];
+      for (int a=1; a<dim; ++a)
+         *_rita->ofh << "," << px[3*p+a];
+   }
+   if (pfile!="")
+      *_rita->ofh << " points=" << pfile;
+   if (file!="")
+      *_rita->ofh << " save=" << file;
+   *_rita->ofh << endl;
+   return 0;
+}
+
+
 int solve::run_transient()
 {
+   for (int e=0; e<_nb_eq; ++e) {
+      if (_rita->_eq_type[e]==PDE_EQ && _rita->PDE[e]->isStructured()) {
+         _rita->msg("solve>","Transient problems are not available on a structured mesh.");
+         return 1;
+      }
+   }
    transient ts(_rita);
    ts.setSave(_isave,_fformat,_save_file,_phase,_phase_file);
    for (int e=0; e<_nb_eq; ++e) {
@@ -277,9 +790,16 @@ int solve::run_transient()
 
 int solve::run_eigen()
 {
-  //   return _rita->PDE[0].Eq->run();
-   _rita->msg("solve>run>","Eigenproblem solver not implemented.");
-   return 0;
+   for (int e=0; e<_nb_eq; ++e) {
+      if (_rita->_eq_type[e]==PDE_EQ && _rita->PDE[e]->isStructured()) {
+         _rita->msg("solve>","Eigen problems are not available on a structured mesh.");
+         return 1;
+      }
+   }
+   eigen ev(_rita);
+   int ret = ev.run();
+   _solved = true;
+   return ret;
 }
 
 
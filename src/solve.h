@@ -85,13 +85,15 @@ class solve
     void display();
     int plot();
     int run_steady();
+    int run_adapt();
+    int probe();
     int run_transient();
     int run_optim();
     int run_eigen();
     void get_error(int eq, int i);
     void setAnalytic();
     vector<string> _kw_solve = {"help","?","set","run","save","display","plot","analytic","error",
-                                "post","end","<","quit","exit","EXIT"};
+                                "post","end","<","quit","exit","EXIT","adapt","probe"};
     vector<string> _kw_save = {"help","?","set","field","format","freq$uency","phase",
                                "file","end","<","quit","exit","EXIT"};
     vector<string> _kw_format = {"ofeli","gmsh","gnuplot","vtk","tecplot","matlab"};
@@ -0,0 +1,510 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                       Implementation of class 'spatialIndex'
+
+  ==============================================================================*/
+
+#include <math.h>
+#include <limits>
+#include <algorithm>
+#include "spatialIndex.h"
+#include "parallel.h"
+
+namespace RITA {
+
+static const size_t none = size_t(-1);
+
+/*
+ * Solution of J s = b (d = 1, 2 or 3) by Cramer's rule, false if J is singular
+ */
+static bool Solve(int           d,
+                  const double  J[3][3],
+                  const double* b,
+                  double*       s)
+{
+   if (d==1) {
+      if (J[0][0]==0.)
+         return false;
+      s[0] = b[0]/J[0][0];
+      return true;
+   }
+   if (d==2) {
+      double det = J[0][0]*J[1][1] - J[0][1]*J[1][0];
+      if (det==0.)
+         return false;
+      s[0] = (b[0]*J[1][1] - J[0][1]*b[1])/det;
+      s[1] = (J[0][0]*b[1] - b[0]*J[1][0])/det;
+      return true;
+   }
+   double c[3][3];
+   c[0][0] = J[1][1]*J[2][2] - J[1][2]*J[2][1];
+   c[0][1] = J[0][2]*J[2][1] - J[0][1]*J[2][2];
+   c[0][2] = J[0][1]*J[1][2] - J[0][2]*J[1][1];
+   c[1][0] = J[1][2]*J[2][0] - J[1][0]*J[2][2];
+   c[1][1] = J[0][0]*J[2][2] - J[0][2]*J[2][0];
+   c[1][2] = J[0][2]*J[1][0] - J[0][0]*J[1][2];
+   c[2][0] = J[1][0]*J[2][1] - J[1][1]*J[2][0];
+   c[2][1] = J[0][1]*J[2][0] - J[0][0]*J[2][1];
+   c[2][2] = J[0][0]*J[1][1] - J[0][1]*J[1][0];
+   double det = J[0][0]*c[0][0] + J[0][1]*c[1][0] + J[0][2]*c[2][0];
+   if (det==0.)
+      return false;
+   for (int a=0; a<3; ++a)
+      s[a] = (c[a][0]*b[0] + c[a][1]*b[1] + c[a][2]*b[2])/det;
+   return true;
+}
+
+
+spatialIndex::spatialIndex()
+             : _dim(0), _max_nodes(0), _nb_el(0), _tol(0.)
+{
+   for (int a=0; a<3; ++a) {
+      _n[a] = 1;
+      _xmin[a] = _xmax[a] = 0.;
+      _h[a] = 1.;
+   }
+}
+
+
+void spatialIndex::bounds(size_t  e,
+                          double* lo,
+                          double* hi) const
+{
+   for (int a=0; a<_dim; ++a)
+      lo[a] = std::numeric_limits<double>::max(), hi[a] = -lo[a];
+   for (size_t k=_el_ptr[e]; k<_el_ptr[e+1]; ++k) {
+      const double *x = &_coord[_dim*_el_node[k]];
+      for (int a=0; a<_dim; ++a)
+         lo[a] = std::min(lo[a],x[a]), hi[a] = std::max(hi[a],x[a]);
+   }
+}
+
+
+int spatialIndex::set(int                   dim,
+                      const vector<double>& coord,
+                      const vector<size_t>& el_ptr,
+                      const vector<size_t>& el_node)
+{
+   _nb_el = 0;
+   _cell_ptr.clear(), _cell_el.clear();
+   if (dim<1 || dim>3 || el_ptr.size()<2 || coord.size()%dim)
+      return 1;
+   size_t ne=el_ptr.size()-1, nn=coord.size()/dim;
+   _max_nodes = 0;
+   for (size_t e=0; e<ne; ++e) {
+      size_t m = el_ptr[e+1] - el_ptr[e];
+      if (m!=size_t(dim+1) && !(dim==2 && m==4) && !(dim==3 && m==8))
+         return 1;
+      for (size_t k=el_ptr[e]; k<el_ptr[e+1]; ++k)
+         if (el_node[k]>=nn)
+            return 1;
+      _max_nodes = std::max(_max_nodes,int(m));
+   }
+   _dim = dim;
+   _coord = coord;
+   _el_ptr = el_ptr;
+   _el_node = el_node;
+   _nb_el = ne;
+
+// Bounding box and cells: about one cell per element, of nearly equal sides
+   double ext=0., vol=1.;
+   int nd = 0;
+   for (int a=0; a<3; ++a)
+      _xmin[a] = _xmax[a] = 0., _n[a] = 1;
+   for (int a=0; a<_dim; ++a) {
+      _xmin[a] = std::numeric_limits<double>::max(), _xmax[a] = -_xmin[a];
+      for (size_t n=0; n<nn; ++n)
+         _xmin[a] = std::min(_xmin[a],_coord[_dim*n+a]), _xmax[a] = std::max(_xmax[a],_coord[_dim*n+a]);
+      ext = std::max(ext,_xmax[a]-_xmin[a]);
+   }
+   _tol = 1.e-10*ext;
+   for (int a=0; a<_dim; ++a) {
+      if (_xmax[a]-_xmin[a]>_tol)
+         vol *= _xmax[a] - _xmin[a], nd++;
+   }
+   double h = nd ? pow(vol/double(ne),1./nd) : 1.;
+   size_t nc = 1;
+   for (int a=0; a<_dim; ++a) {
+      double l = _xmax[a] - _xmin[a];
+      _n[a] = (l>_tol) ? std::max(size_t(1),std::min(size_t(ceil(l/h)),ne)) : 1;
+      _h[a] = (l>_tol) ? l/_n[a] : 1.;
+      nc *= _n[a];
+   }
+
+// Lists of elements of each cell (two passes: counts, then lists)
+   auto range = [this](size_t e, size_t* lo, size_t* hi) {
+      double xl[3], xh[3];
+      bounds(e,xl,xh);
+      for (int a=0; a<3; ++a) {
+         lo[a] = hi[a] = 0;
+         if (a<_dim) {
+            double l=(xl[a]-_tol-_xmin[a])/_h[a], u=(xh[a]+_tol-_xmin[a])/_h[a];
+            lo[a] = std::min(_n[a]-1,size_t(std::max(0.,floor(l))));
+            hi[a] = std::min(_n[a]-1,size_t(std::max(0.,floor(u))));
+         }
+      }
+   };
+   _cell_ptr.assign(nc+1,0);
+   size_t lo[3], hi[3];
+   for (int pass=0; pass<2; ++pass) {
+      for (size_t e=0; e<ne; ++e) {
+         range(e,lo,hi);
+         for (size_t k=lo[2]; k<=hi[2]; ++k)
+            for (size_t j=lo[1]; j<=hi[1]; ++j)
+               for (size_t i=lo[0]; i<=hi[0]; ++i) {
+                  size_t c = (k*_n[1]+j)*_n[0] + i;
+                  if (pass==0)
+                     _cell_ptr[c+1]++;
+                  else
+                     _cell_el[_cell_ptr[c]++] = unsigned(e);
+               }
+      }
+      if (pass==0) {
+         for (size_t c=0; c<nc; ++c)
+            _cell_ptr[c+1] += _cell_ptr[c];
+         _cell_el.resize(_cell_ptr[nc]);
+      }
+   }
+   for (size_t c=nc; c>0; --c)
+      _cell_ptr[c] = _cell_ptr[c-1];
+   _cell_ptr[0] = 0;
+   return 0;
+}
+
+
+/*
+ * Weights of the nodes of element e at x, true if x is in e. With clamp,
+ * the local coordinates are clamped to the element instead, and the result
+ * is only false if they cannot be computed.
+ */
+bool spatialIndex::weights(size_t        e,
+                           const double* x,
+                           double*       w,
+                           bool          clamp) const
+{
+   const double eps = 1.e-10;
+   size_t m = _el_ptr[e+1] - _el_ptr[e];
+   const size_t *nd = &_el_node[_el_ptr[e]];
+   double J[3][3], b[3]={0.,0.,0.}, s[3];
+
+// Simplex: barycentric coordinates
+   if (m==size_t(_dim+1)) {
+      const double *x0 = &_coord[_dim*nd[0]];
+      for (int a=0; a<_dim; ++a) {
+         for (int i=0; i<_dim; ++i)
+            J[a][i] = _coord[_dim*nd[i+1]+a] - x0[a];
+         b[a] = x[a] - x0[a];
+      }
+      if (!Solve(_dim,J,b,s))
+         return false;
+      w[0] = 1.;
+      for (int i=0; i<_dim; ++i) {
+         w[i+1] = s[i];
+         w[0] -= s[i];
+      }
+      if (clamp) {
+         double sw = 0.;
+         for (size_t i=0; i<m; ++i)
+            sw += (w[i] = std::max(w[i],0.));
+         for (size_t i=0; i<m; ++i)
+            w[i] /= sw;
+         return true;
+      }
+      for (size_t i=0; i<m; ++i)
+         if (w[i]<-eps)
+            return false;
+      return true;
+   }
+
+// Quadrilateral or hexahedron: local coordinates in [0,1]^dim by Newton iterations,
+// after a check of the bounding box
+   static const int r[8][3] = {{0,0,0},{1,0,0},{1,1,0},{0,1,0},{0,0,1},{1,0,1},{1,1,1},{0,1,1}};
+   double lo[3], hi[3];
+   bounds(e,lo,hi);
+   for (int a=0; a<_dim && !clamp; ++a)
+      if (x[a]<lo[a]-_tol || x[a]>hi[a]+_tol)
+         return false;
+   for (int a=0; a<_dim; ++a)
+      s[a] = 0.5;
+   bool conv = false;
+   for (int it=0; it<20 && !conv; ++it) {
+      for (int a=0; a<_dim; ++a) {
+         b[a] = -x[a];
+         for (int c=0; c<_dim; ++c)
+            J[a][c] = 0.;
+      }
+      for (size_t k=0; k<m; ++k) {
+         double f[3], g[3];
+         for (int a=0; a<_dim; ++a)
+            f[a] = r[k][a] ? s[a] : 1.-s[a], g[a] = r[k][a] ? 1. : -1.;
+         double N = f[0]*f[1]*(_dim==3 ? f[2] : 1.);
+         const double *xk = &_coord[_dim*nd[k]];
+         for (int c=0; c<_dim; ++c) {
+            double dN = g[c];
+            for (int a=0; a<_dim; ++a)
+               if (a!=c)
+                  dN *= f[a];
+            for (int a=0; a<_dim; ++a)
+               J[a][c] += dN*xk[a];
+         }
+         for (int a=0; a<_dim; ++a)
+            b[a] += N*xk[a];
+      }
+      double ds[3];
+      if (!Solve(_dim,J,b,ds))
+         return false;
+      double dm = 0.;
+      for (int a=0; a<_dim; ++a) {
+         s[a] -= ds[a];
+         dm = std::max(dm,fabs(ds[a]));
+      }
+      conv = (dm<1.e-13);
+      if (dm>10.)
+         return false;
+   }
+   if (!conv && !clamp)
+      return false;
+   for (int a=0; a<_dim; ++a) {
+      if (clamp)
+         s[a] = std::min(std::max(s[a],0.),1.);
+      else if (s[a]<-eps || s[a]>1.+eps)
+         return false;
+   }
+   for (size_t k=0; k<m; ++k) {
+      w[k] = 1.;
+      for (int a=0; a<_dim; ++a)
+         w[k] *= r[k][a] ? s[a] : 1.-s[a];
+   }
+   return true;
+}
+
+
+/*
+ * Element containing x (-1 if none) and weights w of its nodes
+ */
+size_t spatialIndex::cell(const double* x) const
+{
+   if (_nb_el==0)
+      return none;
+   size_t c=0, s=1;
+   for (int a=0; a<_dim; ++a) {
+      if (x[a]<_xmin[a]-_tol || x[a]>_xmax[a]+_tol)
+         return none;
+      size_t i = size_t(std::max(0.,floor((x[a]-_xmin[a])/_h[a])));
+      c += std::min(i,_n[a]-1)*s;
+      s *= _n[a];
+   }
+   return c;
+}
+
+
+long spatialIndex::locate(const double* x,
+                          double*       w) const
+{
+   return locate(x,cell(x),w);
+}
+
+
+long spatialIndex::locate(const double* x,
+                          size_t        c,
+                          double*       w) const
+{
+   if (c==none)
+      return -1;
+   for (size_t k=_cell_ptr[c]; k<_cell_ptr[c+1]; ++k) {
+      if (weights(_cell_el[k],x,w))
+         return long(_cell_el[k]);
+   }
+   return -1;
+}
+
+
+/*
+ * Nearest element to x (-1 if the mesh is empty) and weights w of its
+ * nearest point. Cells are visited by shells of growing size around the
+ * cell of the projection of x on the bounding box, until the distance
+ * found is smaller than that of the next shell.
+ */
+long spatialIndex::closest(const double* x,
+                           double*       w) const
+{
+   if (_nb_el==0)
+      return -1;
+   long ic[3]={0,0,0}, n[3]={1,1,1};
+   double hmin = std::numeric_limits<double>::max();
+   for (int a=0; a<_dim; ++a) {
+      n[a] = long(_n[a]);
+      ic[a] = std::min(n[a]-1,long(std::max(0.,floor((x[a]-_xmin[a])/_h[a]))));
+      hmin = std::min(hmin,_h[a]);
+   }
+   vector<double> ww(_max_nodes);
+   double dmin = std::numeric_limits<double>::max();
+   long emin = -1;
+   for (long r=0; ; ++r) {
+      bool more = false;
+      for (long k=std::max(0L,ic[2]-r); k<=std::min(n[2]-1,ic[2]+r); ++k)
+         for (long j=std::max(0L,ic[1]-r); j<=std::min(n[1]-1,ic[1]+r); ++j)
+            for (long i=std::max(0L,ic[0]-r); i<=std::min(n[0]-1,ic[0]+r); ++i) {
+               if (std::max(std::max(labs(i-ic[0]),labs(j-ic[1])),labs(k-ic[2]))!=r)
+                  continue;
+               more = true;
+               size_t c = (k*n[1]+j)*n[0] + i;
+               for (size_t l=_cell_ptr[c]; l<_cell_ptr[c+1]; ++l) {
+                  size_t e = _cell_el[l];
+                  if (!weights(e,x,&ww[0],true))
+                     continue;
+                  double y[3]={0.,0.,0.}, d=0.;
+                  const size_t *nd = getNodes(e);
+                  for (size_t q=0; q<getNbNodes(e); ++q)
+                     for (int a=0; a<_dim; ++a)
+                        y[a] += ww[q]*_coord[_dim*nd[q]+a];
+                  for (int a=0; a<_dim; ++a)
+                     d += (y[a]-x[a])*(y[a]-x[a]);
+                  if (d<dmin) {
+                     dmin = d, emin = long(e);
+                     std::copy(ww.begin(),ww.begin()+getNbNodes(e),w);
+                  }
+               }
+            }
+      if (!more || (emin>=0 && sqrt(dmin)<=r*hmin))
+         break;
+   }
+   return emin;
+}
+
+
+/*
+ * Elements listed in the cells meeting the box [lo,hi]: a superset of the
+ * elements whose bounding box meets it
+ */
+void spatialIndex::getElements(const double*   lo,
+                               const double*   hi,
+                               vector<size_t>& el) const
+{
+   el.clear();
+   if (_nb_el==0)
+      return;
+   size_t l[3]={0,0,0}, h[3]={0,0,0};
+   for (int a=0; a<_dim; ++a) {
+      if (hi[a]<_xmin[a]-_tol || lo[a]>_xmax[a]+_tol)
+         return;
+      l[a] = std::min(_n[a]-1,size_t(std::max(0.,floor((lo[a]-_tol-_xmin[a])/_h[a]))));
+      h[a] = std::min(_n[a]-1,size_t(std::max(0.,floor((hi[a]+_tol-_xmin[a])/_h[a]))));
+   }
+   for (size_t k=l[2]; k<=h[2]; ++k)
+      for (size_t j=l[1]; j<=h[1]; ++j)
+         for (size_t i=l[0]; i<=h[0]; ++i) {
+            size_t c = (k*_n[1]+j)*_n[0] + i;
+            el.insert(el.end(),_cell_el.begin()+_cell_ptr[c],_cell_el.begin()+_cell_ptr[c+1]);
+         }
+   std::sort(el.begin(),el.end());
+   el.erase(std::unique(el.begin(),el.end()),el.end());
+}
+
+
+/*
+ * Location of np points x (dim coordinates each): el[p] is the element of
+ * point p, w[p*getMaxNodes()+i] the weight of its i-th node. Returns the
+ * number of points found in the mesh; with closest, the other points get
+ * their nearest element. Points are processed by cells, so that the
+ * elements of a cell are tested for all its points while they are in cache.
+ */
+size_t spatialIndex::locate(size_t          np,
+                            const double*   x,
+                            vector<long>&   el,
+                            vector<double>& w,
+                            bool            closest) const
+{
+   size_t m=_max_nodes, nc=getNbCells();
+   el.assign(np,-1);
+   w.assign(np*m,0.);
+   if (_nb_el==0)
+      return 0;
+   vector<size_t> pc(np), ptr(nc+2,0), order(np);
+   parallelFor(np,[&](size_t b, size_t e) {
+      for (size_t p=b; p<e; ++p)
+         pc[p] = std::min(cell(x+_dim*p),nc);
+   });
+   for (size_t p=0; p<np; ++p)
+      ptr[pc[p]+1]++;
+   for (size_t c=0; c<=nc; ++c)
+      ptr[c+1] += ptr[c];
+   for (size_t p=0; p<np; ++p)
+      order[ptr[pc[p]]++] = p;
+   size_t nin = ptr[nc-1];
+   size_t nf = size_t(parallelSum(nin,[&](size_t b, size_t e) {
+      double nf = 0.;
+      for (size_t i=b; i<e; ++i) {
+         size_t p = order[i];
+         el[p] = locate(x+_dim*p,pc[p],&w[m*p]);
+         nf += (el[p]>=0);
+      }
+      return nf;
+   }));
+   if (closest && nf<np) {
+      parallelFor(np,[&](size_t b, size_t e) {
+         for (size_t i=b; i<e; ++i) {
+            size_t p = order[i];
+            if (el[p]<0)
+               el[p] = this->closest(x+_dim*p,&w[m*p]);
+         }
+      },64);
+   }
+   return nf;
+}
+
+
+/*
+ * Values v (nb_dof per point) at the points located by locate() of the
+ * nodal field u (nb_dof per node); NaN for points outside the mesh
+ */
+void spatialIndex::interpolate(const vector<long>&   el,
+                               const vector<double>& w,
+                               const double*         u,
+                               int                   nb_dof,
+                               double*               v) const
+{
+   size_t m = _max_nodes;
+   parallelFor(el.size(),[&](size_t b, size_t e) {
+      for (size_t p=b; p<e; ++p) {
+         for (int k=0; k<nb_dof; ++k)
+            v[nb_dof*p+k] = (el[p]<0) ? std::numeric_limits<double>::quiet_NaN() : 0.;
+         if (el[p]<0)
+            continue;
+         const size_t *nd = getNodes(el[p]);
+         for (size_t i=0; i<getNbNodes(el[p]); ++i)
+            for (int k=0; k<nb_dof; ++k)
+               v[nb_dof*p+k] += w[m*p+i]*u[nb_dof*nd[i]+k];
+      }
+   });
+}
+
+
+size_t spatialIndex::getMemory() const
+{
+   return sizeof(double)*_coord.size() + sizeof(size_t)*(_el_ptr.size()+_el_node.size()+_cell_ptr.size()) +
+          sizeof(unsigned)*_cell_el.size();
+}
+
+} /* namespace RITA */
@@ -0,0 +1,93 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+
+                        Definition of class 'spatialIndex'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+using std::vector;
+
+namespace RITA {
+
+/*
+ * Point location in a mesh of segments (1-D), triangles or quadrilaterals
+ * (2-D), tetrahedra or hexahedra (3-D), by uniform bins: the bounding box of
+ * the mesh is split in about one cell per element, and each cell lists the
+ * elements whose bounding box meets it, so that a point is only tested
+ * against the elements of its cell.
+ * locate() gives the element containing a point and the weights of the
+ * element nodes at this point: barycentric coordinates for simplices, Q1
+ * shape functions (local coordinates obtained by Newton iterations) for
+ * quadrilaterals and hexahedra. Points are located in parallel. Points
+ * outside the mesh get the element -1, or with closest() the nearest
+ * element, the weights being those of its nearest point (local coordinates
+ * clamped to the element).
+ * Node and element numbers are 0-based; coord holds dim coordinates per node.
+ */
+class spatialIndex
+{
+
+ public:
+
+    spatialIndex();
+    ~spatialIndex() { }
+    int set(int dim, const vector<double>& coord, const vector<size_t>& el_ptr,
+            const vector<size_t>& el_node);
+    bool empty() const { return _nb_el==0; }
+    int getDim() const { return _dim; }
+    size_t getNbElements() const { return _nb_el; }
+    size_t getNbCells() const { return _cell_ptr.size() ? _cell_ptr.size()-1 : 0; }
+    int getMaxNodes() const { return _max_nodes; }
+    size_t getNbNodes() const { return _dim ? _coord.size()/_dim : 0; }
+    const double *getCoord(size_t n) const { return &_coord[_dim*n]; }
+    size_t getNbNodes(size_t e) const { return _el_ptr[e+1] - _el_ptr[e]; }
+    const size_t *getNodes(size_t e) const { return &_el_node[_el_ptr[e]]; }
+    long locate(const double* x, double* w) const;
+    size_t locate(size_t np, const double* x, vector<long>& el, vector<double>& w,
+                  bool closest=false) const;
+    long closest(const double* x, double* w) const;
+    void getElements(const double* lo, const double* hi, vector<size_t>& el) const;
+    void interpolate(const vector<long>& el, const vector<double>& w, const double* u, int nb_dof,
+                     double* v) const;
+    size_t getMemory() const;
+
+ private:
+
+    int _dim, _max_nodes;
+    size_t _nb_el, _n[3];
+    double _xmin[3], _xmax[3], _h[3], _tol;
+    vector<double> _coord;
+    vector<size_t> _el_ptr, _el_node, _cell_ptr;
+    vector<unsigned> _cell_el;
+
+    size_t cell(const double* x) const;
+    long locate(const double* x, size_t c, double* w) const;
+    bool weights(size_t e, const double* x, double* w, bool clamp=false) const;
+    void bounds(size_t e, double* lo, double* hi) const;
+};
+
+} /* namespace RITA */
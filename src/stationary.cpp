@@ -106,7 +106,7 @@ int stationary::run()
                ffs[f] << endl;
             }
          }
-         else if ((*_eq_type)[0]==PDE_EQ && _rs) {
+         else if ((*_eq_type)[0]==PDE_EQ && _rs && !_pde_eq[0]->isStructured()) {
             for (int i=0; i<_pde_eq[0]->nb_fields; ++i) {
                int f = _pde_eq[0]->field[i];
                ff[f].open(fn[f],OFELI::IOField::OUT);
@@ -159,12 +159,29 @@ int stationary::run()
          else if (_rita->_eq_type[e]==PDE_EQ) {
             equa *pde = _pde_eq[e];
 
+//          Structured mesh: values at grid nodes, saved in VTK files rita-<e><f>.vtk
+            if (pde->isStructured()) {
+               if (pde->case_bf.size())
+                  _rita->msg("solve>","Load cases are not available on a structured mesh.");
+               int f = pde->field[0];
+               ret = pde->run(*_data->u[f]);
+               if (_rs) {
+                  string fv = "rita-" + to_string(10*(e+1)+f+1) + ".vtk";
+                  vector<double> v(_data->u[f]->size());
+                  for (size_t i=0; i<v.size(); ++i)
+                     v[i] = (*_data->u[f])[i];
+                  _rita->_grid->save(fv,v,_data->Field[f]);
+                  if ((*_isave)[f])
+                     _rita->_grid->save((*_save_file)[f],v,_data->Field[f]);
+                  if (_rita->_verb>1)
+                     cout << "Solution saved in file " << fv << endl;
+               }
+               continue;
+            }
+
 //          Solution
             pde->theEquation->setInput(SOLUTION,*_data->u[pde->field[0]]);
 
-//          Linear system solver
-            pde->theEquation->setSolver(pde->ls,pde->prec);
-
 //          Boundary condition
             if (pde->set_bc) {
                if (pde->bc.withRegex(1)) {
@@ -190,8 +207,24 @@ int stationary::run()
                pde->theEquation->setInput(BOUNDARY_FORCE,pde->sf);
             }
 
-//          Run
-            ret = pde->theEquation->run();
+//          Run (the linear solver is set by pde). Load cases are solved together
+//          with the equation and saved in the files rita-<e><f>-case<c>.sol
+            if (pde->nb_fields>1)
+               pde->theSolution[1] = _data->u[pde->field[1]];
+            if (pde->case_bf.size()) {
+               vector<Vect<double> > uc;
+               ret = pde->runCases(*_data->u[pde->field[0]],uc);
+               int f = pde->field[0];
+               for (size_t c=0; c<uc.size() && _rs; ++c) {
+                  string fc = "rita-" + to_string(10*(e+1)+f+1) + "-case" + to_string(c+2) + ".sol";
+                  OFELI::IOField ffc(fc,OFELI::IOField::OUT);
+                  ffc.put(uc[c]);
+                  if (_rita->_verb>1)
+                     cout << "Solution of load case " << c+2 << " saved in file " << fc << endl;
+               }
+            }
+            else
+               ret = pde->run(*_data->u[pde->field[0]]);
 
 //          Save solution in file
             for (int i=0; i<pde->nb_fields; ++i) {
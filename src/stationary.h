@@ -42,6 +42,7 @@ class stationary
     stationary(rita *r);
     ~stationary();
     void setSave(vector<int>& isave, vector<int>& format, vector<string>& file);
+    void setSaveResults(int rs) { _rs = rs; }
     int run();
 
  private:
@@ -0,0 +1,236 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                    Implementation of class 'structuredMesh'
+
+  ==============================================================================*/
+
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include "structuredMesh.h"
+
+namespace RITA {
+
+structuredMesh::structuredMesh()
+               : _dim(0), _nb_dof(1), _nb_nodes(0), _nb_eq(0)
+{
+   for (int a=0; a<3; ++a) {
+      _ne[a] = _lo[a] = _hi[a] = 0;
+      _xmin[a] = _xmax[a] = 0., _h[a] = 1.;
+   }
+   for (int f=0; f<6; ++f)
+      _code[f] = 0;
+}
+
+
+/*
+ * dim: space dimension (2 or 3), xmin, xmax: extents along each axis,
+ * ne: numbers of elements along each axis, code: codes of the faces
+ * (2*dim values), nb_dof: number of degrees of freedom per node
+ */
+int structuredMesh::set(int           dim,
+                        const double* xmin,
+                        const double* xmax,
+                        const size_t* ne,
+                        const int*    code,
+                        int           nb_dof)
+{
+   if (dim<2 || dim>3)
+      return 1;
+   _dim = dim, _nb_dof = nb_dof;
+   _nb_nodes = _nb_eq = 1;
+   for (int a=0; a<3; ++a) {
+      _ne[a] = _lo[a] = _hi[a] = 0;
+      _xmin[a] = _xmax[a] = 0., _h[a] = 1.;
+      _code[2*a] = _code[2*a+1] = 0;
+      if (a>=dim)
+         continue;
+      if (ne[a]==0 || xmax[a]<=xmin[a])
+         return 1;
+      _ne[a] = ne[a];
+      _xmin[a] = xmin[a], _xmax[a] = xmax[a];
+      _h[a] = (xmax[a]-xmin[a])/double(ne[a]);
+      _code[2*a] = code[2*a], _code[2*a+1] = code[2*a+1];
+      _lo[a] = (_code[2*a]>0) ? 1 : 0;
+      _hi[a] = (_code[2*a+1]>0) ? _ne[a]-1 : _ne[a];
+      _nb_nodes *= _ne[a] + 1;
+      _nb_eq *= (_hi[a]+1>_lo[a]) ? _hi[a]+1-_lo[a] : 0;
+   }
+   return 0;
+}
+
+
+size_t structuredMesh::getNbElements() const
+{
+   if (_dim==2)
+      return 2*_ne[0]*_ne[1];
+   return _ne[0]*_ne[1]*_ne[2];
+}
+
+
+/*
+ * Grid indices of node n
+ */
+void structuredMesh::getIndex(size_t  n,
+                              size_t* i) const
+{
+   i[0] = n%(_ne[0]+1), n /= _ne[0] + 1;
+   i[1] = n%(_ne[1]+1);
+   i[2] = n/(_ne[1]+1);
+}
+
+
+size_t structuredMesh::getNode(const size_t* i) const
+{
+   return (i[2]*(_ne[1]+1) + i[1])*(_ne[0]+1) + i[0];
+}
+
+
+void structuredMesh::getCoord(size_t  n,
+                              double* x) const
+{
+   size_t i[3];
+   getIndex(n,i);
+   for (int a=0; a<3; ++a)
+      x[a] = (i[a]==_ne[a]) ? _xmax[a] : _xmin[a] + i[a]*_h[a];
+}
+
+
+int structuredMesh::getCode(size_t n) const
+{
+   size_t i[3];
+   int c = 0;
+   getIndex(n,i);
+   for (int a=0; a<_dim; ++a) {
+      if (i[a]==0)
+         c = std::max(c,_code[2*a]);
+      if (i[a]==_ne[a])
+         c = std::max(c,_code[2*a+1]);
+   }
+   return c;
+}
+
+
+/*
+ * Equation number of node n, -1 if its value is prescribed
+ */
+long structuredMesh::getEq(size_t n) const
+{
+   size_t i[3];
+   getIndex(n,i);
+   long k = 0;
+   for (int a=2; a>=0; --a) {
+      if (i[a]<_lo[a] || i[a]>_hi[a])
+         return -1;
+      k = k*long(_hi[a]+1-_lo[a]) + long(i[a]-_lo[a]);
+   }
+   return k;
+}
+
+
+size_t structuredMesh::getNodeOfEq(size_t k) const
+{
+   size_t i[3];
+   for (int a=0; a<3; ++a) {
+      size_t m = _hi[a] + 1 - _lo[a];
+      i[a] = _lo[a] + k%m, k /= m;
+   }
+   return getNode(i);
+}
+
+
+/*
+ * Nodes of element e in nd. Returns their number: 3 (triangle) or
+ * 8 (hexahedron, lower face then upper face, counterclockwise)
+ */
+int structuredMesh::getElement(size_t  e,
+                               size_t* nd) const
+{
+   size_t sx=_ne[0]+1, sxy=sx*(_ne[1]+1);
+   if (_dim==2) {
+      size_t c=e/2, n0=(c/_ne[0])*sx + c%_ne[0];
+      nd[0] = n0;
+      nd[1] = (e%2) ? n0+sx+1 : n0+1;
+      nd[2] = (e%2) ? n0+sx : n0+sx+1;
+      return 3;
+   }
+   size_t i=e%_ne[0], j=(e/_ne[0])%_ne[1], k=e/(_ne[0]*_ne[1]);
+   size_t n0 = k*sxy + j*sx + i;
+   nd[0] = n0, nd[1] = n0 + 1, nd[2] = n0 + sx + 1, nd[3] = n0 + sx;
+   for (int l=0; l<4; ++l)
+      nd[l+4] = nd[l] + sxy;
+   return 8;
+}
+
+
+/*
+ * Save the grid and the node codes in a VTK legacy file (structured points):
+ * no connectivity is written
+ */
+int structuredMesh::save(const string& file) const
+{
+   vector<double> u;
+   return save(file,u,"");
+}
+
+
+/*
+ * Save the grid with node codes and the nodal field u (nb_dof values per
+ * node) named name in a VTK legacy file
+ */
+int structuredMesh::save(const string&         file,
+                         const vector<double>& u,
+                         const string&         name) const
+{
+   std::ofstream fs(file.c_str());
+   if (!fs)
+      return 1;
+   fs << "# vtk DataFile Version 3.0\nStructured mesh saved by rita\nASCII\n";
+   fs << "DATASET STRUCTURED_POINTS\n";
+   fs << "DIMENSIONS " << _ne[0]+1 << " " << _ne[1]+1 << " " << _ne[2]+1 << "\n";
+   fs << std::setprecision(12);
+   fs << "ORIGIN " << _xmin[0] << " " << _xmin[1] << " " << _xmin[2] << "\n";
+   fs << "SPACING " << _h[0] << " " << _h[1] << " " << _h[2] << "\n";
+   fs << "POINT_DATA " << _nb_nodes << "\nSCALARS code int 1\nLOOKUP_TABLE default\n";
+   for (size_t n=0; n<_nb_nodes; ++n)
+      fs << getCode(n) << "\n";
+   size_t nd = _nb_nodes ? u.size()/_nb_nodes : 0;
+   if (nd==1) {
+      fs << "SCALARS " << name << " double 1\nLOOKUP_TABLE default\n";
+      for (size_t n=0; n<_nb_nodes; ++n)
+         fs << u[n] << "\n";
+   }
+   else if (nd>1 && nd<=3) {
+      fs << "VECTORS " << name << " double\n";
+      for (size_t n=0; n<_nb_nodes; ++n) {
+         for (size_t k=0; k<3; ++k)
+            fs << ((k<nd) ? u[nd*n+k] : 0.) << " ";
+         fs << "\n";
+      }
+   }
+   return fs.fail() ? 1 : 0;
+}
+
+} /* namespace RITA */
@@ -0,0 +1,89 @@
+/*==============================================================================
+
+                                 r  i  t  a
+
+            An environment for Modelling and Numerical Simulation
+
+  ==============================================================================
+
+    Copyright (C) 2021 Rachid Touzani
+
+    This file is part of rita.
+
+    rita is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rita is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+  ==============================================================================
+
+                      Definition of class 'structuredMesh'
+
+  ==============================================================================*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+using std::vector;
+using std::string;
+
+namespace RITA {
+
+/*
+ * Implicit structured mesh of a rectangle (2-D) or a parallelepiped (3-D).
+ * Only the extents, the numbers of elements along each axis and the codes of
+ * the boundary faces are stored: node coordinates, node codes, element nodes
+ * and equation numbers are computed on the fly.
+ * Nodes are numbered lexicographically (x first), 0-based. In 2-D each cell is
+ * split in two triangles by its diagonal (i,j)-(i+1,j+1), in 3-D elements are
+ * the hexahedral cells.
+ * Face codes are given in the order x=xmin, x=xmax, y=ymin, y=ymax, z=zmin,
+ * z=zmax. A node takes the largest positive code of the faces it lies on, 0 if
+ * none: nodes with a positive code have a prescribed value, so that the free
+ * nodes form a box of the grid and are numbered lexicographically too.
+ */
+class structuredMesh
+{
+
+ public:
+
+    structuredMesh();
+    ~structuredMesh() { }
+    int set(int dim, const double* xmin, const double* xmax, const size_t* ne, const int* code,
+            int nb_dof=1);
+    int getDim() const { return _dim; }
+    int getNbDOF() const { return _nb_dof; }
+    size_t getNbNodes() const { return _nb_nodes; }
+    size_t getNbElements() const;
+    size_t getNbEq() const { return _nb_eq; }
+    size_t getNbElements(int a) const { return _ne[a]; }
+    double getMin(int a) const { return _xmin[a]; }
+    double getMax(int a) const { return _xmax[a]; }
+    double getSize(int a) const { return _h[a]; }
+    int getFaceCode(int f) const { return _code[f]; }
+    void getIndex(size_t n, size_t* i) const;
+    size_t getNode(const size_t* i) const;
+    void getCoord(size_t n, double* x) const;
+    int getCode(size_t n) const;
+    long getEq(size_t n) const;
+    size_t getNodeOfEq(size_t i) const;
+    int getElement(size_t e, size_t* nd) const;
+    int save(const string& file) const;
+    int save(const string& file, const vector<double>& u, const string& name) const;
+    size_t getMemory() const { return sizeof(*this); }
+
+ private:
+
+    int _dim, _nb_dof, _code[6];
+    size_t _ne[3], _lo[3], _hi[3], _nb_nodes, _nb_eq;
+    double _xmin[3], _xmax[3], _h[3];
+};
+
+} /* namespace RITA */
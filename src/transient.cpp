@@ -31,6 +31,7 @@
 #include "io/IOField.h"
 #include "io/saveField.h"
 #include <iostream>
+#include <cstdlib>
 
 #include "transient.h"
 #include "equa.h"
@@ -81,6 +82,34 @@ transient::~transient()
 int transient::setPDE(int e)
 {
    _pde_eq = _rita->PDE;
+   bool ns = (_pde_eq[e]->eq=="incompressible-navier-stokes" && _pde_eq[e]->spD=="feP1");
+   if (ns && _pde_eq[e]->ritaSolver() && _pde_eq[e]->xprec!=SCHUR_MASS_PREC && _pde_eq[e]->xprec!=SCHUR_PCD_PREC) {
+      _rita->msg("solve>","rita linear solvers are used for the transient incompressible Navier-Stokes equations "
+                 "with a block preconditioner.","Preconditioner schur-mass is used.");
+      _pde_eq[e]->xprec = SCHUR_MASS_PREC;
+   }
+   bool block = (ns && (_pde_eq[e]->xprec==SCHUR_MASS_PREC || _pde_eq[e]->xprec==SCHUR_PCD_PREC));
+   if (block) {
+      if (_rita->_scheme!="backward-euler")
+         _rita->msg("solve>","Block preconditioned Navier-Stokes solver uses a linearized backward-euler scheme.");
+      _pde_eq[e]->theSolution[1] = _data->u[_pde_eq[e]->field[1]];
+   }
+   else if (_pde_eq[e]->ritaSolver()) {
+      if (_pde_eq[e]->eq!="heat" || _rita->_scheme!="backward-euler") {
+         _rita->msg("solve>","rita linear solvers (amg, gmg, chebyshev, asm, cholesky, ldlt, mixed precision, matrix-free, parallel, recycle, auto) are available for "
+                    "transient problems with the heat equation and backward-euler scheme, or the incompressible "
+                    "Navier-Stokes equations with feP1 only.",
+                    "OFELI solver with preconditioner dilu is used instead.");
+         _pde_eq[e]->xprec = NO_EXT_PREC;
+         _pde_eq[e]->prec = DILU_PREC;
+         _pde_eq[e]->mixed = false;
+         _pde_eq[e]->matrix_free = false;
+         _pde_eq[e]->parallel_prec = false;
+         _pde_eq[e]->multicolor = false;
+         _pde_eq[e]->recycle = false;
+         _pde_eq[e]->auto_ls = false;
+      }
+   }
    try {
       _ts = new OFELI::TimeStepping(_rita->_sch[_rita->_scheme],_time_step,_final_time);
       _ts_allocated = true;
@@ -231,6 +260,7 @@ int transient::run()
    }
 
 // Loop on time steps
+   int nb_it=0, nb_solve=0;
    try {
       TimeLoop {
 
@@ -286,7 +316,8 @@ int transient::run()
                   pde->bf.setTime(theTime);
                   if (pde->bf.withRegex(1))
                      pde->bf.set(pde->regex_bf);
-                  _ts->setRHS(pde->bf);
+                  if (!pde->ritaSolver())
+                     _ts->setRHS(pde->bf);
                   pde->theEquation->setInput(BODY_FORCE,pde->bf);
                }
 
@@ -297,7 +328,10 @@ int transient::run()
                      for (auto const& v: pde->regex_bc)
                         pde->setNodeBC(v.first,v.second,theTime,pde->bc);
                   }
-                  _ts->setBC(pde->bc);
+                  if (!pde->ritaSolver())
+                     _ts->setBC(pde->bc);
+                  else
+                     pde->theEquation->setInput(BOUNDARY_CONDITION,pde->bc);
                }
 
 //             Boundary force
@@ -310,8 +344,16 @@ int transient::run()
             //            _ts->setSF(_data->sf[i]);
                }
 
-//             Run
-               _ts->runOneTimeStep();
+//             Run (with a rita preconditioner, the step is performed by pde)
+               if (!pde->ritaSolver())
+                  _ts->runOneTimeStep();
+               else {
+                  pde->runOneTimeStep(*_data->u[pde->field[0]],theTimeStep);
+                  nb_it += std::abs(pde->getNbIter());
+                  nb_solve++;
+                  if (_rita->_verb>1)
+                     cout << "Number of linear solver iterations: " << std::abs(pde->getNbIter()) << endl;
+               }
 
 //             Save in native OFELI format file
                for (int i=0; i<pde->nb_fields; ++i) {
@@ -327,6 +369,9 @@ int transient::run()
    } CATCH
 
    theTime -= theTimeStep;
+   if (nb_solve && _rita->_verb)
+      cout << "Total number of linear solver iterations: " << nb_it << ", average per time step: "
+           << double(nb_it)/nb_solve << endl;
    for (int e=0; e<_nb_eq; ++e) {
       if ((*_eq_type)[e]==PDE_EQ) {
          for (int i=0; i<_pde_eq[e]->nb_fields; ++i) {
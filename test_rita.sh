@@ -39,6 +39,14 @@ if test "$ans" = "y" ; then
    $RITA ${DD}/tutorial/pde/example5.rita
 fi
 
+echo "----------------------------------------------"
+echo "Test solution of eigenvalue problems (y/n) ? \c"
+read ans
+if test "$ans" = "y" ; then
+   $RITA ${DD}/tutorial/eigen/example1.rita
+   $RITA ${DD}/tutorial/eigen/example2.rita
+fi
+
 echo "-------------------------------------------------"
 echo "Test solution of optimization problems (y/n) ? \c"
 read ans
@@ -0,0 +1,39 @@
+#!/bin/sh
+# Direct solvers for the 3-D Laplace equation (P1 finite elements on refined
+# cube meshes): the direct solver of OFELI ('ls direct') and the supernodal
+# sparse factorizations of rita with a nested dissection ordering
+# ('ls direct cholesky' and 'ls direct ldlt'), compared with 'ls cg amg'.
+# With verbosity=2, rita prints the size of the factor, the number of
+# operations and the factorization and solve times.
+#
+# Usage: sh direct-solver.sh [ne1 ne2 ...]
+
+RITA=${RITA:-rita}
+NE=${*:-"10 20 30 40"}
+
+for n in $NE; do
+   for s in "direct" "direct cholesky" "direct ldlt" "cg amg"; do
+      cat > direct-solver.rita <<END
+set verbosity=2 save-results=0
+mesh
+  cube min=0.,0.,0. max=1.,1.,1. ne=$n,$n,$n codes=1,1,1,1,1,1
+  end
+pde laplace
+  field u
+  bc code=1 value=0.
+  source value=1.
+  space feP1
+  ls $s
+  end
+solve
+  run
+exit
+END
+      echo "ne=$n, ls $s:"
+      start=`date +%s.%N`
+      $RITA direct-solver.rita | grep -i "factorization\|iteration\|time"
+      end=`date +%s.%N`
+      echo "   wall time: `echo "$end - $start" | bc` s"
+   done
+done
+rm -f direct-solver.rita
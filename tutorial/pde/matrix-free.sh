@@ -0,0 +1,36 @@
+#!/bin/sh
+# Assembled versus matrix-free P1 operator on a scaled up version of
+# example2.rita (2-D Laplace equation on triangles).
+# The problem is solved with 'ls cg p' (assembled matrix) and with
+# 'ls cg p matrix-free' for p = diag, chebyshev. rita prints the number of
+# iterations and the solve time (verbosity=2), and the peak memory of each
+# run is reported by /usr/bin/time.
+#
+# Usage: sh matrix-free.sh [ne]
+
+RITA=${RITA:-rita}
+NE=${1:-1000}
+
+for p in diag chebyshev; do
+   for m in double matrix-free; do
+      cat > matrix-free.rita <<END
+set verbosity=2 save-results=0
+mesh
+  rectangle min=0.,0. max=3.,1. codes=1 ne=$NE,$NE
+  end
+pde laplace
+  field u
+  bc code=1 value=sin(pi*x)*exp(y)
+  source value=(pi*pi-1)*sin(pi*x)*exp(y)
+  space feP1
+  ls cg $p $m
+  end
+solve
+  run
+exit
+END
+      echo "ne=$NE, preconditioner $p, $m:"
+      /usr/bin/time -f "   peak memory: %M kB, wall time: %e s" $RITA matrix-free.rita 2>&1 | grep -i "iteration\|time\|memory"
+   done
+done
+rm -f matrix-free.rita
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Scaling test of the preconditioners for the 3-D Laplace equation
+# (P1 finite elements on refined cube meshes).
+# For each mesh, the problem is solved with 'ls cg dilu', 'ls cg amg' and
+# 'ls cg gmg' and the wall clock time is printed. With amg and gmg, rita also
+# prints the number of iterations, the setup and the solve times (verbosity=2).
+#
+# Usage: sh mg-scaling.sh [ne1 ne2 ...]
+
+RITA=${RITA:-rita}
+NE=${*:-"8 16 24 32 40"}
+
+for n in $NE; do
+   for p in dilu amg gmg; do
+      cat > mg-scaling.rita <<END
+set verbosity=2 save-results=0
+mesh
+  cube min=0.,0.,0. max=1.,1.,1. ne=$n,$n,$n codes=1,1,1,1,1,1
+  end
+pde laplace
+  field u
+  bc code=1 value=0.
+  source value=1.
+  space feP1
+  ls cg $p
+  end
+solve
+  run
+exit
+END
+      echo "ne=$n, preconditioner $p:"
+      start=`date +%s.%N`
+      $RITA mg-scaling.rita | grep -i "iteration\|time"
+      end=`date +%s.%N`
+      echo "   wall time: `echo "$end - $start" | bc` s"
+   done
+done
+rm -f mg-scaling.rita
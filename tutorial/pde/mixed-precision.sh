@@ -0,0 +1,63 @@
+#!/bin/sh
+# Comparison of double and mixed precision linear solvers on scaled up
+# versions of example2.rita (2-D Laplace equation) and of a 3-D Laplace
+# equation on a cube.
+# Each problem is solved with 'ls cg p' and 'ls cg p mixed' for p = amg, gmg
+# and rita prints the number of iterations, setup and solve times
+# (verbosity=2). The wall clock time of each run is printed too.
+#
+# Usage: sh mixed-precision.sh [ne2d] [ne3d]
+
+RITA=${RITA:-rita}
+NE2=${1:-1000}
+NE3=${2:-80}
+
+run()
+{
+   start=`date +%s.%N`
+   $RITA mixed-precision.rita | grep -i "iteration\|time"
+   end=`date +%s.%N`
+   echo "   wall time: `echo "$end - $start" | bc` s"
+}
+
+for p in amg gmg; do
+   for m in double mixed; do
+      cat > mixed-precision.rita <<END
+set verbosity=2 save-results=0
+mesh
+  rectangle min=0.,0. max=3.,1. codes=1 ne=$NE2,$NE2
+  end
+pde laplace
+  field u
+  bc code=1 value=sin(pi*x)*exp(y)
+  source value=(pi*pi-1)*sin(pi*x)*exp(y)
+  space feP1
+  ls cg $p $m
+  end
+solve
+  run
+exit
+END
+      echo "2-D, ne=$NE2, preconditioner $p, $m precision:"
+      run
+      cat > mixed-precision.rita <<END
+set verbosity=2 save-results=0
+mesh
+  cube min=0.,0.,0. max=1.,1.,1. ne=$NE3,$NE3,$NE3 codes=1,1,1,1,1,1
+  end
+pde laplace
+  field u
+  bc code=1 value=0.
+  source value=1.
+  space feP1
+  ls cg $p $m
+  end
+solve
+  run
+exit
+END
+      echo "3-D, ne=$NE3, preconditioner $p, $m precision:"
+      run
+   done
+done
+rm -f mixed-precision.rita
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Block preconditioners for the incompressible Navier-Stokes equations on the
+# flow over a step of example5.rita: the OFELI projection scheme is compared
+# with the coupled velocity-pressure solver of rita, 'ls gmres p' with
+# p = schur-mass (pressure mass Schur complement) and p = schur-pcd (pressure
+# convection-diffusion). rita prints the number of GMRES iterations per
+# time step (verbosity=2) and the wall clock time of each run is printed.
+#
+# Usage: sh navier-stokes.sh [final-time]
+
+RITA=${RITA:-rita}
+T=${1:-0.1}
+
+for p in none schur-mass schur-pcd; do
+   if [ $p = none ]; then
+      sed -e "s/final-time=1.0/final-time=$T/" example5.rita > navier-stokes.rita
+   else
+      sed -e "s/final-time=1.0/final-time=$T/" -e "s/  space feP1/  space feP1\n  ls gmres $p/" \
+          -e "s/^pde /set verbosity=2\npde /" example5.rita > navier-stokes.rita
+   fi
+   echo "Preconditioner $p:"
+   start=`date +%s.%N`
+   $RITA navier-stokes.rita | grep -i "iteration"
+   end=`date +%s.%N`
+   echo "   wall time: `echo "$end - $start" | bc` s"
+done
+rm -f navier-stokes.rita
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Speedup of the parallel assembly of P1 equations with the number of threads
+# on a scaled up version of example2.rita (2-D Laplace equation on triangles).
+# Elements are grouped in colours such that two elements of a colour share no
+# node; colours are assembled one after the other, each one by all threads.
+# Parallel assembly is used with any rita solver, here 'ls cg amg'. rita
+# prints the assembly time for each number of threads (verbosity=2).
+#
+# Usage: sh parallel-assembly.sh [ne] [threads ...]
+
+RITA=${RITA:-rita}
+NE=${1:-2000}
+shift 2>/dev/null
+THREADS=${*:-1 2 4 8 16}
+
+t1=""
+for nt in $THREADS; do
+   cat > parallel-assembly.rita <<END
+set verbosity=2 save-results=0 threads=$nt
+mesh
+  rectangle min=0.,0. max=3.,1. codes=1 ne=$NE,$NE
+  end
+pde laplace
+  field u
+  bc code=1 value=sin(pi*x)*exp(y)
+  source value=(pi*pi-1)*sin(pi*x)*exp(y)
+  space feP1
+  ls cg amg
+  end
+solve
+  run
+exit
+END
+   t=`$RITA parallel-assembly.rita | grep "Assembly time" | head -1 | awk '{print $3}'`
+   [ -z "$t1" ] && t1=$t
+   echo "threads=$nt, assembly time: $t s, speedup: `echo "scale=2; $t1/$t" | bc`"
+done
+rm -f parallel-assembly.rita